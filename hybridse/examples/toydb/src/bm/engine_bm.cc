@@ -134,6 +134,23 @@ static void BM_EngineRunBatchWindowSumFeature5(
     EngineRunBatchWindowSumFeature5(&state, BENCHMARK, state.range(0),
                                     state.range(1));
 }
+static void BM_EngineRunBatchWindowSumFeature5Parallel(
+    benchmark::State& state) {  // NOLINT
+    EngineRunBatchWindowSumFeature5Parallel(&state, BENCHMARK, state.range(0),
+                                            state.range(1));
+}
+static void BM_EngineRunBatchTableProject(
+    benchmark::State& state) {  // NOLINT
+    EngineRunBatchTableProject(&state, BENCHMARK, state.range(0),
+                               state.range(1));
+}
+static void BM_EngineRunBatchLastJoin(benchmark::State& state) {  // NOLINT
+    EngineRunBatchLastJoin(&state, BENCHMARK, state.range(0), state.range(1));
+}
+static void BM_EngineCompileDistinctSql(benchmark::State& state) {  // NOLINT
+    EngineCompileDistinctSql(&state, BENCHMARK, state.range(0),
+                             state.range(1));
+}
 static void BM_EngineRunBatchWindowSumFeature1ExcludeCurrentTime(
     benchmark::State& state) {  // NOLINT
     EngineRunBatchWindowSumFeature1ExcludeCurrentTime(
@@ -257,6 +274,30 @@ BENCHMARK(BM_EngineRunBatchWindowSumFeature5)
     ->Args({100, 100})
     ->Args({1000, 1000})
     ->Args({10000, 10000});
+// batch engine window bm scaling with runner parallelism
+BENCHMARK(BM_EngineRunBatchWindowSumFeature5Parallel)
+    ->Args({1, 100000})
+    ->Args({2, 100000})
+    ->Args({4, 100000})
+    ->Args({8, 100000})
+    ->UseRealTime();
+// compile latency of distinct sql, standalone jit vs shared jit
+BENCHMARK(BM_EngineCompileDistinctSql)
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Args({0, 10})
+    ->Args({1, 10})
+    ->Unit(benchmark::kMillisecond);
+// batch engine table project bm, row by row vs batch entry
+BENCHMARK(BM_EngineRunBatchTableProject)
+    ->Args({0, 100000})
+    ->Args({1, 100000});
+// batch engine last join bm, probe per left row vs join hash table
+BENCHMARK(BM_EngineRunBatchLastJoin)
+    ->Args({0, 1000})
+    ->Args({1, 1000})
+    ->Args({0, 10000})
+    ->Args({1, 10000});
 BENCHMARK(BM_EngineRunBatchWindowSumFeature5Window5)
     ->Args({1, 2})
     ->Args({1, 10})
@@ -22,6 +22,7 @@
 #include <vector>
 #include "benchmark/benchmark.h"
 #include "codec/type_codec.h"
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
 #include "llvm/IR/Function.h"
@@ -38,6 +39,11 @@
 #include "llvm/Transforms/Scalar/GVN.h"
 #include "tablet/tablet_catalog.h"
 
+DECLARE_uint32(batch_runner_parallelism);
+DECLARE_bool(enable_batch_project);
+DECLARE_bool(enable_hash_last_join);
+DECLARE_bool(enable_shared_jit);
+
 namespace hybridse {
 namespace bm {
 using codec::Row;
@@ -250,7 +256,101 @@ void EngineRunBatchWindowSumFeature5(benchmark::State* state, MODE mode,
         std::to_string(limit_cnt) + ";";
     EngineBatchMode(sql, mode, limit_cnt, size, state);
 }
+// window aggregation over 8 partitions without limit, run by `parallelism` threads
+void EngineRunBatchWindowSumFeature5Parallel(benchmark::State* state, MODE mode,
+                                             int64_t parallelism,
+                                             int64_t size) {  // NOLINT
+    const std::string sql =
+        "SELECT "
+        "sum(col1) OVER w1 as w1_col1_sum, "
+        "sum(col3) OVER w1 as w1_col3_sum, "
+        "sum(col4) OVER w1 as w1_col4_sum, "
+        "sum(col2) OVER w1 as w1_col2_sum, "
+        "sum(col5) OVER w1 as w1_col5_sum "
+        "FROM t1 WINDOW w1 AS (PARTITION BY col6 ORDER BY col5 ROWS_RANGE "
+        "BETWEEN "
+        "30d "
+        "PRECEDING AND CURRENT ROW);";
+    FLAGS_batch_runner_parallelism = parallelism;
+    EngineBatchMode(sql, mode, size, size, state);
+    FLAGS_batch_runner_parallelism = 1;
+}
 
+// table project over `size` rows, projected row by row or in batches
+void EngineRunBatchTableProject(benchmark::State* state, MODE mode,
+                                int64_t batch_project,
+                                int64_t size) {  // NOLINT
+    const std::string sql =
+        "SELECT "
+        "col1 + 1 as c1, "
+        "col2 * 2 as c2, "
+        "col3 + col4 as c3, "
+        "col5 - col1 as c5, "
+        "concat(col0, col6) as c6 "
+        "FROM t1;";
+    FLAGS_enable_batch_project = batch_project;
+    EngineBatchMode(sql, mode, size, size, state);
+    FLAGS_enable_batch_project = true;
+    if (BENCHMARK == mode) {
+        // rows/s of the single runner thread
+        state->SetItemsProcessed(state->iterations() * size);
+    }
+}
+// last join t1 with itself on a column without index, so the right side is
+// grouped in memory, probed per left row or through the join hash table
+void EngineRunBatchLastJoin(benchmark::State* state, MODE mode,
+                            int64_t hash_join, int64_t size) {  // NOLINT
+    const std::string sql =
+        "SELECT ta.col1 as c1, tb.col3 as c3 "
+        "FROM t1 AS ta LAST JOIN t1 AS tb ORDER BY tb.col5 "
+        "ON ta.col6 = tb.col6;";
+    FLAGS_enable_hash_last_join = hash_join;
+    EngineBatchMode(sql, mode, size, size, state);
+    FLAGS_enable_hash_last_join = true;
+    if (BENCHMARK == mode) {
+        // left rows/s of the single runner thread
+        state->SetItemsProcessed(state->iterations() * size);
+    }
+}
+// compile distinct sql one after another, each into a jit of its own or
+// into the jit shared by the engine
+void EngineCompileDistinctSql(benchmark::State* state, MODE mode,
+                              int64_t shared_jit, int64_t sql_cnt) {  // NOLINT
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+    gflags::FlagSaver flag_saver;
+    FLAGS_enable_shared_jit = shared_jit;
+    auto catalog = vm::BuildOnePkTableStorage(1);
+    Engine engine(catalog);
+    int64_t sql_idx = 0;
+    auto compile_next = [&]() {
+        const std::string sql =
+            "SELECT col1 + " + std::to_string(sql_idx) +
+            " as c1, substring(col0, 1, " + std::to_string(sql_idx % 3 + 1) +
+            ") as c2 FROM t1;";
+        sql_idx++;
+        BatchRunSession session;
+        base::Status query_status;
+        return engine.Get(sql, "db", session, query_status);
+    };
+    switch (mode) {
+        case BENCHMARK: {
+            for (auto _ : *state) {
+                for (int64_t i = 0; i < sql_cnt; i++) {
+                    benchmark::DoNotOptimize(compile_next());
+                }
+            }
+            state->SetItemsProcessed(state->iterations() * sql_cnt);
+            break;
+        }
+        case TEST: {
+            for (int64_t i = 0; i < sql_cnt; i++) {
+                ASSERT_TRUE(compile_next());
+            }
+            break;
+        }
+    }
+}
 void EngineRunBatchWindowSumFeature1ExcludeCurrentTime(
     benchmark::State* state, MODE mode, int64_t limit_cnt,
     int64_t size) {  // NOLINT
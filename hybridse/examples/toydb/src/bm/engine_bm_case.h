@@ -62,6 +62,16 @@ void EngineRunBatchWindowSumFeature5ExcludeCurrentTime(benchmark::State* state,
                                                        MODE mode,
                                                        int64_t limit_cnt,
                                                        int64_t size);  // NOLINT
+void EngineRunBatchWindowSumFeature5Parallel(benchmark::State* state, MODE mode,
+                                             int64_t parallelism,
+                                             int64_t size);  // NOLINT
+void EngineRunBatchTableProject(benchmark::State* state, MODE mode,
+                                int64_t batch_project,
+                                int64_t size);  // NOLINT
+void EngineRunBatchLastJoin(benchmark::State* state, MODE mode,
+                            int64_t hash_join, int64_t size);  // NOLINT
+void EngineCompileDistinctSql(benchmark::State* state, MODE mode,
+                              int64_t shared_jit, int64_t sql_cnt);  // NOLINT
 void EngineWindowSumFeature5(benchmark::State* state, MODE mode,
                              int64_t limit_cnt,
                              int64_t size);  // NOLINT
@@ -81,6 +81,25 @@ TEST_F(EngineBMCaseTest, WINDOW_CASE0_QUERY_BATCH_TEST) {
     EngineRunBatchWindowSumFeature5(nullptr, TEST, 100L, 100L);
     EngineRunBatchWindowSumFeature5(nullptr, TEST, 1000L, 1000L);
 }
+TEST_F(EngineBMCaseTest, EngineRunBatchWindowSumFeature5Parallel_TEST) {
+    EngineRunBatchWindowSumFeature5Parallel(nullptr, TEST, 1L, 1000L);
+    EngineRunBatchWindowSumFeature5Parallel(nullptr, TEST, 4L, 1000L);
+}
+
+TEST_F(EngineBMCaseTest, EngineRunBatchTableProject_TEST) {
+    EngineRunBatchTableProject(nullptr, TEST, 0L, 1000L);
+    EngineRunBatchTableProject(nullptr, TEST, 1L, 1000L);
+}
+
+TEST_F(EngineBMCaseTest, EngineCompileDistinctSql_TEST) {
+    EngineCompileDistinctSql(nullptr, TEST, 0L, 4L);
+    EngineCompileDistinctSql(nullptr, TEST, 1L, 4L);
+}
+
+TEST_F(EngineBMCaseTest, EngineRunBatchLastJoin_TEST) {
+    EngineRunBatchLastJoin(nullptr, TEST, 0L, 1000L);
+    EngineRunBatchLastJoin(nullptr, TEST, 1L, 1000L);
+}
 
 TEST_F(EngineBMCaseTest, EngineRequestSimpleSelectDouble_TEST) {
     EngineRequestSimpleSelectDouble(nullptr, TEST);
@@ -14,10 +14,18 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <vector>
+
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "gtest/internal/gtest-param-util.h"
 #include "testing/toydb_engine_test_base.h"
 
+DECLARE_uint32(batch_runner_parallelism);
+DECLARE_uint32(batch_request_seek_parallelism);
+DECLARE_bool(enable_window_column_materialize);
+
 using namespace llvm;       // NOLINT (build/namespaces)
 using namespace llvm::orc;  // NOLINT (build/namespaces)
 
@@ -48,6 +56,22 @@ TEST_P(EngineTest, TestBatchEngine) {
         LOG(INFO) << "Skip mode " << sql_case.mode();
     }
 }
+// the parallel runners must give the same output as the serial run the cases expect
+TEST_P(EngineTest, TestParallelBatchEngine) {
+    ParamType sql_case = GetParam();
+    EngineOptions options;
+    LOG(INFO) << "ID: " << sql_case.id() << ", DESC: " << sql_case.desc();
+    if (!boost::contains(sql_case.mode(), "batch-unsupport") &&
+        !boost::contains(sql_case.mode(), "rtidb-unsupport") &&
+        !boost::contains(sql_case.mode(), "performance-sensitive-unsupport") &&
+        !boost::contains(sql_case.mode(), "rtidb-batch-unsupport")) {
+        FLAGS_batch_runner_parallelism = 4;
+        EngineCheck(sql_case, options, kBatchMode);
+        FLAGS_batch_runner_parallelism = 1;
+    } else {
+        LOG(INFO) << "Skip mode " << sql_case.mode();
+    }
+}
 TEST_P(EngineTest, TestBatchRequestEngineForLastRow) {
     ParamType sql_case = GetParam();
     EngineOptions options;
@@ -102,6 +126,20 @@ TEST_P(BatchRequestEngineTest, TestBatchRequestEngine) {
         LOG(INFO) << "Skip mode " << sql_case.mode();
     }
 }
+// the window segments sought concurrently must give the same output as the serial seeks
+TEST_P(BatchRequestEngineTest, TestParallelSeekBatchRequestEngine) {
+    ParamType sql_case = GetParam();
+    LOG(INFO) << "ID: " << sql_case.id() << ", DESC: " << sql_case.desc();
+    EngineOptions options;
+    options.SetClusterOptimized(false);
+    if (!boost::contains(sql_case.mode(), "batch-request-unsupport")) {
+        gflags::FlagSaver saver;
+        FLAGS_batch_request_seek_parallelism = 4;
+        EngineCheck(sql_case, options, kBatchRequestMode);
+    } else {
+        LOG(INFO) << "Skip mode " << sql_case.mode();
+    }
+}
 TEST_P(BatchRequestEngineTest, TestClusterBatchRequestEngine) {
     ParamType sql_case = GetParam();
     LOG(INFO) << "ID: " << sql_case.id() << ", DESC: " << sql_case.desc();
@@ -115,6 +153,71 @@ TEST_P(BatchRequestEngineTest, TestClusterBatchRequestEngine) {
     }
 }
 
+// request rows of one batch sharing window segments must get the rows of running each request alone
+TEST_F(BatchRequestEngineTest, SharedWindowSameAsRequestRun) {
+    std::vector<SqlCase> cases = sqlcase::InitCases("/cases/function/test_batch_request.yaml");
+    auto sql_case = std::find_if(cases.begin(), cases.end(), [](const SqlCase& c) { return c.id() == "9"; });
+    ASSERT_TRUE(sql_case != cases.end());
+    for (bool cluster_optimized : {false, true}) {
+        EngineOptions options;
+        options.SetClusterOptimized(cluster_optimized);
+        ToydbRequestEngineTestRunner request_runner(*sql_case, options);
+        ASSERT_TRUE(request_runner.InitEngineCatalog());
+        ASSERT_TRUE(request_runner.Compile().isOK());
+        ASSERT_TRUE(request_runner.PrepareData().isOK());
+        std::vector<Row> request_outputs;
+        ASSERT_TRUE(request_runner.Compute(&request_outputs).isOK());
+
+        ToydbBatchRequestEngineTestRunner batch_runner(*sql_case, options, {});
+        ASSERT_TRUE(batch_runner.InitEngineCatalog());
+        ASSERT_TRUE(batch_runner.Compile().isOK());
+        ASSERT_TRUE(batch_runner.PrepareData().isOK());
+        std::vector<Row> batch_outputs;
+        ASSERT_TRUE(batch_runner.Compute(&batch_outputs).isOK());
+
+        ASSERT_EQ(5u, request_outputs.size());
+        ASSERT_EQ(request_outputs.size(), batch_outputs.size());
+        for (size_t i = 0; i < request_outputs.size(); i++) {
+            ASSERT_EQ(0, request_outputs[i].compare(batch_outputs[i]))
+                << "row " << i << ", cluster optimized " << cluster_optimized;
+        }
+    }
+}
+
+// window aggregates on the vectorized kernels must output the same bytes as
+// the iterator udafs
+template <class Runner>
+static void CheckColumnMaterializeOutputs(const SqlCase& sql_case) {
+    std::vector<Row> outputs[2];
+    for (bool materialize : {false, true}) {
+        gflags::FlagSaver flag_saver;
+        FLAGS_enable_window_column_materialize = materialize;
+        EngineOptions options;
+        Runner runner(sql_case, options);
+        ASSERT_TRUE(runner.InitEngineCatalog());
+        ASSERT_TRUE(runner.Compile().isOK());
+        ASSERT_TRUE(runner.PrepareData().isOK());
+        ASSERT_TRUE(runner.Compute(&outputs[materialize]).isOK());
+    }
+    ASSERT_EQ(outputs[0].size(), outputs[1].size());
+    for (size_t i = 0; i < outputs[0].size(); i++) {
+        ASSERT_EQ(0, outputs[0][i].compare(outputs[1][i])) << "case " << sql_case.id() << ", row " << i;
+    }
+}
+
+TEST_F(EngineTest, WindowColumnMaterializeSameAsIteratorUdaf) {
+    for (auto& sql_case : sqlcase::InitCases("/cases/function/window/test_window_column_materialize.yaml")) {
+        {
+            gflags::FlagSaver flag_saver;
+            FLAGS_enable_window_column_materialize = true;
+            EngineCheck(sql_case, EngineOptions(), kBatchMode);
+            EngineCheck(sql_case, EngineOptions(), kRequestMode);
+        }
+        CheckColumnMaterializeOutputs<ToydbBatchEngineTestRunner>(sql_case);
+        CheckColumnMaterializeOutputs<ToydbRequestEngineTestRunner>(sql_case);
+    }
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2021 4Paradigm
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_INCLUDE_BASE_HYPER_LOG_LOG_H_
+#define HYBRIDSE_INCLUDE_BASE_HYPER_LOG_LOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+
+#include "base/fe_hash.h"
+
+namespace hybridse {
+namespace base {
+
+// HyperLogLog sketch stored as kRegisterSize one-byte registers.
+//
+// The relative standard error of Estimate() is 1.04 / sqrt(kRegisterSize), about 1.6%.
+// Sketches are mergeable: merging the sketches of two row sets gives exactly the sketch
+// of their union, so pre-aggregated buckets and raw rows can be combined in any order.
+// The pre-aggregation tables and the request time merge must use the same Hash().
+class HyperLogLog {
+ public:
+    static constexpr uint32_t kPrecision = 12;
+    static constexpr uint32_t kRegisterSize = 1u << kPrecision;
+
+    static uint64_t Hash(const void* data, size_t len) {
+        return MurmurHash64A(data, static_cast<int>(len), 0xe17a1465);
+    }
+
+    static void Add(uint64_t hash, uint8_t* registers) {
+        uint32_t idx = static_cast<uint32_t>(hash >> (64 - kPrecision));
+        // the guard bit bounds the rank when the remaining bits are all zero
+        uint64_t rest = (hash << kPrecision) | (1ull << (kPrecision - 1));
+        uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+        registers[idx] = std::max(registers[idx], rank);
+    }
+
+    static void Merge(const uint8_t* src, uint8_t* dst) {
+        for (uint32_t i = 0; i < kRegisterSize; i++) {
+            dst[i] = std::max(dst[i], src[i]);
+        }
+    }
+
+    static int64_t Estimate(const uint8_t* registers) {
+        const double m = kRegisterSize;
+        double sum = 0;
+        uint32_t zeros = 0;
+        for (uint32_t i = 0; i < kRegisterSize; i++) {
+            sum += std::ldexp(1.0, -registers[i]);
+            zeros += registers[i] == 0;
+        }
+        double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+        // small range correction with linear counting
+        if (estimate <= 2.5 * m && zeros > 0) {
+            estimate = m * std::log(m / zeros);
+        }
+        return static_cast<int64_t>(estimate + 0.5);
+    }
+};
+
+}  // namespace base
+}  // namespace hybridse
+#endif  // HYBRIDSE_INCLUDE_BASE_HYPER_LOG_LOG_H_
@@ -16,7 +16,9 @@
 
 #ifndef HYBRIDSE_INCLUDE_CODEC_LIST_ITERATOR_CODEC_H_
 #define HYBRIDSE_INCLUDE_CODEC_LIST_ITERATOR_CODEC_H_
+#include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -44,6 +46,11 @@ class ColumnImpl;
 template <class V>
 class ColumnIterator;
 
+template <class V>
+class MaterializedColumn;
+
+template <class V>
+class MaterializedColumnIterator;
 
 template <class V, class R>
 class WrapListImpl : public ListV<V> {
@@ -65,7 +72,8 @@ class ColumnImpl : public WrapListImpl<V, Row> {
           root_(impl),
           row_idx_(row_idx),
           col_idx_(col_idx),
-          offset_(offset) {}
+          offset_(offset),
+          materialized_(nullptr) {}
 
     ~ColumnImpl() override {}
 
@@ -94,21 +102,46 @@ class ColumnImpl : public WrapListImpl<V, Row> {
 
     // TODO(xxx): iterator of nullable V
     std::unique_ptr<ConstIterator<uint64_t, V>> GetIterator() override {
+        if (materialized_ != nullptr) {
+            return std::make_unique<MaterializedColumnIterator<V>>(
+                materialized_);
+        }
         return std::make_unique<ColumnIterator<V>>(root_, this);
     }
     ConstIterator<uint64_t, V> *GetRawIterator() override {
+        if (materialized_ != nullptr) {
+            return new MaterializedColumnIterator<V>(materialized_);
+        }
         return new ColumnIterator<V>(root_, this);
     }
-    const uint64_t GetCount() override { return root_->GetCount(); }
-    V At(uint64_t pos) override { return GetFieldUnsafe(root_->At(pos)); }
+    const uint64_t GetCount() override {
+        if (materialized_ != nullptr) {
+            return materialized_->size();
+        }
+        return root_->GetCount();
+    }
+    V At(uint64_t pos) override {
+        if (materialized_ != nullptr && pos < materialized_->size()) {
+            return materialized_->values()[pos];
+        }
+        return GetFieldUnsafe(root_->At(pos));
+    }
 
     ListV<Row> *root() const override { return root_; }
 
+    // Once set, iterators, At() and GetCount() read the decoded column
+    // instead of the rows. The caller keeps `column` alive as long as this.
+    void SetMaterialized(const MaterializedColumn<V> *column) {
+        materialized_ = column;
+    }
+    const MaterializedColumn<V> *materialized() const { return materialized_; }
+
  protected:
     ListV<Row> *root_;
     const uint32_t row_idx_;
     const uint32_t col_idx_;
     const uint32_t offset_;
+    const MaterializedColumn<V> *materialized_;
 };
 
 class StringColumnImpl : public ColumnImpl<StringRef> {
@@ -157,6 +190,71 @@ class StringColumnImpl : public ColumnImpl<StringRef> {
     uint32_t str_start_offset_;
 };
 
+// A window column decoded once into contiguous arrays: row keys, values and
+// one null flag per row. Every aggregate over the same window column shares
+// it, so each row is decoded once rather than once per aggregate.
+template <class V>
+class MaterializedColumn : public base::FeBaseObject {
+ public:
+    explicit MaterializedColumn(const ColumnImpl<V> *column) : size_(0) {
+        ListV<Row> *rows = column->root();
+        uint64_t cnt = rows->GetCount();
+        keys_.reset(new uint64_t[cnt]);
+        values_.reset(new V[cnt]);
+        nulls_.reset(new bool[cnt]);
+        auto iter = rows->GetIterator();
+        if (!iter) {
+            return;
+        }
+        iter->SeekToFirst();
+        while (iter->Valid() && size_ < cnt) {
+            const Row &row = iter->GetValue();
+            keys_[size_] = iter->GetKey();
+            nulls_[size_] = column->IsNull(row);
+            values_[size_] =
+                nulls_[size_] ? V() : column->GetFieldUnsafe(row);
+            size_++;
+            iter->Next();
+        }
+    }
+    ~MaterializedColumn() override {}
+
+    uint64_t size() const { return size_; }
+    const uint64_t *keys() const { return keys_.get(); }
+    const V *values() const { return values_.get(); }
+    const bool *nulls() const { return nulls_.get(); }
+
+ private:
+    uint64_t size_;
+    std::unique_ptr<uint64_t[]> keys_;
+    std::unique_ptr<V[]> values_;
+    std::unique_ptr<bool[]> nulls_;
+};
+
+template <class V>
+class MaterializedColumnIterator : public ConstIterator<uint64_t, V> {
+ public:
+    explicit MaterializedColumnIterator(const MaterializedColumn<V> *column)
+        : ConstIterator<uint64_t, V>(), column_(column), pos_(0) {}
+    ~MaterializedColumnIterator() {}
+    void Seek(const uint64_t &key) override {
+        // keys decrease along the window, same as the row iterator, so the first key not above `key` is found by
+        // binary search
+        const uint64_t *keys = column_->keys();
+        pos_ = std::lower_bound(keys, keys + column_->size(), key, std::greater<uint64_t>()) - keys;
+    }
+    void SeekToFirst() override { pos_ = 0; }
+    bool Valid() const override { return pos_ < column_->size(); }
+    void Next() override { pos_++; }
+    const V &GetValue() override { return column_->values()[pos_]; }
+    const uint64_t &GetKey() const override { return column_->keys()[pos_]; }
+    bool IsSeekable() const override { return true; }
+
+ private:
+    const MaterializedColumn<V> *column_;
+    uint64_t pos_;
+};
+
 template <class V>
 class ArrayListV : public ListV<V> {
  public:
@@ -469,7 +567,7 @@ class ColumnIterator : public ConstIterator<uint64_t, V> {
     ColumnIterator(ListV<Row> *list, const ColumnImpl<V> *column_impl)
         : ConstIterator<uint64_t, V>(), column_impl_(column_impl) {
         row_iter_ = list->GetIterator();
-        if (!row_iter_) {
+        if (row_iter_) {
             row_iter_->SeekToFirst();
         }
     }
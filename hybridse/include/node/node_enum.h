@@ -94,6 +94,7 @@ enum SqlNodeType {
     kCreateFunctionStmt,
     kDynamicUdfFnDef,
     kDynamicUdafFnDef,
+    kDiskOption,
     kUnknow = -1
 };
 
@@ -385,6 +385,8 @@ class NodeManager {
 
     SqlNode *MakePartitionNumNode(int num);
 
+    SqlNode *MakeDiskOptionNode(const std::string &name, int64_t value);
+
     SqlNode *MakeDistributionsNode(SqlNodeList *distribution_list);
 
     SqlNode *MakeCreateProcedureNode(const std::string &sp_name,
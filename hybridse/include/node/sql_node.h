@@ -2697,6 +2697,23 @@ class PartitionNumNode : public SqlNode {
     int partition_num_;
 };
 
+// a rocksdb option of a disk table, e.g. block_size_kb, write_buffer_mb or block_cache_mb
+class DiskOptionNode : public SqlNode {
+ public:
+    DiskOptionNode(const std::string &name, int64_t value) : SqlNode(kDiskOption, 0, 0), name_(name), value_(value) {}
+
+    ~DiskOptionNode() {}
+
+    const std::string &GetName() const { return name_; }
+    int64_t GetValue() const { return value_; }
+
+    void Print(std::ostream &output, const std::string &org_tab) const;
+
+ private:
+    std::string name_;
+    int64_t value_;
+};
+
 class DistributionsNode : public SqlNode {
  public:
     explicit DistributionsNode(SqlNodeList *distribution_list)
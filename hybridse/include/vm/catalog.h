@@ -16,6 +16,7 @@
 
 #ifndef HYBRIDSE_INCLUDE_VM_CATALOG_H_
 #define HYBRIDSE_INCLUDE_VM_CATALOG_H_
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
@@ -59,6 +60,9 @@ typedef ::google::protobuf::RepeatedPtrField<::hybridse::type::IndexDef>
 typedef std::map<std::string, ColInfo> Types;
 /// \typedef IndexHint a map with string type key and IndexSt value
 typedef std::map<std::string, IndexSt> IndexHint;
+/// \typedef RowPredicate a filter condition over rows, which a table may
+/// evaluate inside its storage
+typedef std::function<bool(const Row&)> RowPredicate;
 
 class PartitionHandler;
 class TableHandler;
@@ -231,6 +235,30 @@ class TableHandler : public DataHandler {
     /// Return HandlerType::kTableHandler by default
     const HandlerType GetHandlerType() override { return kTableHandler; }
 
+    /// Return the iterator of rows satisfying `predicate`, so that the table
+    /// can drop rows inside its storage before materializing them.
+    /// Return `null` by default, the predicate can't be pushed down.
+    virtual std::unique_ptr<RowIterator> GetFilterIterator(const RowPredicate& predicate) {
+        return std::unique_ptr<RowIterator>();
+    }
+
+    /// Return the iterator of rows where only the columns at `columns` are
+    /// required. The rows keep the table schema and the other columns may be
+    /// read as null, so that the table can skip fetching them.
+    /// Return `null` by default, the projection can't be pushed down.
+    virtual std::unique_ptr<RowIterator> GetProjectIterator(
+        const std::vector<uint32_t>& columns) {
+        return std::unique_ptr<RowIterator>();
+    }
+
+    /// Return the window iterator of given index where only the columns at
+    /// `columns` are required, see GetProjectIterator().
+    /// Return `null` by default.
+    virtual std::unique_ptr<WindowIterator> GetProjectWindowIterator(
+        const std::string& idx_name, const std::vector<uint32_t>& columns) {
+        return std::unique_ptr<WindowIterator>();
+    }
+
     /// Return partition handler of specify partition binding to given index.
     /// Return `null` by default.
     virtual std::shared_ptr<PartitionHandler> GetPartition(
@@ -357,6 +385,14 @@ class PartitionHandler : public TableHandler {
     /// segment-by-segment.
     virtual std::unique_ptr<WindowIterator> GetWindowIterator() = 0;
 
+    /// Return WindowIterator where only the columns at `columns` are
+    /// required, see TableHandler::GetProjectIterator().
+    /// Return `null` by default.
+    virtual std::unique_ptr<WindowIterator> GetProjectWindowIterator(
+        const std::vector<uint32_t>& columns) {
+        return std::unique_ptr<WindowIterator>();
+    }
+
     /// Return HandlerType::kPartitionHandler by default
     const HandlerType GetHandlerType() override { return kPartitionHandler; }
 
@@ -17,6 +17,9 @@
 #ifndef HYBRIDSE_INCLUDE_VM_ENGINE_H_
 #define HYBRIDSE_INCLUDE_VM_ENGINE_H_
 
+#include <array>
+#include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>  //NOLINT
@@ -39,6 +42,9 @@
 namespace hybridse {
 namespace vm {
 
+class HybridSeJitSession;
+class RunnerContext;
+
 using ::hybridse::codec::Row;
 
 inline constexpr const char* LONG_WINDOWS = "long_windows";
@@ -136,6 +142,40 @@ class EngineOptions {
     JitOptions jit_options_;
 };
 
+/// \brief Runtime statistics of a runner, summed over the profiled runs.
+struct RunnerProfile {
+    std::string runner_type;     ///< The type name of the runner
+    uint64_t run_cnt = 0;        ///< The number of times the runner was run
+    uint64_t self_time_us = 0;   ///< Wall time of the runner excluding its producers
+    uint64_t total_time_us = 0;  ///< Wall time of the runner including its producers
+    uint64_t rows_out = 0;       ///< The number of rows the runner output in the counted runs
+    uint64_t uncounted_cnt = 0;  ///< The number of runs whose output is lazy or remote and not counted
+};
+
+/// \brief Per runner runtime profile of one or more runs of a query, keyed by runner id.
+class RunProfile {
+ public:
+    RunProfile() : run_cnt_(0), runners_() {}
+    ~RunProfile() {}
+
+    /// Add the statistics of one run of a runner, `rows_counted` is false if the rows of its output are unknown
+    void Add(int32_t runner_id, const std::string& runner_type, uint64_t self_time_us, uint64_t total_time_us,
+             uint64_t rows_out, bool rows_counted = true);
+    /// Add all statistics of `other` into this profile
+    void Merge(const RunProfile& other);
+    /// Count one profiled run of the query
+    void AddRun() { run_cnt_++; }
+    /// Return the number of profiled runs of the query
+    uint64_t GetRunCnt() const { return run_cnt_; }
+    /// Return the statistics of the runner with `runner_id`, null if the runner was never run
+    const RunnerProfile* GetRunner(int32_t runner_id) const;
+    const std::map<int32_t, RunnerProfile>& GetRunners() const { return runners_; }
+
+ private:
+    uint64_t run_cnt_;
+    std::map<int32_t, RunnerProfile> runners_;
+};
+
 /// \brief A RunSession maintain SQL running context, including compile information, procedure name.
 ///
 class RunSession {
@@ -170,6 +210,16 @@ class RunSession {
     /// Return if this run session support printing debug information.
     bool IsDebug() { return is_debug_; }
 
+    /// \brief Collect the runtime profile of every runner into `profile` while running a query.
+    ///
+    /// Profiling measures the time and output rows of each runner, so only enable it for sampled runs.
+    /// Request and batch runs are profiled. Set `nullptr` to disable it.
+    void SetProfile(const std::shared_ptr<RunProfile>& profile) { profile_ = profile; }
+    /// Return the runtime profile bound to this run session, null if profiling is disabled.
+    const std::shared_ptr<RunProfile>& GetProfile() const { return profile_; }
+    /// \brief Print the plan of the tasks run by this session, each runner annotated with its runtime profile.
+    void PrintProfile(std::ostream& output, const std::string& tab) const;
+
     /// Bind this run session with specific procedure
     void SetSpName(const std::string& sp_name) { sp_name_ = sp_name; }
     /// Return the engine mode of this run session
@@ -189,9 +239,38 @@ class RunSession {
     bool is_debug_;
     std::string sp_name_;
     std::shared_ptr<const std::unordered_map<std::string, std::string>> options_ = nullptr;
+    std::shared_ptr<RunProfile> profile_ = nullptr;
     friend Engine;
 };
 
+/// \brief The result rows of a batch query, produced as the cursor advances.
+///
+/// A cursor keeps the compiled sql and the run context of its query alive, so the result can be consumed
+/// after BatchRunSession::Run returned, e.g. in chunks over several requests. It must not be used by two threads
+/// at the same time.
+class BatchRunCursor {
+ public:
+    ~BatchRunCursor();
+    /// Return if the cursor points to a result row
+    bool Valid() const;
+    /// Return the result row the cursor points to
+    const Row& GetValue();
+    /// Move the cursor to the next result row
+    void Next();
+
+ private:
+    BatchRunCursor();
+    // members are released in reverse order, the iterator and the output before the context they run in
+    std::shared_ptr<CompileInfo> compile_info_;
+    std::shared_ptr<RunProfile> profile_;
+    std::unique_ptr<RunnerContext> ctx_;
+    std::shared_ptr<DataHandler> output_;
+    std::unique_ptr<RowIterator> iter_;
+    Row row_;
+    bool row_valid_;
+    friend class BatchRunSession;
+};
+
 /// \brief BatchRunSession is a kind of RunSession designed for batch mode query.
 class BatchRunSession : public RunSession {
  public:
@@ -207,6 +286,20 @@ class BatchRunSession : public RunSession {
     /// Query results will be returned as std::vector<Row> in output
     int32_t Run(std::vector<Row>& output,  // NOLINT
                 uint64_t limit = 0);
+
+    /// \brief Query sql with parameter row in batch mode, passing each result row to `consumer`
+    /// as the result is iterated, so that the rows need not be collected first.
+    ///
+    /// The iteration stops early if `consumer` returns `false`.
+    /// \return `0` if run successfully else negative integer
+    int32_t Run(const Row& parameter_row, const std::function<bool(const Row&)>& consumer,
+                uint64_t limit = 0);
+
+    /// \brief Query sql with parameter row in batch mode, returning a cursor over the result rows in `cursor`.
+    ///
+    /// The rows are produced as the cursor advances, so a caller can stop or pause at any row.
+    /// \return `0` if run successfully else negative integer
+    int32_t Run(const Row& parameter_row, std::unique_ptr<BatchRunCursor>* cursor);
     /// Bing the run session with specific parameter schema
     void SetParameterSchema(const codec::Schema& schema) { parameter_schema_ = schema; }
     /// Return query parameter schema.
@@ -331,6 +424,18 @@ struct ExplainOutput {
 };
 
 
+/// \brief Statistics of the compiling result cache of an engine.
+struct EngineCacheStats {
+    uint64_t hit_cnt = 0;   ///< The number of queries served by the cache
+    uint64_t miss_cnt = 0;  ///< The number of queries compiled on a miss
+
+    /// Return the ratio of queries served by the cache
+    double HitRate() const {
+        uint64_t total = hit_cnt + miss_cnt;
+        return total == 0 ? 0 : static_cast<double>(hit_cnt) / total;
+    }
+};
+
 /// \brief An engine is responsible to compile SQL on the specific Catalog.
 ///
 /// An engine can be used to `compile sql and explain the compiling result.
@@ -418,6 +523,21 @@ class Engine {
     /// \brief Get engine's options
     EngineOptions GetEngineOptions();
 
+    /// \brief Get the hit and miss counts of engine's compiling result cache
+    EngineCacheStats GetCacheStats() const;
+
+    /// \brief Return the cache key of sql.
+    ///
+    /// Whitespace outside quotes and the trailing `;` are normalized, so sql that differ only in
+    /// formatting share one compiling result. Sql with comments are used as they are.
+    static std::string GetSqlFingerprint(const std::string& sql);
+
+    /// \brief Retire the jit sessions of all engines.
+    ///
+    /// The udf library sessions resolve symbols from is shared by the whole process, so a udf change
+    /// makes every engine compile new sql into a new session.
+    static void ResetJitSession();
+
  private:
     bool GetDependentTables(const node::PlanNode* node, const std::string& default_db,
                             std::set<std::pair<std::string, std::string>>* db_tables, base::Status& status);  // NOLINT
@@ -436,10 +556,29 @@ class Engine {
                  EngineMode engine_mode, const codec::Schema& parameter_schema,
                  const std::set<size_t>& common_column_indices,
                  ExplainOutput* explain_output, base::Status* status);
+
+    // Return the jit session new sql are compiled into, a full session is
+    // replaced by a new one. Return null if the shared jit is disabled
+    std::shared_ptr<HybridSeJitSession> GetJitSession();
+
+    // the compiling result cache is sharded by db and sql, so one hot db does not serialize
+    // on one lock, each shard keeps an lru of its part of `max_sql_cache_size` per db
+    struct CacheShard {
+        base::SpinMutex mu;
+        EngineLRUCache lru_cache;
+    };
+    static constexpr size_t CACHE_SHARD_NUM = 16;
+    size_t GetCacheShardNum() const;
+    CacheShard& GetCacheShard(const std::string& db, const std::string& sql);
+
     std::shared_ptr<Catalog> cl_;
     EngineOptions options_;
-    base::SpinMutex mu_;
-    EngineLRUCache lru_cache_;
+    std::array<CacheShard, CACHE_SHARD_NUM> cache_shards_;
+    std::atomic<uint64_t> cache_hit_cnt_;
+    std::atomic<uint64_t> cache_miss_cnt_;
+    std::mutex jit_mu_;
+    std::shared_ptr<HybridSeJitSession> jit_session_;
+    uint64_t jit_session_epoch_ = 0;
 };
 
 /// \brief Local tablet is responsible to run a task locally.
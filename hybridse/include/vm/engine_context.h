@@ -101,11 +101,17 @@ class JitOptions {
     bool IsEnablePerf() const { return enable_perf_; }
     void SetEnablePerf(bool flag) { enable_perf_ = flag; }
 
+    /// Optimize with O3, inlining and vectorization for the host cpu,
+    /// which compiles slower. Used to recompile hot deployments.
+    bool IsEnableAggressiveOpt() const { return enable_aggressive_opt_; }
+    void SetEnableAggressiveOpt(bool flag) { enable_aggressive_opt_ = flag; }
+
  private:
     bool enable_mcjit_ = false;
     bool enable_vtune_ = false;
     bool enable_gdb_ = false;
     bool enable_perf_ = false;
+    bool enable_aggressive_opt_ = false;
 };
 }  // namespace vm
 }  // namespace hybridse
@@ -108,6 +108,7 @@ class FnInfo {
         frames_.clear();
         schemas_ctx_ = nullptr;
         fn_ptr_ = nullptr;
+        batch_fn_ptr_ = nullptr;
     }
 
     const node::FrameNode *GetFrame(size_t idx) const {
@@ -123,6 +124,9 @@ class FnInfo {
     const int8_t *fn_ptr() const { return fn_ptr_; }
     void SetFnPtr(const int8_t *fn) { fn_ptr_ = fn; }
 
+    const int8_t *batch_fn_ptr() const { return batch_fn_ptr_; }
+    void SetBatchFnPtr(const int8_t *fn) { batch_fn_ptr_ = fn; }
+
  private:
     std::string fn_name_ = "";
     vm::Schema fn_schema_;
@@ -139,6 +143,9 @@ class FnInfo {
 
     // function ptr
     const int8_t *fn_ptr_ = nullptr;
+
+    // batch entry ptr of the function, null if not built
+    const int8_t *batch_fn_ptr_ = nullptr;
 };
 
 class FnComponent {
@@ -681,6 +688,9 @@ class PhysicalProjectNode : public PhysicalUnaryNode {
                                  PhysicalOpNode **out) override;
 
     const ColumnProjects &project() const { return project_; }
+    // row and table projects run their function over many rows,
+    // the function gets a batch entry projecting an array of rows in one call
+    bool HasBatchEntry() const { return kRowProject == project_type_ || kTableProject == project_type_; }
     const ProjectType project_type_;
 
  protected:
@@ -293,6 +293,12 @@ class RowParser {
     bool IsNull(const Row& row, const node::ColumnRefNode& col) const;
     bool IsNull(const Row& row, const std::string& col) const;
 
+    // resolve the column once, then access rows by the resolved index without name lookup
+    bool GetColumnIndex(const std::string& col, size_t* schema_idx, size_t* col_idx) const;
+    bool IsNull(const Row& row, size_t schema_idx, size_t col_idx) const;
+    int32_t GetValue(const Row& row, size_t schema_idx, size_t col_idx, type::Type type, void* val) const;
+    int32_t GetString(const Row& row, size_t schema_idx, size_t col_idx, std::string* val) const;
+
     const SchemasContext* schema_ctx() const {
         return schema_ctx_;
     }
@@ -23,9 +23,7 @@ RefCountedSlice::~RefCountedSlice() { Release(); }
 
 void RefCountedSlice::Release() {
     if (this->ref_cnt_ != nullptr) {
-        auto& cnt = *this->ref_cnt_;
-        cnt -= 1;
-        if (cnt == 0) {
+        if (this->ref_cnt_->fetch_sub(1, std::memory_order_acq_rel) == 1) {
             free(buf());
             delete this->ref_cnt_;
         }
@@ -36,7 +34,7 @@ void RefCountedSlice::Update(const RefCountedSlice& slice) {
     reset(slice.data(), slice.size());
     this->ref_cnt_ = slice.ref_cnt_;
     if (this->ref_cnt_ != nullptr) {
-        (*this->ref_cnt_) += 1;
+        this->ref_cnt_->fetch_add(1, std::memory_order_relaxed);
     }
 }
 
@@ -25,6 +25,10 @@ static void BM_MemSumColInt(benchmark::State& state) {  // NOLINT
     SumMemTableCol(&state, BENCHMARK, state.range(0), "col1");
 }
 
+static void BM_MemSumColIntVectorized(benchmark::State& state) {  // NOLINT
+    SumMemTableCol(&state, BENCHMARK, state.range(0), "col1", true);
+}
+
 static void BM_MemSumColDouble(benchmark::State& state) {  // NOLINT
     SumMemTableCol(&state, BENCHMARK, state.range(0), "col4");
 }
@@ -37,6 +41,10 @@ static void BM_ArraySumColInt(benchmark::State& state) {  // NOLINT
     SumArrayListCol(&state, BENCHMARK, state.range(0), "col1");
 }
 
+static void BM_ArraySumColIntVectorized(benchmark::State& state) {  // NOLINT
+    SumArrayListCol(&state, BENCHMARK, state.range(0), "col1", true);
+}
+
 static void BM_ArraySumColDouble(benchmark::State& state) {  // NOLINT
     SumArrayListCol(&state, BENCHMARK, state.range(0), "col4");
 }
@@ -118,6 +126,11 @@ BENCHMARK(BM_ArraySumColInt)
     ->Args({100})
     ->Args({1000})
     ->Args({10000});
+BENCHMARK(BM_ArraySumColIntVectorized)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
 BENCHMARK(BM_ArraySumColDouble)
     ->Args({10})
     ->Args({100})
@@ -134,6 +147,11 @@ BENCHMARK(BM_MemSumColInt)
     ->Args({100})
     ->Args({1000})
     ->Args({10000});
+BENCHMARK(BM_MemSumColIntVectorized)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
 
 BENCHMARK(BM_MemSumColDouble)
     ->Args({10})
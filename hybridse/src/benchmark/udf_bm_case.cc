@@ -23,11 +23,15 @@
 #include "codec/type_codec.h"
 #include "codegen/ir_base_builder.h"
 #include "codegen/window_ir_builder.h"
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "udf/udf.h"
 #include "udf/udf_test.h"
 #include "vm/jit_runtime.h"
 #include "vm/mem_catalog.h"
+
+DECLARE_bool(enable_window_column_materialize);
+
 namespace hybridse {
 namespace bm {
 using codec::ColumnImpl;
@@ -155,8 +159,67 @@ auto CreateSumFunc() {
         .build();
 }
 
+// Sum the column with the udaf compiled for materialized window columns. The
+// column is decoded into contiguous arrays and summed by the vectorized kernel.
+// It is rebuilt and decoded in every run, as a new window would be.
+template <typename V>
+void SumColVectorized(benchmark::State* state, MODE mode, int8_t* list_ref,
+                      const codec::ColInfo* info, int8_t* buf) {
+    auto sum = [] {
+        gflags::FlagSaver flag_saver;
+        FLAGS_enable_window_column_materialize = true;
+        return CreateSumFunc<V>();
+    }();
+    ::hybridse::codec::ListRef<V> col_ref({buf});
+    auto run = [&]() {
+        ::hybridse::codec::v1::GetCol(list_ref, 0, info->idx, info->offset,
+                                      info->type, buf);
+        V res = sum(col_ref);
+        vm::JitRuntime::get()->ReleaseRunStep();
+        return res;
+    };
+    switch (mode) {
+        case BENCHMARK: {
+            for (auto _ : *state) {
+                benchmark::DoNotOptimize(run());
+            }
+            break;
+        }
+        case TEST: {
+            if (run() <= 0) {
+                FAIL();
+            }
+            break;
+        }
+    }
+}
+
+void DoSumColVectorized(int8_t* list_ref, const codec::ColInfo* info,
+                        benchmark::State* state, MODE mode) {
+    node::TypeNode type;
+    ASSERT_TRUE(codegen::SchemaType2DataType(info->type, &type));
+
+    uint32_t col_size;
+    ASSERT_TRUE(codegen::GetLlvmColumnSize(&type, &col_size));
+
+    int8_t* buf = reinterpret_cast<int8_t*>(alloca(col_size));
+    switch (type.base_) {
+        case node::kInt32: {
+            SumColVectorized<int32_t>(state, mode, list_ref, info, buf);
+            break;
+        }
+        case node::kInt64: {
+            SumColVectorized<int64_t>(state, mode, list_ref, info, buf);
+            break;
+        }
+        default: {
+            FAIL();
+        }
+    }
+}
+
 void SumArrayListCol(benchmark::State* state, MODE mode, int64_t data_size,
-                     const std::string& col_name) {
+                     const std::string& col_name, bool materialize) {
     vm::MemTimeTableHandler window;
     type::TableDef table_def;
     BuildData(table_def, window, data_size);
@@ -181,6 +244,11 @@ void SumArrayListCol(benchmark::State* state, MODE mode, int64_t data_size,
             .isOK());
     const codec::ColInfo* info =
         schemas_context.GetRowFormat(schema_idx)->GetColumnInfo(col_idx);
+    if (materialize) {
+        DoSumColVectorized(reinterpret_cast<int8_t*>(&list_table_ref), info,
+                           state, mode);
+        return;
+    }
 
     codegen::MemoryWindowDecodeIRBuilder builder(&schemas_context, nullptr);
     node::TypeNode type;
@@ -280,7 +348,8 @@ void SumArrayListCol(benchmark::State* state, MODE mode, int64_t data_size,
 }
 
 void DoSumTableCol(vm::TableHandler* window, benchmark::State* state, MODE mode,
-                   int64_t data_size, const std::string& col_name) {
+                   int64_t data_size, const std::string& col_name,
+                   bool materialize = false) {
     vm::SchemasContext schemas_context;
     schemas_context.BuildTrivial(window->GetDatabase(), {window->GetSchema()});
     codegen::MemoryWindowDecodeIRBuilder builder(&schemas_context, nullptr);
@@ -294,6 +363,13 @@ void DoSumTableCol(vm::TableHandler* window, benchmark::State* state, MODE mode,
 
     const codec::ColInfo* info =
         schemas_context.GetRowFormat(schema_idx)->GetColumnInfo(col_idx);
+    if (materialize) {
+        codec::ListRef<> window_ref;
+        window_ref.list = reinterpret_cast<int8_t*>(window);
+        DoSumColVectorized(reinterpret_cast<int8_t*>(&window_ref), info, state,
+                           mode);
+        return;
+    }
 
     node::TypeNode type;
     ASSERT_TRUE(codegen::SchemaType2DataType(info->type, &type));
@@ -392,7 +468,7 @@ void DoSumTableCol(vm::TableHandler* window, benchmark::State* state, MODE mode,
 }
 
 void SumMemTableCol(benchmark::State* state, MODE mode, int64_t data_size,
-                    const std::string& col_name) {
+                    const std::string& col_name, bool materialize) {
     type::TableDef table_def;
     std::vector<Row> buffer;
     CaseDataMock::BuildOnePkTableData(table_def, buffer, data_size);
@@ -400,7 +476,7 @@ void SumMemTableCol(benchmark::State* state, MODE mode, int64_t data_size,
     for (int i = 0; i < data_size - 1; ++i) {
         window.AddRow(buffer[i]);
     }
-    DoSumTableCol(&window, state, mode, data_size, col_name);
+    DoSumTableCol(&window, state, mode, data_size, col_name, materialize);
 }
 
 void SumRequestUnionTableCol(benchmark::State* state, MODE mode,
@@ -22,12 +22,14 @@
 namespace hybridse {
 namespace bm {
 enum MODE { BENCHMARK, TEST };
+// `materialize` sums a materialized integer window column with the vectorized
+// kernel
 void SumMemTableCol(benchmark::State* state, MODE mode, int64_t data_size,
-                    const std::string& col_name);
+                    const std::string& col_name, bool materialize = false);
 void SumRequestUnionTableCol(benchmark::State* state, MODE mode,
                              int64_t data_size, const std::string& col_name);
 void SumArrayListCol(benchmark::State* state, MODE mode, int64_t data_size,
-                     const std::string& col_name);
+                     const std::string& col_name, bool materialize = false);
 void CopyMemTable(benchmark::State* state, MODE mode, int64_t data_size);
 void CopyMemSegment(benchmark::State* state, MODE mode, int64_t data_size);
 void CopyArrayList(benchmark::State* state, MODE mode, int64_t data_size);
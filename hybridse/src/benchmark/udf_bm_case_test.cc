@@ -38,6 +38,13 @@ TEST_F(UdfBMCaseTest, SumMemTableCol1_TEST) {
     SumMemTableCol(nullptr, TEST, 10000L, "col1");
 }
 
+TEST_F(UdfBMCaseTest, SumColVectorized_TEST) {
+    SumArrayListCol(nullptr, TEST, 10L, "col1", true);
+    SumArrayListCol(nullptr, TEST, 10000L, "col1", true);
+    SumMemTableCol(nullptr, TEST, 10L, "col1", true);
+    SumMemTableCol(nullptr, TEST, 10000L, "col1", true);
+}
+
 TEST_F(UdfBMCaseTest, SumRequestUnionTableCol1_TEST) {
     SumRequestUnionTableCol(nullptr, TEST, 10L, "col1");
     SumRequestUnionTableCol(nullptr, TEST, 100L, "col1");
@@ -153,6 +153,68 @@ Status RowFnLetIRBuilder::Build(
     return Status::OK();
 }
 
+Status RowFnLetIRBuilder::BuildBatch(const std::string& name) {
+    ::llvm::Module* module = ctx_->GetModule();
+    ::llvm::Function* row_fn = module->getFunction(name);
+    CHECK_TRUE(row_fn != nullptr, kCodegenError, "function ", name, " not exists");
+    const std::string batch_name = GetBatchFnName(name);
+    CHECK_TRUE(module->getFunction(batch_name) == nullptr, kCodegenError, "function ", batch_name, " already exists");
+
+    auto int8_ptr_ty = ::llvm::Type::getInt8PtrTy(module->getContext());
+    std::vector<::llvm::Type*> args_llvm_type;
+    args_llvm_type.push_back(::llvm::Type::getInt64Ty(module->getContext()));
+    args_llvm_type.push_back(int8_ptr_ty->getPointerTo());
+    args_llvm_type.push_back(int8_ptr_ty);
+    args_llvm_type.push_back(int8_ptr_ty->getPointerTo());
+    args_llvm_type.push_back(::llvm::Type::getInt32PtrTy(module->getContext()));
+
+    ::llvm::Function* fn = nullptr;
+    bool ok = BuildFnHeader(batch_name, args_llvm_type, ::llvm::Type::getInt32Ty(module->getContext()), &fn);
+    CHECK_TRUE(ok && fn != nullptr, kCodegenError, "Fail to build fn header for name ", batch_name);
+
+    FunctionScopeGuard fn_guard(fn, ctx_);
+    auto arg_iter = fn->arg_begin();
+    ::llvm::Value* cnt = &*arg_iter++;
+    ::llvm::Value* rows = &*arg_iter++;
+    ::llvm::Value* parameter = &*arg_iter++;
+    ::llvm::Value* outputs = &*arg_iter++;
+    ::llvm::Value* rets = &*arg_iter++;
+
+    auto builder = ctx_->GetBuilder();
+    ::llvm::Value* idx_ptr = CreateAllocaAtHead(builder, builder->getInt64Ty(), "idx_alloca");
+    ::llvm::Value* fail_cnt_ptr = CreateAllocaAtHead(builder, builder->getInt32Ty(), "fail_cnt_alloca");
+    builder->CreateStore(builder->getInt64(0), idx_ptr);
+    builder->CreateStore(builder->getInt32(0), fail_cnt_ptr);
+
+    // a failed row does not stop the others, its status is kept in rets
+    CHECK_STATUS(ctx_->CreateWhile(
+        [&](::llvm::Value** has_next) {
+            *has_next = builder->CreateICmpSLT(builder->CreateLoad(idx_ptr), cnt);
+            return Status::OK();
+        },
+        [&]() {
+            ::llvm::Value* idx = builder->CreateLoad(idx_ptr);
+            ::llvm::Value* row = builder->CreateLoad(builder->CreateInBoundsGEP(rows, idx));
+            ::llvm::Value* output = builder->CreateInBoundsGEP(outputs, idx);
+            auto call = builder->CreateCall(
+                row_fn, {builder->getInt64(0), row, ::llvm::ConstantPointerNull::get(int8_ptr_ty), parameter, output});
+            // inline the row function, so that the work invariant across rows can be hoisted out of the loop
+            call->addAttribute(::llvm::AttributeList::FunctionIndex, ::llvm::Attribute::AlwaysInline);
+            builder->CreateStore(call, builder->CreateInBoundsGEP(rets, idx));
+            ::llvm::Value* failed = builder->CreateZExt(builder->CreateICmpNE(call, builder->getInt32(0)),
+                                                        builder->getInt32Ty());
+            builder->CreateStore(builder->CreateAdd(builder->CreateLoad(fail_cnt_ptr), failed), fail_cnt_ptr);
+            builder->CreateStore(builder->CreateAdd(idx, builder->getInt64(1)), idx_ptr);
+            return Status::OK();
+        }));
+    builder->CreateRet(builder->CreateLoad(fail_cnt_ptr));
+
+    auto root_scope = ctx_->GetCurrentScope();
+    root_scope->blocks()->DropEmptyBlocks();
+    root_scope->blocks()->ReInsertTo(fn);
+    return Status::OK();
+}
+
 base::Status RowFnLetIRBuilder::EncodeBuf(
     const std::map<uint32_t, NativeValue>* values, const vm::Schema& schema,
     VariableIRBuilder& variable_ir_builder,  // NOLINT (runtime/references)
@@ -45,6 +45,14 @@ class RowFnLetIRBuilder {
                  const std::vector<const node::FrameNode*>& project_frames,
                  const vm::Schema& output_schema);
 
+    // Build `name`_batch, projecting an array of rows with the row function
+    // `name` in one call:
+    // int32_t (int64_t cnt, int8_t** rows, int8_t* parameter, int8_t** outputs, int32_t* rets)
+    // rets[i] is the return code of row i, and the number of failed rows is returned
+    Status BuildBatch(const std::string& name);
+
+    static const std::string GetBatchFnName(const std::string& name) { return name + "_batch"; }
+
  private:
     bool BuildFnHeader(const std::string& name,
                        const std::vector<::llvm::Type*>& args_type,
@@ -134,6 +134,10 @@ void CheckFnLetBuilderWithParameterRow(::hybridse::node::NodeManager* manager,
                       fn_info.GetFrames(), *fn_info.fn_schema());
     LOG(INFO) << "fn let ir build status: " << status;
     ASSERT_TRUE(status.isOK());
+    if (!is_agg) {
+        status = builder.BuildBatch("test_at_fn");
+        ASSERT_TRUE(status.isOK()) << status;
+    }
     *output_schema = *fn_info.fn_schema();
 
     m->print(::llvm::errs(), NULL);
@@ -149,6 +153,28 @@ void CheckFnLetBuilderWithParameterRow(::hybridse::node::NodeManager* manager,
         (int32_t(*)(int64_t, int8_t*, int8_t*, int8_t*, int8_t**))address;
     int32_t ret2 = decode(0, row_ptr, window_ptr, parameter_row_ptr, output);
     ASSERT_EQ(0, ret2);
+
+    if (!is_agg) {
+        // the batch entry projects every row the same as the row function
+        auto batch_address = jit->FindFunction(RowFnLetIRBuilder::GetBatchFnName("test_at_fn"));
+        ASSERT_TRUE(batch_address != nullptr);
+        auto batch_decode = reinterpret_cast<int32_t (*)(int64_t, int8_t**, int8_t*, int8_t**, int32_t*)>(
+            const_cast<int8_t*>(batch_address));
+        std::vector<int8_t*> rows = {row_ptr, row_ptr, row_ptr};
+        std::vector<int8_t*> outputs(rows.size(), nullptr);
+        std::vector<int32_t> rets(rows.size(), -1);
+        ASSERT_EQ(0, batch_decode(rows.size(), rows.data(), parameter_row_ptr, outputs.data(), rets.data()));
+        uint32_t output_size = codec::RowView::GetSize(*output);
+        for (auto ret : rets) {
+            ASSERT_EQ(0, ret);
+        }
+        for (auto batch_output : outputs) {
+            ASSERT_TRUE(batch_output != nullptr);
+            ASSERT_EQ(output_size, codec::RowView::GetSize(batch_output));
+            ASSERT_EQ(0, memcmp(*output, batch_output, output_size));
+            free(batch_output);
+        }
+    }
 }
 void CheckFnLetBuilderWithParameterRow(::hybridse::node::NodeManager* manager,
                                        type::TableDef& table, // NOLINT
@@ -16,6 +16,8 @@
 
 #include "codegen/udf_ir_builder.h"
 #include <iostream>
+#include <set>
+#include <string>
 #include <utility>
 #include <vector>
 #include "codegen/context.h"
@@ -24,6 +26,7 @@
 #include "codegen/list_ir_builder.h"
 #include "codegen/null_ir_builder.h"
 #include "codegen/timestamp_ir_builder.h"
+#include "gflags/gflags.h"
 #include "llvm/IR/Attributes.h"
 #include "node/node_manager.h"
 #include "node/sql_node.h"
@@ -32,6 +35,8 @@
 
 using ::hybridse::common::kCodegenError;
 
+DECLARE_bool(enable_window_column_materialize);
+
 namespace hybridse {
 namespace codegen {
 
@@ -535,9 +540,63 @@ Status UdfIRBuilder::BuildDynamicUdfCall(
     return BuildLlvmCall(fn, callee, arg_types, arg_nullable, new_args, fn->return_by_arg(), output);
 }
 
+// Built-in udafs with a vectorized kernel over an integer list, see
+// udf::v1::vectorized_sum and the others. Floating point lists keep the
+// iterator udaf, since the kernels add them in lanes and the rounding would
+// differ from the sequential sum.
+static bool IsVectorizedUdaf(const node::UdafDefNode* fn) {
+    static const std::set<std::string> kVectorizedUdafs = {"sum", "min", "max", "count", "avg"};
+    if (fn->GetArgSize() != 1 || fn->IsElementNullable(0) || kVectorizedUdafs.count(fn->GetName()) == 0) {
+        return false;
+    }
+    auto elem_type = fn->GetElementType(0);
+    if (elem_type == nullptr) {
+        return false;
+    }
+    switch (elem_type->base()) {
+        case node::kInt16:
+        case node::kInt32:
+        case node::kInt64:
+            return true;
+        default:
+            return false;
+    }
+}
+
+Status UdfIRBuilder::BuildVectorizedUdafCall(
+    const node::UdafDefNode* fn,
+    const std::vector<NativeValue>& args, NativeValue* output) {
+    CHECK_TRUE(args.size() == 1, kCodegenError, "Vectorized udaf expects one list argument");
+    ::llvm::IRBuilder<>* builder = ctx_->GetBuilder();
+    ::llvm::Value* list_ptr = args[0].GetValue(ctx_);
+
+    ::llvm::Type* ret_ty = nullptr;
+    CHECK_TRUE(GetLlvmType(ctx_->GetModule(), fn->GetReturnType(), &ret_ty), kCodegenError,
+               "Fail to get llvm type for " + fn->GetReturnType()->GetName());
+    ::llvm::Type* bool_ty = builder->getInt1Ty();
+    std::string fn_name = "vectorized_" + fn->GetName() + "." + fn->GetElementType(0)->GetName();
+    ::llvm::FunctionCallee callee = ctx_->GetModule()->getOrInsertFunction(
+        fn_name, builder->getVoidTy(), list_ptr->getType(), ret_ty->getPointerTo(), bool_ty->getPointerTo());
+
+    ::llvm::Value* ret_alloca = CreateAllocaAtHead(builder, ret_ty, "vectorized_udaf_ret");
+    ::llvm::Value* null_alloca = CreateAllocaAtHead(builder, bool_ty, "vectorized_udaf_is_null");
+    builder->CreateCall(callee, {list_ptr, ret_alloca, null_alloca});
+    ::llvm::Value* ret = builder->CreateLoad(ret_alloca);
+    if (fn->GetName() == "count") {
+        *output = NativeValue::Create(ret);
+    } else {
+        *output = NativeValue::CreateWithFlag(ret, builder->CreateLoad(null_alloca));
+    }
+    return Status::OK();
+}
+
 Status UdfIRBuilder::BuildUdafCall(
     const node::UdafDefNode* fn,
     const std::vector<NativeValue>& args, NativeValue* output) {
+    // materialized window columns are aggregated by the vectorized kernels
+    if (FLAGS_enable_window_column_materialize && IsVectorizedUdaf(fn)) {
+        return BuildVectorizedUdafCall(fn, args, output);
+    }
     // udaf state type
     const node::TypeNode* state_type = fn->GetStateType();
     CHECK_TRUE(state_type != nullptr, kCodegenError, "Missing state type");
@@ -70,6 +70,10 @@ class UdfIRBuilder {
                         ::llvm::FunctionCallee* callee, bool* return_by_arg);
 
  private:
+    Status BuildVectorizedUdafCall(const node::UdafDefNode* fn,
+                                   const std::vector<NativeValue>& args,
+                                   NativeValue* output);
+
     Status ExpandLlvmCallArgs(const node::TypeNode* dtype, bool nullable,
                               const NativeValue& value,
                               ::llvm::IRBuilder<>* builder,
@@ -22,3 +22,44 @@ DEFINE_string(default_db_name, "_hybridse",
 // Offline Spark config
 DEFINE_bool(enable_spark_unsaferow_format, false,
             "config if codec uses Spark UnsafeRow format");
+
+// batch runner config
+DEFINE_uint32(batch_runner_parallelism, 1,
+              "config the number of threads a batch window/group aggregation or table project runner uses");
+DEFINE_bool(enable_batch_project, true,
+            "config if table and row project runners project rows in batches by the batch entries of functions");
+DEFINE_bool(enable_hash_last_join, true,
+            "config if a batch last join groups the right rows by the join key and sorts them once, instead "
+            "of sorting the right segment for every left row");
+DEFINE_uint32(batch_request_seek_parallelism, 1,
+              "config the number of threads a batch request union uses to seek the window segments of all its "
+              "request rows, so that the reads of a disk table are issued concurrently");
+
+// window column config
+DEFINE_bool(enable_window_column_materialize, false,
+            "config if a window column is decoded once into contiguous arrays shared by all its aggregates");
+
+// jit config
+DEFINE_bool(enable_shared_jit, true,
+            "config if an engine compiles all sql into child dylibs of one long-lived jit session, so that "
+            "the builtin symbols are registered once instead of once per sql");
+DEFINE_uint32(jit_session_max_dylibs, 1024,
+              "config the number of sql compiled in a shared jit session before it is replaced, the code "
+              "memory of a session is freed only when all its compiled sql are evicted");
+DEFINE_string(jit_object_cache_dir, "",
+              "config the dir the object code of compiled deployments is cached in, so that deployments "
+              "skip ir optimization and machine code generation after restart. empty to disable");
+DEFINE_uint32(jit_object_cache_max_size_mb, 1024,
+              "config the max size of the jit object cache dir in MB, the least recently used objects are "
+              "removed once it is exceeded. 0 for no limit");
+
+// cluster request config
+DEFINE_bool(enable_proxy_prefetch, true,
+            "config if a cluster request issues the sub queries of all remote tasks fed by local inputs at once, "
+            "before any remote result is awaited");
+
+// storage pushdown config
+DEFINE_bool(enable_column_pushdown, false,
+            "config if the columns a simple project depends on are pushed down to the table, so that "
+            "remote tablets send only these columns. enable it only after all tablets are upgraded, "
+            "older tablets ignore keep_layout of scan requests");
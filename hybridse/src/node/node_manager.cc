@@ -1050,6 +1050,11 @@ SqlNode *NodeManager::MakePartitionNumNode(int num) {
     return RegisterNode(node_ptr);
 }
 
+SqlNode *NodeManager::MakeDiskOptionNode(const std::string &name, int64_t value) {
+    SqlNode *node_ptr = new DiskOptionNode(name, value);
+    return RegisterNode(node_ptr);
+}
+
 SqlNode *NodeManager::MakeDistributionsNode(SqlNodeList *distribution_list) {
     DistributionsNode *index_ptr = new DistributionsNode(distribution_list);
     return RegisterNode(index_ptr);
@@ -1197,6 +1197,9 @@ std::string NameOfSqlNodeType(const SqlNodeType &type) {
         case kDynamicUdafFnDef:
             output = "kDynamicUdafFnDef";
             break;
+        case kDiskOption:
+            output = "kDiskOption";
+            break;
         case kUnknow:
             output = "kUnknow";
             break;
@@ -2539,6 +2542,13 @@ void PartitionNumNode::Print(std::ostream &output, const std::string &org_tab) c
     PrintValue(output, tab, std::to_string(partition_num_), "partition_num", true);
 }
 
+void DiskOptionNode::Print(std::ostream &output, const std::string &org_tab) const {
+    SqlNode::Print(output, org_tab);
+    const std::string tab = org_tab + INDENT + SPACE_ED;
+    output << "\n";
+    PrintValue(output, tab, std::to_string(value_), name_, true);
+}
+
 void DistributionsNode::Print(std::ostream &output, const std::string &org_tab) const {
     SqlNode::Print(output, org_tab);
     const std::string tab = org_tab + INDENT + SPACE_ED;
@@ -1663,6 +1663,7 @@ base::Status ConvertIndexOption(const zetasql::ASTOptionsEntry* entry, node::Nod
 // case entry
 //   ("partitionnum", int) -> PartitionNumNode(int)
 //   ("replicanum", int)   -> ReplicaNumNode(int)
+//   ("block_size_kb" | "write_buffer_mb" | "block_cache_mb", int) -> DiskOptionNode(string, int)
 //   ("distribution", [ (string, [string] ) ] ) ->
 base::Status ConvertTableOption(const zetasql::ASTOptionsEntry* entry, node::NodeManager* node_manager,
                                 node::SqlNode** output) {
@@ -1710,6 +1711,12 @@ base::Status ConvertTableOption(const zetasql::ASTOptionsEntry* entry, node::Nod
         CHECK_STATUS(AstStringLiteralToString(entry->value(), &storage_mode));
         boost::to_lower(storage_mode);
         *output = node_manager->MakeStorageModeNode(node::NameToStorageMode(storage_mode));
+    } else if (boost::equals("block_size_kb", identifier) || boost::equals("write_buffer_mb", identifier) ||
+               boost::equals("block_cache_mb", identifier)) {
+        int64_t value = 0;
+        CHECK_STATUS(ASTIntLiteralToNum(entry->value(), &value));
+        CHECK_TRUE(value >= 0, common::kSqlAstError, identifier, " should not be negative");
+        *output = node_manager->MakeDiskOptionNode(identifier, value);
     } else {
         return base::Status(common::kOk, "create table option ignored");
     }
@@ -560,6 +560,8 @@ INSTANTIATE_TEST_SUITE_P(EngineTestWindowUnion, EngineTest,
                         testing::ValuesIn(sqlcase::InitCases("/cases/function/window/test_window_union.yaml")));
 INSTANTIATE_TEST_SUITE_P(EngineTestWindowMaxSize, EngineTest,
                         testing::ValuesIn(sqlcase::InitCases("/cases/function/window/test_maxsize.yaml")));
+INSTANTIATE_TEST_SUITE_P(EngineTestWindowColumnMaterialize, EngineTest,
+    testing::ValuesIn(sqlcase::InitCases("/cases/function/window/test_window_column_materialize.yaml")));
 
 INSTANTIATE_TEST_SUITE_P(EngineTestMultipleDatabases, EngineTest,
     testing::ValuesIn(sqlcase::InitCases("/cases/function/multiple_databases/test_multiple_databases.yaml")));
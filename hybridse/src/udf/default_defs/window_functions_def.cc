@@ -40,6 +40,18 @@ void AtList(::hybridse::codec::ListRef<V>* list_ref, int64_t pos, V* v,
         return;
     }
     auto list = reinterpret_cast<codec::ListV<V>*>(list_ref->list);
+    auto column_impl = dynamic_cast<codec::ColumnImpl<V>*>(list);
+    if (column_impl != nullptr && column_impl->materialized() != nullptr) {
+        auto materialized = column_impl->materialized();
+        if (static_cast<uint64_t>(pos) >= materialized->size()) {
+            *is_null = true;
+            *v = V(DataTypeTrait<V>::zero_value());
+        } else {
+            *is_null = materialized->nulls()[pos];
+            *v = materialized->values()[pos];
+        }
+        return;
+    }
     auto column = dynamic_cast<codec::WrapListImpl<V, codec::Row>*>(list);
     if (column != nullptr) {
         auto row = column->root()->At(pos);
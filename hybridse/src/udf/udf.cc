@@ -20,6 +20,7 @@
 #include <map>
 #include <set>
 #include <utility>
+#include <vector>
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_replace.h"
 #include "base/iterator.h"
@@ -28,6 +29,7 @@
 #include "boost/date_time/posix_time/posix_time.hpp"
 
 #include "bthread/types.h"
+#include "gflags/gflags.h"
 #include "codec/list_iterator_codec.h"
 #include "codec/row.h"
 #include "codec/type_codec.h"
@@ -36,8 +38,11 @@
 #include "node/sql_node.h"
 #include "udf/default_udf_library.h"
 #include "udf/literal_traits.h"
+#include "udf/vectorized_kernels.h"
 #include "vm/jit_runtime.h"
 
+DECLARE_bool(enable_window_column_materialize);
+
 namespace hybridse {
 namespace udf {
 namespace v1 {
@@ -1070,6 +1075,20 @@ char *AllocManagedStringBuf(int32_t bytes) {
     return reinterpret_cast<char *>(vm::JitRuntime::get()->AllocManaged(bytes));
 }
 
+// Decode a window column into a MaterializedColumn the first time it is
+// iterated. The column object lives for a single run step, the same as the
+// JIT runtime managed objects, so later aggregates reuse the decoded arrays.
+template <class V>
+void MaterializeColumn(ListV<V> *list) {
+    auto column = dynamic_cast<codec::ColumnImpl<V> *>(list);
+    if (column == nullptr || column->materialized() != nullptr) {
+        return;
+    }
+    auto materialized = new codec::MaterializedColumn<V>(column);
+    vm::JitRuntime::get()->AddManagedObject(materialized);
+    column->SetMaterialized(materialized);
+}
+
 template <class V>
 bool iterator_list(int8_t *input, int8_t *output) {
     if (nullptr == input || nullptr == output) {
@@ -1080,6 +1099,9 @@ bool iterator_list(int8_t *input, int8_t *output) {
     ::hybridse::codec::IteratorRef *iterator_ref =
         (::hybridse::codec::IteratorRef *)(output);
     ListV<V> *col = (ListV<V> *)(list_ref->list);
+    if (FLAGS_enable_window_column_materialize) {
+        MaterializeColumn<V>(col);
+    }
     auto col_iter = col->GetRawIterator();
     col_iter->SeekToFirst();
     iterator_ref->iterator = reinterpret_cast<int8_t *>(col_iter);
@@ -1153,6 +1175,75 @@ void delete_iterator(int8_t *input) {
     }
 }
 
+// Return the contiguous values of the list: the materialized column for a
+// window column, otherwise the elements copied into `buf`.
+template <class V>
+const V *ListValues(int8_t *input, std::vector<V> *buf, uint64_t *size) {
+    auto list_ref = reinterpret_cast<::hybridse::codec::ListRef<> *>(input);
+    auto list = reinterpret_cast<ListV<V> *>(list_ref->list);
+    MaterializeColumn<V>(list);
+    auto column = dynamic_cast<codec::ColumnImpl<V> *>(list);
+    if (column != nullptr && column->materialized() != nullptr) {
+        *size = column->materialized()->size();
+        return column->materialized()->values();
+    }
+    auto iter = list->GetIterator();
+    if (iter) {
+        iter->SeekToFirst();
+        while (iter->Valid()) {
+            buf->push_back(iter->GetValue());
+            iter->Next();
+        }
+    }
+    *size = buf->size();
+    return buf->data();
+}
+
+template <class V>
+void vectorized_sum(int8_t *input, V *output, bool *is_null) {
+    std::vector<V> buf;
+    uint64_t size = 0;
+    const V *values = ListValues<V>(input, &buf, &size);
+    *is_null = size == 0;
+    *output = size == 0 ? V(0) : vectorized::Sum(values, size);
+}
+
+template <class V>
+void vectorized_min(int8_t *input, V *output, bool *is_null) {
+    std::vector<V> buf;
+    uint64_t size = 0;
+    const V *values = ListValues<V>(input, &buf, &size);
+    *is_null = size == 0;
+    *output = size == 0 ? V(0) : vectorized::Min(values, size);
+}
+
+template <class V>
+void vectorized_max(int8_t *input, V *output, bool *is_null) {
+    std::vector<V> buf;
+    uint64_t size = 0;
+    const V *values = ListValues<V>(input, &buf, &size);
+    *is_null = size == 0;
+    *output = size == 0 ? V(0) : vectorized::Max(values, size);
+}
+
+template <class V>
+void vectorized_count(int8_t *input, int64_t *output, bool *is_null) {
+    auto list_ref = reinterpret_cast<::hybridse::codec::ListRef<> *>(input);
+    auto list = reinterpret_cast<ListV<V> *>(list_ref->list);
+    MaterializeColumn<V>(list);
+    *is_null = false;
+    *output = static_cast<int64_t>(list->GetCount());
+}
+
+template <class V>
+void vectorized_avg(int8_t *input, double *output, bool *is_null) {
+    std::vector<V> buf;
+    uint64_t size = 0;
+    const V *values = ListValues<V>(input, &buf, &size);
+    *is_null = size == 0;
+    *output = size == 0 ? 0.0 : vectorized::SumAsDouble(values, size) / size;
+}
+
 }  // namespace v1
 
 bool RegisterMethod(UdfLibrary *lib, const std::string &fn_name, hybridse::node::TypeNode *ret,
@@ -1170,6 +1261,22 @@ bool RegisterMethod(UdfLibrary *lib, const std::string &fn_name, hybridse::node:
     return true;
 }
 
+// Symbols called by codegen::UdfIRBuilder, named "vectorized_<udaf>.<type>"
+template <class V>
+static void RegisterVectorizedUdaf(UdfLibrary* lib) {
+    const std::string suffix = "." + DataTypeTrait<V>::to_string();
+    lib->AddExternalFunction("vectorized_sum" + suffix,
+                             reinterpret_cast<void *>(v1::vectorized_sum<V>));
+    lib->AddExternalFunction("vectorized_min" + suffix,
+                             reinterpret_cast<void *>(v1::vectorized_min<V>));
+    lib->AddExternalFunction("vectorized_max" + suffix,
+                             reinterpret_cast<void *>(v1::vectorized_max<V>));
+    lib->AddExternalFunction("vectorized_count" + suffix,
+                             reinterpret_cast<void *>(v1::vectorized_count<V>));
+    lib->AddExternalFunction("vectorized_avg" + suffix,
+                             reinterpret_cast<void *>(v1::vectorized_avg<V>));
+}
+
 void RegisterNativeUdfToModule(UdfLibrary* lib) {
     base::Status status;
     hybridse::node::NodeManager* nm = lib->node_manager();
@@ -1327,6 +1434,12 @@ void RegisterNativeUdfToModule(UdfLibrary* lib) {
         reinterpret_cast<void *>(v1::delete_iterator<StringRef>));
     RegisterMethodInternal("delete_iterator", bool_ty, {iter_row_ty},
                    reinterpret_cast<void *>(v1::delete_iterator<codec::Row>));
+
+    RegisterVectorizedUdaf<int16_t>(lib);
+    RegisterVectorizedUdaf<int32_t>(lib);
+    RegisterVectorizedUdaf<int64_t>(lib);
+    RegisterVectorizedUdaf<float>(lib);
+    RegisterVectorizedUdaf<double>(lib);
 }
 
 }  // namespace udf
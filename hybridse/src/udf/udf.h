@@ -197,6 +197,24 @@ void delete_iterator(int8_t *input);
 template <class V>
 bool next_struct_iterator(int8_t *input, V *v);
 
+// Built-in aggregates over a whole list, run by the vectorized kernels on the
+// materialized window column. Used instead of the iterator based udaf when
+// window columns are materialized.
+template <class V>
+void vectorized_sum(int8_t *input, V *output, bool *is_null);
+
+template <class V>
+void vectorized_min(int8_t *input, V *output, bool *is_null);
+
+template <class V>
+void vectorized_max(int8_t *input, V *output, bool *is_null);
+
+template <class V>
+void vectorized_count(int8_t *input, int64_t *output, bool *is_null);
+
+template <class V>
+void vectorized_avg(int8_t *input, double *output, bool *is_null);
+
 template <class V>
 struct IncOne {
     using Args = std::tuple<V>;
@@ -31,12 +31,18 @@
 #include "codec/list_iterator_codec.h"
 #include "udf/udf.h"
 #include "udf/udf_registry.h"
+#include "vm/jit_runtime.h"
 #include "vm/mem_catalog.h"
+
+DECLARE_bool(enable_window_column_materialize);
+
 namespace hybridse {
 namespace udf {
 using hybridse::codec::ArrayListV;
 using hybridse::codec::ColumnImpl;
 using hybridse::codec::ListRef;
+using hybridse::codec::MaterializedColumn;
+using hybridse::codec::MaterializedColumnIterator;
 using hybridse::codec::Row;
 using hybridse::sqlcase::SqlCase;
 using openmldb::base::Date;
@@ -231,6 +237,67 @@ TEST_F(UdfTest, udf_sum_test) {
     SumTest(&window);
 }
 
+TEST_F(UdfTest, MaterializedColumnTest) {
+    vm::MemTimeTableHandler window;
+    uint64_t ts = 1000;
+    for (auto& row : rows) {
+        window.AddRow(ts++, row);
+    }
+    FLAGS_enable_window_column_materialize = true;
+    {
+        ListRef<int32_t> list;
+        ASSERT_TRUE(FetchColList(&window, 0, 2, &list));
+        auto sum = UdfFunctionBuilder("sum")
+                       .args<ListRef<int32_t>>()
+                       .returns<int32_t>()
+                       .build();
+        ASSERT_TRUE(sum.valid());
+        auto max = UdfFunctionBuilder("max")
+                       .args<ListRef<int32_t>>()
+                       .returns<int32_t>()
+                       .build();
+        ASSERT_TRUE(max.valid());
+        ASSERT_EQ(1 + 11 + 111, sum(list));
+        auto column = reinterpret_cast<ColumnImpl<int32_t>*>(list.list);
+        auto materialized = column->materialized();
+        ASSERT_TRUE(materialized != nullptr);
+        ASSERT_EQ(3u, materialized->size());
+        // the second aggregate reads the arrays decoded by the first one
+        ASSERT_EQ(111, max(list));
+        ASSERT_EQ(materialized, column->materialized());
+        ASSERT_EQ(3u, column->GetCount());
+        ASSERT_EQ(11, column->At(1));
+    }
+    {
+        // window keys decrease, same as a real window
+        vm::MemTimeTableHandler desc_window;
+        uint64_t desc_ts = 1004;
+        for (auto& row : rows) {
+            desc_window.AddRow(desc_ts, row);
+            desc_ts -= 2;
+        }
+        ListRef<int32_t> list;
+        ASSERT_TRUE(FetchColList(&desc_window, 0, 2, &list));
+        auto column = reinterpret_cast<ColumnImpl<int32_t>*>(list.list);
+        MaterializedColumn<int32_t> materialized(column);
+        MaterializedColumnIterator<int32_t> iter(&materialized);
+        iter.Seek(1002);
+        ASSERT_TRUE(iter.Valid());
+        ASSERT_EQ(1002u, iter.GetKey());
+        ASSERT_EQ(11, iter.GetValue());
+        iter.Seek(1001);
+        ASSERT_TRUE(iter.Valid());
+        ASSERT_EQ(1000u, iter.GetKey());
+        iter.Seek(2000);
+        ASSERT_TRUE(iter.Valid());
+        ASSERT_EQ(1004u, iter.GetKey());
+        iter.Seek(999);
+        ASSERT_FALSE(iter.Valid());
+    }
+    FLAGS_enable_window_column_materialize = false;
+    vm::JitRuntime::get()->ReleaseRunStep();
+}
+
 TEST_F(UdfTest, GetColTest) {
     ArrayListV<Row> impl(&rows);
     const uint32_t size = sizeof(ColumnImpl<int16_t>);
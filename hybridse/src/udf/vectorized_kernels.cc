@@ -0,0 +1,389 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "udf/vectorized_kernels.h"
+
+#include <type_traits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HYBRIDSE_VECTORIZED_X86
+#include <immintrin.h>
+#endif
+
+namespace hybridse {
+namespace udf {
+namespace vectorized {
+
+namespace {
+
+// integer sums wrap around instead of overflowing, same as the jit add
+template <class T>
+inline T AddWrap(T a, T b) {
+    if constexpr (std::is_integral<T>::value) {
+        using U = typename std::make_unsigned<T>::type;
+        return static_cast<T>(static_cast<U>(a) + static_cast<U>(b));
+    } else {
+        return a + b;
+    }
+}
+
+template <class T>
+T SumScalar(const T* values, uint64_t size) {
+    T sum = 0;
+    for (uint64_t i = 0; i < size; i++) {
+        sum = AddWrap(sum, values[i]);
+    }
+    return sum;
+}
+
+template <class T>
+double SumAsDoubleScalar(const T* values, uint64_t size) {
+    double sum = 0;
+    for (uint64_t i = 0; i < size; i++) {
+        sum += static_cast<double>(values[i]);
+    }
+    return sum;
+}
+
+template <class T>
+T MinScalar(const T* values, uint64_t size) {
+    T res = values[0];
+    for (uint64_t i = 1; i < size; i++) {
+        res = values[i] < res ? values[i] : res;
+    }
+    return res;
+}
+
+template <class T>
+T MaxScalar(const T* values, uint64_t size) {
+    T res = values[0];
+    for (uint64_t i = 1; i < size; i++) {
+        res = values[i] > res ? values[i] : res;
+    }
+    return res;
+}
+
+#ifdef HYBRIDSE_VECTORIZED_X86
+
+#define HYBRIDSE_AVX2 __attribute__((target("avx2")))
+#define HYBRIDSE_AVX512 __attribute__((target("avx512f")))
+
+// Per type vector operations. Each struct provides T, V, kLanes and
+// Zero/Load/Store/Add/Min/Max on V.
+template <class T>
+struct Avx2Ops;
+
+template <>
+struct Avx2Ops<int16_t> {
+    using T = int16_t;
+    using V = __m256i;
+    static constexpr uint64_t kLanes = 16;
+    HYBRIDSE_AVX2 static V Zero() { return _mm256_setzero_si256(); }
+    HYBRIDSE_AVX2 static V Load(const T* p) { return _mm256_loadu_si256(reinterpret_cast<const V*>(p)); }
+    HYBRIDSE_AVX2 static void Store(T* p, V v) { _mm256_storeu_si256(reinterpret_cast<V*>(p), v); }
+    HYBRIDSE_AVX2 static V Add(V a, V b) { return _mm256_add_epi16(a, b); }
+    HYBRIDSE_AVX2 static V Min(V a, V b) { return _mm256_min_epi16(a, b); }
+    HYBRIDSE_AVX2 static V Max(V a, V b) { return _mm256_max_epi16(a, b); }
+};
+
+template <>
+struct Avx2Ops<int32_t> {
+    using T = int32_t;
+    using V = __m256i;
+    static constexpr uint64_t kLanes = 8;
+    HYBRIDSE_AVX2 static V Zero() { return _mm256_setzero_si256(); }
+    HYBRIDSE_AVX2 static V Load(const T* p) { return _mm256_loadu_si256(reinterpret_cast<const V*>(p)); }
+    HYBRIDSE_AVX2 static void Store(T* p, V v) { _mm256_storeu_si256(reinterpret_cast<V*>(p), v); }
+    HYBRIDSE_AVX2 static V Add(V a, V b) { return _mm256_add_epi32(a, b); }
+    HYBRIDSE_AVX2 static V Min(V a, V b) { return _mm256_min_epi32(a, b); }
+    HYBRIDSE_AVX2 static V Max(V a, V b) { return _mm256_max_epi32(a, b); }
+};
+
+template <>
+struct Avx2Ops<int64_t> {
+    using T = int64_t;
+    using V = __m256i;
+    static constexpr uint64_t kLanes = 4;
+    HYBRIDSE_AVX2 static V Zero() { return _mm256_setzero_si256(); }
+    HYBRIDSE_AVX2 static V Load(const T* p) { return _mm256_loadu_si256(reinterpret_cast<const V*>(p)); }
+    HYBRIDSE_AVX2 static void Store(T* p, V v) { _mm256_storeu_si256(reinterpret_cast<V*>(p), v); }
+    HYBRIDSE_AVX2 static V Add(V a, V b) { return _mm256_add_epi64(a, b); }
+    // avx2 has no 64-bit min/max, select by comparison instead
+    HYBRIDSE_AVX2 static V Min(V a, V b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+    HYBRIDSE_AVX2 static V Max(V a, V b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(b, a)); }
+};
+
+template <>
+struct Avx2Ops<float> {
+    using T = float;
+    using V = __m256;
+    static constexpr uint64_t kLanes = 8;
+    HYBRIDSE_AVX2 static V Zero() { return _mm256_setzero_ps(); }
+    HYBRIDSE_AVX2 static V Load(const T* p) { return _mm256_loadu_ps(p); }
+    HYBRIDSE_AVX2 static void Store(T* p, V v) { _mm256_storeu_ps(p, v); }
+    HYBRIDSE_AVX2 static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+    HYBRIDSE_AVX2 static V Min(V a, V b) { return _mm256_min_ps(a, b); }
+    HYBRIDSE_AVX2 static V Max(V a, V b) { return _mm256_max_ps(a, b); }
+};
+
+template <>
+struct Avx2Ops<double> {
+    using T = double;
+    using V = __m256d;
+    static constexpr uint64_t kLanes = 4;
+    HYBRIDSE_AVX2 static V Zero() { return _mm256_setzero_pd(); }
+    HYBRIDSE_AVX2 static V Load(const T* p) { return _mm256_loadu_pd(p); }
+    HYBRIDSE_AVX2 static void Store(T* p, V v) { _mm256_storeu_pd(p, v); }
+    HYBRIDSE_AVX2 static V Add(V a, V b) { return _mm256_add_pd(a, b); }
+    HYBRIDSE_AVX2 static V Min(V a, V b) { return _mm256_min_pd(a, b); }
+    HYBRIDSE_AVX2 static V Max(V a, V b) { return _mm256_max_pd(a, b); }
+};
+
+// avx512f has no 16-bit lanes, int16_t stays on avx2
+template <class T>
+struct Avx512Ops;
+
+template <>
+struct Avx512Ops<int32_t> {
+    using T = int32_t;
+    using V = __m512i;
+    static constexpr uint64_t kLanes = 16;
+    HYBRIDSE_AVX512 static V Zero() { return _mm512_setzero_si512(); }
+    HYBRIDSE_AVX512 static V Load(const T* p) { return _mm512_loadu_si512(p); }
+    HYBRIDSE_AVX512 static void Store(T* p, V v) { _mm512_storeu_si512(p, v); }
+    HYBRIDSE_AVX512 static V Add(V a, V b) { return _mm512_add_epi32(a, b); }
+    HYBRIDSE_AVX512 static V Min(V a, V b) { return _mm512_min_epi32(a, b); }
+    HYBRIDSE_AVX512 static V Max(V a, V b) { return _mm512_max_epi32(a, b); }
+};
+
+template <>
+struct Avx512Ops<int64_t> {
+    using T = int64_t;
+    using V = __m512i;
+    static constexpr uint64_t kLanes = 8;
+    HYBRIDSE_AVX512 static V Zero() { return _mm512_setzero_si512(); }
+    HYBRIDSE_AVX512 static V Load(const T* p) { return _mm512_loadu_si512(p); }
+    HYBRIDSE_AVX512 static void Store(T* p, V v) { _mm512_storeu_si512(p, v); }
+    HYBRIDSE_AVX512 static V Add(V a, V b) { return _mm512_add_epi64(a, b); }
+    HYBRIDSE_AVX512 static V Min(V a, V b) { return _mm512_min_epi64(a, b); }
+    HYBRIDSE_AVX512 static V Max(V a, V b) { return _mm512_max_epi64(a, b); }
+};
+
+template <>
+struct Avx512Ops<float> {
+    using T = float;
+    using V = __m512;
+    static constexpr uint64_t kLanes = 16;
+    HYBRIDSE_AVX512 static V Zero() { return _mm512_setzero_ps(); }
+    HYBRIDSE_AVX512 static V Load(const T* p) { return _mm512_loadu_ps(p); }
+    HYBRIDSE_AVX512 static void Store(T* p, V v) { _mm512_storeu_ps(p, v); }
+    HYBRIDSE_AVX512 static V Add(V a, V b) { return _mm512_add_ps(a, b); }
+    HYBRIDSE_AVX512 static V Min(V a, V b) { return _mm512_min_ps(a, b); }
+    HYBRIDSE_AVX512 static V Max(V a, V b) { return _mm512_max_ps(a, b); }
+};
+
+template <>
+struct Avx512Ops<double> {
+    using T = double;
+    using V = __m512d;
+    static constexpr uint64_t kLanes = 8;
+    HYBRIDSE_AVX512 static V Zero() { return _mm512_setzero_pd(); }
+    HYBRIDSE_AVX512 static V Load(const T* p) { return _mm512_loadu_pd(p); }
+    HYBRIDSE_AVX512 static void Store(T* p, V v) { _mm512_storeu_pd(p, v); }
+    HYBRIDSE_AVX512 static V Add(V a, V b) { return _mm512_add_pd(a, b); }
+    HYBRIDSE_AVX512 static V Min(V a, V b) { return _mm512_min_pd(a, b); }
+    HYBRIDSE_AVX512 static V Max(V a, V b) { return _mm512_max_pd(a, b); }
+};
+
+// The reduction loops are the same for every instruction set, but they must
+// carry the target attribute of their ops to get them inlined.
+#define HYBRIDSE_DEFINE_REDUCE_KERNELS(ISA, TARGET)                          \
+    template <class Ops>                                                     \
+    TARGET typename Ops::T Sum##ISA(const typename Ops::T* values,           \
+                                    uint64_t size) {                         \
+        using T = typename Ops::T;                                           \
+        typename Ops::V acc = Ops::Zero();                                   \
+        uint64_t i = 0;                                                      \
+        for (; i + Ops::kLanes <= size; i += Ops::kLanes) {                  \
+            acc = Ops::Add(acc, Ops::Load(values + i));                      \
+        }                                                                    \
+        T lanes[Ops::kLanes];                                                \
+        Ops::Store(lanes, acc);                                              \
+        return AddWrap(SumScalar(lanes, Ops::kLanes),                        \
+                       SumScalar(values + i, size - i));                     \
+    }                                                                        \
+                                                                             \
+    template <class Ops, bool kMin>                                          \
+    TARGET typename Ops::T MinMax##ISA(const typename Ops::T* values,        \
+                                       uint64_t size) {                      \
+        using T = typename Ops::T;                                           \
+        if (size < Ops::kLanes) {                                            \
+            return kMin ? MinScalar(values, size) : MaxScalar(values, size); \
+        }                                                                    \
+        typename Ops::V acc = Ops::Load(values);                             \
+        uint64_t i = Ops::kLanes;                                            \
+        for (; i + Ops::kLanes <= size; i += Ops::kLanes) {                  \
+            auto cur = Ops::Load(values + i);                                \
+            acc = kMin ? Ops::Min(acc, cur) : Ops::Max(acc, cur);            \
+        }                                                                    \
+        T lanes[Ops::kLanes];                                                \
+        Ops::Store(lanes, acc);                                              \
+        T res = kMin ? MinScalar(lanes, Ops::kLanes)                         \
+                     : MaxScalar(lanes, Ops::kLanes);                        \
+        for (; i < size; i++) {                                              \
+            res = kMin ? (values[i] < res ? values[i] : res)                 \
+                       : (values[i] > res ? values[i] : res);                \
+        }                                                                    \
+        return res;                                                          \
+    }
+
+HYBRIDSE_DEFINE_REDUCE_KERNELS(Avx2, HYBRIDSE_AVX2)
+HYBRIDSE_DEFINE_REDUCE_KERNELS(Avx512, HYBRIDSE_AVX512)
+
+// avg sums int32 and float in double lanes, which is exact for int32
+HYBRIDSE_AVX2 double SumAsDoubleAvx2(const int32_t* values, uint64_t size) {
+    __m256d acc = _mm256_setzero_pd();
+    uint64_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        acc = _mm256_add_pd(acc, _mm256_cvtepi32_pd(cur));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumAsDoubleScalar(values + i, size - i);
+}
+
+HYBRIDSE_AVX2 double SumAsDoubleAvx2(const float* values, uint64_t size) {
+    __m256d acc = _mm256_setzero_pd();
+    uint64_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm_loadu_ps(values + i)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumAsDoubleScalar(values + i, size - i);
+}
+
+template <class T>
+constexpr bool HasAvx512Ops() {
+    return !std::is_same<T, int16_t>::value;
+}
+
+#endif  // HYBRIDSE_VECTORIZED_X86
+
+// never run a kernel the cpu does not support
+inline Isa Supported(Isa isa) {
+    Isa detected = DetectIsa();
+    return static_cast<int>(isa) < static_cast<int>(detected) ? isa : detected;
+}
+
+}  // namespace
+
+Isa DetectIsa() {
+#ifdef HYBRIDSE_VECTORIZED_X86
+    static const Isa isa = __builtin_cpu_supports("avx512f")
+                               ? Isa::kAvx512
+                               : (__builtin_cpu_supports("avx2") ? Isa::kAvx2 : Isa::kScalar);
+    return isa;
+#else
+    return Isa::kScalar;
+#endif
+}
+
+template <class T>
+T Sum(const T* values, uint64_t size, Isa isa) {
+#ifdef HYBRIDSE_VECTORIZED_X86
+    switch (Supported(isa)) {
+        case Isa::kAvx512:
+            if constexpr (HasAvx512Ops<T>()) {
+                return SumAvx512<Avx512Ops<T>>(values, size);
+            }
+            return SumAvx2<Avx2Ops<T>>(values, size);
+        case Isa::kAvx2:
+            return SumAvx2<Avx2Ops<T>>(values, size);
+        default:
+            break;
+    }
+#endif
+    return SumScalar(values, size);
+}
+
+template <class T>
+double SumAsDouble(const T* values, uint64_t size, Isa isa) {
+    if constexpr (std::is_same<T, double>::value) {
+        return Sum(values, size, isa);
+    }
+#ifdef HYBRIDSE_VECTORIZED_X86
+    if constexpr (std::is_same<T, int32_t>::value || std::is_same<T, float>::value) {
+        if (Supported(isa) != Isa::kScalar) {
+            return SumAsDoubleAvx2(values, size);
+        }
+    }
+#endif
+    return SumAsDoubleScalar(values, size);
+}
+
+template <class T>
+T Min(const T* values, uint64_t size, Isa isa) {
+#ifdef HYBRIDSE_VECTORIZED_X86
+    switch (Supported(isa)) {
+        case Isa::kAvx512:
+            if constexpr (HasAvx512Ops<T>()) {
+                return MinMaxAvx512<Avx512Ops<T>, true>(values, size);
+            }
+            return MinMaxAvx2<Avx2Ops<T>, true>(values, size);
+        case Isa::kAvx2:
+            return MinMaxAvx2<Avx2Ops<T>, true>(values, size);
+        default:
+            break;
+    }
+#endif
+    return MinScalar(values, size);
+}
+
+template <class T>
+T Max(const T* values, uint64_t size, Isa isa) {
+#ifdef HYBRIDSE_VECTORIZED_X86
+    switch (Supported(isa)) {
+        case Isa::kAvx512:
+            if constexpr (HasAvx512Ops<T>()) {
+                return MinMaxAvx512<Avx512Ops<T>, false>(values, size);
+            }
+            return MinMaxAvx2<Avx2Ops<T>, false>(values, size);
+        case Isa::kAvx2:
+            return MinMaxAvx2<Avx2Ops<T>, false>(values, size);
+        default:
+            break;
+    }
+#endif
+    return MaxScalar(values, size);
+}
+
+#define HYBRIDSE_INSTANTIATE_KERNELS(T)                     \
+    template T Sum<T>(const T*, uint64_t, Isa);             \
+    template double SumAsDouble<T>(const T*, uint64_t, Isa); \
+    template T Min<T>(const T*, uint64_t, Isa);             \
+    template T Max<T>(const T*, uint64_t, Isa);
+
+HYBRIDSE_INSTANTIATE_KERNELS(int16_t)
+HYBRIDSE_INSTANTIATE_KERNELS(int32_t)
+HYBRIDSE_INSTANTIATE_KERNELS(int64_t)
+HYBRIDSE_INSTANTIATE_KERNELS(float)
+HYBRIDSE_INSTANTIATE_KERNELS(double)
+
+}  // namespace vectorized
+}  // namespace udf
+}  // namespace hybridse
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_UDF_VECTORIZED_KERNELS_H_
+#define HYBRIDSE_SRC_UDF_VECTORIZED_KERNELS_H_
+
+#include <cstdint>
+
+namespace hybridse {
+namespace udf {
+namespace vectorized {
+
+enum class Isa { kScalar, kAvx2, kAvx512 };
+
+/// \brief The widest instruction set supported by the running cpu.
+/// Detected once, kernels are dispatched by it.
+Isa DetectIsa();
+
+/// \brief Reduction kernels over a contiguous column array, instantiated for
+/// int16_t, int32_t, int64_t, float and double.
+///
+/// Integer sums wrap around like the scalar udaf does. Float sums are
+/// accumulated in lanes, so the rounding can differ from a sequential sum, and
+/// the udafs only run on the kernels for integer lists.
+/// Min() and Max() require `size > 0`.
+template <class T>
+T Sum(const T* values, uint64_t size, Isa isa = DetectIsa());
+
+template <class T>
+double SumAsDouble(const T* values, uint64_t size, Isa isa = DetectIsa());
+
+template <class T>
+T Min(const T* values, uint64_t size, Isa isa = DetectIsa());
+
+template <class T>
+T Max(const T* values, uint64_t size, Isa isa = DetectIsa());
+
+}  // namespace vectorized
+}  // namespace udf
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_UDF_VECTORIZED_KERNELS_H_
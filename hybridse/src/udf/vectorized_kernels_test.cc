@@ -0,0 +1,76 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "udf/vectorized_kernels.h"
+
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace udf {
+namespace vectorized {
+
+class VectorizedKernelsTest : public ::testing::Test {};
+
+template <class T>
+void CheckKernels() {
+    for (uint64_t size : {1, 3, 8, 15, 16, 17, 33, 100, 1001}) {
+        std::vector<T> values(size);
+        for (uint64_t i = 0; i < size; i++) {
+            values[i] = static_cast<T>(static_cast<int32_t>((i * 7919) % 2003) - 1000);
+        }
+        T expect_sum = Sum(values.data(), size, Isa::kScalar);
+        T expect_min = Min(values.data(), size, Isa::kScalar);
+        T expect_max = Max(values.data(), size, Isa::kScalar);
+        double expect_avg_sum = SumAsDouble(values.data(), size, Isa::kScalar);
+        // isa above the cpu support falls back to the supported one
+        for (Isa isa : {Isa::kScalar, Isa::kAvx2, Isa::kAvx512}) {
+            ASSERT_EQ(expect_sum, Sum(values.data(), size, isa)) << size;
+            ASSERT_EQ(expect_min, Min(values.data(), size, isa)) << size;
+            ASSERT_EQ(expect_max, Max(values.data(), size, isa)) << size;
+            ASSERT_DOUBLE_EQ(expect_avg_sum, SumAsDouble(values.data(), size, isa)) << size;
+        }
+    }
+}
+
+TEST_F(VectorizedKernelsTest, SumMinMaxTest) {
+    CheckKernels<int16_t>();
+    CheckKernels<int32_t>();
+    CheckKernels<int64_t>();
+    CheckKernels<float>();
+    CheckKernels<double>();
+}
+
+TEST_F(VectorizedKernelsTest, SumWrapAroundTest) {
+    std::vector<int32_t> values(100, std::numeric_limits<int32_t>::max());
+    int32_t expect = 0;
+    for (auto v : values) {
+        expect = static_cast<int32_t>(static_cast<uint32_t>(expect) + static_cast<uint32_t>(v));
+    }
+    ASSERT_EQ(expect, Sum(values.data(), values.size()));
+    ASSERT_EQ(expect, Sum(values.data(), values.size(), Isa::kScalar));
+}
+
+}  // namespace vectorized
+}  // namespace udf
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -21,8 +21,10 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <vector>
 #include <boost/algorithm/string/compare.hpp>
 
+#include "base/hyper_log_log.h"
 #include "codec/fe_row_codec.h"
 #include "codec/row.h"
 #include "proto/fe_type.pb.h"
@@ -303,6 +305,50 @@ class AvgAggregator : public Aggregator<double> {
     double avg_ = 0;
 };
 
+// approximate distinct count, see base::HyperLogLog for the error bound
+class DistinctCountAggregator : public Aggregator<int64_t> {
+ public:
+    DistinctCountAggregator(type::Type type, const Schema& output_schema)
+        : Aggregator<int64_t>(type, output_schema, 0), registers_(base::HyperLogLog::kRegisterSize, 0) {}
+
+    // hash is the base::HyperLogLog::Hash of a not null value
+    void UpdateValue(const int64_t& hash) override {
+        base::HyperLogLog::Add(static_cast<uint64_t>(hash), registers_.data());
+        this->counter_++;
+    }
+
+    // bval is the registers of a pre-aggregated bucket
+    void Update(const std::string& bval) override {
+        if (bval.size() != base::HyperLogLog::kRegisterSize) {
+            LOG(ERROR) << "encoded aggr val is not valid";
+            return;
+        }
+        base::HyperLogLog::Merge(reinterpret_cast<const uint8_t*>(bval.data()), registers_.data());
+        this->counter_++;
+    }
+
+    const int64_t& val() override {
+        this->val_ = base::HyperLogLog::Estimate(registers_.data());
+        return this->val_;
+    }
+
+    bool IsNull() const override {
+        return false;
+    }
+
+    type::Type GetRepType() const override {
+        return type::kInt64;
+    }
+
+    void Reset() override {
+        Aggregator::Reset();
+        std::fill(registers_.begin(), registers_.end(), 0);
+    }
+
+ private:
+    std::vector<uint8_t> registers_;
+};
+
 template <class T>
 class MinAggregator : public Aggregator<T> {
  public:
@@ -416,25 +462,26 @@ std::unique_ptr<BaseAggregator> MakeSameTypeAggregator(type::Type agg_col_type,
     }
 }
 
+// the rep type decides the concrete Aggregator<T>, so no runtime type check is needed per value
 template <class T>
 std::enable_if_t<std::is_arithmetic<T>{}> AggregatorUpdate(BaseAggregator* aggregator, const T& val) {
     switch (aggregator->GetRepType()) {
         case type::kInt16:
-            dynamic_cast<Aggregator<int16_t>*>(aggregator)->UpdateValue(val);
+            static_cast<Aggregator<int16_t>*>(aggregator)->UpdateValue(val);
             break;
         case type::kDate:
         case type::kInt32:
-            dynamic_cast<Aggregator<int32_t>*>(aggregator)->UpdateValue(val);
+            static_cast<Aggregator<int32_t>*>(aggregator)->UpdateValue(val);
             break;
         case type::kTimestamp:
         case type::kInt64:
-            dynamic_cast<Aggregator<int64_t>*>(aggregator)->UpdateValue(val);
+            static_cast<Aggregator<int64_t>*>(aggregator)->UpdateValue(val);
             break;
         case type::kFloat:
-            dynamic_cast<Aggregator<float>*>(aggregator)->UpdateValue(val);
+            static_cast<Aggregator<float>*>(aggregator)->UpdateValue(val);
             break;
         case type::kDouble:
-            dynamic_cast<Aggregator<double>*>(aggregator)->UpdateValue(val);
+            static_cast<Aggregator<double>*>(aggregator)->UpdateValue(val);
             break;
         default:
             LOG(ERROR) << "ERROR: unsupport type " << Type_Name(aggregator->GetRepType());
@@ -446,7 +493,7 @@ template <class T>
 std::enable_if_t<!std::is_arithmetic<T>{}> AggregatorUpdate(BaseAggregator* aggregator, const T& val) {
     switch (aggregator->GetRepType()) {
         case type::kVarchar:
-            dynamic_cast<Aggregator<std::string>*>(aggregator)->UpdateValue(val);
+            static_cast<Aggregator<std::string>*>(aggregator)->UpdateValue(val);
             break;
         default:
             LOG(ERROR) << "ERROR: unsupport type " << Type_Name(aggregator->GetRepType());
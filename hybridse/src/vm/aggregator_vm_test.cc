@@ -505,6 +505,35 @@ TEST_P(AggregatorVMTest, MaxTest) {
     }
 }
 
+TEST_F(AggregatorVMTest, DistinctCountTest) {
+    codec::Schema schema;
+    auto column = schema.Add();
+    column->set_type(type::kInt64);
+    column->set_name("val");
+    DistinctCountAggregator aggregator(type::kInt64, schema);
+    EXPECT_EQ(0, aggregator.val());
+
+    // raw values [0, 10000) and a pre-aggregated bucket of [5000, 20000)
+    for (int64_t i = 0; i < 10000; i++) {
+        aggregator.UpdateValue(static_cast<int64_t>(base::HyperLogLog::Hash(&i, sizeof(i))));
+    }
+    std::string bval(base::HyperLogLog::kRegisterSize, '\0');
+    for (int64_t i = 5000; i < 20000; i++) {
+        base::HyperLogLog::Add(base::HyperLogLog::Hash(&i, sizeof(i)), reinterpret_cast<uint8_t*>(&bval[0]));
+    }
+    aggregator.Update(bval);
+    // 1.6% standard error, check within 5%
+    EXPECT_NEAR(20000, aggregator.val(), 1000);
+
+    codec::RowView row_view(schema);
+    Row row = aggregator.Output();
+    row_view.Reset(row.buf());
+    int64_t output = 0;
+    row_view.GetInt64(0, &output);
+    EXPECT_NEAR(20000, output, 1000);
+    EXPECT_EQ(0, aggregator.val());
+}
+
 TEST_F(AggregatorVMTest, NullTest) {
     auto agg_col_type = type::kInt64;
     codec::Schema schema;
@@ -25,7 +25,7 @@ std::shared_ptr<TableHandler> PartitionProjectWrapper::GetSegment(
         return std::shared_ptr<TableHandler>();
     } else {
         return std::shared_ptr<TableHandler>(
-            new TableProjectWrapper(segment, parameter_, fun_));
+            new TableProjectWrapper(segment, parameter_, fun_, columns_));
     }
 }
 base::ConstIterator<uint64_t, Row>* PartitionProjectWrapper::GetRawIterator() {
@@ -62,7 +62,7 @@ std::shared_ptr<PartitionHandler> TableProjectWrapper::GetPartition(
         return std::shared_ptr<PartitionHandler>();
     } else {
         return std::shared_ptr<PartitionHandler>(
-            new PartitionProjectWrapper(partition, parameter_, fun_));
+            new PartitionProjectWrapper(partition, parameter_, fun_, columns_));
     }
 }
 std::shared_ptr<PartitionHandler> TableFilterWrapper::GetPartition(
@@ -19,6 +19,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 #include "vm/catalog.h"
 namespace hybridse {
 namespace vm {
@@ -58,11 +59,14 @@ class IteratorFilterWrapper : public RowIterator {
     IteratorFilterWrapper(std::unique_ptr<RowIterator> iter,
                           const Row& parameter,
                           const PredicateFun* fun)
-        : RowIterator(), iter_(std::move(iter)), parameter_(parameter), predicate_(fun) {}
-    virtual ~IteratorFilterWrapper() {}
-    bool Valid() const override {
-        return iter_->Valid() && predicate_->operator()(iter_->GetValue(), parameter_);
+        : RowIterator(), iter_(std::move(iter)), parameter_(parameter), predicate_(fun) {
+        while (iter_ && iter_->Valid() && !predicate_->operator()(iter_->GetValue(), parameter_)) {
+            iter_->Next();
+        }
     }
+    virtual ~IteratorFilterWrapper() {}
+    // every move skips the rows not satisfying the predicate, so the current row always satisfies it
+    bool Valid() const override { return iter_ && iter_->Valid(); }
     void Next() override {
         iter_->Next();
         while (iter_->Valid() && !predicate_->operator()(iter_->GetValue(), parameter_)) {
@@ -72,12 +76,18 @@ class IteratorFilterWrapper : public RowIterator {
     const uint64_t& GetKey() const override { return iter_->GetKey(); }
     const Row& GetValue() override { return iter_->GetValue(); }
     void Seek(const uint64_t& k) override {
+        if (!iter_) {
+            return;
+        }
         iter_->Seek(k);
         while (iter_->Valid() && !predicate_->operator()(iter_->GetValue(), parameter_)) {
             iter_->Next();
         }
     }
     void SeekToFirst() override {
+        if (!iter_) {
+            return;
+        }
         iter_->SeekToFirst();
         while (iter_->Valid() && !predicate_->operator()(iter_->GetValue(), parameter_)) {
             iter_->Next();
@@ -162,17 +172,27 @@ class TableFilterWrapper;
 
 class PartitionProjectWrapper : public PartitionHandler {
  public:
+    // `columns` are the source columns `fun` depends on, they are pushed down
+    // to the partition if not null
     PartitionProjectWrapper(std::shared_ptr<PartitionHandler> partition_handler,
                             const Row& parameter,
-                            const ProjectFun* fun)
+                            const ProjectFun* fun,
+                            const std::vector<uint32_t>* columns = nullptr)
         : PartitionHandler(),
           partition_handler_(partition_handler),
           parameter_(parameter),
           value_(),
-          fun_(fun) {}
+          fun_(fun),
+          columns_(columns) {}
     virtual ~PartitionProjectWrapper() {}
     std::unique_ptr<WindowIterator> GetWindowIterator() override {
-        auto iter = partition_handler_->GetWindowIterator();
+        std::unique_ptr<WindowIterator> iter;
+        if (columns_ != nullptr && !columns_->empty()) {
+            iter = partition_handler_->GetProjectWindowIterator(*columns_);
+        }
+        if (!iter) {
+            iter = partition_handler_->GetWindowIterator();
+        }
         if (!iter) {
             return std::unique_ptr<WindowIterator>();
         } else {
@@ -222,6 +242,7 @@ class PartitionProjectWrapper : public PartitionHandler {
     const Row& parameter_;
     Row value_;
     const ProjectFun* fun_;
+    const std::vector<uint32_t>* columns_;
 };
 class PartitionFilterWrapper : public PartitionHandler {
  public:
@@ -279,14 +300,22 @@ class PartitionFilterWrapper : public PartitionHandler {
 };
 class TableProjectWrapper : public TableHandler {
  public:
+    // `columns` are the source columns `fun` depends on, they are pushed down
+    // to the table if not null
     TableProjectWrapper(std::shared_ptr<TableHandler> table_handler,
                         const Row& parameter,
-                        const ProjectFun* fun)
-        : TableHandler(), table_hander_(table_handler), parameter_(parameter), value_(), fun_(fun) {}
+                        const ProjectFun* fun,
+                        const std::vector<uint32_t>* columns = nullptr)
+        : TableHandler(),
+          table_hander_(table_handler),
+          parameter_(parameter),
+          value_(),
+          fun_(fun),
+          columns_(columns) {}
     virtual ~TableProjectWrapper() {}
 
     std::unique_ptr<RowIterator> GetIterator() {
-        auto iter = table_hander_->GetIterator();
+        auto iter = GetSourceIterator();
         if (!iter) {
             return std::unique_ptr<RowIterator>();
         } else {
@@ -298,7 +327,13 @@ class TableProjectWrapper : public TableHandler {
     const IndexHint& GetIndex() override { return table_hander_->GetIndex(); }
     std::unique_ptr<WindowIterator> GetWindowIterator(
         const std::string& idx_name) override {
-        auto iter = table_hander_->GetWindowIterator(idx_name);
+        std::unique_ptr<WindowIterator> iter;
+        if (columns_ != nullptr && !columns_->empty()) {
+            iter = table_hander_->GetProjectWindowIterator(idx_name, *columns_);
+        }
+        if (!iter) {
+            iter = table_hander_->GetWindowIterator(idx_name);
+        }
         if (!iter) {
             return std::unique_ptr<WindowIterator>();
         } else {
@@ -312,7 +347,7 @@ class TableProjectWrapper : public TableHandler {
         return table_hander_->GetDatabase();
     }
     base::ConstIterator<uint64_t, Row>* GetRawIterator() override {
-        auto iter = table_hander_->GetIterator();
+        auto iter = GetSourceIterator();
         if (!iter) {
             return nullptr;
         } else {
@@ -333,6 +368,18 @@ class TableProjectWrapper : public TableHandler {
     const Row& parameter_;
     Row value_;
     const ProjectFun* fun_;
+    const std::vector<uint32_t>* columns_;
+
+ private:
+    std::unique_ptr<RowIterator> GetSourceIterator() {
+        if (columns_ != nullptr && !columns_->empty()) {
+            auto iter = table_hander_->GetProjectIterator(*columns_);
+            if (iter) {
+                return iter;
+            }
+        }
+        return table_hander_->GetIterator();
+    }
 };
 
 class TableFilterWrapper : public TableHandler {
@@ -344,6 +391,11 @@ class TableFilterWrapper : public TableHandler {
     virtual ~TableFilterWrapper() {}
 
     std::unique_ptr<RowIterator> GetIterator() {
+        // evaluate the predicate inside the storage if the table supports it
+        auto filter_iter = GetPushdownIterator();
+        if (filter_iter) {
+            return filter_iter;
+        }
         auto iter = table_hander_->GetIterator();
         if (!iter) {
             return std::unique_ptr<RowIterator>();
@@ -370,6 +422,10 @@ class TableFilterWrapper : public TableHandler {
         return table_hander_->GetDatabase();
     }
     base::ConstIterator<uint64_t, Row>* GetRawIterator() override {
+        auto filter_iter = GetPushdownIterator();
+        if (filter_iter) {
+            return filter_iter.release();
+        }
         return new IteratorFilterWrapper(
             static_cast<std::unique_ptr<RowIterator>>(
                 table_hander_->GetRawIterator()),
@@ -381,6 +437,13 @@ class TableFilterWrapper : public TableHandler {
     virtual const OrderType GetOrderType() const {
         return table_hander_->GetOrderType();
     }
+    // iterator of the table with the predicate pushed down, null if unsupported
+    std::unique_ptr<RowIterator> GetPushdownIterator() {
+        auto fun = fun_;
+        Row parameter = parameter_;
+        return table_hander_->GetFilterIterator(
+            [fun, parameter](const Row& row) { return fun->operator()(row, parameter); });
+    }
     std::shared_ptr<TableHandler> table_hander_;
     const Row& parameter_;
     Row value_;
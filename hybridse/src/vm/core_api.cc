@@ -15,6 +15,7 @@
  */
 
 #include "vm/core_api.h"
+#include <vector>
 #include "base/sig_trace.h"
 #include "codec/fe_row_codec.h"
 #include "udf/default_udf_library.h"
@@ -243,6 +244,49 @@ hybridse::codec::Row CoreAPI::RowProject(const RawPtrHandle fn,
         buf, hybridse::codec::RowView::GetSize(buf)));
 }
 
+bool CoreAPI::RowProjectBatch(const RawPtrHandle batch_fn,
+                              const hybridse::codec::Row* rows, size_t cnt,
+                              const hybridse::codec::Row& parameter,
+                              hybridse::codec::Row* outputs) {
+    std::vector<size_t> idxs;
+    std::vector<const int8_t*> row_ptrs;
+    for (size_t i = 0; i < cnt; i++) {
+        outputs[i] = hybridse::codec::Row();
+        if (!rows[i].empty()) {
+            idxs.push_back(i);
+            row_ptrs.push_back(reinterpret_cast<const int8_t*>(&rows[i]));
+        }
+    }
+    if (idxs.empty()) {
+        return true;
+    }
+    // Init current run step runtime
+    JitRuntime::get()->InitRunStep();
+
+    auto udf = reinterpret_cast<int32_t (*)(const int64_t, const int8_t**,
+                                            const int8_t*, int8_t**, int32_t*)>(
+        const_cast<int8_t*>(batch_fn));
+
+    auto parameter_ptr = reinterpret_cast<const int8_t*>(&parameter);
+    std::vector<int8_t*> bufs(idxs.size(), nullptr);
+    std::vector<int32_t> rets(idxs.size(), 0);
+    int32_t fail_cnt = udf(idxs.size(), row_ptrs.data(), parameter_ptr, bufs.data(), rets.data());
+
+    // Release current run step resources
+    JitRuntime::get()->ReleaseRunStep();
+
+    // a failed row outputs an empty row, as RowProject does
+    for (size_t i = 0; i < idxs.size(); i++) {
+        if (rets[i] != 0) {
+            LOG(WARNING) << "fail to run udf " << rets[i];
+            continue;
+        }
+        outputs[idxs[i]] = Row(base::RefCountedSlice::CreateManaged(
+            bufs[i], hybridse::codec::RowView::GetSize(bufs[i])));
+    }
+    return fail_cnt == 0;
+}
+
 hybridse::codec::Row CoreAPI::UnsafeRowProject(
     const hybridse::vm::RawPtrHandle fn,
     hybridse::vm::ByteArrayPtr inputUnsafeRowBytes,
@@ -130,6 +130,13 @@ class CoreAPI {
                                            const hybridse::codec::Row row,
                                            const hybridse::codec::Row parameter,
                                            const bool need_free = false);
+    // Project rows[0, cnt) into outputs[0, cnt) in one call of the batch entry
+    // of a row project function. empty input rows and rows failed to project
+    // output empty rows, return false if any row failed.
+    static bool RowProjectBatch(const hybridse::vm::RawPtrHandle batch_fn,
+                                const hybridse::codec::Row* rows, size_t cnt,
+                                const hybridse::codec::Row& parameter,
+                                hybridse::codec::Row* outputs);
     static hybridse::codec::Row RowConstProject(
         const hybridse::vm::RawPtrHandle fn, const hybridse::codec::Row parameter,
         const bool need_free = false);
@@ -15,10 +15,13 @@
  */
 
 #include "vm/engine.h"
+#include <algorithm>
+#include <cctype>
 #include <string>
 #include <utility>
 #include <vector>
 #include "base/fe_strings.h"
+#include "boost/functional/hash.hpp"
 #include "boost/none.hpp"
 #include "boost/optional.hpp"
 #include "codec/fe_row_codec.h"
@@ -28,6 +31,7 @@
 #include "gflags/gflags.h"
 #include "llvm-c/Target.h"
 #include "udf/default_udf_library.h"
+#include "vm/jit.h"
 #include "vm/local_tablet_handler.h"
 #include "vm/mem_catalog.h"
 #include "vm/sql_compiler.h"
@@ -35,11 +39,16 @@
 DECLARE_bool(logtostderr);
 DECLARE_string(log_dir);
 DECLARE_bool(enable_spark_unsaferow_format);
+DECLARE_bool(enable_shared_jit);
+DECLARE_uint32(jit_session_max_dylibs);
+DECLARE_bool(enable_proxy_prefetch);
 
 namespace hybridse {
 namespace vm {
 
 static bool LLVM_IS_INITIALIZED = false;
+// bumped when the udf library changes, sessions of an older epoch are retired
+static std::atomic<uint64_t> JIT_SESSION_EPOCH(0);
 
 EngineOptions::EngineOptions()
     : keep_ir_(false),
@@ -53,9 +62,10 @@ EngineOptions::EngineOptions()
       max_sql_cache_size_(50) {
 }
 
-Engine::Engine(const std::shared_ptr<Catalog>& catalog) : cl_(catalog), options_(), mu_(), lru_cache_() {}
+Engine::Engine(const std::shared_ptr<Catalog>& catalog)
+    : cl_(catalog), options_(), cache_shards_(), cache_hit_cnt_(0), cache_miss_cnt_(0) {}
 Engine::Engine(const std::shared_ptr<Catalog>& catalog, const EngineOptions& options)
-    : cl_(catalog), options_(options), mu_(), lru_cache_() {}
+    : cl_(catalog), options_(options), cache_shards_(), cache_hit_cnt_(0), cache_miss_cnt_(0) {}
 Engine::~Engine() {}
 void Engine::InitializeGlobalLLVM() {
     if (LLVM_IS_INITIALIZED) return;
@@ -204,11 +214,14 @@ bool Engine::IsCompatibleCache(RunSession& session,  // NOLINT
 
 bool Engine::Get(const std::string& sql, const std::string& db, RunSession& session,
                  base::Status& status) {  // NOLINT (runtime/references)
-    std::shared_ptr<CompileInfo> cached_info = GetCacheLocked(db, sql, session.engine_mode());
+    std::string cache_key = GetSqlFingerprint(sql);
+    std::shared_ptr<CompileInfo> cached_info = GetCacheLocked(db, cache_key, session.engine_mode());
     if (cached_info && IsCompatibleCache(session, cached_info, status)) {
+        cache_hit_cnt_.fetch_add(1, std::memory_order_relaxed);
         session.SetCompileInfo(cached_info);
         return true;
     }
+    cache_miss_cnt_.fetch_add(1, std::memory_order_relaxed);
     // TODO(baoxinqi): IsCompatibleCache fail, return false, or reset status.
     if (!status.isOK()) {
         LOG(WARNING) << status;
@@ -227,6 +240,11 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
     sql_context.enable_window_column_pruning = options_.IsEnableWindowColumnPruning();
     sql_context.enable_expr_optimize = options_.IsEnableExprOptimize();
     sql_context.jit_options = options_.jit_options();
+    if (!options_.IsPlanOnly()) {
+        sql_context.jit_session = GetJitSession();
+    }
+    // only deployments are worth an on-disk cache
+    sql_context.enable_object_cache = !session.sp_name_.empty();
     sql_context.options = session.GetOptions();
     if (session.engine_mode() == kBatchMode) {
         sql_context.parameter_types = dynamic_cast<BatchRunSession*>(&session)->GetParameterSchema();
@@ -249,7 +267,7 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
         }
     }
 
-    SetCacheLocked(db, sql, session.engine_mode(), info);
+    SetCacheLocked(db, cache_key, session.engine_mode(), info);
     session.SetCompileInfo(info);
     if (session.is_debug_) {
         std::ostringstream plan_oss;
@@ -271,12 +289,40 @@ base::Status Engine::RegisterExternalFunction(const std::string& name, node::Dat
         return {common::kExternalUDFError, "function name is empty"};
     }
     auto lib = udf::DefaultUdfLibrary::get();
-    return lib->RegisterDynamicUdf(name, return_type, arg_types, is_aggregate, file);
+    auto status = lib->RegisterDynamicUdf(name, return_type, arg_types, is_aggregate, file);
+    // the symbols of the session are registered when it is created
+    ResetJitSession();
+    return status;
 }
 
 base::Status Engine::RemoveExternalFunction(const std::string& name,
         const std::vector<node::DataType>& arg_types, const std::string& file) {
-    return udf::DefaultUdfLibrary::get()->RemoveDynamicUdf(name, arg_types, file);
+    auto status = udf::DefaultUdfLibrary::get()->RemoveDynamicUdf(name, arg_types, file);
+    ResetJitSession();
+    return status;
+}
+
+std::shared_ptr<HybridSeJitSession> Engine::GetJitSession() {
+    if (!FLAGS_enable_shared_jit || options_.jit_options().IsEnableMcjit() ||
+        options_.jit_options().IsEnableAggressiveOpt()) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(jit_mu_);
+    uint64_t epoch = JIT_SESSION_EPOCH.load(std::memory_order_acquire);
+    if (jit_session_ == nullptr || jit_session_epoch_ != epoch ||
+        jit_session_->GetDylibCount() >= FLAGS_jit_session_max_dylibs) {
+        // compiled sql keep the retired session alive until they are evicted
+        jit_session_ = HybridSeJitWrapper::CreateSession();
+        jit_session_epoch_ = epoch;
+        if (jit_session_ == nullptr) {
+            LOG(WARNING) << "fail to create jit session, compile sql with a standalone jit";
+        }
+    }
+    return jit_session_;
+}
+
+void Engine::ResetJitSession() {
+    JIT_SESSION_EPOCH.fetch_add(1, std::memory_order_acq_rel);
 }
 
 bool Engine::Explain(const std::string& sql, const std::string& db, EngineMode engine_mode,
@@ -369,14 +415,20 @@ bool Engine::Explain(const std::string& sql, const std::string& db, EngineMode e
 }
 
 void Engine::ClearCacheLocked(const std::string& db) {
-    std::lock_guard<base::SpinMutex> lock(mu_);
     if (db.empty()) {
-        lru_cache_.clear();
+        for (auto& shard : cache_shards_) {
+            std::lock_guard<base::SpinMutex> lock(shard.mu);
+            shard.lru_cache.clear();
+        }
         return;
     }
-    for (auto& cache : lru_cache_) {
-        auto& mode_cache = cache.second;
-        mode_cache.erase(db);
+    // sql of the db are spread over all shards
+    for (auto& shard : cache_shards_) {
+        std::lock_guard<base::SpinMutex> lock(shard.mu);
+        for (auto& cache : shard.lru_cache) {
+            auto& mode_cache = cache.second;
+            mode_cache.erase(db);
+        }
     }
 }
 
@@ -384,12 +436,73 @@ EngineOptions Engine::GetEngineOptions() {
     return options_;
 }
 
+EngineCacheStats Engine::GetCacheStats() const {
+    EngineCacheStats stats;
+    stats.hit_cnt = cache_hit_cnt_.load(std::memory_order_relaxed);
+    stats.miss_cnt = cache_miss_cnt_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::string Engine::GetSqlFingerprint(const std::string& sql) {
+    std::string fingerprint;
+    fingerprint.reserve(sql.size());
+    char quote = 0;
+    bool pending_space = false;
+    for (size_t i = 0; i < sql.size(); i++) {
+        char c = sql[i];
+        if (quote != 0) {
+            fingerprint.push_back(c);
+            if (c == '\\' && quote != '`' && i + 1 < sql.size()) {
+                fingerprint.push_back(sql[++i]);
+            } else if (c == quote) {
+                quote = 0;
+            }
+            continue;
+        }
+        if (c == '#' || (c == '-' && i + 1 < sql.size() && sql[i + 1] == '-') ||
+            (c == '/' && i + 1 < sql.size() && sql[i + 1] == '*')) {
+            // newlines in comments are significant
+            return sql;
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pending_space = !fingerprint.empty();
+            continue;
+        }
+        if (pending_space) {
+            fingerprint.push_back(' ');
+            pending_space = false;
+        }
+        if (c == '\'' || c == '"' || c == '`') {
+            quote = c;
+        }
+        fingerprint.push_back(c);
+    }
+    if (quote == 0) {
+        while (!fingerprint.empty() && (fingerprint.back() == ';' || fingerprint.back() == ' ')) {
+            fingerprint.pop_back();
+        }
+    }
+    return fingerprint;
+}
+
+size_t Engine::GetCacheShardNum() const {
+    // a small cache stays in few shards, so it keeps the lru order of all its sql
+    return std::min<size_t>(CACHE_SHARD_NUM, std::max<uint32_t>(options_.GetMaxSqlCacheSize(), 1));
+}
+
+Engine::CacheShard& Engine::GetCacheShard(const std::string& db, const std::string& sql) {
+    size_t seed = std::hash<std::string>()(db);
+    boost::hash_combine(seed, std::hash<std::string>()(sql));
+    return cache_shards_[seed % GetCacheShardNum()];
+}
+
 std::shared_ptr<CompileInfo> Engine::GetCacheLocked(const std::string& db, const std::string& sql,
                                                     EngineMode engine_mode) {
-    std::lock_guard<base::SpinMutex> lock(mu_);
+    auto& shard = GetCacheShard(db, sql);
+    std::lock_guard<base::SpinMutex> lock(shard.mu);
     // Check mode
-    auto mode_iter = lru_cache_.find(engine_mode);
-    if (mode_iter == lru_cache_.end()) {
+    auto mode_iter = shard.lru_cache.find(engine_mode);
+    if (mode_iter == shard.lru_cache.end()) {
         return nullptr;
     }
     auto& mode_cache = mode_iter->second;
@@ -411,13 +524,17 @@ std::shared_ptr<CompileInfo> Engine::GetCacheLocked(const std::string& db, const
 
 bool Engine::SetCacheLocked(const std::string& db, const std::string& sql, EngineMode engine_mode,
                             std::shared_ptr<CompileInfo> info) {
-    std::lock_guard<base::SpinMutex> lock(mu_);
+    auto& shard = GetCacheShard(db, sql);
+    std::lock_guard<base::SpinMutex> lock(shard.mu);
 
-    auto& mode_cache = lru_cache_[engine_mode];
+    auto& mode_cache = shard.lru_cache[engine_mode];
     using BoostLRU = boost::compute::detail::lru_cache<std::string, std::shared_ptr<CompileInfo>>;
     std::map<std::string, BoostLRU>::iterator db_iter = mode_cache.find(db);
     if (db_iter == mode_cache.end()) {
-        db_iter = mode_cache.insert(db_iter, {db, BoostLRU(options_.GetMaxSqlCacheSize())});
+        // each shard keeps its part of the `max_sql_cache_size` sql of the db
+        size_t shard_num = GetCacheShardNum();
+        size_t capacity = (options_.GetMaxSqlCacheSize() + shard_num - 1) / shard_num;
+        db_iter = mode_cache.insert(db_iter, {db, BoostLRU(std::max<size_t>(capacity, 1))});
     }
     auto& lru = db_iter->second;
     auto value = lru.get(sql);
@@ -439,6 +556,58 @@ bool RunSession::SetCompileInfo(const std::shared_ptr<CompileInfo>& compile_info
     return true;
 }
 
+void RunSession::PrintProfile(std::ostream& output, const std::string& tab) const {
+    if (!profile_ || !compile_info_) {
+        output << tab << "NO PROFILE";
+        return;
+    }
+    auto& cluster_job = std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job;
+    output << tab << "PROFILED RUNS " << profile_->GetRunCnt();
+    // a tablet runs the main task or the sub tasks it is asked for, print the tasks it ran
+    for (size_t i = 0; i < cluster_job.GetTaskSize(); i++) {
+        auto root = cluster_job.GetTask(i).GetRoot();
+        if (nullptr == root || nullptr == profile_->GetRunner(root->id_)) {
+            continue;
+        }
+        output << "\n" << tab << (cluster_job.main_task_id() == static_cast<int32_t>(i) ? "MAIN TASK ID " : "TASK ID ")
+               << i << "\n";
+        std::set<int32_t> visited_ids;
+        root->PrintProfile(output, tab, *profile_, &visited_ids);
+    }
+}
+
+void RunProfile::Add(int32_t runner_id, const std::string& runner_type, uint64_t self_time_us,
+                     uint64_t total_time_us, uint64_t rows_out, bool rows_counted) {
+    auto& runner = runners_[runner_id];
+    runner.runner_type = runner_type;
+    runner.run_cnt++;
+    runner.self_time_us += self_time_us;
+    runner.total_time_us += total_time_us;
+    if (rows_counted) {
+        runner.rows_out += rows_out;
+    } else {
+        runner.uncounted_cnt++;
+    }
+}
+
+void RunProfile::Merge(const RunProfile& other) {
+    run_cnt_ += other.run_cnt_;
+    for (auto& kv : other.runners_) {
+        auto& runner = runners_[kv.first];
+        runner.runner_type = kv.second.runner_type;
+        runner.run_cnt += kv.second.run_cnt;
+        runner.self_time_us += kv.second.self_time_us;
+        runner.total_time_us += kv.second.total_time_us;
+        runner.rows_out += kv.second.rows_out;
+        runner.uncounted_cnt += kv.second.uncounted_cnt;
+    }
+}
+
+const RunnerProfile* RunProfile::GetRunner(int32_t runner_id) const {
+    auto iter = runners_.find(runner_id);
+    return iter == runners_.end() ? nullptr : &iter->second;
+}
+
 int32_t RequestRunSession::Run(const Row& in_row, Row* out_row) {
     DLOG(INFO) << "Request Row Run with main task";
     return Run(std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job.main_task_id(),
@@ -456,6 +625,13 @@ int32_t RequestRunSession::Run(const uint32_t task_id, const Row& in_row, Row* o
     DLOG(INFO) << "Request Row Run with task_id " << task_id;
     RunnerContext ctx(&std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context().cluster_job, in_row,
                       sp_name_, is_debug_);
+    if (profile_) {
+        profile_->AddRun();
+        ctx.SetProfile(profile_.get());
+    }
+    if (FLAGS_enable_proxy_prefetch && ctx.cluster_job()->GetTaskSize() > 1) {
+        ProxyRequestRunner::PrefetchIndependent(task, ctx, false);
+    }
     auto output = task->RunWithCache(ctx);
     if (!output) {
         LOG(WARNING) << "Run request plan output is null";
@@ -482,6 +658,9 @@ int32_t BatchRequestRunSession::Run(const uint32_t id, const std::vector<Row>& r
         LOG(WARNING) << "Fail to run request plan: taskid" << id << " not exist!";
         return -2;
     }
+    if (FLAGS_enable_proxy_prefetch && ctx.cluster_job()->GetTaskSize() > 1) {
+        ProxyRequestRunner::PrefetchIndependent(task, ctx, true);
+    }
     auto handler = task->BatchRequestRun(ctx);
     if (!handler) {
         LOG(WARNING) << "Run request plan output is null";
@@ -498,38 +677,84 @@ int32_t BatchRunSession::Run(std::vector<Row>& rows, uint64_t limit) {
     return Run(Row(), rows, limit);
 }
 int32_t BatchRunSession::Run(const Row& parameter_row, std::vector<Row>& rows, uint64_t limit) {
+    return Run(
+        parameter_row,
+        [&rows](const Row& row) {
+            rows.push_back(row);
+            return true;
+        },
+        limit);
+}
+int32_t BatchRunSession::Run(const Row& parameter_row, const std::function<bool(const Row&)>& consumer,
+                             uint64_t limit) {
+    std::unique_ptr<BatchRunCursor> cursor;
+    int32_t ret = Run(parameter_row, &cursor);
+    if (ret != 0) {
+        return ret;
+    }
+    while (cursor->Valid()) {
+        if (!consumer(cursor->GetValue())) {
+            break;
+        }
+        cursor->Next();
+    }
+    return 0;
+}
+
+int32_t BatchRunSession::Run(const Row& parameter_row, std::unique_ptr<BatchRunCursor>* cursor) {
+    std::unique_ptr<BatchRunCursor> run_cursor(new BatchRunCursor());
+    run_cursor->compile_info_ = compile_info_;
+    run_cursor->profile_ = profile_;
     auto& sql_ctx = std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context();
-    RunnerContext ctx(&sql_ctx.cluster_job, parameter_row, is_debug_);
-    auto output = sql_ctx.cluster_job.GetTask(0).GetRoot()->RunWithCache(ctx);
+    run_cursor->ctx_.reset(new RunnerContext(&sql_ctx.cluster_job, parameter_row, is_debug_));
+    if (profile_) {
+        profile_->AddRun();
+        run_cursor->ctx_->SetProfile(profile_.get());
+    }
+    auto output = sql_ctx.cluster_job.GetTask(0).GetRoot()->RunWithCache(*run_cursor->ctx_);
     if (!output) {
         DLOG(INFO) << "Run batch plan output is empty";
-        return 0;
-    }
-    switch (output->GetHandlerType()) {
-        case kTableHandler: {
-            auto iter = std::dynamic_pointer_cast<TableHandler>(output)->GetIterator();
-            if (!iter) {
-                return 0;
+    } else {
+        switch (output->GetHandlerType()) {
+            case kTableHandler: {
+                run_cursor->iter_ = std::dynamic_pointer_cast<TableHandler>(output)->GetIterator();
+                if (run_cursor->iter_) {
+                    run_cursor->iter_->SeekToFirst();
+                }
+                break;
             }
-            iter->SeekToFirst();
-            while (iter->Valid()) {
-                rows.push_back(iter->GetValue());
-                iter->Next();
+            case kRowHandler: {
+                run_cursor->row_ = std::dynamic_pointer_cast<RowHandler>(output)->GetValue();
+                run_cursor->row_valid_ = true;
+                break;
+            }
+            case kPartitionHandler: {
+                LOG(WARNING) << "Partition output is invalid";
+                return -1;
             }
-            return 0;
-        }
-        case kRowHandler: {
-            rows.push_back(std::dynamic_pointer_cast<RowHandler>(output)->GetValue());
-            return 0;
-        }
-        case kPartitionHandler: {
-            LOG(WARNING) << "Partition output is invalid";
-            return -1;
         }
     }
+    run_cursor->output_ = output;
+    *cursor = std::move(run_cursor);
     return 0;
 }
 
+BatchRunCursor::BatchRunCursor() : row_valid_(false) {}
+
+BatchRunCursor::~BatchRunCursor() {}
+
+bool BatchRunCursor::Valid() const { return iter_ ? iter_->Valid() : row_valid_; }
+
+const Row& BatchRunCursor::GetValue() { return iter_ ? iter_->GetValue() : row_; }
+
+void BatchRunCursor::Next() {
+    if (iter_) {
+        iter_->Next();
+    } else {
+        row_valid_ = false;
+    }
+}
+
 std::shared_ptr<RowHandler> LocalTablet::SubQuery(uint32_t task_id, const std::string& db, const std::string& sql,
                                                   const Row& row, const bool is_procedure, const bool is_debug) {
     DLOG(INFO) << "Local tablet SubQuery request: task id " << task_id;
@@ -14,15 +14,21 @@
  * limitations under the License.
  */
 
+#include <thread>  // NOLINT
 #include "case/case_data_mock.h"
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "gtest/internal/gtest-param-util.h"
 #include "testing/engine_test_base.h"
 #include "udf/openmldb_udf.h"
+#include "vm/sql_compiler.h"
 
 using namespace llvm;       // NOLINT (build/namespaces)
 using namespace llvm::orc;  // NOLINT (build/namespaces)
 
+DECLARE_bool(enable_shared_jit);
+DECLARE_uint32(jit_session_max_dylibs);
+
 namespace hybridse {
 namespace vm {
 using hybridse::sqlcase::CaseDataMock;
@@ -84,6 +90,74 @@ TEST_F(EngineCompileTest, EngineLRUCacheTest) {
 }
 
 
+TEST_F(EngineCompileTest, EngineSqlFingerprintTest) {
+    ASSERT_EQ("select col1, col2 from t1", Engine::GetSqlFingerprint("select col1, col2 from t1;"));
+    ASSERT_EQ("select col1, col2 from t1", Engine::GetSqlFingerprint("  select col1,\n\t col2\nfrom t1 ;\n"));
+    // quoted whitespace is kept
+    ASSERT_EQ("select 'a  b' as `c  d` from t1", Engine::GetSqlFingerprint("select 'a  b'  as `c  d` from t1;"));
+    ASSERT_EQ("select \"a\\\"  b\" from t1", Engine::GetSqlFingerprint("select  \"a\\\"  b\" from t1"));
+    // sql with comments are kept as they are
+    std::string sql = "select col1 -- comment\n, col2 from t1;";
+    ASSERT_EQ(sql, Engine::GetSqlFingerprint(sql));
+}
+
+TEST_F(EngineCompileTest, EngineCacheStatsTest) {
+    auto catalog = BuildSimpleCatalog();
+    for (auto db_name : {"db1", "db2"}) {
+        hybridse::type::Database db;
+        db.set_name(db_name);
+        hybridse::type::TableDef table_def;
+        sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+        table_def.set_name("t1");
+        AddTable(db, table_def);
+        catalog->AddDatabase(db);
+    }
+    EngineOptions options;
+    options.SetCompileOnly(true);
+    Engine engine(catalog, options);
+
+    base::Status get_status;
+    BatchRunSession bsession1;
+    ASSERT_TRUE(engine.Get("select col1, col2 from t1;", "db1", bsession1, get_status)) << get_status;
+    BatchRunSession bsession2;
+    ASSERT_TRUE(engine.Get("select col1,\n  col2\nfrom t1", "db1", bsession2, get_status)) << get_status;
+    ASSERT_EQ(bsession1.GetCompileInfo().get(), bsession2.GetCompileInfo().get());
+    BatchRunSession bsession3;
+    ASSERT_TRUE(engine.Get("select col1, col2 from t1;", "db2", bsession3, get_status)) << get_status;
+    ASSERT_NE(bsession1.GetCompileInfo().get(), bsession3.GetCompileInfo().get());
+
+    auto stats = engine.GetCacheStats();
+    ASSERT_EQ(1u, stats.hit_cnt);
+    ASSERT_EQ(2u, stats.miss_cnt);
+    ASSERT_DOUBLE_EQ(1.0 / 3, stats.HitRate());
+
+    engine.ClearCacheLocked("db1");
+    BatchRunSession bsession4;
+    ASSERT_TRUE(engine.Get("select col1, col2 from t1;", "db1", bsession4, get_status)) << get_status;
+    ASSERT_NE(bsession1.GetCompileInfo().get(), bsession4.GetCompileInfo().get());
+    BatchRunSession bsession5;
+    ASSERT_TRUE(engine.Get("select col1, col2 from t1;", "db2", bsession5, get_status)) << get_status;
+    ASSERT_EQ(bsession3.GetCompileInfo().get(), bsession5.GetCompileInfo().get());
+
+    // sql of a db are spread over the cache shards, clearing the db clears all of them
+    std::vector<std::shared_ptr<CompileInfo>> infos;
+    for (int i = 0; i < 32; i++) {
+        BatchRunSession session;
+        std::string sql = "select col1 + " + std::to_string(i) + " as c1 from t1;";
+        ASSERT_TRUE(engine.Get(sql, "db1", session, get_status)) << get_status;
+        infos.push_back(session.GetCompileInfo());
+    }
+    engine.ClearCacheLocked("db1");
+    uint64_t miss_cnt = engine.GetCacheStats().miss_cnt;
+    for (int i = 0; i < 32; i++) {
+        BatchRunSession session;
+        std::string sql = "select col1 + " + std::to_string(i) + " as c1 from t1;";
+        ASSERT_TRUE(engine.Get(sql, "db1", session, get_status)) << get_status;
+        ASSERT_NE(infos[i].get(), session.GetCompileInfo().get());
+    }
+    ASSERT_EQ(miss_cnt + 32, engine.GetCacheStats().miss_cnt);
+}
+
 TEST_F(EngineCompileTest, EngineWithParameterizedLRUCacheTest) {
     // Build Simple Catalog
     auto catalog = BuildSimpleCatalog();
@@ -663,6 +737,242 @@ TEST_F(EngineCompileTest, ExternalFunctionTest) {
     std::string sql2 = "select cut2(col0) from t1;";
     ASSERT_TRUE(engine.Get(sql2, "simple_db", session, get_status));
 }
+
+TEST_F(EngineCompileTest, SharedJitConcurrentCompileTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    const int thread_cnt = 4;
+    const int sql_cnt = 16;
+    EngineOptions options;
+    options.SetMaxSqlCacheSize(thread_cnt * sql_cnt);
+    Engine engine(catalog, options);
+    // sql are compiled into the same session from all threads
+    std::vector<std::vector<std::shared_ptr<CompileInfo>>> infos(thread_cnt);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_cnt; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < sql_cnt; i++) {
+                std::string sql = "select col1 + " + std::to_string(t * sql_cnt + i) +
+                                  " as c1, substring(col0, 1, " + std::to_string(i % 3 + 1) + ") as c2 from t1;";
+                base::Status get_status;
+                BatchRunSession session;
+                EXPECT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+                infos[t].push_back(session.GetCompileInfo());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto& thread_infos : infos) {
+        ASSERT_EQ(static_cast<size_t>(sql_cnt), thread_infos.size());
+        for (auto& info : thread_infos) {
+            ASSERT_TRUE(info != nullptr);
+            auto& ctx = std::dynamic_pointer_cast<SqlCompileInfo>(info)->get_sql_context();
+            ASSERT_TRUE(ctx.jit != nullptr);
+            ASSERT_TRUE(ctx.jit_session != nullptr);
+        }
+    }
+}
+
+TEST_F(EngineCompileTest, SharedJitSessionResetTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    auto compile_session = [](Engine& engine, const std::string& sql) -> std::shared_ptr<HybridSeJitSession> {
+        base::Status get_status;
+        BatchRunSession session;
+        EXPECT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+        return std::dynamic_pointer_cast<SqlCompileInfo>(session.GetCompileInfo())->get_sql_context().jit_session;
+    };
+    Engine engine1(catalog);
+    Engine engine2(catalog);
+    auto session1 = compile_session(engine1, "select col1 + 1 as c1 from t1;");
+    auto session2 = compile_session(engine2, "select col1 + 1 as c1 from t1;");
+    ASSERT_TRUE(session1 != nullptr);
+    ASSERT_TRUE(session2 != nullptr);
+    ASSERT_EQ(session1.get(), compile_session(engine1, "select col1 + 2 as c1 from t1;").get());
+    // a udf change retires the sessions of every engine
+    Engine::ResetJitSession();
+    ASSERT_NE(session1.get(), compile_session(engine1, "select col1 + 3 as c1 from t1;").get());
+    ASSERT_NE(session2.get(), compile_session(engine2, "select col1 + 3 as c1 from t1;").get());
+}
+
+TEST_F(EngineCompileTest, SharedJitSessionRetireTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    uint32_t max_dylibs = FLAGS_jit_session_max_dylibs;
+    FLAGS_jit_session_max_dylibs = 2;
+    EngineOptions options;
+    options.SetMaxSqlCacheSize(8);
+    Engine engine(catalog, options);
+    std::vector<std::shared_ptr<CompileInfo>> infos;
+    for (int i = 0; i < 5; i++) {
+        // same function names in every dylib
+        std::string sql = "select col1 + " + std::to_string(i) + " as c1 from t1;";
+        base::Status get_status;
+        BatchRunSession session;
+        ASSERT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+        infos.push_back(session.GetCompileInfo());
+    }
+    FLAGS_jit_session_max_dylibs = max_dylibs;
+
+    // sql compiled in retired sessions keep their session alive
+    for (auto& info : infos) {
+        auto& ctx = std::dynamic_pointer_cast<SqlCompileInfo>(info)->get_sql_context();
+        ASSERT_TRUE(ctx.jit != nullptr);
+        ASSERT_TRUE(ctx.jit_session != nullptr);
+    }
+    auto& ctx0 = std::dynamic_pointer_cast<SqlCompileInfo>(infos[0])->get_sql_context();
+    auto& ctx4 = std::dynamic_pointer_cast<SqlCompileInfo>(infos[4])->get_sql_context();
+    ASSERT_NE(ctx0.jit_session.get(), ctx4.jit_session.get());
+}
+
+TEST_F(EngineCompileTest, RunProfileTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    std::vector<Row> rows;
+    CaseDataMock::BuildOnePkTableData(table_def, rows, 10);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+    ASSERT_TRUE(catalog->InsertRows("simple_db", "t1", rows));
+
+    EngineOptions options;
+    Engine engine(catalog, options);
+    base::Status get_status;
+    BatchRunSession session;
+    ASSERT_TRUE(engine.Get("select col1 + 1 as c1 from t1;", "simple_db", session, get_status)) << get_status;
+    auto profile = std::make_shared<RunProfile>();
+    session.SetProfile(profile);
+    for (int i = 0; i < 2; i++) {
+        std::vector<Row> outputs;
+        ASSERT_EQ(0, session.Run(outputs));
+        ASSERT_EQ(10u, outputs.size());
+    }
+    ASSERT_EQ(2u, profile->GetRunCnt());
+
+    auto root = std::dynamic_pointer_cast<SqlCompileInfo>(session.GetCompileInfo())
+                    ->get_sql_context()
+                    .cluster_job.GetTask(0)
+                    .GetRoot();
+    auto stat = profile->GetRunner(root->id_);
+    ASSERT_TRUE(stat != nullptr);
+    ASSERT_EQ(2u, stat->run_cnt);
+    ASSERT_EQ(20u, stat->rows_out);
+    ASSERT_GE(stat->total_time_us, stat->self_time_us);
+    ASSERT_EQ(0u, stat->uncounted_cnt);
+    bool has_uncounted = false;
+    for (auto& kv : profile->GetRunners()) {
+        ASSERT_EQ(2u, kv.second.run_cnt) << kv.second.runner_type;
+        // the table of the catalog is not scanned to count its rows
+        if (kv.second.runner_type == "DATA") {
+            ASSERT_EQ(2u, kv.second.uncounted_cnt);
+            ASSERT_EQ(0u, kv.second.rows_out);
+            has_uncounted = true;
+        }
+    }
+    ASSERT_TRUE(has_uncounted);
+
+    std::ostringstream oss;
+    session.PrintProfile(oss, "");
+    LOG(INFO) << "profile:\n" << oss.str();
+    ASSERT_NE(std::string::npos, oss.str().find("rows=20"));
+    ASSERT_NE(std::string::npos, oss.str().find("rows=n/a"));
+
+    // a session without profile records nothing
+    BatchRunSession plain_session;
+    ASSERT_TRUE(engine.Get("select col1 + 1 as c1 from t1;", "simple_db", plain_session, get_status));
+    std::vector<Row> outputs;
+    ASSERT_EQ(0, plain_session.Run(outputs));
+    ASSERT_EQ(2u, profile->GetRunCnt());
+}
+
+TEST_F(EngineCompileTest, BatchRunConsumerTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    std::vector<Row> rows;
+    CaseDataMock::BuildOnePkTableData(table_def, rows, 10);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+    ASSERT_TRUE(catalog->InsertRows("simple_db", "t1", rows));
+
+    EngineOptions options;
+    Engine engine(catalog, options);
+    base::Status get_status;
+    BatchRunSession session;
+    ASSERT_TRUE(engine.Get("select col1, col6 from t1;", "simple_db", session, get_status)) << get_status;
+
+    std::vector<Row> outputs;
+    ASSERT_EQ(0, session.Run(Row(), outputs));
+    ASSERT_EQ(10u, outputs.size());
+
+    // rows are passed one by one, the consumer stops the iteration
+    size_t consumed = 0;
+    ASSERT_EQ(0, session.Run(Row(), [&consumed](const Row& row) { return ++consumed < 3; }));
+    ASSERT_EQ(3u, consumed);
+}
+
+TEST_F(EngineCompileTest, BatchRunCursorTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    std::vector<Row> rows;
+    CaseDataMock::BuildOnePkTableData(table_def, rows, 10);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+    ASSERT_TRUE(catalog->InsertRows("simple_db", "t1", rows));
+
+    EngineOptions options;
+    Engine engine(catalog, options);
+    base::Status get_status;
+    std::vector<Row> outputs;
+    std::unique_ptr<BatchRunCursor> cursor;
+    {
+        BatchRunSession session;
+        ASSERT_TRUE(engine.Get("select col1, col6 from t1;", "simple_db", session, get_status)) << get_status;
+        ASSERT_EQ(0, session.Run(Row(), outputs));
+        ASSERT_EQ(0, session.Run(Row(), &cursor));
+    }
+    // the cursor outlives its session, it is consumed in two parts as by two chunked requests
+    for (size_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(cursor->Valid());
+        ASSERT_EQ(0, cursor->GetValue().compare(outputs[i]));
+        cursor->Next();
+    }
+    size_t cnt = 4;
+    for (; cursor->Valid(); cursor->Next()) {
+        ASSERT_EQ(0, cursor->GetValue().compare(outputs[cnt++]));
+    }
+    ASSERT_EQ(10u, cnt);
+}
 }  // namespace vm
 }  // namespace hybridse
 
@@ -15,13 +15,23 @@
  */
 
 #include "vm/jit.h"
+#include <unistd.h>
+#include <utime.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 extern "C" {
 #include <cmath>
 #include <cstdlib>
 }
+#include "gflags/gflags.h"
 #include "glog/logging.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/ExecutionEngine/JITEventListener.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
@@ -35,7 +45,16 @@ extern "C" {
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/AlwaysInliner.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
@@ -44,15 +63,26 @@ extern "C" {
 #include "llvm_ext/symbol_resolve.h"
 #endif
 
+DECLARE_string(jit_object_cache_dir);
+DECLARE_uint32(jit_object_cache_max_size_mb);
+
 namespace hybridse {
 namespace vm {
 using ::llvm::orc::LLJIT;
 
+static const char OBJECT_CACHE_KEY_PREFIX[] = "objcache_";
+static const char OBJECT_CACHE_UNOPTIMIZED_FLAG[] = "hybridse_unoptimized";
+
 HybridSeJit::HybridSeJit(::llvm::orc::LLJITBuilderState& s, ::llvm::Error& e)
     : LLJIT(s, e) {}
 HybridSeJit::~HybridSeJit() {}
 
 static void RunDefaultOptPasses(::llvm::Module* m) {
+    // Inline the row functions called by their batch entries
+    ::llvm::legacy::PassManager mpm;
+    mpm.add(::llvm::createAlwaysInlinerLegacyPass());
+    mpm.run(*m);
+
     ::llvm::legacy::FunctionPassManager fpm(m);
     // Add some optimizations.
     fpm.add(::llvm::createInstructionCombiningPass());
@@ -60,6 +90,7 @@ static void RunDefaultOptPasses(::llvm::Module* m) {
     fpm.add(::llvm::createGVNPass());
     fpm.add(::llvm::createCFGSimplificationPass());
     fpm.add(::llvm::createPromoteMemoryToRegisterPass());
+    fpm.add(::llvm::createLICMPass());
     fpm.doInitialization();
     for (auto it = m->begin(); it != m->end(); ++it) {
         fpm.run(*it);
@@ -78,12 +109,45 @@ static void RunDefaultOptPasses(::llvm::Module* m) {
     return CompileLayer->add(jd, std::move(tsm), key);
 }
 
-bool HybridSeJit::OptModule(::llvm::Module* m) {
+// O3 with inlining and loop/slp vectorization, tuned by the target
+static void RunAggressiveOptPasses(::llvm::Module* m,
+                                   ::llvm::TargetMachine* tm) {
+    m->setTargetTriple(tm->getTargetTriple().str());
+    ::llvm::PassManagerBuilder builder;
+    builder.OptLevel = 3;
+    builder.SizeLevel = 0;
+    builder.Inliner = ::llvm::createFunctionInliningPass(3, 0, false);
+    builder.LoopVectorize = true;
+    builder.SLPVectorize = true;
+    tm->adjustPassManager(builder);
+
+    ::llvm::legacy::FunctionPassManager fpm(m);
+    fpm.add(::llvm::createTargetTransformInfoWrapperPass(
+        tm->getTargetIRAnalysis()));
+    builder.populateFunctionPassManager(fpm);
+    ::llvm::legacy::PassManager mpm;
+    mpm.add(::llvm::createTargetTransformInfoWrapperPass(
+        tm->getTargetIRAnalysis()));
+    builder.populateModulePassManager(mpm);
+
+    fpm.doInitialization();
+    for (auto it = m->begin(); it != m->end(); ++it) {
+        fpm.run(*it);
+    }
+    fpm.doFinalization();
+    mpm.run(*m);
+}
+
+bool HybridSeJit::OptModule(::llvm::Module* m, ::llvm::TargetMachine* tm) {
     if (auto err = applyDataLayout(*m)) {
         return false;
     }
     DLOG(INFO) << "Module before opt:\n" << LlvmToString(*m);
-    RunDefaultOptPasses(m);
+    if (tm != nullptr) {
+        RunAggressiveOptPasses(m, tm);
+    } else {
+        RunDefaultOptPasses(m);
+    }
     DLOG(INFO) << "Module after opt:\n" << LlvmToString(*m);
     return true;
 }
@@ -148,10 +212,57 @@ bool HybridSeJit::AddSymbol(::llvm::orc::JITDylib& jd,
     }
 }
 
+HybridSeLlvmJitWrapper::~HybridSeLlvmJitWrapper() {
+    if (session_ != nullptr && jd_ != nullptr) {
+        session_->ReleaseDylib(jd_, symbols_);
+    }
+}
+
+HybridSeJit* HybridSeLlvmJitWrapper::GetJit() {
+    return session_ != nullptr ? session_->GetJit() : jit_.get();
+}
+
 bool HybridSeLlvmJitWrapper::Init() {
+    if (session_ != nullptr) {
+        jd_ = session_->CreateDylib();
+        auto jit = session_->GetJit();
+        this->mi_ = std::unique_ptr<::llvm::orc::MangleAndInterner>(
+            new ::llvm::orc::MangleAndInterner(jit->getExecutionSession(),
+                                               jit->getDataLayout()));
+        return true;
+    }
     DLOG(INFO) << "Start to initialize hybridse jit";
-    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(
-        HybridSeJitBuilder().create());
+    HybridSeJitBuilder builder;
+    if (jit_options_.IsEnableAggressiveOpt()) {
+        auto jtmb = ::llvm::orc::JITTargetMachineBuilder::detectHost();
+        if (!jtmb) {
+            LOG(WARNING) << "fail to detect host target: "
+                         << LlvmToString(jtmb.takeError());
+            return false;
+        }
+        jtmb->setCPU(::llvm::sys::getHostCPUName());
+        jtmb->setCodeGenOptLevel(::llvm::CodeGenOpt::Aggressive);
+        auto tm = jtmb->createTargetMachine();
+        if (!tm) {
+            LOG(WARNING) << "fail to create host target machine: "
+                         << LlvmToString(tm.takeError());
+            return false;
+        }
+        tm_ = std::move(*tm);
+        builder.setJITTargetMachineBuilder(std::move(*jtmb));
+    }
+    // a jit of a session is shared by the sql compiled concurrently, the
+    // concurrent compiler creates a target machine for each module instead of
+    // sharing a single one which is not thread safe
+    auto object_cache = HybridSeObjectCache::Get();
+    builder.setCompileFunctionCreator(
+        [object_cache](::llvm::orc::JITTargetMachineBuilder jtmb)
+            -> ::llvm::Expected<::llvm::orc::IRCompileLayer::CompileFunction> {
+            return ::llvm::orc::IRCompileLayer::CompileFunction(
+                ::llvm::orc::ConcurrentIRCompiler(std::move(jtmb),
+                                                  object_cache));
+        });
+    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(builder.create());
     {
         ::llvm::Error e = jit.takeError();
         if (e) {
@@ -162,6 +273,7 @@ bool HybridSeLlvmJitWrapper::Init() {
     }
     this->jit_ = std::move(jit.get());
     jit_->Init();
+    jd_ = &jit_->getMainJITDylib();
 
     this->mi_ = std::unique_ptr<::llvm::orc::MangleAndInterner>(
         new ::llvm::orc::MangleAndInterner(jit_->getExecutionSession(),
@@ -170,13 +282,25 @@ bool HybridSeLlvmJitWrapper::Init() {
 }
 
 bool HybridSeLlvmJitWrapper::OptModule(::llvm::Module* module) {
-    return jit_->OptModule(module);
+    return GetJit()->OptModule(module, tm_.get());
 }
 
 bool HybridSeLlvmJitWrapper::AddModule(
     std::unique_ptr<llvm::Module> module,
     std::unique_ptr<llvm::LLVMContext> llvm_ctx) {
-    ::llvm::Error e = jit_->addIRModule(
+    if (session_ != nullptr) {
+        // remember the definitions to drop them from the session later
+        for (auto& gv : module->global_values()) {
+            if (!gv.hasName() || gv.isDeclaration() || gv.hasLocalLinkage() ||
+                gv.hasAvailableExternallyLinkage() ||
+                gv.hasAppendingLinkage()) {
+                continue;
+            }
+            symbols_.insert((*mi_)(gv.getName()));
+        }
+    }
+    ::llvm::Error e = GetJit()->addIRModule(
+        *jd_,
         ::llvm::orc::ThreadSafeModule(std::move(module), std::move(llvm_ctx)));
     if (e) {
         LOG(WARNING) << "fail to add ir module: " << LlvmToString(e);
@@ -189,7 +313,8 @@ RawPtrHandle HybridSeLlvmJitWrapper::FindFunction(const std::string& funcname) {
     if (funcname == "") {
         return 0;
     }
-    ::llvm::Expected<::llvm::JITEvaluatedSymbol> symbol(jit_->lookup(funcname));
+    ::llvm::Expected<::llvm::JITEvaluatedSymbol> symbol(
+        GetJit()->lookup(*jd_, funcname));
     ::llvm::Error e = symbol.takeError();
     if (e) {
         LOG(WARNING) << "fail to resolve fn address of" << funcname << ": "
@@ -201,8 +326,191 @@ RawPtrHandle HybridSeLlvmJitWrapper::FindFunction(const std::string& funcname) {
 
 bool HybridSeLlvmJitWrapper::AddExternalFunction(const std::string& name,
                                                void* addr) {
-    return hybridse::vm::HybridSeJit::AddSymbol(jit_->getMainJITDylib(), *mi_,
-                                                name, addr);
+    if (session_ != nullptr) {
+        symbols_.insert((*mi_)(name));
+    }
+    return hybridse::vm::HybridSeJit::AddSymbol(*jd_, *mi_, name, addr);
+}
+
+bool HybridSeJitSession::Init() {
+    if (!main_.Init()) {
+        LOG(WARNING) << "fail to init jit session";
+        return false;
+    }
+    return HybridSeJitWrapper::InitJitSymbols(&main_);
+}
+
+::llvm::orc::JITDylib* HybridSeJitSession::CreateDylib() {
+    uint64_t id = dylib_cnt_.fetch_add(1, std::memory_order_relaxed);
+    auto jit = GetJit();
+    auto& jd = jit->getExecutionSession().createJITDylib(
+        "sql_" + std::to_string(id), false);
+    // builtin symbols are defined with the default (non-exported) flags
+    jd.addToSearchOrder(jit->getMainJITDylib(), true);
+    return &jd;
+}
+
+void HybridSeJitSession::ReleaseDylib(
+    ::llvm::orc::JITDylib* jd, const ::llvm::orc::SymbolNameSet& symbols) {
+    if (jd == nullptr || symbols.empty()) {
+        return;
+    }
+    if (auto err = jd->remove(symbols)) {
+        LOG(WARNING) << "fail to remove symbols of " << jd->getName() << ": "
+                     << LlvmToString(err);
+    }
+}
+
+HybridSeObjectCache* HybridSeObjectCache::Get() {
+    static HybridSeObjectCache* cache = []() -> HybridSeObjectCache* {
+        if (FLAGS_jit_object_cache_dir.empty()) {
+            return nullptr;
+        }
+        auto ec = ::llvm::sys::fs::create_directories(
+            FLAGS_jit_object_cache_dir);
+        if (ec) {
+            LOG(WARNING) << "fail to create jit object cache dir "
+                         << FLAGS_jit_object_cache_dir << ": " << ec.message();
+            return nullptr;
+        }
+        auto cache = new HybridSeObjectCache(
+            FLAGS_jit_object_cache_dir,
+            static_cast<uint64_t>(FLAGS_jit_object_cache_max_size_mb) << 20);
+        cache->Evict();
+        return cache;
+    }();
+    return cache;
+}
+
+std::string HybridSeObjectCache::GetModuleKey(const ::llvm::Module& m,
+                                              bool aggressive_opt) {
+    ::llvm::MD5 md5;
+    md5.update(LLVM_VERSION_STRING);
+    md5.update(aggressive_opt ? "aggressive" : "default");
+    md5.update(::llvm::sys::getProcessTriple());
+    md5.update(::llvm::sys::getHostCPUName());
+    ::llvm::StringMap<bool> features;
+    if (::llvm::sys::getHostCPUFeatures(features)) {
+        // StringMap is unordered
+        std::map<std::string, bool> sorted;
+        for (auto& feature : features) {
+            sorted[feature.getKey().str()] = feature.getValue();
+        }
+        for (auto& feature : sorted) {
+            md5.update(feature.first);
+            md5.update(feature.second ? "+" : "-");
+        }
+    }
+    md5.update(LlvmToString(m));
+    ::llvm::MD5::MD5Result result;
+    md5.final(result);
+    return OBJECT_CACHE_KEY_PREFIX + result.digest().str().str();
+}
+
+void HybridSeObjectCache::MarkUnoptimized(::llvm::Module* m) {
+    m->addModuleFlag(::llvm::Module::Warning, OBJECT_CACHE_UNOPTIMIZED_FLAG, 1);
+}
+
+std::string HybridSeObjectCache::GetPath(const std::string& key) const {
+    return dir_ + "/" + key + ".o";
+}
+
+bool HybridSeObjectCache::Contains(const std::string& key) const {
+    return ::llvm::sys::fs::exists(GetPath(key));
+}
+
+void HybridSeObjectCache::notifyObjectCompiled(const ::llvm::Module* m,
+                                               ::llvm::MemoryBufferRef obj) {
+    const std::string& key = m->getModuleIdentifier();
+    if (key.compare(0, sizeof(OBJECT_CACHE_KEY_PREFIX) - 1,
+                    OBJECT_CACHE_KEY_PREFIX) != 0 ||
+        m->getModuleFlag(OBJECT_CACHE_UNOPTIMIZED_FLAG) != nullptr) {
+        return;
+    }
+    // write to a temporary file then rename, so readers never see a partial
+    // object when tablets share the dir or crash while writing
+    std::string path = GetPath(key);
+    std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+        ofs.write(obj.getBufferStart(), obj.getBufferSize());
+        if (!ofs.good()) {
+            LOG(WARNING) << "fail to write jit object cache " << tmp_path;
+            std::remove(tmp_path.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        LOG(WARNING) << "fail to rename jit object cache " << tmp_path;
+        std::remove(tmp_path.c_str());
+        return;
+    }
+    DLOG(INFO) << "cache object of module " << key;
+    Evict();
+}
+
+void HybridSeObjectCache::Evict() {
+    if (max_size_ == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(evict_mu_);
+    // <last use time, size, path>, the modification time is refreshed on
+    // every load
+    std::vector<std::tuple<::llvm::sys::TimePoint<>, uint64_t, std::string>>
+        objects;
+    uint64_t total_size = 0;
+    std::error_code ec;
+    for (::llvm::sys::fs::directory_iterator it(dir_, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        const std::string& path = it->path();
+        if (::llvm::sys::path::extension(path) != ".o") {
+            continue;
+        }
+        ::llvm::sys::fs::file_status st;
+        if (::llvm::sys::fs::status(path, st)) {
+            continue;
+        }
+        objects.emplace_back(st.getLastModificationTime(), st.getSize(), path);
+        total_size += st.getSize();
+    }
+    if (ec) {
+        LOG(WARNING) << "fail to list jit object cache dir " << dir_ << ": "
+                     << ec.message();
+        return;
+    }
+    if (total_size <= max_size_) {
+        return;
+    }
+    std::sort(objects.begin(), objects.end());
+    for (auto& object : objects) {
+        if (total_size <= max_size_) {
+            break;
+        }
+        if (::llvm::sys::fs::remove(std::get<2>(object))) {
+            continue;
+        }
+        total_size -= std::get<1>(object);
+        DLOG(INFO) << "evict jit object cache " << std::get<2>(object);
+    }
+}
+
+std::unique_ptr<::llvm::MemoryBuffer> HybridSeObjectCache::getObject(
+    const ::llvm::Module* m) {
+    const std::string& key = m->getModuleIdentifier();
+    if (key.compare(0, sizeof(OBJECT_CACHE_KEY_PREFIX) - 1,
+                    OBJECT_CACHE_KEY_PREFIX) != 0) {
+        return nullptr;
+    }
+    std::string path = GetPath(key);
+    auto buf = ::llvm::MemoryBuffer::getFile(path, -1, false);
+    if (!buf) {
+        return nullptr;
+    }
+    // mark it as recently used, so that it outlives the objects of dropped
+    // deployments on eviction
+    utime(path.c_str(), nullptr);
+    DLOG(INFO) << "load object of module " << key << " from cache";
+    return std::move(buf.get());
 }
 
 #ifdef LLVM_EXT_ENABLE
@@ -17,10 +17,13 @@
 #ifndef HYBRIDSE_SRC_VM_JIT_H_
 #define HYBRIDSE_SRC_VM_JIT_H_
 
+#include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include "llvm/ExecutionEngine/GenericValue.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
 #include "vm/jit_wrapper.h"
 
@@ -48,7 +51,8 @@ class HybridSeJit : public ::llvm::orc::LLJIT {
                               ::llvm::orc::ThreadSafeModule tsm,
                               ::llvm::orc::VModuleKey key);
 
-    bool OptModule(::llvm::Module* m);
+    // run the aggressive pipeline tuned for `tm` if it is set
+    bool OptModule(::llvm::Module* m, ::llvm::TargetMachine* tm = nullptr);
 
     ::llvm::orc::VModuleKey CreateVModule();
 
@@ -70,6 +74,50 @@ class HybridSeJit : public ::llvm::orc::LLJIT {
     HybridSeJit(::llvm::orc::LLJITBuilderState& s, ::llvm::Error& e);  // NOLINT
 };
 
+// An on-disk cache of the object code of compiled modules, so that
+// deployments skip ir optimization and machine code generation on restart.
+//
+// Only modules named by GetModuleKey() are cached, as `<dir>/<key>.o`. The
+// key hashes the unoptimized ir with the host cpu and llvm version, so any
+// change of sql, schemas or udf declarations gives another key. Objects of
+// dropped or changed deployments are never loaded again, so the least
+// recently used objects are removed once the dir exceeds `max_size` bytes.
+class HybridSeObjectCache : public ::llvm::ObjectCache {
+ public:
+    HybridSeObjectCache(const std::string& dir, uint64_t max_size)
+        : dir_(dir), max_size_(max_size) {}
+    ~HybridSeObjectCache() {}
+
+    // the process-wide cache, null if `jit_object_cache_dir` is empty
+    static HybridSeObjectCache* Get();
+
+    static std::string GetModuleKey(const ::llvm::Module& m,
+                                    bool aggressive_opt);
+
+    // mark a module whose passes were skipped for a cached object, so that
+    // its object is never written back if the cached file disappeared
+    static void MarkUnoptimized(::llvm::Module* m);
+
+    bool Contains(const std::string& key) const;
+
+    // remove the least recently used objects until the dir fits in the max
+    // size, no-op if the max size is 0
+    void Evict();
+
+    void notifyObjectCompiled(const ::llvm::Module* m,
+                              ::llvm::MemoryBufferRef obj) override;
+
+    std::unique_ptr<::llvm::MemoryBuffer> getObject(
+        const ::llvm::Module* m) override;
+
+ private:
+    std::string GetPath(const std::string& key) const;
+
+    std::string dir_;
+    uint64_t max_size_;
+    std::mutex evict_mu_;
+};
+
 class HybridSeJitBuilder
     : public ::llvm::orc::LLJITBuilderState,
       public ::llvm::orc::LLJITBuilderSetters<HybridSeJit, HybridSeJitBuilder,
@@ -88,7 +136,13 @@ std::string LlvmToString(const T& value) {
 class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
  public:
     HybridSeLlvmJitWrapper() {}
-    ~HybridSeLlvmJitWrapper() {}
+    explicit HybridSeLlvmJitWrapper(const JitOptions& jit_options)
+        : jit_options_(jit_options) {}
+    // compile into a new dylib of `session`, which is dropped on destruction
+    explicit HybridSeLlvmJitWrapper(
+        const std::shared_ptr<HybridSeJitSession>& session)
+        : session_(session) {}
+    ~HybridSeLlvmJitWrapper();
 
     bool Init() override;
 
@@ -102,11 +156,52 @@ class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
     hybridse::vm::RawPtrHandle FindFunction(
         const std::string& funcname) override;
 
+    HybridSeJit* GetJit();
+
  private:
+    JitOptions jit_options_;
     std::unique_ptr<HybridSeJit> jit_;
+    // the host target of the aggressive pipeline
+    std::unique_ptr<::llvm::TargetMachine> tm_;
+    std::shared_ptr<HybridSeJitSession> session_;
+    // the dylib modules and symbols are added to
+    ::llvm::orc::JITDylib* jd_ = nullptr;
+    // symbols defined in the session dylib
+    ::llvm::orc::SymbolNameSet symbols_;
     std::unique_ptr<::llvm::orc::MangleAndInterner> mi_;
 };
 
+// A long-lived LLJIT whose main dylib holds the builtin and udf symbols.
+//
+// Each sql is compiled into its own dylib searching the main dylib, so the
+// builtin symbols are registered once per session instead of once per sql.
+// The symbols of a dylib are removed when its jit wrapper is released, while
+// the code memory stays until the session is destroyed. The engine replaces
+// its session after `jit_session_max_dylibs` dylibs to bound the memory.
+class HybridSeJitSession {
+ public:
+    HybridSeJitSession() : dylib_cnt_(0) {}
+    ~HybridSeJitSession() {}
+
+    bool Init();
+
+    HybridSeJit* GetJit() { return main_.GetJit(); }
+
+    ::llvm::orc::JITDylib* CreateDylib();
+
+    void ReleaseDylib(::llvm::orc::JITDylib* jd,
+                      const ::llvm::orc::SymbolNameSet& symbols);
+
+    // the number of dylibs created in the session
+    uint64_t GetDylibCount() const {
+        return dylib_cnt_.load(std::memory_order_relaxed);
+    }
+
+ private:
+    HybridSeLlvmJitWrapper main_;
+    std::atomic<uint64_t> dylib_cnt_;
+};
+
 #ifdef LLVM_EXT_ENABLE
 class HybridSeMcJitWrapper : public HybridSeJitWrapper {
  public:
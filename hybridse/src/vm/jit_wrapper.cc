@@ -15,6 +15,7 @@
  */
 #include "vm/jit_wrapper.h"
 
+#include <memory>
 #include <string>
 #include <utility>
 #include "glog/logging.h"
@@ -83,8 +84,21 @@ HybridSeJitWrapper* HybridSeJitWrapper::Create(const JitOptions& jit_options) {
             jit_options.IsEnableGdb()) {
             LOG(WARNING) << "LLJIT do not support jit events";
         }
-        return new HybridSeLlvmJitWrapper();
+        return new HybridSeLlvmJitWrapper(jit_options);
+    }
+}
+
+HybridSeJitWrapper* HybridSeJitWrapper::Create(
+    const std::shared_ptr<HybridSeJitSession>& session) {
+    return new HybridSeLlvmJitWrapper(session);
+}
+
+std::shared_ptr<HybridSeJitSession> HybridSeJitWrapper::CreateSession() {
+    auto session = std::make_shared<HybridSeJitSession>();
+    if (!session->Init()) {
+        return nullptr;
     }
+    return session;
 }
 
 void HybridSeJitWrapper::DeleteJit(HybridSeJitWrapper* jit) {
@@ -31,6 +31,7 @@ namespace hybridse {
 namespace vm {
 
 class JitOptions;
+class HybridSeJitSession;
 
 class HybridSeJitWrapper {
  public:
@@ -53,9 +54,17 @@ class HybridSeJitWrapper {
 
     static HybridSeJitWrapper* Create(const JitOptions& jit_options);
     static HybridSeJitWrapper* Create();
+    // Create a jit compiling into a new dylib of `session`, the builtin
+    // symbols are resolved from the session and need not be added again
+    static HybridSeJitWrapper* Create(
+        const std::shared_ptr<HybridSeJitSession>& session);
     static void DeleteJit(HybridSeJitWrapper* jit);
 
     static bool InitJitSymbols(HybridSeJitWrapper* jit);
+
+    // Create a long-lived jit session with the builtin symbols registered,
+    // return null on failure
+    static std::shared_ptr<HybridSeJitSession> CreateSession();
 };
 
 void InitBuiltinJitSymbols(HybridSeJitWrapper* jit_ptr);
@@ -15,13 +15,21 @@
  */
 
 #include "vm/jit_wrapper.h"
+#include <unistd.h>
+#include <ctime>
+#include <fstream>
+#include "boost/filesystem.hpp"
 #include "codec/fe_row_codec.h"
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "udf/udf.h"
 #include "vm/engine.h"
+#include "vm/jit.h"
 #include "vm/simple_catalog.h"
 #include "vm/sql_compiler.h"
 
+DECLARE_string(jit_object_cache_dir);
+
 namespace hybridse {
 namespace vm {
 
@@ -130,6 +138,36 @@ TEST_F(JitWrapperTest, test_mcjit) {
 }
 #endif
 
+TEST_F(JitWrapperTest, test_aggressive_opt) {
+    EngineOptions options;
+    options.jit_options().SetEnableAggressiveOpt(true);
+    auto catalog = GetTestCatalog();
+    auto compile_info = Compile("select col_1 * 2.0 as c1, col_2 + 1 as c2 from t1;", options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    auto &sql_context = compile_info->get_sql_context();
+    ASSERT_TRUE(sql_context.jit_session == nullptr);
+    auto fn = sql_context.jit->FindFunction(sql_context.physical_plan->GetFnInfos()[0]->fn_name());
+    ASSERT_TRUE(fn != nullptr);
+
+    int8_t buf[1024];
+    auto schema = catalog->GetTable("db", "t1")->GetSchema();
+    codec::RowBuilder row_builder(*schema);
+    row_builder.SetBuffer(buf, 1024);
+    row_builder.AppendDouble(3.5);
+    row_builder.AppendInt64(42);
+
+    hybridse::codec::Row empty_parameter;
+    hybridse::codec::Row row(base::RefCountedSlice::Create(buf, 1024));
+    hybridse::codec::Row output = CoreAPI::RowProject(fn, row, empty_parameter);
+    codec::RowView row_view(sql_context.schema, output.buf(), output.size());
+    double c1;
+    int64_t c2;
+    ASSERT_EQ(row_view.GetDouble(0, &c1), 0);
+    ASSERT_EQ(row_view.GetInt64(1, &c2), 0);
+    ASSERT_EQ(c1, 7.0);
+    ASSERT_EQ(c2, 43);
+}
+
 TEST_F(JitWrapperTest, test_window) {
     EngineOptions options;
     options.SetKeepIr(true);
@@ -162,11 +200,131 @@ TEST_F(JitWrapperTest, test_window) {
     delete jit;
 }
 
+TEST_F(JitWrapperTest, test_session) {
+    EngineOptions options;
+    options.SetKeepIr(true);
+    auto catalog = GetTestCatalog();
+    auto compile_info = Compile("select col_1, col_2 from t1;", options, catalog);
+    auto &sql_context = compile_info->get_sql_context();
+    std::string ir_str = sql_context.ir;
+    ASSERT_FALSE(ir_str.empty());
+    auto fn_name = sql_context.physical_plan->GetFnInfos()[0]->fn_name();
+
+    auto session = HybridSeJitWrapper::CreateSession();
+    ASSERT_TRUE(session != nullptr);
+    // the same module is added to two dylibs of the session
+    base::RawBuffer ir_buf(const_cast<char *>(ir_str.data()), ir_str.size());
+    HybridSeJitWrapper *jit1 = HybridSeJitWrapper::Create(session);
+    ASSERT_TRUE(jit1->Init());
+    ASSERT_TRUE(jit1->AddModuleFromBuffer(ir_buf));
+    HybridSeJitWrapper *jit2 = HybridSeJitWrapper::Create(session);
+    ASSERT_TRUE(jit2->Init());
+    ASSERT_TRUE(jit2->AddModuleFromBuffer(ir_buf));
+
+    auto fn1 = jit1->FindFunction(fn_name);
+    auto fn2 = jit2->FindFunction(fn_name);
+    ASSERT_TRUE(fn1 != nullptr);
+    ASSERT_TRUE(fn2 != nullptr);
+    ASSERT_NE(fn1, fn2);
+    delete jit1;
+
+    int8_t buf[1024];
+    auto schema = catalog->GetTable("db", "t1")->GetSchema();
+    codec::RowBuilder row_builder(*schema);
+    row_builder.SetBuffer(buf, 1024);
+    row_builder.AppendDouble(3.14);
+    row_builder.AppendInt64(42);
+
+    hybridse::codec::Row empty_parameter;
+    hybridse::codec::Row row(base::RefCountedSlice::Create(buf, 1024));
+    hybridse::codec::Row output = CoreAPI::RowProject(fn2, row, empty_parameter);
+    codec::RowView row_view(*schema, output.buf(), output.size());
+    double c1;
+    int64_t c2;
+    ASSERT_EQ(row_view.GetDouble(0, &c1), 0);
+    ASSERT_EQ(row_view.GetInt64(1, &c2), 0);
+    ASSERT_EQ(c1, 3.14);
+    ASSERT_EQ(c2, 42);
+    delete jit2;
+    ASSERT_EQ(2u, session->GetDylibCount());
+}
+
+TEST_F(JitWrapperTest, test_object_cache) {
+    auto catalog = GetTestCatalog();
+    std::string sql = "select col_1, col_2 + 1 as col_3 from t1;";
+    auto schema = catalog->GetTable("db", "t1")->GetSchema();
+    int8_t buf[1024];
+    codec::RowBuilder row_builder(*schema);
+    row_builder.SetBuffer(buf, 1024);
+    row_builder.AppendDouble(3.14);
+    row_builder.AppendInt64(42);
+
+    // the first engine writes the object, the second one loads it
+    for (int i = 0; i < 2; i++) {
+        EngineOptions options;
+        Engine engine(catalog, options);
+        base::Status status;
+        RequestRunSession session;
+        session.SetSpName("sp");
+        ASSERT_TRUE(engine.Get(sql, "db", session, status)) << status;
+        auto compile_info = std::dynamic_pointer_cast<SqlCompileInfo>(session.GetCompileInfo());
+        auto &sql_context = compile_info->get_sql_context();
+        auto fn_name = sql_context.physical_plan->GetFnInfos()[0]->fn_name();
+        auto fn = sql_context.jit->FindFunction(fn_name);
+        ASSERT_TRUE(fn != nullptr);
+
+        hybridse::codec::Row empty_parameter;
+        hybridse::codec::Row row(base::RefCountedSlice::Create(buf, 1024));
+        hybridse::codec::Row output = CoreAPI::RowProject(fn, row, empty_parameter);
+        codec::RowView row_view(sql_context.schema, output.buf(), output.size());
+        double c1;
+        int64_t c3;
+        ASSERT_EQ(row_view.GetDouble(0, &c1), 0);
+        ASSERT_EQ(row_view.GetInt64(1, &c3), 0);
+        ASSERT_EQ(c1, 3.14);
+        ASSERT_EQ(c3, 43);
+    }
+    size_t object_cnt = 0;
+    for (auto &entry : boost::filesystem::directory_iterator(FLAGS_jit_object_cache_dir)) {
+        if (entry.path().extension() == ".o") {
+            object_cnt++;
+        }
+    }
+    ASSERT_EQ(1u, object_cnt);
+}
+
+TEST_F(JitWrapperTest, test_object_cache_evict) {
+    std::string dir = FLAGS_jit_object_cache_dir + "_evict";
+    boost::filesystem::create_directories(dir);
+    // objects of 1000 bytes, the smaller index is used less recently
+    std::time_t now = std::time(nullptr);
+    for (int i = 0; i < 5; i++) {
+        std::string path = dir + "/objcache_" + std::to_string(i) + ".o";
+        std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+        ofs << std::string(1000, 'a');
+        ofs.close();
+        boost::filesystem::last_write_time(path, now - 100 + i);
+    }
+    HybridSeObjectCache unlimited(dir, 0);
+    unlimited.Evict();
+    ASSERT_TRUE(boost::filesystem::exists(dir + "/objcache_0.o"));
+
+    HybridSeObjectCache cache(dir, 3000);
+    cache.Evict();
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(i >= 2, boost::filesystem::exists(dir + "/objcache_" + std::to_string(i) + ".o")) << i;
+    }
+    boost::filesystem::remove_all(dir);
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
+    // only sql of deployments are cached, other tests are not affected
+    FLAGS_jit_object_cache_dir = "/tmp/jit_wrapper_test_" + std::to_string(getpid());
+    boost::filesystem::remove_all(FLAGS_jit_object_cache_dir);
     hybridse::vm::Engine::InitializeGlobalLLVM();
     return RUN_ALL_TESTS();
 }
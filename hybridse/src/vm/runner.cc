@@ -16,8 +16,18 @@
 
 #include "vm/runner.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <set>
 #include <string>
+#include <string_view>
+#include <thread>  // NOLINT
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -26,10 +36,16 @@
 #include "udf/udf.h"
 #include "vm/catalog_wrapper.h"
 #include "vm/core_api.h"
+#include "vm/engine.h"
 #include "vm/jit_runtime.h"
 #include "vm/mem_catalog.h"
 
 DECLARE_bool(enable_spark_unsaferow_format);
+DECLARE_uint32(batch_runner_parallelism);
+DECLARE_bool(enable_batch_project);
+DECLARE_bool(enable_column_pushdown);
+DECLARE_bool(enable_hash_last_join);
+DECLARE_uint32(batch_request_seek_parallelism);
 
 namespace hybridse {
 namespace vm {
@@ -71,6 +87,43 @@ namespace vm {
 // kPhysicalOpFilter
 // kPhysicalOpLimit
 // kPhysicalOpRename
+// Resolve the columns of the single input table the projects depend on.
+// `columns` is left empty if any of them can't be resolved.
+static void ResolveSourceColumns(const PhysicalSimpleProjectNode* op,
+                                 std::vector<uint32_t>* columns) {
+    auto input_schema = op->GetProducer(0)->schemas_ctx();
+    if (input_schema->GetSchemaSourceSize() != 1) {
+        return;
+    }
+    std::set<size_t> column_ids;
+    const auto& projects = op->project();
+    for (size_t i = 0; i < projects.size(); ++i) {
+        if (!input_schema
+                 ->ResolveExprDependentColumns(projects.GetExpr(i),
+                                               &column_ids)
+                 .isOK()) {
+            return;
+        }
+    }
+    std::set<uint32_t> indexes;
+    for (size_t column_id : column_ids) {
+        size_t schema_idx = 0;
+        size_t col_idx = 0;
+        if (!input_schema
+                 ->ResolveColumnIndexByID(column_id, &schema_idx, &col_idx)
+                 .isOK()) {
+            return;
+        }
+        indexes.insert(static_cast<uint32_t>(col_idx));
+    }
+    // no gain if every column is required
+    if (indexes.empty() ||
+        indexes.size() == static_cast<size_t>(input_schema->GetColumnNum())) {
+        return;
+    }
+    columns->assign(indexes.begin(), indexes.end());
+}
+
 ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
     auto fail = InvalidTask();
     if (nullptr == node) {
@@ -153,6 +206,11 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                 CreateRunner<SimpleProjectRunner>(
                     &runner, id_++, node->schemas_ctx(), op->GetLimitCnt(),
                     op->project().fn_info());
+                if (FLAGS_enable_column_pushdown &&
+                    op->GetProducer(0)->GetOpType() ==
+                        kPhysicalOpDataProvider) {
+                    ResolveSourceColumns(op, &runner->source_columns_);
+                }
                 return RegisterTask(node,
                                     UnaryInheritTask(cluster_task, runner));
             }
@@ -1128,6 +1186,10 @@ std::shared_ptr<DataHandlerList> Runner::BatchRequestRun(RunnerContext& ctx) {
         }
         outputs->Add(res);
     }
+    SetBatchOutputs(ctx, outputs);
+    return outputs;
+}
+void Runner::SetBatchOutputs(RunnerContext& ctx, std::shared_ptr<DataHandlerList> outputs) {
     if (ctx.is_debug()) {
         std::ostringstream oss;
         oss << "RUNNER TYPE: " << RunnerTypeName(type_) << ", ID: " << id_
@@ -1144,8 +1206,38 @@ std::shared_ptr<DataHandlerList> Runner::BatchRequestRun(RunnerContext& ctx) {
     if (need_cache_) {
         ctx.SetBatchCache(id_, outputs);
     }
-    return outputs;
 }
+static uint64_t ProfileNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// rows of a runner output, return false if the output is not counted. only
+// materialized outputs are counted, counting a lazy or remote output would
+// scan the table or wait for the rpc
+static bool ProfileRowCnt(const std::shared_ptr<DataHandler>& data, uint64_t* cnt) {
+    *cnt = 0;
+    if (!data) {
+        return true;
+    }
+    if (kRowHandler == data->GetHandlerType()) {
+        *cnt = 1;
+        return true;
+    }
+    // a concat table is built on its first read
+    if (nullptr != dynamic_cast<ConcatTableHandler*>(data.get())) {
+        return false;
+    }
+    if (nullptr != dynamic_cast<MemTimeTableHandler*>(data.get()) ||
+        nullptr != dynamic_cast<MemTableHandler*>(data.get()) ||
+        nullptr != dynamic_cast<MemPartitionHandler*>(data.get())) {
+        *cnt = data->GetCount();
+        return true;
+    }
+    return false;
+}
+
 std::shared_ptr<DataHandler> Runner::RunWithCache(RunnerContext& ctx) {
     if (need_cache_) {
         auto cached = ctx.GetCache(id_);
@@ -1154,12 +1246,28 @@ std::shared_ptr<DataHandler> Runner::RunWithCache(RunnerContext& ctx) {
             return cached;
         }
     }
+    auto profile = ctx.profile();
+    uint64_t start_us = 0;
+    uint64_t outer_producers_time_us = 0;
+    if (nullptr != profile) {
+        start_us = ProfileNowUs();
+        outer_producers_time_us = ctx.GetProducersTime();
+        ctx.SetProducersTime(0);
+    }
     std::vector<std::shared_ptr<DataHandler>> inputs(producers_.size());
     for (size_t idx = producers_.size(); idx > 0; idx--) {
         inputs[idx - 1] = producers_[idx - 1]->RunWithCache(ctx);
     }
 
     auto res = Run(ctx, inputs);
+    if (nullptr != profile) {
+        uint64_t total_us = ProfileNowUs() - start_us;
+        uint64_t producers_us = std::min(ctx.GetProducersTime(), total_us);
+        uint64_t rows_out = 0;
+        bool rows_counted = ProfileRowCnt(res, &rows_out);
+        profile->Add(id_, RunnerTypeName(type_), total_us - producers_us, total_us, rows_out, rows_counted);
+        ctx.SetProducersTime(outer_producers_time_us + total_us);
+    }
     if (ctx.is_debug()) {
         std::ostringstream oss;
         oss << "RUNNER TYPE: " << RunnerTypeName(type_) << ", ID: " << id_ << "\n";
@@ -1171,6 +1279,33 @@ std::shared_ptr<DataHandler> Runner::RunWithCache(RunnerContext& ctx) {
     }
     return res;
 }
+
+void Runner::PrintProfile(std::ostream& output, const std::string& tab, const RunProfile& profile,
+                          std::set<int32_t>* visited_ids) const {
+    PrintRunnerInfo(output, tab);
+    auto stat = profile.GetRunner(id_);
+    if (nullptr == stat) {
+        output << " (never run)";
+    } else {
+        output << " (runs=" << stat->run_cnt << ", self=" << stat->self_time_us
+               << "us, total=" << stat->total_time_us << "us, rows=";
+        if (stat->uncounted_cnt > 0) {
+            output << "n/a";
+        } else {
+            output << stat->rows_out;
+        }
+        output << ")";
+    }
+    if (!visited_ids->insert(id_).second) {
+        output << "\n";
+        output << "  " << tab << "...";
+        return;
+    }
+    for (auto producer : producers_) {
+        output << "\n";
+        producer->PrintProfile(output, "  " + tab, profile, visited_ids);
+    }
+}
 std::shared_ptr<DataHandler> DataRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
@@ -1277,6 +1412,99 @@ std::shared_ptr<DataHandler> ConstProjectRunner::Run(
     output_table->AddRow(project_gen_.Gen(ctx.GetParameterRow()));
     return output_table;
 }
+size_t Runner::GetBatchParallelism(size_t task_cnt) {
+    return std::min(static_cast<size_t>(FLAGS_batch_runner_parallelism), task_cnt);
+}
+
+namespace {
+// worker threads shared by all parallel batch runners. the pool grows to the
+// largest parallelism requested and its threads live until the process exits
+class BatchWorkerPool {
+ public:
+    static BatchWorkerPool& Instance() {
+        static BatchWorkerPool* pool = new BatchWorkerPool();
+        return *pool;
+    }
+
+    void Submit(size_t worker_cnt, const std::function<void()>& fn) {
+        std::lock_guard<std::mutex> lock(mu_);
+        while (threads_.size() < worker_cnt) {
+            threads_.emplace_back(&BatchWorkerPool::Loop, this);
+            threads_.back().detach();
+        }
+        for (size_t i = 0; i < worker_cnt; i++) {
+            tasks_.push_back(fn);
+        }
+        cv_.notify_all();
+    }
+
+ private:
+    void Loop() {
+        while (true) {
+            std::function<void()> fn;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_.wait(lock, [this] { return !tasks_.empty(); });
+                fn = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            fn();
+        }
+    }
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> threads_;
+};
+
+// state of a ParallelFor call. a pool thread that starts after the caller has
+// finished all tasks returns at once, so the caller only waits for the threads
+// that actually joined and never for tasks still queued behind other runs
+struct ParallelForState {
+    std::mutex mu;
+    std::condition_variable cv;
+    bool finished = false;
+    size_t running = 0;
+};
+}  // namespace
+
+void Runner::ParallelFor(size_t parallelism, size_t task_cnt, const std::function<void(size_t)>& task) {
+    // JitRuntime is thread local, so every thread uses its own memory pool
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t idx = next.fetch_add(1, std::memory_order_relaxed); idx < task_cnt;
+             idx = next.fetch_add(1, std::memory_order_relaxed)) {
+            task(idx);
+        }
+    };
+    if (parallelism <= 1) {
+        worker();
+        return;
+    }
+    auto state = std::make_shared<ParallelForState>();
+    // pool threads touch the caller's stack only after they joined, i.e. before the caller returns
+    std::function<void()> shared_worker = worker;
+    const std::function<void()>* worker_fn = &shared_worker;
+    BatchWorkerPool::Instance().Submit(parallelism - 1, [state, worker_fn]() {
+        {
+            std::lock_guard<std::mutex> lock(state->mu);
+            if (state->finished) {
+                return;
+            }
+            state->running++;
+        }
+        (*worker_fn)();
+        std::lock_guard<std::mutex> lock(state->mu);
+        state->running--;
+        state->cv.notify_all();
+    });
+    worker();
+    std::unique_lock<std::mutex> lock(state->mu);
+    state->finished = true;
+    state->cv.wait(lock, [&state] { return state->running == 0; });
+}
+
 std::shared_ptr<DataHandler> TableProjectRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
@@ -1300,6 +1528,41 @@ std::shared_ptr<DataHandler> TableProjectRunner::Run(
     }
     auto& parameter = ctx.GetParameterRow();
     iter->SeekToFirst();
+    if (FLAGS_batch_runner_parallelism > 1 || project_gen_.HasBatchEntry()) {
+        // project rows by morsels, and keep the input order in the output. only
+        // one morsel per thread is read from the input at a time
+        const size_t morsel_size = 1024;
+        const size_t round_size = morsel_size * std::max(static_cast<size_t>(FLAGS_batch_runner_parallelism), 1ul);
+        size_t total = 0;
+        std::vector<Row> rows;
+        std::vector<Row> outputs;
+        rows.reserve(round_size);
+        while (iter->Valid()) {
+            rows.clear();
+            while (iter->Valid() && rows.size() < round_size) {
+                if (limit_cnt_ > 0 && total >= static_cast<size_t>(limit_cnt_)) {
+                    break;
+                }
+                rows.push_back(iter->GetValue());
+                iter->Next();
+                total++;
+            }
+            if (rows.empty()) {
+                break;
+            }
+            size_t morsel_cnt = (rows.size() + morsel_size - 1) / morsel_size;
+            outputs.assign(rows.size(), Row());
+            ParallelFor(GetBatchParallelism(morsel_cnt), morsel_cnt, [&](size_t morsel) {
+                size_t start = morsel * morsel_size;
+                size_t end = std::min(rows.size(), start + morsel_size);
+                project_gen_.Gen(rows.data() + start, end - start, parameter, outputs.data() + start);
+            });
+            for (auto& row : outputs) {
+                output_table->AddRow(row);
+            }
+        }
+        return output_table;
+    }
     int32_t cnt = 0;
     while (iter->Valid()) {
         if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
@@ -1323,6 +1586,35 @@ std::shared_ptr<DataHandler> RowProjectRunner::Run(
         new MemRowHandler(project_gen_.Gen(row->GetValue(), ctx.GetParameterRow())));
 }
 
+std::shared_ptr<DataHandlerList> RowProjectRunner::BatchRequestRun(RunnerContext& ctx) {
+    if (need_batch_cache_ || !project_gen_.HasBatchEntry()) {
+        return Runner::BatchRequestRun(ctx);
+    }
+    if (need_cache_) {
+        auto cached = ctx.GetBatchCache(id_);
+        if (cached != nullptr) {
+            DLOG(INFO) << "RUNNER ID " << id_ << " HIT CACHE!";
+            return cached;
+        }
+    }
+    auto batch_inputs = producers_[0]->BatchRequestRun(ctx);
+    std::vector<Row> rows(ctx.GetRequestSize());
+    for (size_t idx = 0; idx < rows.size(); idx++) {
+        auto row = std::dynamic_pointer_cast<RowHandler>(batch_inputs->Get(idx));
+        if (row) {
+            rows[idx] = row->GetValue();
+        }
+    }
+    std::vector<Row> rows_out(rows.size());
+    project_gen_.Gen(rows.data(), rows.size(), ctx.GetParameterRow(), rows_out.data());
+    std::shared_ptr<DataHandlerVector> outputs = std::make_shared<DataHandlerVector>();
+    for (auto& row : rows_out) {
+        outputs->Add(std::shared_ptr<RowHandler>(new MemRowHandler(row)));
+    }
+    SetBatchOutputs(ctx, outputs);
+    return outputs;
+}
+
 std::shared_ptr<DataHandler> SimpleProjectRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
@@ -1342,12 +1634,12 @@ std::shared_ptr<DataHandler> SimpleProjectRunner::Run(
         case kTableHandler: {
             return std::shared_ptr<TableHandler>(new TableProjectWrapper(
                 std::dynamic_pointer_cast<TableHandler>(input),
-                parameter, &project_gen_.fun_));
+                parameter, &project_gen_.fun_, &source_columns_));
         }
         case kPartitionHandler: {
             return std::shared_ptr<TableHandler>(new PartitionProjectWrapper(
                 std::dynamic_pointer_cast<PartitionHandler>(input),
-                parameter, &project_gen_.fun_));
+                parameter, &project_gen_.fun_, &source_columns_));
         }
         case kRowHandler: {
             return std::shared_ptr<RowHandler>(new RowProjectWrapper(
@@ -1444,6 +1736,27 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
 
     // Compute output
     std::shared_ptr<MemTableHandler> output_table = std::make_shared<MemTableHandler>();
+    // the limit is applied on the rows of all keys in order, so it runs serially
+    if (FLAGS_batch_runner_parallelism > 1 && limit_cnt_ <= 0) {
+        std::vector<std::string> keys;
+        while (instance_partition_iter->Valid()) {
+            keys.push_back(instance_partition_iter->GetKey().ToString());
+            instance_partition_iter->Next();
+        }
+        // every key has its own output, merged in key order so the result is the same as the serial run
+        std::vector<std::shared_ptr<MemTableHandler>> key_outputs(keys.size());
+        ParallelFor(GetBatchParallelism(keys.size()), keys.size(), [&](size_t idx) {
+            key_outputs[idx] = std::make_shared<MemTableHandler>();
+            RunWindowAggOnKey(parameter, instance_partition, union_partitions, join_right_tables, keys[idx],
+                              key_outputs[idx]);
+        });
+        for (auto& key_output : key_outputs) {
+            for (uint64_t i = 0; i < key_output->GetCount(); i++) {
+                output_table->AddRow(key_output->At(i));
+            }
+        }
+        return output_table;
+    }
     while (instance_partition_iter->Valid()) {
         auto key = instance_partition_iter->GetKey().ToString();
         RunWindowAggOnKey(parameter, instance_partition, union_partitions,
@@ -1817,6 +2130,7 @@ std::shared_ptr<PartitionHandler> SortGenerator::Sort(
                            segment_iter->GetValue());
             segment_iter->Next();
         }
+        iter->Next();
     }
     if (order_gen_.Valid()) {
         output->Sort(is_asc);
@@ -1932,6 +2246,29 @@ Row JoinGenerator::RowLastJoinTable(const Row& left_row,
         LOG(WARNING) << "Last Join right table is empty";
         return Row(left_slices_, left_row, right_slices_, Row());
     }
+    bool has_condition = left_key_gen_.Valid() || condition_gen_.Valid();
+    std::string left_key_str = "";
+    if (left_key_gen_.Valid()) {
+        left_key_str = left_key_gen_.Gen(left_row, parameter);
+    }
+    auto match = [&](const Row& right_row) {
+        if (right_group_gen_.Valid() && left_key_gen_.Valid() &&
+            left_key_str != right_group_gen_.GetKey(right_row, parameter)) {
+            return false;
+        }
+        return !condition_gen_.Valid() ||
+               condition_gen_.Gen(Row(left_slices_, left_row, right_slices_, right_row), parameter);
+    };
+    if (has_condition) {
+        // the key and the join condition bound to the left row are evaluated inside the storage of the right
+        // table if it supports it, so the right rows that do not join are never copied out
+        auto filter_iter = table->GetFilterIterator(match);
+        if (filter_iter) {
+            filter_iter->SeekToFirst();
+            return Row(left_slices_, left_row, right_slices_,
+                       filter_iter->Valid() ? filter_iter->GetValue() : Row());
+        }
+    }
     auto right_iter = table->GetIterator();
     if (!right_iter) {
         LOG(WARNING) << "Last Join right table is empty";
@@ -1943,34 +2280,92 @@ Row JoinGenerator::RowLastJoinTable(const Row& left_row,
         return Row(left_slices_, left_row, right_slices_, Row());
     }
 
-    if (!left_key_gen_.Valid() && !condition_gen_.Valid()) {
+    if (!has_condition) {
         return Row(left_slices_, left_row, right_slices_,
                    right_iter->GetValue());
     }
 
-    std::string left_key_str = "";
-    if (left_key_gen_.Valid()) {
-        left_key_str = left_key_gen_.Gen(left_row, parameter);
-    }
     while (right_iter->Valid()) {
-        if (right_group_gen_.Valid()) {
-            auto right_key_str =
-                right_group_gen_.GetKey(right_iter->GetValue(), parameter);
-            if (left_key_gen_.Valid() && left_key_str != right_key_str) {
-                right_iter->Next();
-                continue;
-            }
+        if (match(right_iter->GetValue())) {
+            return Row(left_slices_, left_row, right_slices_, right_iter->GetValue());
         }
+        right_iter->Next();
+    }
+    return Row(left_slices_, left_row, right_slices_, Row());
+}
 
-        Row joined_row(left_slices_, left_row, right_slices_,
-                       right_iter->GetValue());
-        if (!condition_gen_.Valid()) {
-            return joined_row;
+bool LastJoinHashTable::Build(std::shared_ptr<PartitionHandler> right) {
+    auto window_iter = right->GetWindowIterator();
+    if (!window_iter) {
+        LOG(WARNING) << "fail to build last join hash table: right partition is empty";
+        return false;
+    }
+    window_iter->SeekToFirst();
+    while (window_iter->Valid()) {
+        std::string key = window_iter->GetKey().ToString();
+        auto segment = right->GetSegment(key);
+        if (segment) {
+            rows_[key].table = segment;
         }
+        window_iter->Next();
+    }
+    return true;
+}
+
+const std::vector<Row>* LastJoinHashTable::Find(const std::string& key) {
+    auto iter = rows_.find(key);
+    if (iter == rows_.end()) {
+        return nullptr;
+    }
+    auto& segment = iter->second;
+    if (segment.table) {
+        auto sorted = right_sort_->Sort(segment.table, true);
+        segment.table.reset();
+        auto row_iter = sorted ? sorted->GetIterator() : std::unique_ptr<RowIterator>();
+        if (row_iter) {
+            row_iter->SeekToFirst();
+            while (row_iter->Valid()) {
+                segment.rows.push_back(row_iter->GetValue());
+                row_iter->Next();
+            }
+        }
+    }
+    return &segment.rows;
+}
+
+std::unique_ptr<LastJoinHashTable> JoinGenerator::BuildHashTable(std::shared_ptr<PartitionHandler> right) {
+    // a partition from an index is probed by key, only build the partition grouped by the right key
+    if (!FLAGS_enable_hash_last_join || !right_group_gen_.Valid()) {
+        return nullptr;
+    }
+    std::unique_ptr<LastJoinHashTable> hash_table(new LastJoinHashTable(&right_sort_gen_));
+    if (!hash_table->Build(right)) {
+        return nullptr;
+    }
+    return hash_table;
+}
+
+std::string JoinGenerator::GetJoinKey(const Row& left_row, const Row& parameter) {
+    std::string key_str = index_key_gen_.Valid() ? index_key_gen_.Gen(left_row, parameter) : "";
+    if (left_key_gen_.Valid()) {
+        key_str = key_str.empty() ? left_key_gen_.Gen(left_row, parameter)
+                                  : key_str.append("|").append(left_key_gen_.Gen(left_row, parameter));
+    }
+    return key_str;
+}
+
+Row JoinGenerator::RowLastJoinRows(const Row& left_row, const std::vector<Row>* rows, const Row& parameter) {
+    if (rows == nullptr || rows->empty()) {
+        return Row(left_slices_, left_row, right_slices_, Row());
+    }
+    if (!condition_gen_.Valid()) {
+        return Row(left_slices_, left_row, right_slices_, rows->front());
+    }
+    for (auto& right_row : *rows) {
+        Row joined_row(left_slices_, left_row, right_slices_, right_row);
         if (condition_gen_.Gen(joined_row, parameter)) {
             return joined_row;
         }
-        right_iter->Next();
     }
     return Row(left_slices_, left_row, right_slices_, Row());
 }
@@ -1984,13 +2379,13 @@ bool JoinGenerator::TableJoin(std::shared_ptr<TableHandler> left,
         LOG(WARNING) << "Table Join with empty left table";
         return false;
     }
+    // sort the right table once instead of for every left row
+    auto sorted_right = right_sort_gen_.Sort(right, true);
     left_iter->SeekToFirst();
     while (left_iter->Valid()) {
         const Row& left_row = left_iter->GetValue();
-        output->AddRow(
-            left_iter->GetKey(),
-            Runner::RowLastJoinTable(left_slices_, left_row, right_slices_,
-                                     right, parameter, right_sort_gen_, condition_gen_));
+        output->AddRow(left_iter->GetKey(), Runner::RowLastJoinSortedTable(left_slices_, left_row, right_slices_,
+                                                                           sorted_right, parameter, condition_gen_));
         left_iter->Next();
     }
     return true;
@@ -2011,20 +2406,20 @@ bool JoinGenerator::TableJoin(std::shared_ptr<TableHandler> left,
         return false;
     }
 
+    auto hash_table = BuildHashTable(right);
     left_iter->SeekToFirst();
     while (left_iter->Valid()) {
         const Row& left_row = left_iter->GetValue();
-        std::string key_str =
-            index_key_gen_.Valid() ? index_key_gen_.Gen(left_row, parameter) : "";
-        if (left_key_gen_.Valid()) {
-            key_str = key_str.empty()
-                          ? left_key_gen_.Gen(left_row, parameter)
-                          : key_str + "|" + left_key_gen_.Gen(left_row, parameter);
-        }
+        std::string key_str = GetJoinKey(left_row, parameter);
         DLOG(INFO) << "key_str " << key_str;
-        auto right_table = right->GetSegment(key_str);
-        output->AddRow(left_iter->GetKey(), Runner::RowLastJoinTable(left_slices_, left_row, right_slices_, right_table,
-                                                                     parameter, right_sort_gen_, condition_gen_));
+        if (hash_table) {
+            output->AddRow(left_iter->GetKey(), RowLastJoinRows(left_row, hash_table->Find(key_str), parameter));
+        } else {
+            auto right_table = right->GetSegment(key_str);
+            output->AddRow(left_iter->GetKey(),
+                           Runner::RowLastJoinTable(left_slices_, left_row, right_slices_, right_table, parameter,
+                                                    right_sort_gen_, condition_gen_));
+        }
         left_iter->Next();
     }
     return true;
@@ -2039,6 +2434,8 @@ bool JoinGenerator::PartitionJoin(std::shared_ptr<PartitionHandler> left,
         LOG(WARNING) << "fail to run last join: left iter empty";
         return false;
     }
+    // sort the right table once instead of for every left row
+    auto sorted_right = right_sort_gen_.Sort(right, true);
     left_window_iter->SeekToFirst();
     while (left_window_iter->Valid()) {
         auto left_iter = left_window_iter->GetValue();
@@ -2053,10 +2450,8 @@ bool JoinGenerator::PartitionJoin(std::shared_ptr<PartitionHandler> left,
             auto key_str = std::string(
                 reinterpret_cast<const char*>(left_key.buf()), left_key.size());
             output->AddRow(key_str, left_iter->GetKey(),
-                           Runner::RowLastJoinTable(
-                               left_slices_, left_row, right_slices_, right,
-                               parameter,
-                               right_sort_gen_, condition_gen_));
+                           Runner::RowLastJoinSortedTable(left_slices_, left_row, right_slices_, sorted_right,
+                                                          parameter, condition_gen_));
             left_iter->Next();
         }
         left_window_iter->Next();
@@ -2082,6 +2477,7 @@ bool JoinGenerator::PartitionJoin(std::shared_ptr<PartitionHandler> left,
         return false;
     }
 
+    auto hash_table = BuildHashTable(right);
     left_partition_iter->SeekToFirst();
     while (left_partition_iter->Valid()) {
         auto left_iter = left_partition_iter->GetValue();
@@ -2093,22 +2489,18 @@ bool JoinGenerator::PartitionJoin(std::shared_ptr<PartitionHandler> left,
         left_iter->SeekToFirst();
         while (left_iter->Valid()) {
             const Row& left_row = left_iter->GetValue();
-
-            std::string key_str = "";
-            if (index_key_gen_.Valid()) {
-                key_str = index_key_gen_.Gen(left_row, parameter);
-            }
-            if (left_key_gen_.Valid()) {
-                key_str = key_str.empty() ? left_key_gen_.Gen(left_row, parameter) :
-                                          key_str.append("|").append(left_key_gen_.Gen(left_row, parameter));
-            }
-            auto right_table = right->GetSegment(key_str);
+            std::string key_str = GetJoinKey(left_row, parameter);
             auto left_key_str = std::string(
                 reinterpret_cast<const char*>(left_key.buf()), left_key.size());
-            output->AddRow(left_key_str, left_iter->GetKey(),
-                           Runner::RowLastJoinTable(
-                               left_slices_, left_row, right_slices_,
-                               right_table, parameter, right_sort_gen_, condition_gen_));
+            if (hash_table) {
+                output->AddRow(left_key_str, left_iter->GetKey(),
+                               RowLastJoinRows(left_row, hash_table->Find(key_str), parameter));
+            } else {
+                auto right_table = right->GetSegment(key_str);
+                output->AddRow(left_key_str, left_iter->GetKey(),
+                               Runner::RowLastJoinTable(left_slices_, left_row, right_slices_, right_table,
+                                                        parameter, right_sort_gen_, condition_gen_));
+            }
             left_iter->Next();
         }
         left_partition_iter->Next();
@@ -2121,7 +2513,12 @@ const Row Runner::RowLastJoinTable(size_t left_slices, const Row& left_row,
                                    const Row& parameter,
                                    SortGenerator& right_sort,
                                    ConditionGenerator& cond_gen) {
-    right_table = right_sort.Sort(right_table, true);
+    return RowLastJoinSortedTable(left_slices, left_row, right_slices, right_sort.Sort(right_table, true), parameter,
+                                  cond_gen);
+}
+const Row Runner::RowLastJoinSortedTable(size_t left_slices, const Row& left_row, size_t right_slices,
+                                         std::shared_ptr<TableHandler> right_table, const Row& parameter,
+                                         ConditionGenerator& cond_gen) {
     if (!right_table) {
         LOG(WARNING) << "Last Join right table is empty";
         return Row(left_slices, left_row, right_slices, Row());
@@ -2645,6 +3042,40 @@ std::shared_ptr<DataHandler> GroupAggRunner::Run(
             return std::shared_ptr<DataHandler>();
         }
         iter->SeekToFirst();
+        if (FLAGS_batch_runner_parallelism > 1) {
+            std::vector<std::string> keys;
+            while (iter->Valid()) {
+                if (limit_cnt_ > 0 && keys.size() >= static_cast<size_t>(limit_cnt_)) {
+                    break;
+                }
+                keys.push_back(iter->GetKey().ToString());
+                iter->Next();
+            }
+            std::vector<Row> outputs(keys.size());
+            std::vector<uint8_t> selected(keys.size(), 0);
+            std::atomic<bool> segment_missing(false);
+            ParallelFor(GetBatchParallelism(keys.size()), keys.size(), [&](size_t idx) {
+                auto segment = partition->GetSegment(keys[idx]);
+                if (!segment) {
+                    segment_missing.store(true, std::memory_order_relaxed);
+                    return;
+                }
+                if (!having_condition_.Valid() || having_condition_.Gen(segment, parameter)) {
+                    outputs[idx] = agg_gen_.Gen(parameter, segment);
+                    selected[idx] = 1;
+                }
+            });
+            if (segment_missing.load(std::memory_order_relaxed)) {
+                LOG(WARNING) << "group aggregation fail: segment segment is null";
+                return std::shared_ptr<DataHandler>();
+            }
+            for (size_t i = 0; i < keys.size(); i++) {
+                if (selected[i]) {
+                    output_table->AddRow(outputs[i]);
+                }
+            }
+            return output_table;
+        }
         int32_t cnt = 0;
         while (iter->Valid()) {
             if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
@@ -2689,9 +3120,72 @@ bool RequestAggUnionRunner::InitAggregator() {
         LOG(ERROR) << "non-support aggr expr type " << ExprTypeName(agg_col_->GetExprType());
         return false;
     }
+
+    auto base_row_parser = producers_[1]->row_parser();
+    if (!agg_col_name_.empty() &&
+        !base_row_parser->GetColumnIndex(agg_col_name_, &agg_col_idx_.schema_idx, &agg_col_idx_.col_idx)) {
+        LOG(ERROR) << "fail to resolve aggr column " << agg_col_name_;
+        return false;
+    }
+    auto agg_row_parser = producers_[2]->row_parser();
+    if (!agg_row_parser->GetColumnIndex("agg_val", &agg_val_idx_.schema_idx, &agg_val_idx_.col_idx) ||
+        !agg_row_parser->GetColumnIndex("ts_end", &ts_end_idx_.schema_idx, &ts_end_idx_.col_idx) ||
+        !agg_row_parser->GetColumnIndex("num_rows", &num_rows_idx_.schema_idx, &num_rows_idx_.col_idx)) {
+        LOG(ERROR) << "fail to resolve columns of pre-aggr table";
+        return false;
+    }
     return true;
 }
 
+// hash a not null aggr column value the same way the pre-aggr table does, i.e. over
+// the bytes of the value in its column type
+static bool HashAggrCol(const RowParser* row_parser, const Row& row, size_t schema_idx, size_t col_idx,
+                        type::Type type, uint64_t* hash) {
+    switch (type) {
+        case type::Type::kInt16: {
+            int16_t val = 0;
+            row_parser->GetValue(row, schema_idx, col_idx, type, &val);
+            *hash = base::HyperLogLog::Hash(&val, sizeof(val));
+            return true;
+        }
+        case type::Type::kDate:
+        case type::Type::kInt32: {
+            int32_t val = 0;
+            row_parser->GetValue(row, schema_idx, col_idx, type, &val);
+            *hash = base::HyperLogLog::Hash(&val, sizeof(val));
+            return true;
+        }
+        case type::Type::kTimestamp:
+        case type::Type::kInt64: {
+            int64_t val = 0;
+            row_parser->GetValue(row, schema_idx, col_idx, type, &val);
+            *hash = base::HyperLogLog::Hash(&val, sizeof(val));
+            return true;
+        }
+        case type::Type::kFloat: {
+            float val = 0;
+            row_parser->GetValue(row, schema_idx, col_idx, type, &val);
+            *hash = base::HyperLogLog::Hash(&val, sizeof(val));
+            return true;
+        }
+        case type::Type::kDouble: {
+            double val = 0;
+            row_parser->GetValue(row, schema_idx, col_idx, type, &val);
+            *hash = base::HyperLogLog::Hash(&val, sizeof(val));
+            return true;
+        }
+        case type::Type::kVarchar: {
+            std::string val;
+            row_parser->GetString(row, schema_idx, col_idx, &val);
+            *hash = base::HyperLogLog::Hash(val.data(), val.size());
+            return true;
+        }
+        default:
+            LOG(ERROR) << "Not support type: " << Type_Name(type);
+            return false;
+    }
+}
+
 std::unique_ptr<BaseAggregator> RequestAggUnionRunner::CreateAggregator() const {
     switch (agg_type_) {
         case kSum:
@@ -2704,6 +3198,8 @@ std::unique_ptr<BaseAggregator> RequestAggUnionRunner::CreateAggregator() const
             return MakeSameTypeAggregator<MinAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
         case kMax:
             return MakeSameTypeAggregator<MaxAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
+        case kDistinctCount:
+            return std::make_unique<DistinctCountAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
         default:
             LOG(ERROR) << "RequestAggUnionRunner does not support for op " << func_->GetName();
             return nullptr;
@@ -2830,55 +3326,66 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
     int64_t request_key = ts_gen > 0 ? ts_gen : 0;
 
     auto aggregator = CreateAggregator();
-    auto update_base_aggregator = [aggregator = aggregator.get(), row_parser = base_row_parser, this](const Row& row) {
-        if (!agg_col_name_.empty() && row_parser->IsNull(row, agg_col_name_)) {
+    // the aggr column type and its index are fixed for the runner, resolve them out of the per-row path
+    const auto type = aggregator->type();
+    const size_t col_schema_idx = agg_col_idx_.schema_idx;
+    const size_t col_idx = agg_col_idx_.col_idx;
+    auto update_base_aggregator = [aggregator = aggregator.get(), row_parser = base_row_parser, type, col_schema_idx,
+                                   col_idx, this](const Row& row) {
+        if (!agg_col_name_.empty() && row_parser->IsNull(row, col_schema_idx, col_idx)) {
             return;
         }
 
-        auto type = aggregator->type();
         if (agg_type_ == kCount) {
-            dynamic_cast<Aggregator<int64_t>*>(aggregator)->UpdateValue(1);
+            static_cast<Aggregator<int64_t>*>(aggregator)->UpdateValue(1);
             return;
         }
         if (agg_col_name_.empty()) {
             return;
         }
+        if (agg_type_ == kDistinctCount) {
+            uint64_t hash = 0;
+            if (HashAggrCol(row_parser, row, col_schema_idx, col_idx, type, &hash)) {
+                static_cast<Aggregator<int64_t>*>(aggregator)->UpdateValue(static_cast<int64_t>(hash));
+            }
+            return;
+        }
         switch (type) {
             case type::Type::kInt16: {
                 int16_t val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
+                row_parser->GetValue(row, col_schema_idx, col_idx, type, &val);
                 AggregatorUpdate(aggregator, val);
                 break;
             }
             case type::Type::kDate:
             case type::Type::kInt32: {
                 int32_t val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
+                row_parser->GetValue(row, col_schema_idx, col_idx, type, &val);
                 AggregatorUpdate(aggregator, val);
                 break;
             }
             case type::Type::kTimestamp:
             case type::Type::kInt64: {
                 int64_t val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
+                row_parser->GetValue(row, col_schema_idx, col_idx, type, &val);
                 AggregatorUpdate(aggregator, val);
                 break;
             }
             case type::Type::kFloat: {
                 float val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
+                row_parser->GetValue(row, col_schema_idx, col_idx, type, &val);
                 AggregatorUpdate(aggregator, val);
                 break;
             }
             case type::Type::kDouble: {
                 double val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
+                row_parser->GetValue(row, col_schema_idx, col_idx, type, &val);
                 AggregatorUpdate(aggregator, val);
                 break;
             }
             case type::Type::kVarchar: {
                 std::string val;
-                row_parser->GetString(row, agg_col_name_, &val);
+                row_parser->GetString(row, col_schema_idx, col_idx, &val);
                 AggregatorUpdate(aggregator, val);
                 break;
             }
@@ -2888,13 +3395,14 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
         }
     };
 
-    auto update_agg_aggregator = [aggregator = aggregator.get(), row_parser = agg_row_parser, this](const Row& row) {
-        if (row_parser->IsNull(row, "agg_val")) {
+    std::string agg_val;
+    auto update_agg_aggregator = [aggregator = aggregator.get(), row_parser = agg_row_parser, &agg_val,
+                                  this](const Row& row) {
+        if (row_parser->IsNull(row, agg_val_idx_.schema_idx, agg_val_idx_.col_idx)) {
             return;
         }
 
-        std::string agg_val;
-        row_parser->GetString(row, "agg_val", &agg_val);
+        row_parser->GetString(row, agg_val_idx_.schema_idx, agg_val_idx_.col_idx, &agg_val);
         aggregator->Update(agg_val);
     };
 
@@ -2936,13 +3444,15 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
     if (agg_it && agg_it->Valid()) {
         int64_t ts_start = agg_it->GetKey();
         int64_t ts_end = -1;
-        agg_row_parser->GetValue(agg_it->GetValue(), "ts_end", type::Type::kTimestamp, &ts_end);
+        agg_row_parser->GetValue(agg_it->GetValue(), ts_end_idx_.schema_idx, ts_end_idx_.col_idx,
+                                 type::Type::kTimestamp, &ts_end);
 
         if (ts_end > end) {  // [ts_start, ts_end] covers beyond the [start, end] region
             end_base = ts_start;
             agg_it->Next();
             if (agg_it->Valid()) {
-                agg_row_parser->GetValue(agg_it->GetValue(), "ts_end", type::Type::kTimestamp, &ts_end);
+                agg_row_parser->GetValue(agg_it->GetValue(), ts_end_idx_.schema_idx, ts_end_idx_.col_idx,
+                                         type::Type::kTimestamp, &ts_end);
                 end_base = ts_end;
             } else {
                 // only base table will be used
@@ -2994,9 +3504,9 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
 
         const Row& row = agg_it->GetValue();
         int64_t ts_end = -1;
-        agg_row_parser->GetValue(row, "ts_end", type::Type::kTimestamp, &ts_end);
+        agg_row_parser->GetValue(row, ts_end_idx_.schema_idx, ts_end_idx_.col_idx, type::Type::kTimestamp, &ts_end);
         int num_rows = 0;
-        agg_row_parser->GetValue(row, "num_rows", type::Type::kInt32, &num_rows);
+        agg_row_parser->GetValue(row, num_rows_idx_.schema_idx, num_rows_idx_.col_idx, type::Type::kInt32, &num_rows);
 
         // FIXME(zhanghao): check cnt and rows_start_preceding meanings
         int next_incr = num_rows > 0 ? num_rows - 1 : 0;
@@ -3113,26 +3623,192 @@ std::shared_ptr<DataHandler> RequestUnionRunner::Run(
                               range_gen_.window_range_, output_request_row_,
                               exclude_current_time_);
 }
+// Rows of one window segment shared by batch request rows with the same window key.
+// Rows are fetched from the segment lazily, at most once, and kept in descending key
+// order, so the request with the latest window end pays for the scan and the others
+// seek into what has been fetched already.
+class SharedSegment {
+ public:
+    SharedSegment(std::unique_ptr<RowIterator> iter, uint64_t end) : iter_(std::move(iter)) {
+        if (iter_) {
+            iter_->Seek(end);
+        }
+    }
+    // fetch rows until position `pos` is available, return false if the segment is exhausted
+    bool Fetch(size_t pos) {
+        while (pos >= rows_.size()) {
+            if (!iter_ || !iter_->Valid()) {
+                return false;
+            }
+            rows_.emplace_back(iter_->GetKey(), iter_->GetValue());
+            iter_->Next();
+        }
+        return true;
+    }
+    // first position whose key is less or equal to `key`
+    size_t Seek(uint64_t key) {
+        if (!rows_.empty() && rows_.back().first <= key) {
+            return std::lower_bound(rows_.begin(), rows_.end(), key,
+                                    [](const std::pair<uint64_t, Row>& row, uint64_t k) { return row.first > k; }) -
+                   rows_.begin();
+        }
+        while (Fetch(rows_.size()) && rows_.back().first > key) {
+        }
+        return rows_.empty() || rows_.back().first > key ? rows_.size() : rows_.size() - 1;
+    }
+    const std::pair<uint64_t, Row>& Get(size_t pos) const { return rows_[pos]; }
+
+ private:
+    std::unique_ptr<RowIterator> iter_;
+    std::deque<std::pair<uint64_t, Row>> rows_;
+};
+
+class SharedSegmentIterator : public RowIterator {
+ public:
+    explicit SharedSegmentIterator(SharedSegment* segment) : segment_(segment), pos_(0) {}
+    bool Valid() const override { return segment_->Fetch(pos_); }
+    void Next() override { pos_++; }
+    const uint64_t& GetKey() const override { return segment_->Get(pos_).first; }
+    const Row& GetValue() override { return segment_->Get(pos_).second; }
+    bool IsSeekable() const override { return true; }
+    void Seek(const uint64_t& key) override { pos_ = segment_->Seek(key); }
+    void SeekToFirst() override { pos_ = 0; }
+
+ private:
+    SharedSegment* segment_;
+    size_t pos_;
+};
+
+std::shared_ptr<DataHandlerList> RequestUnionRunner::BatchRequestRun(RunnerContext& ctx) {
+    if (need_batch_cache_) {
+        return Runner::BatchRequestRun(ctx);
+    }
+    if (need_cache_) {
+        auto cached = ctx.GetBatchCache(id_);
+        if (cached != nullptr) {
+            DLOG(INFO) << "RUNNER ID " << id_ << " HIT CACHE!";
+            return cached;
+        }
+    }
+    auto batch_right = producers_[1]->BatchRequestRun(ctx);
+    auto batch_requests = producers_[0]->BatchRequestRun(ctx);
+    size_t request_size = ctx.GetRequestSize();
+
+    // group the request rows by their window keys, each group shares the window segments
+    std::vector<std::vector<size_t>> groups;
+    std::vector<std::shared_ptr<DataHandler>> results(request_size);
+    std::unordered_map<std::string, size_t> group_idx;
+    for (size_t idx = 0; idx < request_size; idx++) {
+        auto request = batch_requests->Get(idx);
+        if (!request || kRowHandler != request->GetHandlerType()) {
+            results[idx] = Run(ctx, {request, batch_right->Get(idx)});
+            continue;
+        }
+        auto key = windows_union_gen_.GetRequestWindowsKey(
+            std::dynamic_pointer_cast<RowHandler>(request)->GetValue(), ctx.GetParameterRow());
+        auto it = group_idx.emplace(key, groups.size()).first;
+        if (it->second == groups.size()) {
+            groups.emplace_back();
+        }
+        groups[it->second].push_back(idx);
+    }
+
+    auto union_inputs = groups.empty() ? std::vector<std::shared_ptr<DataHandler>>()
+                                       : windows_union_gen_.RunInputs(ctx);
+    std::vector<std::vector<Row>> group_requests(groups.size());
+    std::vector<std::vector<int64_t>> group_ts_gens(groups.size());
+    std::vector<uint64_t> group_ends(groups.size(), 0);
+    std::vector<std::vector<std::shared_ptr<TableHandler>>> group_union_segments(groups.size());
+    // (group, segment) of every window segment to seek
+    std::vector<std::pair<size_t, size_t>> seeks;
+    for (size_t g = 0; g < groups.size(); g++) {
+        for (size_t idx : groups[g]) {
+            group_requests[g].push_back(std::dynamic_pointer_cast<RowHandler>(batch_requests->Get(idx))->GetValue());
+            group_ts_gens[g].push_back(range_gen_.Valid() ? range_gen_.ts_gen_.Gen(group_requests[g].back()) : -1);
+            uint64_t start = 0;
+            uint64_t end = UINT64_MAX;
+            GetWindowBound(group_ts_gens[g].back(), range_gen_.window_range_, exclude_current_time_, &start, &end);
+            group_ends[g] = std::max(group_ends[g], end);
+        }
+        group_union_segments[g] =
+            windows_union_gen_.GetRequestWindows(group_requests[g][0], ctx.GetParameterRow(), union_inputs);
+        for (size_t i = 0; i < group_union_segments[g].size(); i++) {
+            seeks.emplace_back(g, i);
+        }
+    }
+    // seek the segments of all groups and fetch their first rows before any window is built. with
+    // batch_request_seek_parallelism > 1 the seeks run concurrently, so the reads of a disk table overlap
+    // instead of being issued one window key after another
+    std::vector<std::vector<std::unique_ptr<SharedSegment>>> group_shared_segments(groups.size());
+    for (size_t g = 0; g < groups.size(); g++) {
+        group_shared_segments[g].resize(group_union_segments[g].size());
+    }
+    ParallelFor(std::min(static_cast<size_t>(FLAGS_batch_request_seek_parallelism), seeks.size()), seeks.size(),
+                [&](size_t idx) {
+                    size_t g = seeks[idx].first;
+                    auto& segment = group_union_segments[g][seeks[idx].second];
+                    auto shared_segment =
+                        std::make_unique<SharedSegment>(segment ? segment->GetIterator() : nullptr, group_ends[g]);
+                    shared_segment->Fetch(0);
+                    group_shared_segments[g][seeks[idx].second] = std::move(shared_segment);
+                });
+    for (size_t g = 0; g < groups.size(); g++) {
+        for (size_t i = 0; i < groups[g].size(); i++) {
+            std::vector<std::unique_ptr<RowIterator>> union_segment_iters;
+            for (auto& shared_segment : group_shared_segments[g]) {
+                union_segment_iters.emplace_back(new SharedSegmentIterator(shared_segment.get()));
+            }
+            results[groups[g][i]] = RequestUnionWindow(group_requests[g][i], std::move(union_segment_iters),
+                                                       group_ts_gens[g][i], range_gen_.window_range_,
+                                                       output_request_row_, exclude_current_time_);
+        }
+    }
+
+    std::shared_ptr<DataHandlerVector> outputs = std::make_shared<DataHandlerVector>();
+    for (auto& res : results) {
+        outputs->Add(res);
+    }
+    SetBatchOutputs(ctx, outputs);
+    return outputs;
+}
+
+void RequestUnionRunner::GetWindowBound(int64_t ts_gen, const WindowRange& window_range,
+                                        const bool exclude_current_time, uint64_t* start, uint64_t* end) {
+    if (ts_gen < 0) {
+        return;
+    }
+    *start = (ts_gen + window_range.start_offset_) < 0 ? 0 : (ts_gen + window_range.start_offset_);
+    if (exclude_current_time && 0 == window_range.end_offset_) {
+        *end = (ts_gen - 1) < 0 ? 0 : (ts_gen - 1);
+    } else {
+        *end = (ts_gen + window_range.end_offset_) < 0 ? 0 : (ts_gen + window_range.end_offset_);
+    }
+}
+
 std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
     const Row& request,
     std::vector<std::shared_ptr<TableHandler>> union_segments, int64_t ts_gen,
     const WindowRange& window_range, const bool output_request_row,
     const bool exclude_current_time) {
+    std::vector<std::unique_ptr<RowIterator>> union_segment_iters;
+    for (auto& segment : union_segments) {
+        union_segment_iters.push_back(segment ? segment->GetIterator() : nullptr);
+    }
+    return RequestUnionWindow(request, std::move(union_segment_iters), ts_gen, window_range, output_request_row,
+                              exclude_current_time);
+}
+
+std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
+    const Row& request,
+    std::vector<std::unique_ptr<RowIterator>> union_segment_iters, int64_t ts_gen,
+    const WindowRange& window_range, const bool output_request_row,
+    const bool exclude_current_time) {
     uint64_t start = 0;
     uint64_t end = UINT64_MAX;
     uint64_t rows_start_preceding = 0;
     uint64_t max_size = 0;
     if (ts_gen >= 0) {
-        start = (ts_gen + window_range.start_offset_) < 0
-                    ? 0
-                    : (ts_gen + window_range.start_offset_);
-        if (exclude_current_time && 0 == window_range.end_offset_) {
-            end = (ts_gen - 1) < 0 ? 0 : (ts_gen - 1);
-        } else {
-            end = (ts_gen + window_range.end_offset_) < 0
-                      ? 0
-                      : (ts_gen + window_range.end_offset_);
-        }
+        GetWindowBound(ts_gen, window_range, exclude_current_time, &start, &end);
         rows_start_preceding = window_range.start_row_;
         max_size = window_range.max_size_;
     }
@@ -3141,17 +3817,18 @@ std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
     auto window_table =
         std::shared_ptr<MemTimeTableHandler>(new MemTimeTableHandler());
 
-    size_t unions_cnt = union_segments.size();
+    size_t unions_cnt = union_segment_iters.size();
+    // a window over a single table needs no merging between segments
+    if (unions_cnt == 1) {
+        RequestUnionSingleWindow(request, union_segment_iters[0].get(), request_key, start, end,
+                                 rows_start_preceding, max_size, window_range, output_request_row,
+                                 window_table.get());
+        return window_table;
+    }
     // Prepare Union Segment Iterators
-    std::vector<std::unique_ptr<RowIterator>> union_segment_iters(unions_cnt);
     std::vector<IteratorStatus> union_segment_status(unions_cnt);
 
     for (size_t i = 0; i < unions_cnt; i++) {
-        if (!union_segments[i]) {
-            union_segment_status[i] = IteratorStatus();
-            continue;
-        }
-        union_segment_iters[i] = union_segments[i]->GetIterator();
         if (!union_segment_iters[i]) {
             union_segment_status[i] = IteratorStatus();
             continue;
@@ -3209,6 +3886,39 @@ std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
     return window_table;
 }
 
+void RequestUnionRunner::RequestUnionSingleWindow(const Row& request, RowIterator* iter,
+                                                  uint64_t request_key, uint64_t start, uint64_t end,
+                                                  uint64_t rows_start_preceding, uint64_t max_size,
+                                                  const WindowRange& window_range, const bool output_request_row,
+                                                  MemTimeTableHandler* window_table) {
+    uint64_t cnt = 0;
+    auto range_status = window_range.GetWindowPositionStatus(cnt > rows_start_preceding, window_range.end_offset_ < 0,
+                                                             request_key < start);
+    if (output_request_row) {
+        window_table->AddRow(request_key, request);
+    }
+    if (WindowRange::kInWindow == range_status) {
+        cnt++;
+    }
+    if (!iter) {
+        return;
+    }
+    for (iter->Seek(end); iter->Valid(); iter->Next()) {
+        if (max_size > 0 && cnt >= max_size) {
+            break;
+        }
+        uint64_t ts = iter->GetKey();
+        auto range_status = window_range.GetWindowPositionStatus(cnt > rows_start_preceding, ts > end, ts < start);
+        if (WindowRange::kExceedWindow == range_status) {
+            break;
+        }
+        if (WindowRange::kInWindow == range_status) {
+            window_table->AddRow(ts, iter->GetValue());
+            cnt++;
+        }
+    }
+}
+
 std::shared_ptr<DataHandler> PostRequestUnionRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
@@ -3265,12 +3975,11 @@ std::shared_ptr<DataHandler> AggRunner::Run(
 }
 std::shared_ptr<DataHandlerList> ProxyRequestRunner::BatchRequestRun(
     RunnerContext& ctx) {
-    if (need_cache_) {
-        auto cached = ctx.GetBatchCache(id_);
-        if (cached != nullptr) {
-            DLOG(INFO) << "RUNNER ID " << id_ << " HIT CACHE!";
-            return cached;
-        }
+    // the outputs of a prefetched proxy are cached even if need_cache_ is off
+    auto cached = ctx.GetBatchCache(id_);
+    if (cached != nullptr) {
+        DLOG(INFO) << "RUNNER ID " << id_ << " HIT CACHE!";
+        return cached;
     }
     std::shared_ptr<DataHandlerList> proxy_batch_input =
         producers_[0]->BatchRequestRun(ctx);
@@ -3338,6 +4047,90 @@ std::shared_ptr<DataHandlerList> ProxyRequestRunner::BatchRequestRun(
     return outputs;
 }
 
+std::shared_ptr<DataHandler> ProxyRequestRunner::RunWithCache(
+    RunnerContext& ctx) {
+    // the output of a prefetched proxy is cached even if need_cache_ is off
+    auto cached = ctx.GetCache(id_);
+    if (cached != nullptr) {
+        DLOG(INFO) << "RUNNER ID " << id_ << " HIT CACHE!";
+        return cached;
+    }
+    return Runner::RunWithCache(ctx);
+}
+
+bool ProxyRequestRunner::HasProxyProducer(const Runner* runner) {
+    if (nullptr == runner) {
+        return false;
+    }
+    if (kRunnerRequestRunProxy == runner->type_) {
+        return true;
+    }
+    for (auto producer : runner->GetProducers()) {
+        if (HasProxyProducer(producer)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ProxyRequestRunner::CollectIndependent(Runner* runner, std::set<int32_t>* visited_ids,
+                                            std::vector<ProxyRequestRunner*>* proxies) {
+    if (nullptr == runner || !visited_ids->insert(runner->id_).second) {
+        return;
+    }
+    if (kRunnerRequestRunProxy == runner->type_) {
+        auto proxy = dynamic_cast<ProxyRequestRunner*>(runner);
+        // a proxy fed by another remote result has to wait for it
+        bool independent = nullptr != proxy && !proxy->GetProducers().empty();
+        for (auto producer : runner->GetProducers()) {
+            independent = independent && !HasProxyProducer(producer);
+        }
+        if (independent && !HasProxyProducer(proxy->index_input_)) {
+            proxies->push_back(proxy);
+            return;
+        }
+    }
+    for (auto producer : runner->GetProducers()) {
+        CollectIndependent(producer, visited_ids, proxies);
+    }
+}
+
+size_t ProxyRequestRunner::PrefetchIndependent(Runner* root, RunnerContext& ctx, bool is_batch_request) {
+    std::set<int32_t> visited_ids;
+    std::vector<ProxyRequestRunner*> proxies;
+    CollectIndependent(root, &visited_ids, &proxies);
+    if (proxies.size() < 2) {
+        // a single remote task is issued as early as before
+        return 0;
+    }
+    // remote sub queries are asynchronous, issuing them all here means a
+    // result is awaited only when the runner tree reads it
+    for (auto proxy : proxies) {
+        if (is_batch_request) {
+            ctx.SetBatchCache(proxy->id_, proxy->BatchRequestRun(ctx));
+        } else {
+            ctx.SetCache(proxy->id_, proxy->RunWithCache(ctx));
+        }
+    }
+    DLOG(INFO) << "prefetch " << proxies.size() << " remote tasks";
+    return proxies.size();
+}
+
+std::string ProxyRequestRunner::GetSubQueryKey(const Tablet& tablet, const std::vector<Row>& rows,
+                                               const bool request_is_common) const {
+    size_t hash = rows.size();
+    for (auto& row : rows) {
+        for (int32_t idx = 0; idx < row.GetRowPtrCnt(); idx++) {
+            size_t slice_hash = nullptr == row.buf(idx)
+                                    ? 0
+                                    : std::hash<std::string_view>()(std::string_view(
+                                          reinterpret_cast<const char*>(row.buf(idx)), row.size(idx)));
+            hash = hash * 31 + slice_hash;
+        }
+    }
+    return absl::StrCat(task_id_, "|", tablet.GetName(), "|", request_is_common ? "1" : "0", "|", hash);
+}
+
 // run each line of request
 std::shared_ptr<DataHandler> ProxyRequestRunner::Run(
     RunnerContext& ctx,
@@ -3574,14 +4367,24 @@ std::shared_ptr<DataHandler> ProxyRequestRunner::RunWithRowInput(
                             "unsupported currently";
             return std::shared_ptr<DataHandler>();
         }
+        std::vector<Row> rows({row});
+        auto key = GetSubQueryKey(*tablet, rows, false);
+        auto cached = ctx.GetSubQueryCache(key, rows);
+        if (cached) {
+            DLOG(INFO) << "task " << task_id_ << " shares an in flight sub query";
+            return cached;
+        }
+        std::shared_ptr<DataHandler> res;
         if (ctx.sp_name().empty()) {
-            return tablet->SubQuery(task_id_, cluster_job->db(),
-                                    cluster_job->sql(), row, false,
-                                    ctx.is_debug());
+            res = tablet->SubQuery(task_id_, cluster_job->db(),
+                                   cluster_job->sql(), row, false,
+                                   ctx.is_debug());
         } else {
-            return tablet->SubQuery(task_id_, cluster_job->db(),
-                                    ctx.sp_name(), row, true, ctx.is_debug());
+            res = tablet->SubQuery(task_id_, cluster_job->db(),
+                                   ctx.sp_name(), row, true, ctx.is_debug());
         }
+        ctx.SetSubQueryCache(key, rows, res);
+        return res;
     }
 }
 // out_table = Proxy(in_table) , remote table left join
@@ -3628,18 +4431,26 @@ std::shared_ptr<TableHandler> ProxyRequestRunner::RunWithRowsInput(
             << "fail to run proxy runner with rows: subquery tablet is null";
         return fail_ptr;
     }
+    auto key = GetSubQueryKey(*tablet, rows, request_is_common);
+    auto cached = std::dynamic_pointer_cast<TableHandler>(ctx.GetSubQueryCache(key, rows));
+    if (cached) {
+        DLOG(INFO) << "task " << task_id_ << " shares an in flight sub query";
+        return cached;
+    }
+    std::shared_ptr<TableHandler> res;
     if (ctx.sp_name().empty()) {
-        return tablet->SubQuery(task_id_, cluster_job->db(),
-                                cluster_job->sql(),
-                                ctx.cluster_job()->common_column_indices(),
-                                rows, request_is_common, false, ctx.is_debug());
+        res = tablet->SubQuery(task_id_, cluster_job->db(),
+                               cluster_job->sql(),
+                               ctx.cluster_job()->common_column_indices(),
+                               rows, request_is_common, false, ctx.is_debug());
     } else {
-        return tablet->SubQuery(task_id_, cluster_job->db(),
-                                ctx.sp_name(),
-                                ctx.cluster_job()->common_column_indices(),
-                                rows, request_is_common, true, ctx.is_debug());
+        res = tablet->SubQuery(task_id_, cluster_job->db(),
+                               ctx.sp_name(),
+                               ctx.cluster_job()->common_column_indices(),
+                               rows, request_is_common, true, ctx.is_debug());
     }
-    return fail_ptr;
+    ctx.SetSubQueryCache(key, rows, res);
+    return res;
 }
 
 /**
@@ -3768,6 +4579,18 @@ const bool ConditionGenerator::Gen(std::shared_ptr<TableHandler> table, const co
 const Row ProjectGenerator::Gen(const Row& row, const Row& parameter) {
     return CoreAPI::RowProject(fn_, row, parameter, false);
 }
+void ProjectGenerator::Gen(const Row* rows, size_t cnt, const Row& parameter, Row* outputs) {
+    if (HasBatchEntry()) {
+        CoreAPI::RowProjectBatch(batch_fn_, rows, cnt, parameter, outputs);
+        return;
+    }
+    for (size_t i = 0; i < cnt; i++) {
+        outputs[i] = Gen(rows[i], parameter);
+    }
+}
+const bool ProjectGenerator::HasBatchEntry() const {
+    return FLAGS_enable_batch_project && nullptr != batch_fn_;
+}
 
 const Row ConstProjectGenerator::Gen(const Row& parameter) {
     return CoreAPI::RowConstProject(fn_, parameter, false);
@@ -4028,6 +4851,26 @@ void RunnerContext::SetCache(int64_t id,
     cache_[id] = data;
 }
 
+std::shared_ptr<DataHandler> RunnerContext::GetSubQueryCache(const std::string& key,
+                                                             const std::vector<Row>& rows) const {
+    auto iter = subquery_cache_.find(key);
+    if (iter == subquery_cache_.end() || iter->second.first.size() != rows.size()) {
+        return std::shared_ptr<DataHandler>();
+    }
+    // rows of the same hash may differ
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (0 != iter->second.first[i].compare(rows[i])) {
+            return std::shared_ptr<DataHandler>();
+        }
+    }
+    return iter->second.second;
+}
+
+void RunnerContext::SetSubQueryCache(const std::string& key, const std::vector<Row>& rows,
+                                     std::shared_ptr<DataHandler> data) {
+    subquery_cache_[key] = std::make_pair(rows, data);
+}
+
 void RunnerContext::SetRequest(const hybridse::codec::Row& request) {
     request_ = request;
 }
@@ -17,6 +17,7 @@
 #ifndef HYBRIDSE_SRC_VM_RUNNER_H_
 #define HYBRIDSE_SRC_VM_RUNNER_H_
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
@@ -47,6 +48,7 @@ using vm::Window;
 
 class Runner;
 class RunnerContext;
+class RunProfile;
 class FnGenerator {
  public:
     explicit FnGenerator(const FnInfo& info)
@@ -78,10 +80,14 @@ class RowProjectFun : public ProjectFun {
 class ProjectGenerator : public FnGenerator {
  public:
     explicit ProjectGenerator(const FnInfo& info)
-        : FnGenerator(info), fun_(info.fn_ptr()) {}
+        : FnGenerator(info), fun_(info.fn_ptr()), batch_fn_(info.batch_fn_ptr()) {}
     virtual ~ProjectGenerator() {}
     const Row Gen(const Row& row, const Row& parameter);
+    // project rows[0, cnt) into outputs[0, cnt), in one call if the function has a batch entry
+    void Gen(const Row* rows, size_t cnt, const Row& parameter, Row* outputs);
+    const bool HasBatchEntry() const;
     RowProjectFun fun_;
+    const int8_t* batch_fn_;
 };
 
 class ConstProjectGenerator : public FnGenerator {
@@ -315,6 +321,19 @@ class RequestWindowGenertor {
         }
         return segment;
     }
+    const std::string GetRequestWindowKey(const Row& row, const Row& parameter) {
+        // both parts are length prefixed, a bare index key could run into the filter key
+        std::string key;
+        if (index_seek_gen_.Valid()) {
+            std::string index_key = index_seek_gen_.index_key_gen_.Gen(row, parameter);
+            key.append(std::to_string(index_key.size())).append(":").append(index_key);
+        }
+        if (filter_gen_.Valid()) {
+            std::string filter_key = filter_gen_.GetKey(row, parameter);
+            key.append(std::to_string(filter_key.size())).append(":").append(filter_key);
+        }
+        return key;
+    }
     RequestWindowOp window_op_;
     FilterKeyGenerator filter_gen_;
     SortGenerator sort_gen_;
@@ -455,6 +474,9 @@ class Runner : public node::NodeBase<Runner> {
             output << " lazy";
         }
     }
+    // print the runner tree, each runner annotated with its statistics in `profile`
+    void PrintProfile(std::ostream& output, const std::string& tab, const RunProfile& profile,
+                      std::set<int32_t>* visited_ids) const;  // NOLINT
     virtual void Print(std::ostream& output, const std::string& tab,
                        std::set<int32_t>* visited_ids) const {  // NOLINT
         PrintRunnerInfo(output, tab);
@@ -506,6 +528,10 @@ class Runner : public node::NodeBase<Runner> {
                              const bool is_instance,
                              size_t append_slices, Window* window);
     static Row GroupbyProject(const int8_t* fn, const Row& parameter, TableHandler* table);
+    // same as RowLastJoinTable, but `right_table` is already sorted by the right sort reversed
+    static const Row RowLastJoinSortedTable(size_t left_slices, const Row& left_row, size_t right_slices,
+                                            std::shared_ptr<TableHandler> right_table, const Row& parameter,
+                                            ConditionGenerator& cond_gen);  // NOLINT
     static const Row RowLastJoinTable(size_t left_slices, const Row& left_row,
                                       size_t right_slices,
                                       std::shared_ptr<TableHandler> right_table,
@@ -514,6 +540,11 @@ class Runner : public node::NodeBase<Runner> {
                                       ConditionGenerator& filter);  // NOLINT
     static std::shared_ptr<TableHandler> TableReverse(
         std::shared_ptr<TableHandler> table);
+    // number of threads to run task_cnt independent tasks of a batch runner
+    static size_t GetBatchParallelism(size_t task_cnt);
+    // run task(0) ... task(task_cnt - 1) on the caller and `parallelism - 1` threads of a shared
+    // pool. each thread picks the next unprocessed task, so tasks of uneven cost are balanced
+    static void ParallelFor(size_t parallelism, size_t task_cnt, const std::function<void(size_t)>& task);
 
     static void PrintData(std::ostringstream& oss,
                           const vm::SchemasContext* schema_list,
@@ -550,6 +581,9 @@ class Runner : public node::NodeBase<Runner> {
  protected:
     bool is_lazy_;
 
+    // print the outputs of a batch request run in debug mode, and cache them if needed
+    void SetBatchOutputs(RunnerContext& ctx, std::shared_ptr<DataHandlerList> outputs);  // NOLINT
+
     void PrintCacheInfo(std::ostream& output) const {
         if (need_cache_ && need_batch_cache_) {
             output << " (cache_enable, batch_common)";
@@ -646,8 +680,39 @@ class RequestWindowUnionGenerator : public InputsGenerator {
         }
         return union_segments;
     }
+    // Request rows with the same key get the same request windows
+    const std::string GetRequestWindowsKey(const Row& row, const Row& parameter) {
+        std::string key;
+        for (auto& window_gen : windows_gen_) {
+            std::string window_key = window_gen.GetRequestWindowKey(row, parameter);
+            key.append(std::to_string(window_key.size())).append(":").append(window_key);
+        }
+        return key;
+    }
     std::vector<RequestWindowGenertor> windows_gen_;
 };
+// The right rows of a batch last join grouped by the join key once.
+// Rows of a key are ordered by the right sort reversed on the first find of the key,
+// so the first row matching the join condition is the last joined row, and keys
+// never joined are not sorted.
+class LastJoinHashTable {
+ public:
+    explicit LastJoinHashTable(SortGenerator* right_sort) : right_sort_(right_sort), rows_() {}
+    ~LastJoinHashTable() {}
+    bool Build(std::shared_ptr<PartitionHandler> right);
+    // return null if no right row has the key
+    const std::vector<Row>* Find(const std::string& key);
+
+ private:
+    struct Segment {
+        // reset once the rows are sorted
+        std::shared_ptr<TableHandler> table;
+        std::vector<Row> rows;
+    };
+    SortGenerator* right_sort_;
+    std::unordered_map<std::string, Segment> rows_;
+};
+
 class JoinGenerator {
  public:
     explicit JoinGenerator(const Join& join, size_t left_slices,
@@ -691,6 +756,11 @@ class JoinGenerator {
     Row RowLastJoinTable(const Row& left_row,
                          std::shared_ptr<TableHandler> table,
                          const Row& parameter);
+    Row RowLastJoinRows(const Row& left_row, const std::vector<Row>* rows, const Row& parameter);
+    // the key of the right segment joined with left row
+    std::string GetJoinKey(const Row& left_row, const Row& parameter);
+    // build a hash table of the right partition if it is grouped in memory
+    std::unique_ptr<LastJoinHashTable> BuildHashTable(std::shared_ptr<PartitionHandler> right);
 
     size_t left_slices_;
     size_t right_slices_;
@@ -812,6 +882,9 @@ class RowProjectRunner : public Runner {
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
         override;  // NOLINT
+    // project all request rows in one call
+    std::shared_ptr<DataHandlerList> BatchRequestRun(
+        RunnerContext& ctx) override;  // NOLINT
     ProjectGenerator project_gen_;
 };
 
@@ -836,6 +909,9 @@ class SimpleProjectRunner : public Runner {
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
         override;  // NOLINT
     ProjectGenerator project_gen_;
+    // the columns of the input table the project depends on, pushed down to
+    // the table when it is a data provider, empty for all columns
+    std::vector<uint32_t> source_columns_;
 };
 
 class SelectSliceRunner : public Runner {
@@ -954,6 +1030,9 @@ class WindowAggRunner : public Runner {
     WindowProjectGenerator window_project_gen_;
 };
 
+// Build the window of a request row from the rows in storage. Windows listed in
+// the long_windows option of a deployment are served by RequestAggUnionRunner
+// instead, which reads the aggregate state the tablet updates on put.
 class RequestUnionRunner : public Runner {
  public:
     RequestUnionRunner(const int32_t id, const SchemasContext* schema,
@@ -968,11 +1047,19 @@ class RequestUnionRunner : public Runner {
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
         override;  // NOLINT
+    // Request rows sharing a window key scan their window segments once
+    std::shared_ptr<DataHandlerList> BatchRequestRun(
+        RunnerContext& ctx) override;  // NOLINT
     static std::shared_ptr<TableHandler> RequestUnionWindow(
         const Row& request,
         std::vector<std::shared_ptr<TableHandler>> union_segments,
         int64_t request_ts, const WindowRange& window_range,
         const bool output_request_row, const bool exclude_current_time);
+    static std::shared_ptr<TableHandler> RequestUnionWindow(
+        const Row& request,
+        std::vector<std::unique_ptr<RowIterator>> union_segment_iters,
+        int64_t request_ts, const WindowRange& window_range,
+        const bool output_request_row, const bool exclude_current_time);
     void AddWindowUnion(const RequestWindowOp& window, Runner* runner) {
         windows_union_gen_.AddWindowUnion(window, runner);
     }
@@ -980,6 +1067,15 @@ class RequestUnionRunner : public Runner {
     RangeGenerator range_gen_;
     bool exclude_current_time_;
     bool output_request_row_;
+
+ private:
+    static void GetWindowBound(int64_t request_ts, const WindowRange& window_range,
+                               const bool exclude_current_time, uint64_t* start, uint64_t* end);
+    static void RequestUnionSingleWindow(const Row& request, RowIterator* iter,
+                                         uint64_t request_key, uint64_t start, uint64_t end,
+                                         uint64_t rows_start_preceding, uint64_t max_size,
+                                         const WindowRange& window_range, const bool output_request_row,
+                                         MemTimeTableHandler* window_table);
 };
 
 class RequestAggUnionRunner : public Runner {
@@ -1016,7 +1112,8 @@ class RequestAggUnionRunner : public Runner {
         kCount,
         kAvg,
         kMin,
-        kMax
+        kMax,
+        kDistinctCount
     };
 
     RequestWindowUnionGenerator windows_union_gen_;
@@ -1029,9 +1126,20 @@ class RequestAggUnionRunner : public Runner {
     std::string agg_col_name_;
     type::Type agg_col_type_;
 
+    // columns of the base and agg table, resolved once in InitAggregator
+    struct ColumnIndex {
+        size_t schema_idx = 0;
+        size_t col_idx = 0;
+    };
+    ColumnIndex agg_col_idx_;
+    ColumnIndex agg_val_idx_;
+    ColumnIndex ts_end_idx_;
+    ColumnIndex num_rows_idx_;
+
     std::unique_ptr<BaseAggregator> CreateAggregator() const;
     static inline const std::unordered_map<std::string, AggType> agg_type_map_ = {
         {"sum", kSum}, {"count", kCount}, {"avg", kAvg}, {"min", kMin}, {"max", kMax},
+        {"distinct_count", kDistinctCount},
     };
 };
 
@@ -1137,6 +1245,13 @@ class ProxyRequestRunner : public Runner {
         const std::vector<std::shared_ptr<DataHandler>>& inputs) override;
     std::shared_ptr<DataHandlerList> BatchRequestRun(
         RunnerContext& ctx) override;  // NOLINT
+    std::shared_ptr<DataHandler> RunWithCache(
+        RunnerContext& ctx) override;  // NOLINT
+    // issue the sub queries of all proxy runners under `root` whose inputs
+    // are computed locally, before any remote result is awaited. return the
+    // number of proxy runners prefetched
+    static size_t PrefetchIndependent(Runner* root, RunnerContext& ctx,  // NOLINT
+                                      bool is_batch_request);
     virtual void PrintRunnerInfo(std::ostream& output,
                                  const std::string& tab) const {
         output << tab << "[" << id_ << "]" << RunnerTypeName(type_)
@@ -1184,6 +1299,13 @@ class ProxyRequestRunner : public Runner {
         RunnerContext& ctx,  // NOLINT
         const std::vector<Row>& rows, const std::vector<Row>& index_rows,
         const bool request_is_common);
+    // key of a sub query, identical sub queries of a request share one rpc. the
+    // input rows are hashed, not copied, the cache compares them on a hit
+    std::string GetSubQueryKey(const Tablet& tablet, const std::vector<Row>& rows,
+                               const bool request_is_common) const;
+    static bool HasProxyProducer(const Runner* runner);
+    static void CollectIndependent(Runner* runner, std::set<int32_t>* visited_ids,
+                                   std::vector<ProxyRequestRunner*>* proxies);
     uint32_t task_id_;
     Runner* index_input_;
 };
@@ -1576,13 +1698,25 @@ class RunnerContext {
     void SetRequest(const hybridse::codec::Row& request);
     void SetRequests(const std::vector<hybridse::codec::Row>& requests);
     bool is_debug() const { return is_debug_; }
+    // runtime profile the runners record into, null if profiling is disabled
+    RunProfile* profile() const { return profile_; }
+    void SetProfile(RunProfile* profile) { profile_ = profile; }
+    // wall time of the producers of the runner being profiled
+    uint64_t GetProducersTime() const { return producers_time_us_; }
+    void SetProducersTime(uint64_t time_us) { producers_time_us_ = time_us; }
 
     const std::string& sp_name() { return sp_name_; }
     std::shared_ptr<DataHandler> GetCache(int64_t id) const;
     void SetCache(int64_t id, std::shared_ptr<DataHandler> data);
-    void ClearCache() { cache_.clear(); }
+    void ClearCache() {
+        cache_.clear();
+        subquery_cache_.clear();
+    }
     std::shared_ptr<DataHandlerList> GetBatchCache(int64_t id) const;
     void SetBatchCache(int64_t id, std::shared_ptr<DataHandlerList> data);
+    // the sub query of `key` is shared only if it was issued with the same input rows
+    std::shared_ptr<DataHandler> GetSubQueryCache(const std::string& key, const std::vector<Row>& rows) const;
+    void SetSubQueryCache(const std::string& key, const std::vector<Row>& rows, std::shared_ptr<DataHandler> data);
 
  private:
     hybridse::vm::ClusterJob* cluster_job_;
@@ -1595,6 +1729,11 @@ class RunnerContext {
     // TODO(chenjing): optimize
     std::map<int64_t, std::shared_ptr<DataHandler>> cache_;
     std::map<int64_t, std::shared_ptr<DataHandlerList>> batch_cache_;
+    // in flight sub queries of the request with their input rows, keyed by task, tablet and the hash of the
+    // input rows
+    std::map<std::string, std::pair<std::vector<Row>, std::shared_ptr<DataHandler>>> subquery_cache_;
+    RunProfile* profile_ = nullptr;
+    uint64_t producers_time_us_ = 0;
 };
 }  // namespace vm
 }  // namespace hybridse
@@ -18,6 +18,7 @@
 #include <utility>
 #include "boost/algorithm/string.hpp"
 #include "case/sql_case.h"
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
 #include "llvm/IR/Function.h"
@@ -36,6 +37,8 @@
 #include "testing/test_base.h"
 #include "vm/sql_compiler.h"
 
+DECLARE_bool(enable_hash_last_join);
+
 using namespace llvm;       // NOLINT
 using namespace llvm::orc;  // NOLINT
 
@@ -522,6 +525,232 @@ TEST_F(RunnerTest, RunnerPrintDataMemTimeTableTest) {
         LOG(INFO) << oss.str();
     }
 }
+
+static std::vector<uint64_t> GetWindowKeys(std::shared_ptr<TableHandler> window) {
+    std::vector<uint64_t> keys;
+    auto iter = window->GetIterator();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        keys.push_back(iter->GetKey());
+    }
+    return keys;
+}
+
+// a window over one segment is built without the union merge, and must give the
+// same rows as the merge over the same segment plus an empty one
+TEST_F(RunnerTest, RequestUnionSingleWindowTest) {
+    std::vector<Row> rows;
+    hybridse::type::TableDef temp_table;
+    BuildRows(temp_table, rows);
+    auto segment = std::make_shared<MemTimeTableHandler>();
+    std::vector<uint64_t> keys = {100, 100, 99, 98, 95, 90, 80, 50, 10};
+    for (size_t i = 0; i < keys.size(); i++) {
+        segment->AddRow(keys[i], rows[i % rows.size()]);
+    }
+    auto empty_segment = std::make_shared<MemTimeTableHandler>();
+
+    std::vector<WindowRange> ranges = {
+        WindowRange::CreateRowsWindow(0),
+        WindowRange::CreateRowsWindow(3),
+        WindowRange::CreateRowsWindow(100),
+        WindowRange::CreateRowsRangeWindow(-10, 0),
+        WindowRange::CreateRowsRangeWindow(-10, 0, 2),
+        WindowRange::CreateRowsRangeWindow(-30, -5),
+        WindowRange::CreateRowsRangeWindow(-1000, 0),
+        WindowRange::CreateRowsMergeRowsRangeWindow(-10, 3),
+        WindowRange::CreateRowsMergeRowsRangeWindow(-50, 2, 3),
+    };
+    for (int64_t request_ts : {100, 97, 5}) {
+        for (size_t i = 0; i < ranges.size(); i++) {
+            for (bool output_request_row : {true, false}) {
+                for (bool exclude_current_time : {true, false}) {
+                    auto single = RequestUnionRunner::RequestUnionWindow(
+                        rows[0], {segment}, request_ts, ranges[i], output_request_row, exclude_current_time);
+                    auto merged = RequestUnionRunner::RequestUnionWindow(rows[0], {segment, empty_segment},
+                                                                         request_ts, ranges[i], output_request_row,
+                                                                         exclude_current_time);
+                    ASSERT_EQ(GetWindowKeys(merged), GetWindowKeys(single))
+                        << "request_ts " << request_ts << ", range " << i << ", output_request_row "
+                        << output_request_row << ", exclude_current_time " << exclude_current_time;
+                }
+            }
+        }
+    }
+}
+
+static Row BuildJoinRow(const hybridse::type::TableDef& table_def, int32_t col1, int16_t col2, int64_t col5) {
+    codec::RowBuilder builder(table_def.columns());
+    std::string str = std::to_string(col5);
+    uint32_t total_size = builder.CalTotalLength(1 + str.size());
+    int8_t* ptr = static_cast<int8_t*>(malloc(total_size));
+    builder.SetBuffer(ptr, total_size);
+    builder.AppendString("0", 1);
+    builder.AppendInt32(col1);
+    builder.AppendInt16(col2);
+    builder.AppendFloat(1.1f);
+    builder.AppendDouble(11.1);
+    builder.AppendInt64(col5);
+    builder.AppendString(str.c_str(), str.size());
+    return Row(base::RefCountedSlice::Create(ptr, total_size));
+}
+
+// the last join over the hash table of the right partition must join the same rows as
+// the join looking up the right segment of every left row
+TEST_F(RunnerTest, LastJoinHashTableTest) {
+    hybridse::type::TableDef t1;
+    BuildTableDef(t1);
+    t1.set_name("t1");
+    hybridse::type::TableDef t2;
+    BuildTableDef(t2);
+    t2.set_name("t2");
+    // joined by `index_key|left_key` if the right table has an index on a part of the keys
+    hybridse::type::TableDef t3;
+    BuildTableDef(t3);
+    t3.set_name("t3");
+    ::hybridse::type::IndexDef* index = t3.add_indexes();
+    index->set_name("index1");
+    index->add_first_keys("col1");
+    index->set_second_key("col5");
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, t1);
+    AddTable(db, t2);
+    AddTable(db, t3);
+    auto catalog = BuildSimpleCatalog(db);
+
+    std::vector<Row> left_rows;
+    std::vector<Row> right_rows;
+    for (int32_t col1 = 1; col1 <= 4; col1++) {
+        for (int16_t col2 = 1; col2 <= 3; col2++) {
+            left_rows.push_back(BuildJoinRow(t1, col1, col2, col1 * 10 + col2));
+            // keys of col1 = 4 or col2 = 3 are missing on the right
+            if (col1 == 4 || col2 == 3) {
+                continue;
+            }
+            // in no order of col5
+            for (int64_t col5 : {20, 50, 10, 40}) {
+                right_rows.push_back(BuildJoinRow(t2, col1, col2, col5 + col1));
+            }
+        }
+    }
+
+    std::vector<std::string> sqls = {
+        "select t1.col1, t2.col5 from t1 last join t2 order by t2.col5 on t1.col1 = t2.col1 and t1.col2 = t2.col2;",
+        "select t1.col1, t2.col5 from t1 last join t2 order by t2.col5 on t1.col1 = t2.col1 and t1.col2 = t2.col2 "
+        "and t2.col5 < 30;",
+        "select t1.col1, t2.col5 from t1 last join t2 on t1.col1 = t2.col1;",
+        "select t1.col1, t3.col5 from t1 last join t3 order by t3.col5 on t1.col1 = t3.col1 and t1.col2 = t3.col2;",
+    };
+    bool hash_last_join = FLAGS_enable_hash_last_join;
+    for (auto& sql : sqls) {
+        SqlCompiler sql_compiler(catalog);
+        SqlContext sql_context;
+        sql_context.sql = sql;
+        sql_context.db = "db";
+        sql_context.engine_mode = kBatchMode;
+        base::Status compile_status;
+        ASSERT_TRUE(sql_compiler.Compile(sql_context, compile_status)) << compile_status;
+        ASSERT_TRUE(sql_compiler.BuildClusterJob(sql_context, compile_status)) << compile_status;
+        auto join_runner = dynamic_cast<LastJoinRunner*>(
+            GetFirstRunnerOfType(sql_context.cluster_job.GetTask(0).GetRoot(), kRunnerLastJoin));
+        ASSERT_TRUE(join_runner != nullptr) << sql;
+        auto& join_gen = join_runner->join_gen_;
+        ASSERT_TRUE(join_gen.right_group_gen_.Valid()) << sql;
+
+        auto left = std::make_shared<MemTableHandler>();
+        for (auto& row : left_rows) {
+            left->AddRow(row);
+        }
+        std::shared_ptr<DataHandler> right;
+        if (join_gen.index_key_gen_.Valid()) {
+            // the right segments of the index
+            auto right_partition = std::make_shared<MemPartitionHandler>();
+            codec::RowView row_view(t2.columns());
+            for (auto& row : right_rows) {
+                row_view.Reset(row.buf(), row.size());
+                int32_t col1 = 0;
+                int64_t col5 = 0;
+                row_view.GetInt32(1, &col1);
+                row_view.GetInt64(5, &col5);
+                right_partition->AddRow(std::to_string(col1), col5, row);
+            }
+            right_partition->Sort(false);
+            right = right_partition;
+        } else {
+            auto right_table = std::make_shared<MemTableHandler>();
+            for (auto& row : right_rows) {
+                right_table->AddRow(row);
+            }
+            right = right_table;
+        }
+        Row parameter;
+        auto right_grouped = join_gen.right_group_gen_.Partition(right, parameter);
+        ASSERT_TRUE(right_grouped != nullptr) << sql;
+
+        std::vector<std::shared_ptr<MemTimeTableHandler>> outputs;
+        for (bool hash_join : {true, false}) {
+            FLAGS_enable_hash_last_join = hash_join;
+            auto output = std::make_shared<MemTimeTableHandler>();
+            ASSERT_TRUE(join_gen.TableJoin(left, right_grouped, parameter, output)) << sql;
+            outputs.push_back(output);
+        }
+        FLAGS_enable_hash_last_join = hash_last_join;
+
+        ASSERT_EQ(left_rows.size(), outputs[0]->GetCount()) << sql;
+        ASSERT_EQ(left_rows.size(), outputs[1]->GetCount()) << sql;
+        size_t joined_cnt = 0;
+        auto hash_iter = outputs[0]->GetIterator();
+        auto segment_iter = outputs[1]->GetIterator();
+        hash_iter->SeekToFirst();
+        segment_iter->SeekToFirst();
+        while (hash_iter->Valid() && segment_iter->Valid()) {
+            ASSERT_EQ(0, hash_iter->GetValue().compare(segment_iter->GetValue())) << sql;
+            if (hash_iter->GetValue().size(1) > 0) {
+                joined_cnt++;
+            }
+            hash_iter->Next();
+            segment_iter->Next();
+        }
+        // rows of missing keys are joined with a null right row
+        ASSERT_LT(0u, joined_cnt) << sql;
+        ASSERT_GT(left_rows.size(), joined_cnt) << sql;
+    }
+
+    // the right row of the largest col5, or the largest one matching the condition
+    for (auto& sql : {sqls[0], sqls[1]}) {
+        SqlCompiler sql_compiler(catalog);
+        SqlContext sql_context;
+        sql_context.sql = sql;
+        sql_context.db = "db";
+        sql_context.engine_mode = kBatchMode;
+        base::Status compile_status;
+        ASSERT_TRUE(sql_compiler.Compile(sql_context, compile_status)) << compile_status;
+        ASSERT_TRUE(sql_compiler.BuildClusterJob(sql_context, compile_status)) << compile_status;
+        auto join_runner = dynamic_cast<LastJoinRunner*>(
+            GetFirstRunnerOfType(sql_context.cluster_job.GetTask(0).GetRoot(), kRunnerLastJoin));
+        ASSERT_TRUE(join_runner != nullptr);
+        auto& join_gen = join_runner->join_gen_;
+        auto left = std::make_shared<MemTableHandler>();
+        left->AddRow(left_rows[0]);
+        auto right = std::make_shared<MemTableHandler>();
+        for (auto& row : right_rows) {
+            right->AddRow(row);
+        }
+        Row parameter;
+        auto right_grouped =
+            join_gen.right_group_gen_.Partition(std::static_pointer_cast<DataHandler>(right), parameter);
+        ASSERT_TRUE(right_grouped != nullptr);
+        auto output = std::make_shared<MemTimeTableHandler>();
+        ASSERT_TRUE(join_gen.TableJoin(left, right_grouped, parameter, output));
+        auto iter = output->GetIterator();
+        iter->SeekToFirst();
+        ASSERT_TRUE(iter->Valid());
+        codec::RowView row_view(t2.columns());
+        row_view.Reset(iter->GetValue().buf(1), iter->GetValue().size(1));
+        int64_t col5 = 0;
+        ASSERT_EQ(0, row_view.GetInt64(5, &col5));
+        ASSERT_EQ(sql == sqls[0] ? 51 : 21, col5);
+    }
+}
 }  // namespace vm
 }  // namespace hybridse
 
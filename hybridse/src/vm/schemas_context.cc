@@ -807,6 +807,27 @@ int32_t RowParser::GetString(const Row& row, const node::ColumnRefNode& col, std
     return 0;
 }
 
+bool RowParser::GetColumnIndex(const std::string& col, size_t* schema_idx, size_t* col_idx) const {
+    return schema_ctx_->ResolveColumnIndexByName("", "", col, schema_idx, col_idx).isOK();
+}
+
+bool RowParser::IsNull(const Row& row, size_t schema_idx, size_t col_idx) const {
+    return row_view_list_[schema_idx].IsNULL(row.buf(schema_idx), col_idx);
+}
+
+int32_t RowParser::GetValue(const Row& row, size_t schema_idx, size_t col_idx, ::hybridse::type::Type type,
+                            void* val) const {
+    return row_view_list_[schema_idx].GetValue(row.buf(schema_idx), col_idx, type, val);
+}
+
+int32_t RowParser::GetString(const Row& row, size_t schema_idx, size_t col_idx, std::string* val) const {
+    const char* ch = nullptr;
+    uint32_t str_size;
+    row_view_list_[schema_idx].GetValue(row.buf(schema_idx), col_idx, &ch, &str_size);
+    val->assign(ch, str_size);
+    return 0;
+}
+
 type::Type RowParser::GetType(const std::string& col) const {
     size_t schema_idx, col_idx;
     schema_ctx_->ResolveColumnIndexByName("", "", col, &schema_idx, &col_idx);
@@ -294,6 +294,46 @@ TEST_F(SchemasContextTest, DifferentDBNameAndSameTableName) {
     ASSERT_TRUE(status.isOK()) << status;
     ASSERT_EQ(8u, column_id);
 }
+
+TEST_F(SchemasContextTest, RowParserColumnIndexTest) {
+    type::TableDef t1;
+    BuildTableDef(t1);
+    vm::SchemasContext schemas_context;
+    auto source = schemas_context.AddSource();
+    source->SetSourceDBAndTableName(t1.catalog(), t1.name());
+    source->SetSchema(&t1.columns());
+    for (int i = 0; i < t1.columns_size(); ++i) {
+        source->SetColumnID(i, i);
+    }
+    schemas_context.Build();
+
+    int8_t* buf = nullptr;
+    uint32_t size = 0;
+    BuildBuf(&buf, &size);
+    codec::Row row(base::RefCountedSlice::CreateManaged(buf, size));
+    RowParser parser(&schemas_context);
+
+    // the accessors by resolved index read the same values as the ones by name
+    size_t schema_idx = 0;
+    size_t col_idx = 0;
+    ASSERT_TRUE(parser.GetColumnIndex("col5", &schema_idx, &col_idx));
+    ASSERT_EQ(0u, schema_idx);
+    ASSERT_EQ(5u, col_idx);
+    ASSERT_FALSE(parser.IsNull(row, schema_idx, col_idx));
+    int64_t by_idx = 0;
+    int64_t by_name = 0;
+    ASSERT_EQ(0, parser.GetValue(row, schema_idx, col_idx, type::kInt64, &by_idx));
+    ASSERT_EQ(0, parser.GetValue(row, "col5", type::kInt64, &by_name));
+    ASSERT_EQ(64, by_idx);
+    ASSERT_EQ(by_name, by_idx);
+
+    ASSERT_TRUE(parser.GetColumnIndex("col6", &schema_idx, &col_idx));
+    std::string str;
+    ASSERT_EQ(0, parser.GetString(row, schema_idx, col_idx, &str));
+    ASSERT_EQ("1", str);
+
+    ASSERT_FALSE(parser.GetColumnIndex("not_exist", &schema_idx, &col_idx));
+}
 }  // namespace vm
 }  // namespace hybridse
 
@@ -24,16 +24,21 @@
 #include "codec/type_codec.h"
 #include "codegen/block_ir_builder.h"
 #include "codegen/fn_ir_builder.h"
+#include "codegen/fn_let_ir_builder.h"
 #include "codegen/ir_base_builder.h"
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/raw_ostream.h"
 #include "plan/plan_api.h"
 #include "udf/default_udf_library.h"
+#include "vm/jit.h"
 #include "vm/runner.h"
 #include "vm/transform.h"
 #include "vm/engine.h"
 
+DECLARE_bool(enable_batch_project);
+
 using ::hybridse::base::Status;
 using hybridse::common::kPlanError;
 
@@ -115,17 +120,37 @@ bool SqlCompiler::Compile(SqlContext& ctx, Status& status) {  // NOLINT
         return false;
     }
     // ::llvm::errs() << *(m.get());
+    // the shared session has registered the symbols of the default library
+    bool use_session = ctx.jit_session != nullptr &&
+                       !ctx.jit_options.IsEnableMcjit() &&
+                       !ctx.jit_options.IsEnableAggressiveOpt() &&
+                       ctx.udf_library == udf::DefaultUdfLibrary::get();
     auto jit = std::shared_ptr<HybridSeJitWrapper>(
-        HybridSeJitWrapper::Create(ctx.jit_options));
+        use_session ? HybridSeJitWrapper::Create(ctx.jit_session)
+                    : HybridSeJitWrapper::Create(ctx.jit_options));
     if (jit == nullptr || !jit->Init()) {
         status.msg = "fail to init jit let";
         status.code = common::kJitError;
         LOG(WARNING) << status;
         return false;
     }
-    InitBuiltinJitSymbols(jit.get());
-    ctx.udf_library->InitJITSymbols(jit.get());
-    if (!jit->OptModule(m.get())) {
+    if (!use_session) {
+        InitBuiltinJitSymbols(jit.get());
+        ctx.udf_library->InitJITSymbols(jit.get());
+    }
+    bool object_cached = false;
+    auto object_cache = HybridSeObjectCache::Get();
+    if (ctx.enable_object_cache && object_cache != nullptr &&
+        !ctx.jit_options.IsEnableMcjit()) {
+        std::string key = HybridSeObjectCache::GetModuleKey(
+            *m, ctx.jit_options.IsEnableAggressiveOpt());
+        m->setModuleIdentifier(key);
+        object_cached = object_cache->Contains(key);
+    }
+    if (object_cached) {
+        // the cached object is already optimized
+        HybridSeObjectCache::MarkUnoptimized(m.get());
+    } else if (!jit->OptModule(m.get())) {
         LOG(WARNING) << "fail to opt ir module for sql " << ctx.sql;
         return false;
     }
@@ -397,6 +422,8 @@ bool SqlCompiler::ResolvePlanFnAddress(vm::PhysicalOpNode* node,
         default: {
         }
     }
+    bool batch_entry = FLAGS_enable_batch_project && kPhysicalOpProject == node->GetOpType() &&
+                       dynamic_cast<PhysicalProjectNode*>(node)->HasBatchEntry();
     if (!node->GetFnInfos().empty()) {
         for (auto info_ptr : node->GetFnInfos()) {
             if (!info_ptr->fn_name().empty()) {
@@ -409,6 +436,11 @@ bool SqlCompiler::ResolvePlanFnAddress(vm::PhysicalOpNode* node,
                                  << *node;
                 }
                 const_cast<FnInfo*>(info_ptr)->SetFnPtr(addr);
+                if (batch_entry) {
+                    auto batch_addr =
+                        jit->FindFunction(codegen::RowFnLetIRBuilder::GetBatchFnName(info_ptr->fn_name()));
+                    const_cast<FnInfo*>(info_ptr)->SetBatchFnPtr(batch_addr);
+                }
             }
         }
     }
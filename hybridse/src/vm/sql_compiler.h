@@ -58,6 +58,10 @@ struct SqlContext {
     // eg using bthead to compile ir
     hybridse::vm::JitOptions jit_options;
     std::shared_ptr<hybridse::vm::HybridSeJitWrapper> jit = nullptr;
+    // if set, compile into a new dylib of the shared jit session
+    std::shared_ptr<hybridse::vm::HybridSeJitSession> jit_session = nullptr;
+    // if set, reuse the object code cached on disk for an unchanged module
+    bool enable_object_cache = false;
     Schema schema;
     Schema request_schema;
     std::string request_db_name;
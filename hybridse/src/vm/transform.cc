@@ -21,6 +21,7 @@
 #include "codegen/context.h"
 #include "codegen/fn_ir_builder.h"
 #include "codegen/fn_let_ir_builder.h"
+#include "gflags/gflags.h"
 #include "passes/physical/transform_up_physical_pass.h"
 #include "vm/physical_op.h"
 #include "vm/schemas_context.h"
@@ -38,6 +39,8 @@
 #include "passes/physical/split_aggregation_optimized.h"
 #include "passes/physical/window_column_pruning.h"
 
+DECLARE_bool(enable_batch_project);
+
 namespace hybridse {
 namespace vm {
 
@@ -297,6 +300,8 @@ Status BatchModeTransformer::InitFnInfo(PhysicalOpNode* node,
     }
 
     // instantiate llvm functions for current node
+    bool batch_entry = FLAGS_enable_batch_project && kPhysicalOpProject == node->GetOpType() &&
+                       dynamic_cast<PhysicalProjectNode*>(node)->HasBatchEntry();
     const auto& fn_infos = node->GetFnInfos();
     for (size_t i = 0; i < fn_infos.size(); ++i) {
         const FnInfo* fn_info = fn_infos[i];
@@ -304,7 +309,7 @@ Status BatchModeTransformer::InitFnInfo(PhysicalOpNode* node,
         if (fn_info->fn_name().empty()) {
             continue;
         }
-        CHECK_STATUS(InstantiateLLVMFunction(*fn_infos[i]), "Instantiate ", i,
+        CHECK_STATUS(InstantiateLLVMFunction(*fn_infos[i], batch_entry), "Instantiate ", i,
                      "th native function \"", fn_info->fn_name(),
                      "\" failed at node:\n", node->GetTreeString());
     }
@@ -937,12 +942,16 @@ Status ExtractProjectInfos(const node::PlanNodeList& projects,
     return Status::OK();
 }
 
-Status BatchModeTransformer::InstantiateLLVMFunction(const FnInfo& fn_info) {
+Status BatchModeTransformer::InstantiateLLVMFunction(const FnInfo& fn_info, bool batch_entry) {
     CHECK_TRUE(fn_info.IsValid(), kCodegenError, "Fail to install llvm function, function info is invalid");
     codegen::CodeGenContext codegen_ctx(module_, fn_info.schemas_ctx(), plan_ctx_.parameter_types(), node_manager_);
     codegen::RowFnLetIRBuilder builder(&codegen_ctx);
-    return builder.Build(fn_info.fn_name(), fn_info.fn_def(), fn_info.GetPrimaryFrame(), fn_info.GetFrames(),
-                         *fn_info.fn_schema());
+    CHECK_STATUS(builder.Build(fn_info.fn_name(), fn_info.fn_def(), fn_info.GetPrimaryFrame(), fn_info.GetFrames(),
+                               *fn_info.fn_schema()));
+    if (batch_entry) {
+        CHECK_STATUS(builder.BuildBatch(fn_info.fn_name()));
+    }
+    return Status::OK();
 }
 
 bool BatchModeTransformer::AddDefaultPasses() {
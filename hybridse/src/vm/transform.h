@@ -215,9 +215,10 @@ class BatchModeTransformer {
     Status GenFnDef(const node::FuncDefPlanNode* fn_plan);
 
     /**
-     * Instantiate underlying llvm function with specified fn info.
+     * Instantiate underlying llvm function with specified fn info,
+     * and its batch entry if `batch_entry` is true.
      */
-    Status InstantiateLLVMFunction(const FnInfo& fn_info);
+    Status InstantiateLLVMFunction(const FnInfo& fn_info, bool batch_entry = false);
 
     Status GenWindowJoinList(PhysicalWindowAggrerationNode* window_agg_op,
                              PhysicalOpNode* in);
@@ -19,6 +19,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "apiserver/interface_provider.h"
 #include "brpc/server.h"
@@ -64,6 +65,8 @@ void APIServerImpl::Refresh(google::protobuf::RpcController* cntl_base, const Ht
     if (sql_router_) {
         sql_router_->RefreshCatalog();
     }
+    std::lock_guard<std::mutex> lock(procedure_input_mu_);
+    procedure_inputs_.clear();
 }
 
 void APIServerImpl::Process(google::protobuf::RpcController* cntl_base, const HttpRequest*, HttpResponse*,
@@ -78,48 +81,39 @@ void APIServerImpl::Process(google::protobuf::RpcController* cntl_base, const Ht
     const butil::IOBuf& req_body = cntl->request_attachment();
 
     JsonWriter writer;
-    provider_.handle(unresolved_path, method, req_body, writer);
+    if (cntl->http_request().content_type() == kNativeRowContentType) {
+        butil::IOBuf rows;
+        if (provider_.handle_row(unresolved_path, method, req_body, &rows, writer)) {
+            cntl->http_response().set_content_type(kNativeRowContentType);
+            cntl->response_attachment().swap(rows);
+            return;
+        }
+        cntl->http_response().set_content_type("application/json");
+    } else {
+        provider_.handle(unresolved_path, method, req_body, writer);
+    }
 
     cntl->response_attachment().append(writer.GetString());
 }
 
 bool APIServerImpl::Json2SQLRequestRow(const butil::rapidjson::Value& non_common_cols_v,
-                                       const butil::rapidjson::Value& common_cols_v,
+                                       const butil::rapidjson::Value& common_cols_v, const ProcedureInput& input,
                                        std::shared_ptr<openmldb::sdk::SQLRequestRow> row) {
-    auto sch = row->GetSchema();
-
     // scan all strings to init the total string length
     decltype(common_cols_v.Size()) str_len_sum = 0;
-    decltype(common_cols_v.Size()) non_common_idx = 0, common_idx = 0;
-    for (decltype(sch->GetColumnCnt()) i = 0; i < sch->GetColumnCnt(); ++i) {
+    for (const auto& col : input.columns) {
         // if element is null, GetStringLength() will get 0
-        if (sch->IsConstant(i)) {
-            if (sch->GetColumnType(i) == hybridse::sdk::kTypeString) {
-                str_len_sum += common_cols_v[common_idx].GetStringLength();
-            }
-            ++common_idx;
-        } else {
-            if (sch->GetColumnType(i) == hybridse::sdk::kTypeString) {
-                str_len_sum += non_common_cols_v[non_common_idx].GetStringLength();
-            }
-            ++non_common_idx;
+        if (col.type == hybridse::sdk::kTypeString) {
+            str_len_sum += col.is_common ? common_cols_v[col.pos].GetStringLength()
+                                         : non_common_cols_v[col.pos].GetStringLength();
         }
     }
     row->Init(static_cast<int32_t>(str_len_sum));
 
-    non_common_idx = 0, common_idx = 0;
-    for (decltype(sch->GetColumnCnt()) i = 0; i < sch->GetColumnCnt(); ++i) {
-        if (sch->IsConstant(i)) {
-            if (!AppendJsonValue(common_cols_v[common_idx], sch->GetColumnType(i), sch->IsColumnNotNull(i), row)) {
-                return false;
-            }
-            ++common_idx;
-        } else {
-            if (!AppendJsonValue(non_common_cols_v[non_common_idx], sch->GetColumnType(i), sch->IsColumnNotNull(i),
-                                 row)) {
-                return false;
-            }
-            ++non_common_idx;
+    for (const auto& col : input.columns) {
+        const auto& v = col.is_common ? common_cols_v[col.pos] : non_common_cols_v[col.pos];
+        if (!AppendJsonValue(v, col.type, col.is_not_null, row)) {
+            return false;
         }
     }
     return true;
@@ -281,11 +275,17 @@ void APIServerImpl::RegisterPut() {
 void APIServerImpl::RegisterExecDeployment() {
     provider_.post("/dbs/:db_name/deployments/:sp_name", std::bind(&APIServerImpl::ExecuteProcedure, this,
                 false, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    provider_.post_row("/dbs/:db_name/deployments/:sp_name",
+                       std::bind(&APIServerImpl::ExecuteProcedureRows, this, false, std::placeholders::_1,
+                                 std::placeholders::_2, std::placeholders::_3, std::placeholders::_4));
 }
 
 void APIServerImpl::RegisterExecSP() {
     provider_.post("/dbs/:db_name/procedures/:sp_name", std::bind(&APIServerImpl::ExecuteProcedure, this,
                 true, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    provider_.post_row("/dbs/:db_name/procedures/:sp_name",
+                       std::bind(&APIServerImpl::ExecuteProcedureRows, this, true, std::placeholders::_1,
+                                 std::placeholders::_2, std::placeholders::_3, std::placeholders::_4));
 }
 
 void APIServerImpl::ExecuteProcedure(bool has_common_col, const InterfaceProvider::Params& param,
@@ -322,53 +322,36 @@ void APIServerImpl::ExecuteProcedure(bool has_common_col, const InterfaceProvide
         common_cols_v.SetArray();
     }
 
-    auto input = document.FindMember("input");
-    if (input == document.MemberEnd() || !input->value.IsArray() || input->value.Empty()) {
+    auto input_it = document.FindMember("input");
+    if (input_it == document.MemberEnd() || !input_it->value.IsArray() || input_it->value.Empty()) {
         writer << err.Set("Invalid input");
         return;
     }
-    const auto& rows = input->value;
+    const auto& rows = input_it->value;
 
     hybridse::sdk::Status status;
-    // We need to use ShowProcedure to get input schema(should know which column is constant).
-    // GetRequestRowByProcedure can't do that.
-    auto sp_info = sql_router_->ShowProcedure(db, sp, &status);
-    if (!sp_info) {
+    auto input = GetProcedureInput(db, sp, has_common_col, &status);
+    if (!input) {
         writer << err.Set(status.msg);
         return;
     }
-
-    const auto& schema_impl = dynamic_cast<const ::hybridse::sdk::SchemaImpl&>(sp_info->GetInputSchema());
-    // Hard copy, and RequestRow needs shared schema
-    auto input_schema = std::make_shared<::hybridse::sdk::SchemaImpl>(schema_impl.GetSchema());
-    auto common_column_indices = std::make_shared<openmldb::sdk::ColumnIndicesSet>(input_schema);
-    decltype(common_cols_v.Size()) expected_common_size = 0;
-    if (has_common_col) {
-        for (int i = 0; i < input_schema->GetColumnCnt(); ++i) {
-            if (input_schema->IsConstant(i)) {
-                common_column_indices->AddCommonColumnIdx(i);
-                ++expected_common_size;
-            }
-        }
-        if (common_cols_v.Size() != expected_common_size) {
-            writer << err.Set("Invalid common cols size");
-            return;
-        }
+    if (has_common_col && common_cols_v.Size() != input->common_cnt) {
+        writer << err.Set("Invalid common cols size");
+        return;
     }
-    auto expected_input_size = input_schema->GetColumnCnt() - expected_common_size;
 
     // TODO(hw): SQLRequestRowBatch should add common & non-common cols directly
-    auto row_batch = std::make_shared<sdk::SQLRequestRowBatch>(input_schema, common_column_indices);
+    auto row_batch = std::make_shared<sdk::SQLRequestRowBatch>(input->schema, input->common_column_indices);
     std::set<std::string> col_set;
     for (decltype(rows.Size()) i = 0; i < rows.Size(); ++i) {
-        if (!rows[i].IsArray() || rows[i].Size() != expected_input_size) {
+        if (!rows[i].IsArray() || rows[i].Size() != input->non_common_cnt) {
             writer << err.Set("Invalid input data row");
             return;
         }
-        auto row = std::make_shared<sdk::SQLRequestRow>(input_schema, col_set);
+        auto row = std::make_shared<sdk::SQLRequestRow>(input->schema, col_set);
 
         // sizes have been checked
-        if (!Json2SQLRequestRow(rows[i], common_cols_v, row)) {
+        if (!Json2SQLRequestRow(rows[i], common_cols_v, *input, row)) {
             writer << err.Set("Translate to request row failed");
             return;
         }
@@ -385,7 +368,7 @@ void APIServerImpl::ExecuteProcedure(bool has_common_col, const InterfaceProvide
     ExecSPResp resp;
     // output schema in sp_info is needed for encoding data, so we need a bool in ExecSPResp to know whether to
     // print schema
-    resp.sp_info = sp_info;
+    resp.sp_info = input->sp_info;
     if (document.HasMember("need_schema") && document["need_schema"].IsBool() &&
         document["need_schema"].GetBool()) {
         resp.need_schema = true;
@@ -394,6 +377,194 @@ void APIServerImpl::ExecuteProcedure(bool has_common_col, const InterfaceProvide
     writer << resp;
 }
 
+bool APIServerImpl::ExecuteProcedureRows(bool has_common_col, const InterfaceProvider::Params& param,
+                                         const butil::IOBuf& req_body, butil::IOBuf* resp_body, JsonWriter& writer) {
+    auto err = GeneralError();
+    auto db_it = param.find("db_name");
+    auto sp_it = param.find("sp_name");
+    if (db_it == param.end() || sp_it == param.end()) {
+        writer << err.Set("Invalid path");
+        return false;
+    }
+    const auto& db = db_it->second;
+    const auto& sp = sp_it->second;
+
+    hybridse::sdk::Status status;
+    auto input = GetProcedureInput(db, sp, has_common_col, &status);
+    if (!input) {
+        writer << err.Set(status.msg);
+        return false;
+    }
+
+    // the rows are encoded back to back, each one starts with its version and size
+    auto row_batch = std::make_shared<sdk::SQLRequestRowBatch>(input->schema, input->common_column_indices);
+    const std::string body = req_body.to_string();
+    ::hybridse::codec::RowView row_view(input->schema->GetSchema());
+    size_t pos = 0;
+    while (pos < body.size()) {
+        if (body.size() - pos < ::hybridse::codec::HEADER_LENGTH) {
+            writer << err.Set("Invalid input data row");
+            return false;
+        }
+        auto buf = reinterpret_cast<const int8_t*>(body.data() + pos);
+        uint32_t size = ::hybridse::codec::RowView::GetSize(buf);
+        if (size < ::hybridse::codec::HEADER_LENGTH || size > body.size() - pos || !row_view.Reset(buf, size) ||
+            !row_batch->AddRow(buf, size)) {
+            writer << err.Set("Invalid input data row");
+            return false;
+        }
+        pos += size;
+    }
+    if (row_batch->Size() == 0) {
+        writer << err.Set("Invalid input");
+        return false;
+    }
+
+    auto rs = sql_router_->CallSQLBatchRequestProcedure(db, sp, row_batch, &status);
+    if (!rs) {
+        writer << err.Set(status.msg);
+        return false;
+    }
+    std::string row;
+    while (rs->Next()) {
+        if (!EncodeResultRow(rs.get(), input->output_schema, &row)) {
+            writer << err.Set("Encode output row failed");
+            return false;
+        }
+        resp_body->append(row);
+    }
+    return true;
+}
+
+bool APIServerImpl::EncodeResultRow(::hybridse::sdk::ResultSet* rs, const ::hybridse::codec::Schema& schema,
+                                    std::string* buf) {
+    uint32_t str_len_sum = 0;
+    std::vector<std::string> strs(schema.size());
+    for (int i = 0; i < schema.size(); i++) {
+        if (schema.Get(i).type() == ::hybridse::type::kVarchar && !rs->IsNULL(i)) {
+            if (!rs->GetString(i, &strs[i])) {
+                return false;
+            }
+            str_len_sum += strs[i].size();
+        }
+    }
+    ::hybridse::codec::RowBuilder builder(schema);
+    buf->assign(builder.CalTotalLength(str_len_sum), '\0');
+    if (!builder.SetBuffer(reinterpret_cast<int8_t*>(&(*buf)[0]), buf->size())) {
+        return false;
+    }
+    for (int i = 0; i < schema.size(); i++) {
+        if (rs->IsNULL(i)) {
+            if (!builder.AppendNULL()) {
+                return false;
+            }
+            continue;
+        }
+        bool ok = false;
+        switch (schema.Get(i).type()) {
+            case ::hybridse::type::kBool: {
+                bool v = false;
+                ok = rs->GetBool(i, &v) && builder.AppendBool(v);
+                break;
+            }
+            case ::hybridse::type::kInt16: {
+                int16_t v = 0;
+                ok = rs->GetInt16(i, &v) && builder.AppendInt16(v);
+                break;
+            }
+            case ::hybridse::type::kInt32: {
+                int32_t v = 0;
+                ok = rs->GetInt32(i, &v) && builder.AppendInt32(v);
+                break;
+            }
+            case ::hybridse::type::kInt64: {
+                int64_t v = 0;
+                ok = rs->GetInt64(i, &v) && builder.AppendInt64(v);
+                break;
+            }
+            case ::hybridse::type::kFloat: {
+                float v = 0;
+                ok = rs->GetFloat(i, &v) && builder.AppendFloat(v);
+                break;
+            }
+            case ::hybridse::type::kDouble: {
+                double v = 0;
+                ok = rs->GetDouble(i, &v) && builder.AppendDouble(v);
+                break;
+            }
+            case ::hybridse::type::kVarchar: {
+                ok = builder.AppendString(strs[i].data(), strs[i].size());
+                break;
+            }
+            case ::hybridse::type::kDate: {
+                int32_t v = 0;
+                ok = rs->GetDate(i, &v) && builder.AppendDate(v);
+                break;
+            }
+            case ::hybridse::type::kTimestamp: {
+                int64_t v = 0;
+                ok = rs->GetTime(i, &v) && builder.AppendTimestamp(v);
+                break;
+            }
+            default:
+                break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<APIServerImpl::ProcedureInput> APIServerImpl::GetProcedureInput(const std::string& db,
+                                                                                const std::string& sp,
+                                                                                bool has_common_col,
+                                                                                hybridse::sdk::Status* status) {
+    std::string key = db + "." + sp + (has_common_col ? ".1" : ".0");
+    // read the version before the catalog, a layout built on a newer catalog is only rebuilt once more
+    uint64_t version = cluster_sdk_->GetClusterVersion();
+    {
+        std::lock_guard<std::mutex> lock(procedure_input_mu_);
+        auto it = procedure_inputs_.find(key);
+        // every catalog update bumps the version, the procedure may have been recreated since
+        if (it != procedure_inputs_.end() && it->second->version == version) {
+            return it->second;
+        }
+    }
+
+    // We need to use ShowProcedure to get input schema(should know which column is constant).
+    // GetRequestRowByProcedure can't do that.
+    auto sp_info = sql_router_->ShowProcedure(db, sp, status);
+    if (!sp_info) {
+        return {};
+    }
+    auto input = std::make_shared<ProcedureInput>();
+    input->version = version;
+    input->sp_info = sp_info;
+    input->output_schema =
+        dynamic_cast<const ::hybridse::sdk::SchemaImpl&>(sp_info->GetOutputSchema()).GetSchema();
+    const auto& schema_impl = dynamic_cast<const ::hybridse::sdk::SchemaImpl&>(sp_info->GetInputSchema());
+    // Hard copy, and RequestRow needs shared schema
+    input->schema = std::make_shared<::hybridse::sdk::SchemaImpl>(schema_impl.GetSchema());
+    input->common_column_indices = std::make_shared<openmldb::sdk::ColumnIndicesSet>(input->schema);
+    for (int i = 0; i < input->schema->GetColumnCnt(); ++i) {
+        ProcedureInput::Column col;
+        col.type = input->schema->GetColumnType(i);
+        col.is_not_null = input->schema->IsColumnNotNull(i);
+        col.is_common = has_common_col && input->schema->IsConstant(i);
+        if (col.is_common) {
+            input->common_column_indices->AddCommonColumnIdx(i);
+            col.pos = input->common_cnt++;
+        } else {
+            col.pos = input->non_common_cnt++;
+        }
+        input->columns.push_back(col);
+    }
+    std::lock_guard<std::mutex> lock(procedure_input_mu_);
+    procedure_inputs_[key] = input;
+    return input;
+}
+
 void APIServerImpl::RegisterGetSP() {
     provider_.get("/dbs/:db_name/procedures/:sp_name",
                   [this](const InterfaceProvider::Params& param, const butil::IOBuf& req_body, JsonWriter& writer) {
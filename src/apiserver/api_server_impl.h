@@ -18,13 +18,16 @@
 #define SRC_APISERVER_API_SERVER_IMPL_H_
 
 #include <algorithm>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "apiserver/interface_provider.h"
 #include "apiserver/json_helper.h"
+#include "codec/fe_row_codec.h"
 #include "json2pb/rapidjson.h"  // rapidjson's DOM-style API
 #include "proto/api_server.pb.h"
 #include "sdk/sql_cluster_router.h"
@@ -36,11 +39,16 @@ using butil::rapidjson::Document;
 using butil::rapidjson::StringBuffer;
 using butil::rapidjson::Writer;
 
+// The content type of deployment requests and responses in the native row format. The body is the rows encoded
+// back to back, the input schema for requests and the output schema for responses. Errors are still returned in json.
+inline constexpr char kNativeRowContentType[] = "application/x-openmldb-row";
+
 // APIServer is a service for brpc::Server. The entire implement is `StartAPIServer()` in src/cmd/openmldb.cc
 // Every request is handled by `Process()`, we will choose the right method of the request by `InterfaceProvider`.
 // InterfaceProvider's url parser supports to parse urls like "/a/:arg1/b/:arg2/:arg3", but doesn't support wildcards.
 // Methods should be registered in `InterfaceProvider` in the init phase.
-// Both input and output are json data. We use rapidjson to handle it.
+// Both input and output are json data. We use rapidjson to handle it. Procedures and deployments are also served in
+// the native row format when the request has the content type `kNativeRowContentType`.
 class APIServerImpl : public APIServer {
  public:
     APIServerImpl() = default;
@@ -63,12 +71,41 @@ class APIServerImpl : public APIServer {
     void RegisterGetDB();
     void RegisterGetTable();
 
+    // The input layout of a procedure, built once and reused by all calls until the procedure changes
+    struct ProcedureInput {
+        struct Column {
+            hybridse::sdk::DataType type;
+            bool is_not_null;
+            bool is_common;
+            // the position in the json array of common or non-common columns
+            uint32_t pos;
+        };
+        // the catalog version the layout is built on
+        uint64_t version = 0;
+        std::shared_ptr<hybridse::sdk::ProcedureInfo> sp_info;
+        std::shared_ptr<::hybridse::sdk::SchemaImpl> schema;
+        std::shared_ptr<openmldb::sdk::ColumnIndicesSet> common_column_indices;
+        std::vector<Column> columns;
+        ::hybridse::codec::Schema output_schema;
+        uint32_t common_cnt = 0;
+        uint32_t non_common_cnt = 0;
+    };
+
     void ExecuteProcedure(bool has_common_col, const InterfaceProvider::Params& param,
             const butil::IOBuf& req_body, JsonWriter& writer); // NOLINT
+    bool ExecuteProcedureRows(bool has_common_col, const InterfaceProvider::Params& param,
+                              const butil::IOBuf& req_body, butil::IOBuf* resp_body, JsonWriter& writer);  // NOLINT
+
+    // get the cached input layout of the procedure, rebuild it after the catalog has been changed
+    std::shared_ptr<ProcedureInput> GetProcedureInput(const std::string& db, const std::string& sp,
+                                                      bool has_common_col, hybridse::sdk::Status* status);
 
     static bool Json2SQLRequestRow(const butil::rapidjson::Value& non_common_cols_v,
-                                   const butil::rapidjson::Value& common_cols_v,
+                                   const butil::rapidjson::Value& common_cols_v, const ProcedureInput& input,
                                    std::shared_ptr<openmldb::sdk::SQLRequestRow> row);
+    // encode the current row of `rs` in the native row format
+    static bool EncodeResultRow(::hybridse::sdk::ResultSet* rs, const ::hybridse::codec::Schema& schema,
+                                std::string* buf);
     template <typename T>
     static bool AppendJsonValue(const butil::rapidjson::Value& v, hybridse::sdk::DataType type, bool is_not_null,
                                 T row);
@@ -78,6 +115,9 @@ class APIServerImpl : public APIServer {
     InterfaceProvider provider_;
     // cluster_sdk_ is not owned by this class.
     ::openmldb::sdk::DBSDK* cluster_sdk_ = nullptr;
+    std::mutex procedure_input_mu_;
+    // key is {db}.{sp}.{has_common_col}
+    std::map<std::string, std::shared_ptr<ProcedureInput>> procedure_inputs_;
 };
 
 struct PutResp {
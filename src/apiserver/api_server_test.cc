@@ -654,6 +654,150 @@ TEST_F(APIServerTest, no_common_not_first_string) {
     ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, "drop table trans1;", &status));
 }
 
+TEST_F(APIServerTest, redeploy) {
+    const auto env = APIServerTestEnv::Instance();
+    hybridse::sdk::Status status;
+    std::string sp_name = "sp2";
+    auto call = [&env, &sp_name](const std::string& body, butil::rapidjson::Document* document) {
+        brpc::Controller cntl;
+        cntl.http_request().set_method(brpc::HTTP_METHOD_POST);
+        cntl.http_request().uri() = "http://127.0.0.1:8010/dbs/" + env->db + "/deployments/" + sp_name;
+        cntl.request_attachment().append(body);
+        env->http_channel.CallMethod(NULL, &cntl, NULL, NULL, NULL);
+        ASSERT_FALSE(cntl.Failed()) << cntl.ErrorText();
+        LOG(INFO) << "exec procedure resp:\n" << cntl.response_attachment().to_string();
+        ASSERT_FALSE(document->Parse(cntl.response_attachment().to_string().c_str()).HasParseError());
+    };
+
+    // the cached input of the first deployment must not be used by the second one with the same name
+    std::vector<std::string> ddls = {"create table trans2(c1 string, c3 int, c7 timestamp, index(key=c1, ts=c7));",
+                                     "create table trans2(c1 string, c3 int, c4 bigint, c7 timestamp, "
+                                     "index(key=c1, ts=c7));"};
+    std::vector<std::string> sp_ddls = {
+        "create procedure " + sp_name +
+            " (c1 string, c3 int, c7 timestamp) begin SELECT c1, sum(c3) OVER w1 as w1_c3_sum FROM trans2 "
+            "WINDOW w1 AS (PARTITION BY trans2.c1 ORDER BY trans2.c7 ROWS BETWEEN 2 PRECEDING AND CURRENT ROW); end;",
+        "create procedure " + sp_name +
+            " (c1 string, c3 int, c4 bigint, c7 timestamp) begin SELECT c1, sum(c4) OVER w1 as w1_c4_sum FROM trans2 "
+            "WINDOW w1 AS (PARTITION BY trans2.c1 ORDER BY trans2.c7 ROWS BETWEEN 2 PRECEDING AND CURRENT ROW); end;"};
+    std::vector<std::string> bodies = {R"({"input": [["bb", 23, 1590738994000]]})",
+                                       R"({"input": [["bb", 23, 123, 1590738994000]]})"};
+    env->cluster_remote->ExecuteDDL(env->db, "drop table trans2;", &status);
+    for (size_t i = 0; i < ddls.size(); i++) {
+        ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, ddls[i], &status)) << "fail to create table";
+        ASSERT_TRUE(env->cluster_sdk->Refresh());
+        ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, sp_ddls[i], &status)) << "fail to create procedure";
+        ASSERT_TRUE(env->cluster_sdk->Refresh());
+
+        butil::rapidjson::Document document;
+        // call twice, the second call uses the cached input
+        for (int j = 0; j < 2; j++) {
+            call(bodies[i], &document);
+            ASSERT_EQ(0, document["code"].GetInt()) << document["msg"].GetString();
+            ASSERT_EQ(1, document["data"]["data"].Size());
+        }
+        // the input of the other deployment is rejected
+        call(bodies[1 - i], &document);
+        ASSERT_EQ(-1, document["code"].GetInt());
+
+        ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, "drop procedure " + sp_name + ";", &status));
+        ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, "drop table trans2;", &status));
+        ASSERT_TRUE(env->cluster_sdk->Refresh());
+    }
+}
+
+TEST_F(APIServerTest, native_row_format) {
+    const auto env = APIServerTestEnv::Instance();
+    hybridse::sdk::Status status;
+    env->cluster_remote->ExecuteDDL(env->db, "drop table trans3;", &status);
+    ASSERT_TRUE(env->cluster_remote->ExecuteDDL(
+        env->db, "create table trans3(c1 string, c3 int, c4 bigint, c7 timestamp, index(key=c1, ts=c7));", &status))
+        << "fail to create table";
+    ASSERT_TRUE(env->cluster_sdk->Refresh());
+    ASSERT_TRUE(env->cluster_remote->ExecuteInsert(env->db, "insert into trans3 values(\"bb\",24,34,1590738994000);",
+                                                   &status));
+    std::string sp_name = "sp3";
+    ASSERT_TRUE(env->cluster_remote->ExecuteDDL(
+        env->db,
+        "create procedure " + sp_name +
+            " (c1 string, c3 int, c4 bigint, c7 timestamp) begin SELECT c1, c3, sum(c4) OVER w1 as w1_c4_sum "
+            "FROM trans3 WINDOW w1 AS (PARTITION BY trans3.c1 ORDER BY trans3.c7 ROWS BETWEEN 2 PRECEDING AND "
+            "CURRENT ROW); end;",
+        &status))
+        << "fail to create procedure";
+    ASSERT_TRUE(env->cluster_sdk->Refresh());
+
+    ::hybridse::codec::Schema input_schema;
+    std::vector<std::pair<std::string, ::hybridse::type::Type>> input_cols = {{"c1", ::hybridse::type::kVarchar},
+                                                                              {"c3", ::hybridse::type::kInt32},
+                                                                              {"c4", ::hybridse::type::kInt64},
+                                                                              {"c7", ::hybridse::type::kTimestamp}};
+    for (const auto& kv : input_cols) {
+        auto col = input_schema.Add();
+        col->set_name(kv.first);
+        col->set_type(kv.second);
+    }
+    ::hybridse::codec::Schema output_schema;
+    std::vector<std::pair<std::string, ::hybridse::type::Type>> output_cols = {
+        {"c1", ::hybridse::type::kVarchar}, {"c3", ::hybridse::type::kInt32}, {"w1_c4_sum", ::hybridse::type::kInt64}};
+    for (const auto& kv : output_cols) {
+        auto col = output_schema.Add();
+        col->set_name(kv.first);
+        col->set_type(kv.second);
+    }
+
+    brpc::Controller cntl;
+    cntl.http_request().set_method(brpc::HTTP_METHOD_POST);
+    cntl.http_request().set_content_type(kNativeRowContentType);
+    cntl.http_request().uri() = "http://127.0.0.1:8010/dbs/" + env->db + "/deployments/" + sp_name;
+    for (int64_t c4 : {123, 234}) {
+        ::hybridse::codec::RowBuilder builder(input_schema);
+        std::string row(builder.CalTotalLength(2), '\0');
+        ASSERT_TRUE(builder.SetBuffer(reinterpret_cast<int8_t*>(&row[0]), row.size()));
+        ASSERT_TRUE(builder.AppendString("bb", 2));
+        ASSERT_TRUE(builder.AppendInt32(23));
+        ASSERT_TRUE(builder.AppendInt64(c4));
+        ASSERT_TRUE(builder.AppendTimestamp(1590738995000));
+        cntl.request_attachment().append(row);
+    }
+    env->http_channel.CallMethod(NULL, &cntl, NULL, NULL, NULL);
+    ASSERT_FALSE(cntl.Failed()) << cntl.ErrorText();
+    ASSERT_EQ(kNativeRowContentType, cntl.http_response().content_type())
+        << cntl.response_attachment().to_string();
+
+    // the output rows are encoded back to back as well
+    const std::string body = cntl.response_attachment().to_string();
+    ::hybridse::codec::RowView row_view(output_schema);
+    std::vector<int64_t> sums;
+    size_t pos = 0;
+    while (pos < body.size()) {
+        auto buf = reinterpret_cast<const int8_t*>(body.data() + pos);
+        uint32_t size = ::hybridse::codec::RowView::GetSize(buf);
+        ASSERT_TRUE(row_view.Reset(buf, size));
+        ASSERT_EQ("bb", row_view.GetStringUnsafe(0));
+        ASSERT_EQ(23, row_view.GetInt32Unsafe(1));
+        sums.push_back(row_view.GetInt64Unsafe(2));
+        pos += size;
+    }
+    ASSERT_EQ(std::vector<int64_t>({157, 268}), sums);
+
+    // a broken row gets a json error
+    brpc::Controller bad_cntl;
+    bad_cntl.http_request().set_method(brpc::HTTP_METHOD_POST);
+    bad_cntl.http_request().set_content_type(kNativeRowContentType);
+    bad_cntl.http_request().uri() = "http://127.0.0.1:8010/dbs/" + env->db + "/deployments/" + sp_name;
+    bad_cntl.request_attachment().append("abc");
+    env->http_channel.CallMethod(NULL, &bad_cntl, NULL, NULL, NULL);
+    ASSERT_FALSE(bad_cntl.Failed()) << bad_cntl.ErrorText();
+    butil::rapidjson::Document document;
+    ASSERT_FALSE(document.Parse(bad_cntl.response_attachment().to_string().c_str()).HasParseError());
+    ASSERT_EQ(-1, document["code"].GetInt());
+
+    ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, "drop procedure " + sp_name + ";", &status));
+    ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, "drop table trans3;", &status));
+    ASSERT_TRUE(env->cluster_sdk->Refresh());
+}
+
 TEST_F(APIServerTest, getDBs) {
     const auto env = APIServerTestEnv::Instance();
     {
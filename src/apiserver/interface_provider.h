@@ -117,6 +117,10 @@ class InterfaceProvider {
 
     typedef std::unordered_map<std::string, std::string> Params;
     using func = void(const Params& params, const butil::IOBuf& req_body, JsonWriter& writer);  // NOLINT
+    // Handler of a body in the native row format. It returns true with the rows written to `resp_body`, or false with
+    // an error written to `writer`.
+    using row_func = bool(const Params& params, const butil::IOBuf& req_body, butil::IOBuf* resp_body,
+                          JsonWriter& writer);  // NOLINT
     /**
      *  Registers a new get request handler.
      *
@@ -144,14 +148,31 @@ class InterfaceProvider {
      */
     InterfaceProvider& post(std::string const& path, std::function<func> callback);
 
+    /**
+     *  Registers a new post request handler for bodies in the native row format.
+     *
+     *  @param path The url to listen on, the same syntax as post().
+     *  @param callback The function called when a client sends rows on the url.
+     *
+     */
+    InterfaceProvider& post_row(std::string const& path, std::function<row_func> callback);
+
     bool handle(const std::string& path, const brpc::HttpMethod& method, const butil::IOBuf& req_body,
                 JsonWriter& writer);  // NOLINT
 
+    // Returns true if the rows of the response are written to `resp_body`, otherwise an error is written to `writer`
+    bool handle_row(const std::string& path, const brpc::HttpMethod& method, const butil::IOBuf& req_body,
+                    butil::IOBuf* resp_body, JsonWriter& writer);  // NOLINT
+
  private:
     struct BuiltRequest {
         Url url;
         std::function<func> callback;
     };
+    struct BuiltRowRequest {
+        Url url;
+        std::function<row_func> callback;
+    };
 
     static bool matching(const Url& received, const Url& registered);
     static std::unordered_map<std::string, std::string> extractParameters(const Url& received, const Url& registered);
@@ -161,6 +182,7 @@ class InterfaceProvider {
 
  private:
     std::unordered_map<int, std::vector<BuiltRequest>> requests_;
+    std::unordered_map<int, std::vector<BuiltRowRequest>> row_requests_;
 };
 
 struct GeneralError {
@@ -30,6 +30,20 @@ FullTableIterator::FullTableIterator(uint32_t tid, std::shared_ptr<Tables> table
     it_(), kv_it_(), key_(0), last_ts_(0), last_pk_(), value_() {
 }
 
+FullTableIterator::FullTableIterator(uint32_t tid, std::shared_ptr<Tables> tables,
+        const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients,
+        const ::hybridse::vm::RowPredicate& predicate)
+    : FullTableIterator(tid, tables, tablet_clients) {
+    predicate_ = predicate;
+}
+
+FullTableIterator::FullTableIterator(uint32_t tid, std::shared_ptr<Tables> tables,
+        const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients,
+        const ::hybridse::vm::RowPredicate& predicate, const std::vector<uint32_t>& projection)
+    : FullTableIterator(tid, tables, tablet_clients, predicate) {
+    projection_ = projection;
+}
+
 void FullTableIterator::SeekToFirst() {
     Reset();
     Next();
@@ -40,10 +54,25 @@ bool FullTableIterator::Valid() const {
 }
 
 void FullTableIterator::Next() {
+    while (NextRow()) {
+        if (!predicate_ || MatchPredicate()) {
+            return;
+        }
+    }
+}
+
+bool FullTableIterator::NextRow() {
     if (NextFromLocal()) {
-        return;
+        return true;
     }
-    NextFromRemote();
+    return NextFromRemote();
+}
+
+bool FullTableIterator::MatchPredicate() const {
+    // the row refers to the raw data, GetValue() copies it only for the rows kept
+    auto slice = (it_ && it_->Valid()) ? it_->GetValue() : kv_it_->GetValue();
+    ::hybridse::codec::Row row(::hybridse::base::RefCountedSlice::Create(slice.data(), slice.size()));
+    return predicate_(row);
 }
 
 void FullTableIterator::Reset() {
@@ -129,7 +158,7 @@ bool FullTableIterator::NextFromRemote() {
         if (kv_it_) {
             if (!kv_it_->IsFinish()) {
                 kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", last_pk_, last_ts_,
-                            FLAGS_traverse_cnt_limit, false, count);
+                            FLAGS_traverse_cnt_limit, false, count, projection_);
                 DLOG(INFO) << "pid " << cur_pid_ << " last pk " << last_pk_ <<
                     " key " << last_ts_ << " count " << count;
             } else {
@@ -138,7 +167,8 @@ bool FullTableIterator::NextFromRemote() {
                 continue;
             }
         } else {
-            kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", "", 0, FLAGS_traverse_cnt_limit, false, count);
+            kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", "", 0, FLAGS_traverse_cnt_limit, false, count,
+                                            projection_);
             DLOG(INFO) << "count " << count;
         }
         if (kv_it_ && kv_it_->Valid()) {
@@ -172,9 +202,10 @@ const ::hybridse::codec::Row& FullTableIterator::GetValue() {
 
 DistributeWindowIterator::DistributeWindowIterator(uint32_t tid, uint32_t pid_num, std::shared_ptr<Tables> tables,
         uint32_t index, const std::string& index_name,
-        const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients)
+        const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients,
+        const std::vector<uint32_t>& projection)
     : tid_(tid), pid_num_(pid_num), tables_(tables), tablet_clients_(tablet_clients),
-    index_(index), index_name_(index_name),
+    index_(index), index_name_(index_name), projection_(projection),
     cur_pid_(0), it_(), kv_it_() {}
 
 void DistributeWindowIterator::Reset() {
@@ -208,7 +239,8 @@ void DistributeWindowIterator::Seek(const std::string& key) {
 DistributeWindowIterator::ItStat DistributeWindowIterator::SeekToFirstRemote() const {
     for (const auto& kv : tablet_clients_) {
         uint32_t count = 0;
-        auto it = kv.second->Traverse(tid_, kv.first, index_name_, "", 0, FLAGS_traverse_cnt_limit, false, count);
+        auto it = kv.second->Traverse(tid_, kv.first, index_name_, "", 0, FLAGS_traverse_cnt_limit, false, count,
+                                      projection_);
         if (it && it->Valid()) {
             DLOG(INFO) << "first pos in remote: pid=" << kv.first;
             return {kv.first, nullptr, it};
@@ -269,7 +301,8 @@ DistributeWindowIterator::ItStat DistributeWindowIterator::SeekByKey(const std::
     auto client_iter = tablet_clients_.find(pid);
     if (client_iter != tablet_clients_.end()) {
         std::string msg;
-        auto it = client_iter->second->Scan(tid_, pid, key, index_name_, 0, 0, FLAGS_traverse_cnt_limit, msg);
+        auto it = client_iter->second->Scan(tid_, pid, key, index_name_, 0, 0, FLAGS_traverse_cnt_limit, 0,
+                                            projection_, msg);
         if (it != nullptr && it->Valid()) {
             return {pid, {}, it};
         }
@@ -314,7 +347,8 @@ void DistributeWindowIterator::Next() {
             return;
         }
         uint32_t count = 0;
-        kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", cur_pk, last_ts, FLAGS_traverse_cnt_limit, true, count);
+        kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", cur_pk, last_ts, FLAGS_traverse_cnt_limit, true, count,
+                                        projection_);
         DLOG(INFO) << "pid " << cur_pid_ << " last pk " << cur_pk << " key " << last_ts << " count " << count;
         if (kv_it_ && kv_it_->Valid()) {
             response_vec_.emplace_back(kv_it_->GetResponse());
@@ -327,7 +361,8 @@ void DistributeWindowIterator::Next() {
             }
             cur_pid_ = iter->first;
             uint32_t count = 0;
-            kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", "", 0, FLAGS_traverse_cnt_limit, false, count);
+            kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", "", 0, FLAGS_traverse_cnt_limit, false, count,
+                                            projection_);
             DLOG(INFO) << "count " << count;
             if (kv_it_ && kv_it_->Valid()) {
                 response_vec_.emplace_back(kv_it_->GetResponse());
@@ -363,11 +398,13 @@ std::unique_ptr<::hybridse::codec::RowIterator> DistributeWindowIterator::GetVal
         auto response = std::dynamic_pointer_cast<::openmldb::api::TraverseResponse>(traverse_it->GetResponse());
         auto new_traverse_it = std::make_shared<openmldb::base::TraverseKvIterator>(response);
         new_traverse_it->Seek(traverse_it->GetPK());
-        return new RemoteWindowIterator(tid_, cur_pid_, index_name_, new_traverse_it, tablet_clients_[cur_pid_]);
+        return new RemoteWindowIterator(tid_, cur_pid_, index_name_, new_traverse_it, tablet_clients_[cur_pid_],
+                                        projection_);
     } else {
         auto response = std::dynamic_pointer_cast<::openmldb::api::ScanResponse>(kv_it_->GetResponse());
         auto scan_it = std::make_shared<openmldb::base::ScanKvIterator>(kv_it_->GetPK(), response);
-        return new RemoteWindowIterator(tid_, cur_pid_, index_name_, scan_it, tablet_clients_[cur_pid_]);
+        return new RemoteWindowIterator(tid_, cur_pid_, index_name_, scan_it, tablet_clients_[cur_pid_],
+                                        projection_);
     }
 }
 
@@ -394,9 +431,9 @@ const ::hybridse::codec::Row& RemoteWindowIterator::GetValue() {
 
 RemoteWindowIterator::RemoteWindowIterator(uint32_t tid, uint32_t pid, const std::string& index_name,
         const std::shared_ptr<::openmldb::base::KvIterator>& kv_it,
-        const std::shared_ptr<openmldb::client::TabletClient>& client)
+        const std::shared_ptr<openmldb::client::TabletClient>& client, const std::vector<uint32_t>& projection)
     : tid_(tid), pid_(pid), index_name_(index_name), kv_it_(kv_it), tablet_client_(client),
-        is_traverse_data_(false), ts_(0), ts_cnt_(0) {
+        is_traverse_data_(false), ts_(0), ts_cnt_(0), projection_(projection) {
     if (kv_it_ && kv_it_->Valid()) {
         pk_ = kv_it_->GetPK();
         ts_ = kv_it_->GetKey();
@@ -432,7 +469,7 @@ void RemoteWindowIterator::SetTs() {
 void RemoteWindowIterator::ScanRemote(uint64_t key, uint32_t ts_cnt) {
     std::string msg;
     kv_it_ = tablet_client_->Scan(tid_, pid_, pk_, index_name_, key, 0,
-                FLAGS_traverse_cnt_limit, ts_cnt, msg);
+                FLAGS_traverse_cnt_limit, ts_cnt, projection_, msg);
     DLOG(INFO) << "scan key " << pk_ << " ts " << key << " from remote. tid "
         << tid_ << " pid " << pid_ << " ts_cnt " << ts_cnt;
     if (kv_it_ && kv_it_->Valid()) {
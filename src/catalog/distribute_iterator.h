@@ -37,6 +37,16 @@ class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hy
  public:
     FullTableIterator(uint32_t tid, std::shared_ptr<Tables> tables,
             const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients);
+    // iterate the rows satisfying `predicate` only, it is evaluated on the raw data
+    // before a row is copied out of the storage or the rpc response
+    FullTableIterator(uint32_t tid, std::shared_ptr<Tables> tables,
+            const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients,
+            const ::hybridse::vm::RowPredicate& predicate);
+    // a non-empty `projection` lets remote tablets send the projected columns only,
+    // the rows keep the table layout and the other columns are null
+    FullTableIterator(uint32_t tid, std::shared_ptr<Tables> tables,
+            const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients,
+            const ::hybridse::vm::RowPredicate& predicate, const std::vector<uint32_t>& projection);
     void Seek(const uint64_t& ts) override {
         LOG(ERROR) << "Unsupport Seek in FullTableIterator";
     }
@@ -50,8 +60,10 @@ class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hy
     const uint64_t& GetKey() const override { return key_; }
 
  private:
+    bool NextRow();
     bool NextFromLocal();
     bool NextFromRemote();
+    bool MatchPredicate() const;
     void Reset();
     void EndLocal();
 
@@ -68,13 +80,16 @@ class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hy
     std::string last_pk_;
     ::hybridse::codec::Row value_;
     std::vector<std::shared_ptr<::google::protobuf::Message>> response_vec_;
+    ::hybridse::vm::RowPredicate predicate_;
+    std::vector<uint32_t> projection_;
 };
 
 class RemoteWindowIterator : public ::hybridse::vm::RowIterator {
  public:
     RemoteWindowIterator(uint32_t tid, uint32_t pid, const std::string& index_name,
             const std::shared_ptr<::openmldb::base::KvIterator>& kv_it,
-            const std::shared_ptr<openmldb::client::TabletClient>& client);
+            const std::shared_ptr<openmldb::client::TabletClient>& client,
+            const std::vector<uint32_t>& projection = {});
 
     bool Valid() const override;
 
@@ -109,13 +124,15 @@ class RemoteWindowIterator : public ::hybridse::vm::RowIterator {
     std::string pk_;
     mutable uint64_t ts_;
     uint32_t ts_cnt_;
+    std::vector<uint32_t> projection_;
 };
 
 class DistributeWindowIterator : public ::hybridse::codec::WindowIterator {
  public:
     DistributeWindowIterator(uint32_t tid, uint32_t pid_num, std::shared_ptr<Tables> tables,
             uint32_t index, const std::string& index_name,
-            const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients);
+            const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients,
+            const std::vector<uint32_t>& projection = {});
     void Seek(const std::string& key) override;
     void SeekToFirst() override;
     void Next() override;
@@ -152,6 +169,8 @@ class DistributeWindowIterator : public ::hybridse::codec::WindowIterator {
     std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients_;
     const uint32_t index_;
     const std::string index_name_;
+    // columns fetched from the remote tablets, empty for all
+    const std::vector<uint32_t> projection_;
 
     uint32_t cur_pid_;
     // iterator to locally data
@@ -133,6 +133,31 @@ TEST_F(DistributeIteratorTest, AllInMemory) {
     ASSERT_EQ(count, 100);
 }
 
+TEST_F(DistributeIteratorTest, AllInMemoryWithPredicate) {
+    uint32_t tid = 1;
+    auto tables = std::make_shared<Tables>();
+    auto table1 = CreateTable(1, 1);
+    auto table2 = CreateTable(1, 3);
+    tables->emplace(1, table1);
+    tables->emplace(3, table2);
+    PutData((*tables)[1]);
+    PutData((*tables)[3]);
+    // keep every other row
+    int evaluated = 0;
+    FullTableIterator it(tid, tables, {}, [&evaluated](const ::hybridse::codec::Row& row) {
+        return !row.empty() && evaluated++ % 2 == 0;
+    });
+    it.SeekToFirst();
+    int count = 0;
+    while (it.Valid()) {
+        ASSERT_FALSE(it.GetValue().empty());
+        count++;
+        it.Next();
+    }
+    ASSERT_EQ(count, 50);
+    ASSERT_EQ(evaluated, 100);
+}
+
 TEST_F(DistributeIteratorTest, Empty) {
     uint32_t tid = 2;
     FullTableIterator it(tid, {}, {});
@@ -177,6 +202,37 @@ TEST_F(DistributeIteratorTest, AllInRemote) {
     ASSERT_EQ(count, 100);
 }
 
+TEST_F(DistributeIteratorTest, AllInRemoteWithProjection) {
+    uint32_t tid = 3;
+    FLAGS_db_root_path = "/tmp/" + ::openmldb::test::GenRand();
+    std::vector<std::string> endpoints = {"127.0.0.1:9230"};
+    brpc::Server tablet1;
+    ASSERT_TRUE(::openmldb::test::StartTablet(endpoints[0], &tablet1));
+    auto client1 = std::make_shared<openmldb::client::TabletClient>(endpoints[0], endpoints[0]);
+    ASSERT_EQ(client1->Init(), 0);
+    auto meta = CreateTableMeta(tid, 1);
+    ASSERT_TRUE(client1->CreateTable(meta));
+    PutData(meta, client1);
+    std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients = {{1, client1}};
+    // fetch ts only, the rows keep the layout with card and mcc set to null
+    FullTableIterator it(tid, {}, tablet_clients, ::hybridse::vm::RowPredicate(), {2});
+    it.SeekToFirst();
+    codec::RowView row_view(meta.column_desc());
+    int count = 0;
+    while (it.Valid()) {
+        const auto& row = it.GetValue();
+        ASSERT_TRUE(row_view.Reset(row.buf(), row.size()));
+        ASSERT_TRUE(row_view.IsNULL(0));
+        ASSERT_TRUE(row_view.IsNULL(1));
+        int64_t ts = 0;
+        ASSERT_EQ(0, row_view.GetInt64(2, &ts));
+        ASSERT_GT(ts, 0);
+        count++;
+        it.Next();
+    }
+    ASSERT_EQ(count, 50);
+}
+
 TEST_F(DistributeIteratorTest, Hybrid) {
     uint32_t tid = 3;
     FLAGS_db_root_path = "/tmp/" + ::openmldb::test::GenRand();
@@ -135,12 +135,33 @@ bool SDKCatalog::Init(const std::vector<::openmldb::nameserver::TableInfo>& tabl
                 std::make_pair(table->GetDatabase(), std::map<std::string, std::shared_ptr<SDKTableHandler>>()));
             db_it = result_pair.first;
         }
-        db_it->second.insert(std::make_pair(table->GetName(), table));
+        db_it->second[table->GetName()] = table;
     }
     db_sp_map_ = db_sp_map;
     return true;
 }
 
+std::shared_ptr<SDKCatalog> SDKCatalog::Apply(
+    const std::vector<::openmldb::nameserver::TableInfo>& upserted_tables,
+    const std::vector<std::pair<std::string, std::string>>& removed_tables, const Procedures& db_sp_map) const {
+    auto catalog = std::make_shared<SDKCatalog>(client_manager_);
+    catalog->tables_ = tables_;
+    for (const auto& db_table : removed_tables) {
+        auto db_it = catalog->tables_.find(db_table.first);
+        if (db_it == catalog->tables_.end()) {
+            continue;
+        }
+        db_it->second.erase(db_table.second);
+        if (db_it->second.empty()) {
+            catalog->tables_.erase(db_it);
+        }
+    }
+    if (!catalog->Init(upserted_tables, db_sp_map)) {
+        return {};
+    }
+    return catalog;
+}
+
 std::shared_ptr<::hybridse::vm::TableHandler> SDKCatalog::GetTable(const std::string& db,
                                                                    const std::string& table_name) {
     auto db_it = tables_.find(db);
@@ -113,6 +113,12 @@ class SDKCatalog : public ::hybridse::vm::Catalog {
 
     bool Init(const std::vector<::openmldb::nameserver::TableInfo>& tables, const Procedures& db_sp_map);
 
+    // copy on write: the new catalog shares the handlers of the unchanged tables with this one, only the
+    // upserted tables are initialized again. returns null if an upserted table fails to init
+    std::shared_ptr<SDKCatalog> Apply(const std::vector<::openmldb::nameserver::TableInfo>& upserted_tables,
+                                      const std::vector<std::pair<std::string, std::string>>& removed_tables,
+                                      const Procedures& db_sp_map) const;
+
     std::shared_ptr<::hybridse::type::Database> GetDatabase(const std::string& db) override {
         return std::shared_ptr<::hybridse::type::Database>();
     }
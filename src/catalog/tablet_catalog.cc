@@ -42,7 +42,8 @@ TabletTableHandler::TabletTableHandler(const ::openmldb::api::TableMeta& meta,
       index_list_(),
       index_hint_(),
       table_client_manager_(),
-      local_tablet_(local_tablet) {}
+      local_tablet_(local_tablet),
+      compressed_(meta.compress_type() == ::openmldb::type::kSnappy) {}
 
 TabletTableHandler::TabletTableHandler(const ::openmldb::nameserver::TableInfo& meta,
                                        std::shared_ptr<hybridse::vm::Tablet> local_tablet)
@@ -54,7 +55,8 @@ TabletTableHandler::TabletTableHandler(const ::openmldb::nameserver::TableInfo&
       index_list_(),
       index_hint_(),
       table_client_manager_(),
-      local_tablet_(local_tablet) {}
+      local_tablet_(local_tablet),
+      compressed_(meta.compress_type() == ::openmldb::type::kSnappy) {}
 
 bool TabletTableHandler::Init(const ClientManager& client_manager) {
     bool ok = schema::SchemaAdapter::ConvertSchema(table_st_.GetColumns(), &schema_);
@@ -123,6 +125,14 @@ std::unique_ptr<::hybridse::codec::RowIterator> TabletTableHandler::GetIterator(
 }
 
 std::unique_ptr<::hybridse::codec::WindowIterator> TabletTableHandler::GetWindowIterator(const std::string& idx_name) {
+    return GetProjectWindowIterator(idx_name, {});
+}
+
+std::unique_ptr<::hybridse::codec::WindowIterator> TabletTableHandler::GetProjectWindowIterator(
+    const std::string& idx_name, const std::vector<uint32_t>& columns) {
+    if (compressed_ && !columns.empty()) {
+        return {};
+    }
     auto iter = index_hint_.find(idx_name);
     if (iter == index_hint_.end()) {
         LOG(WARNING) << "index name " << idx_name << " not exist";
@@ -134,18 +144,8 @@ std::unique_ptr<::hybridse::codec::WindowIterator> TabletTableHandler::GetWindow
         LOG(WARNING) << " tables is null";
         return {};
     }
-    std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients;
-    for (uint32_t pid = 0; pid < partition_num_; pid++) {
-        if (tables->count(pid) == 0) {
-            auto accessor = table_client_manager_->GetTablet(pid);
-            if (accessor) {
-                tablet_clients.emplace(pid, accessor->GetClient());
-            }
-        }
-    }
-    DLOG(INFO) << "table size " << tables->size() << " tablet_clients size " << tablet_clients.size();
     return std::make_unique<DistributeWindowIterator>(GetTid(), partition_num_, tables,
-            iter->second.index, idx_name, tablet_clients);
+            iter->second.index, idx_name, GetRemoteClients(tables), columns);
 }
 
 // TODO(chenjing): optimize Get(int pos) base segment
@@ -157,8 +157,8 @@ const ::hybridse::codec::Row TabletTableHandler::Get(int32_t pos) {
     return iter->Valid() ? iter->GetValue() : ::hybridse::codec::Row();
 }
 
-::hybridse::codec::RowIterator* TabletTableHandler::GetRawIterator() {
-    auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
+std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> TabletTableHandler::GetRemoteClients(
+    const std::shared_ptr<Tables>& tables) {
     std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients;
     for (uint32_t pid = 0; pid < partition_num_; pid++) {
         if (tables->count(pid) == 0) {
@@ -169,7 +169,28 @@ const ::hybridse::codec::Row TabletTableHandler::Get(int32_t pos) {
         }
     }
     DLOG(INFO) << "table size " << tables->size() << " tablet_clients size " << tablet_clients.size();
-    return new catalog::FullTableIterator(GetTid(), tables, tablet_clients);
+    return tablet_clients;
+}
+
+::hybridse::codec::RowIterator* TabletTableHandler::GetRawIterator() {
+    auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
+    return new catalog::FullTableIterator(GetTid(), tables, GetRemoteClients(tables));
+}
+
+std::unique_ptr<::hybridse::codec::RowIterator> TabletTableHandler::GetFilterIterator(
+    const ::hybridse::vm::RowPredicate& predicate) {
+    auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
+    return std::make_unique<catalog::FullTableIterator>(GetTid(), tables, GetRemoteClients(tables), predicate);
+}
+
+std::unique_ptr<::hybridse::codec::RowIterator> TabletTableHandler::GetProjectIterator(
+    const std::vector<uint32_t>& columns) {
+    if (compressed_) {
+        return {};
+    }
+    auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
+    return std::make_unique<catalog::FullTableIterator>(GetTid(), tables, GetRemoteClients(tables),
+                                                        ::hybridse::vm::RowPredicate(), columns);
 }
 
 const uint64_t TabletTableHandler::GetCount() {
@@ -571,6 +592,19 @@ std::unique_ptr<::hybridse::vm::RowIterator> TabletSegmentHandler::GetIterator()
     return std::unique_ptr<::hybridse::vm::RowIterator>();
 }
 
+std::unique_ptr<::hybridse::vm::RowIterator> TabletSegmentHandler::GetProjectIterator(
+    const std::vector<uint32_t>& columns) {
+    auto iter = partition_handler_->GetProjectWindowIterator(columns);
+    if (iter) {
+        DLOG(INFO) << "seek to pk " << key_;
+        iter->Seek(key_);
+        if (iter->Valid() && 0 == iter->GetKey().compare(hybridse::codec::Row(key_))) {
+            return iter->GetValue();
+        }
+    }
+    return std::unique_ptr<::hybridse::vm::RowIterator>();
+}
+
 ::hybridse::vm::RowIterator* TabletSegmentHandler::GetRawIterator() {
     auto iter = partition_handler_->GetWindowIterator();
     if (iter) {
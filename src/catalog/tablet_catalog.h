@@ -63,6 +63,8 @@ class TabletSegmentHandler : public ::hybridse::vm::TableHandler {
 
     ::hybridse::vm::RowIterator *GetRawIterator() override;
 
+    std::unique_ptr<::hybridse::vm::RowIterator> GetProjectIterator(const std::vector<uint32_t> &columns) override;
+
     std::unique_ptr<::hybridse::vm::WindowIterator> GetWindowIterator(const std::string &idx_name) override {
         return std::unique_ptr<::hybridse::vm::WindowIterator>();
     }
@@ -109,6 +111,11 @@ class TabletPartitionHandler : public ::hybridse::vm::PartitionHandler,
         return table_handler_->GetWindowIterator(index_name_);
     }
 
+    std::unique_ptr<::hybridse::vm::WindowIterator> GetProjectWindowIterator(
+        const std::vector<uint32_t> &columns) override {
+        return table_handler_->GetProjectWindowIterator(index_name_, columns);
+    }
+
     const uint64_t GetCount() override {
         auto iter = GetWindowIterator();
         if (!iter) return 0;
@@ -161,8 +168,16 @@ class TabletTableHandler : public ::hybridse::vm::TableHandler,
 
     ::hybridse::codec::RowIterator *GetRawIterator() override;
 
+    std::unique_ptr<::hybridse::codec::RowIterator> GetFilterIterator(
+        const ::hybridse::vm::RowPredicate &predicate) override;
+
+    std::unique_ptr<::hybridse::codec::RowIterator> GetProjectIterator(const std::vector<uint32_t> &columns) override;
+
     std::unique_ptr<::hybridse::codec::WindowIterator> GetWindowIterator(const std::string &idx_name) override;
 
+    std::unique_ptr<::hybridse::codec::WindowIterator> GetProjectWindowIterator(
+        const std::string &idx_name, const std::vector<uint32_t> &columns) override;
+
     const uint64_t GetCount() override;
 
     ::hybridse::codec::Row At(uint64_t pos) override;
@@ -185,6 +200,10 @@ class TabletTableHandler : public ::hybridse::vm::TableHandler,
     void Update(const ::openmldb::nameserver::TableInfo &meta, const ClientManager &client_manager);
 
  private:
+    // clients of the partitions without a local table
+    std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> GetRemoteClients(
+        const std::shared_ptr<Tables> &tables);
+
     inline int32_t GetColumnIndex(const std::string &column) {
         auto it = types_.find(column);
         if (it != types_.end()) {
@@ -203,6 +222,8 @@ class TabletTableHandler : public ::hybridse::vm::TableHandler,
     ::hybridse::vm::IndexHint index_hint_;
     std::shared_ptr<TableClientManager> table_client_manager_;
     std::shared_ptr<hybridse::vm::Tablet> local_tablet_;
+    // rows of a compressed table are not projected by tablets
+    bool compressed_;
 };
 
 typedef std::map<std::string, std::map<std::string, std::shared_ptr<TabletTableHandler>>> TabletTables;
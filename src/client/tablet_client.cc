@@ -71,13 +71,16 @@ bool TabletClient::Query(const std::string& db, const std::string& sql, const st
 bool TabletClient::Query(const std::string& db, const std::string& sql,
                          const std::vector<openmldb::type::DataType>& parameter_types,
                          const std::string& parameter_row,
-                         brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug) {
+                         brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug,
+                         const bool is_profile, const bool is_chunked) {
     if (cntl == NULL || response == NULL) return false;
     ::openmldb::api::QueryRequest request;
     request.set_sql(sql);
     request.set_db(db);
     request.set_is_batch(true);
     request.set_is_debug(is_debug);
+    request.set_is_profile(is_profile);
+    request.set_is_chunked(is_chunked);
     request.set_parameter_row_size(parameter_row.size());
     request.set_parameter_row_slices(1);
     for (auto& type : parameter_types) {
@@ -97,6 +100,19 @@ bool TabletClient::Query(const std::string& db, const std::string& sql,
     return true;
 }
 
+bool TabletClient::QueryChunk(uint64_t cursor_id, brpc::Controller* cntl, ::openmldb::api::QueryResponse* response) {
+    if (cntl == NULL || response == NULL) return false;
+    ::openmldb::api::QueryRequest request;
+    request.set_is_batch(true);
+    request.set_cursor_id(cursor_id);
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::Query, cntl, &request, response);
+    if (!ok || response->code() != 0) {
+        LOG(WARNING) << "fail to query the next chunk of cursor " << cursor_id;
+        return false;
+    }
+    return true;
+}
+
 /**
  * Utility function to encode row batch data into rpc attachment buffer
  */
@@ -582,6 +598,13 @@ bool TabletClient::GetTableStatus(uint32_t tid, uint32_t pid, bool need_schema,
 std::shared_ptr<openmldb::base::ScanKvIterator> TabletClient::Scan(uint32_t tid, uint32_t pid,
         const std::string& pk, const std::string& idx_name,
         uint64_t stime, uint64_t etime, uint32_t limit, uint32_t skip_record_num, std::string& msg) {
+    return Scan(tid, pid, pk, idx_name, stime, etime, limit, skip_record_num, {}, msg);
+}
+
+std::shared_ptr<openmldb::base::ScanKvIterator> TabletClient::Scan(uint32_t tid, uint32_t pid,
+        const std::string& pk, const std::string& idx_name,
+        uint64_t stime, uint64_t etime, uint32_t limit, uint32_t skip_record_num,
+        const std::vector<uint32_t>& projection, std::string& msg) {
     ::openmldb::api::ScanRequest request;
     request.set_pk(pk);
     request.set_st(stime);
@@ -593,6 +616,10 @@ std::shared_ptr<openmldb::base::ScanKvIterator> TabletClient::Scan(uint32_t tid,
     }
     request.set_limit(limit);
     request.set_skip_record_num(skip_record_num);
+    if (!projection.empty()) {
+        request.mutable_projection()->Add(projection.begin(), projection.end());
+        request.set_keep_layout(true);
+    }
     auto response = std::make_shared<openmldb::api::ScanResponse>();
     bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::Scan, &request, response.get(),
                 FLAGS_request_timeout_ms, 1);
@@ -882,7 +909,7 @@ bool TabletClient::DeleteBinlog(uint32_t tid, uint32_t pid, openmldb::common::St
 
 std::shared_ptr<openmldb::base::TraverseKvIterator> TabletClient::Traverse(uint32_t tid, uint32_t pid,
         const std::string& idx_name, const std::string& pk, uint64_t ts, uint32_t limit, bool skip_current_pk,
-        uint32_t& count) {
+        uint32_t& count, const std::vector<uint32_t>& projection) {
     ::openmldb::api::TraverseRequest request;
     auto response = std::make_shared<openmldb::api::TraverseResponse>();
     request.set_tid(tid);
@@ -896,6 +923,10 @@ std::shared_ptr<openmldb::base::TraverseKvIterator> TabletClient::Traverse(uint3
         request.set_ts(ts);
     }
     request.set_skip_current_pk(skip_current_pk);
+    if (!projection.empty()) {
+        request.mutable_projection()->Add(projection.begin(), projection.end());
+        request.set_keep_layout(true);
+    }
     bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::Traverse, &request, response.get(),
                                   FLAGS_request_timeout_ms, FLAGS_request_max_retry);
     if (!ok || response->code() != 0) {
@@ -70,7 +70,11 @@ class TabletClient : public Client {
 
     bool Query(const std::string& db, const std::string& sql,
                const std::vector<openmldb::type::DataType>& parameter_types, const std::string& parameter_row,
-               brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug = false);
+               brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug = false,
+               const bool is_profile = false, const bool is_chunked = false);
+
+    // fetch the next chunk of a chunked batch query result
+    bool QueryChunk(uint64_t cursor_id, brpc::Controller* cntl, ::openmldb::api::QueryResponse* response);
 
     bool Query(const std::string& db, const std::string& sql, const std::string& row, brpc::Controller* cntl,
                ::openmldb::api::QueryResponse* response, const bool is_debug = false);
@@ -110,6 +114,12 @@ class TabletClient : public Client {
             uint64_t stime, uint64_t etime,
             uint32_t limit, std::string& msg);  // NOLINT
 
+    // the rows keep the table layout and only the columns in projection are filled, the others are null
+    std::shared_ptr<openmldb::base::ScanKvIterator> Scan(uint32_t tid, uint32_t pid,
+            const std::string& pk, const std::string& idx_name,
+            uint64_t stime, uint64_t etime, uint32_t limit, uint32_t skip_record_num,
+            const std::vector<uint32_t>& projection, std::string& msg);  // NOLINT
+
     bool Scan(const ::openmldb::api::ScanRequest& request, brpc::Controller* cntl,
               ::openmldb::api::ScanResponse* response);
 
@@ -192,9 +202,11 @@ class TabletClient : public Client {
     bool ConnectZK();
     bool DisConnectZK();
 
+    // a non-empty projection keeps the table layout of rows and sets the other columns to null
     std::shared_ptr<openmldb::base::TraverseKvIterator> Traverse(uint32_t tid, uint32_t pid,
             const std::string& idx_name, const std::string& pk, uint64_t ts,
-            uint32_t limit, bool skip_current_pk, uint32_t& count);  // NOLINT
+            uint32_t limit, bool skip_current_pk, uint32_t& count,  // NOLINT
+            const std::vector<uint32_t>& projection = {});
 
     bool SetMode(bool mode);
 
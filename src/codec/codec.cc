@@ -996,8 +996,11 @@ int32_t GetStrField(const int8_t* row, uint32_t field_offset, uint32_t next_str_
 
 }  // namespace v1
 
-RowProject::RowProject(const std::map<int32_t, std::shared_ptr<Schema>>& vers_schema, const ProjectList& plist)
+RowProject::RowProject(const std::map<int32_t, std::shared_ptr<Schema>>& vers_schema, const ProjectList& plist,
+                       bool keep_layout)
     : plist_(plist),
+      keep_layout_(keep_layout),
+      selected_(),
       output_schema_(),
       row_builder_(NULL),
       cur_rv_(nullptr),
@@ -1020,7 +1023,8 @@ bool RowProject::Init() {
         }
     }
     for (const auto& sch : vers_schema_) {
-        if (max_idx_ >= static_cast<uint32_t>(sch.second->size())) {
+        // with keep_layout, the columns a version does not have yet are output as null
+        if (!keep_layout_ && max_idx_ >= static_cast<uint32_t>(sch.second->size())) {
             continue;
         }
         std::shared_ptr<RowView> rv = std::make_shared<RowView>(*sch.second);
@@ -1031,12 +1035,24 @@ bool RowProject::Init() {
         return false;
     }
     const auto it = vers_views_.begin();
+    cur_ver_ = it->first;
     cur_schema_ = vers_schema_.find(it->first)->second;
     cur_rv_ = it->second;
-    for (int32_t i = 0; i < plist_.size(); i++) {
-        uint32_t idx = plist_.Get(i);
-        const ::openmldb::common::ColumnDesc& column = cur_schema_->Get(idx);
-        output_schema_.Add()->CopyFrom(column);
+    if (keep_layout_) {
+        output_schema_.CopyFrom(*vers_schema_.rbegin()->second);
+        selected_.assign(output_schema_.size(), false);
+        for (int32_t i = 0; i < plist_.size(); i++) {
+            selected_[plist_.Get(i)] = true;
+        }
+        for (int32_t i = 0; i < output_schema_.size(); i++) {
+            output_schema_.Mutable(i)->set_not_null(false);
+        }
+    } else {
+        for (int32_t i = 0; i < plist_.size(); i++) {
+            uint32_t idx = plist_.Get(i);
+            const ::openmldb::common::ColumnDesc& column = cur_schema_->Get(idx);
+            output_schema_.Add()->CopyFrom(column);
+        }
     }
     row_builder_ = new RowBuilder(output_schema_);
     return true;
@@ -1060,6 +1076,9 @@ bool RowProject::Project(const int8_t* row_ptr, uint32_t size, int8_t** output_p
     uint32_t str_size = 0;
     for (int32_t i = 0; i < plist_.size(); i++) {
         uint32_t idx = plist_.Get(i);
+        if (idx >= static_cast<uint32_t>(cur_schema_->size())) {
+            continue;
+        }
         const ::openmldb::common::ColumnDesc& column = cur_schema_->Get(idx);
         if (column.data_type() == ::openmldb::type::kVarchar || column.data_type() == ::openmldb::type::kString) {
             if (cur_rv_->IsNULL(idx)) continue;
@@ -1075,77 +1094,31 @@ bool RowProject::Project(const int8_t* row_ptr, uint32_t size, int8_t** output_p
     uint32_t total_size = row_builder_->CalTotalLength(str_size);
     char* ptr = new char[total_size];
     row_builder_->SetBuffer(reinterpret_cast<int8_t*>(ptr), total_size);
-    for (int32_t i = 0; i < plist_.size(); i++) {
-        uint32_t idx = plist_.Get(i);
-        const ::openmldb::common::ColumnDesc& column = cur_schema_->Get(idx);
-        int32_t ret = 0;
-        if (cur_rv_->IsNULL(idx)) {
-            row_builder_->AppendNULL();
-            continue;
-        }
-        switch (column.data_type()) {
-            case ::openmldb::type::kBool: {
-                bool val = false;
-                ret = cur_rv_->GetBool(idx, &val);
-                if (ret == 0) row_builder_->AppendBool(val);
-                break;
-            }
-            case ::openmldb::type::kSmallInt: {
-                int16_t val = 0;
-                ret = cur_rv_->GetInt16(idx, &val);
-                if (ret == 0) row_builder_->AppendInt16(val);
-                break;
-            }
-            case ::openmldb::type::kInt: {
-                int32_t val = 0;
-                ret = cur_rv_->GetInt32(idx, &val);
-                if (ret == 0) row_builder_->AppendInt32(val);
-                break;
-            }
-            case ::openmldb::type::kDate: {
-                int32_t val = 0;
-                ret = cur_rv_->GetDate(idx, &val);
-                if (ret == 0) row_builder_->AppendDate(val);
-                break;
-            }
-            case ::openmldb::type::kBigInt: {
-                int64_t val = 0;
-                ret = cur_rv_->GetInt64(idx, &val);
-                if (ret == 0) row_builder_->AppendInt64(val);
-                break;
-            }
-            case ::openmldb::type::kTimestamp: {
-                int64_t val = 0;
-                ret = cur_rv_->GetTimestamp(idx, &val);
-                if (ret == 0) row_builder_->AppendTimestamp(val);
-                break;
+    if (keep_layout_) {
+        for (int32_t idx = 0; idx < output_schema_.size(); idx++) {
+            if (selected_[idx] && idx < cur_schema_->size() && !cur_rv_->IsNULL(idx)) {
+                ok = AppendColumn(idx);
+            } else {
+                ok = row_builder_->AppendNULL();
             }
-            case ::openmldb::type::kFloat: {
-                float val = 0;
-                ret = cur_rv_->GetFloat(idx, &val);
-                if (ret == 0) row_builder_->AppendFloat(val);
-                break;
+            if (!ok) {
+                delete[] ptr;
+                PDLOG(WARNING, "fail to project column %s with idx %d", output_schema_.Get(idx).name().c_str(), idx);
+                return false;
             }
-            case ::openmldb::type::kDouble: {
-                double val = 0;
-                ret = cur_rv_->GetDouble(idx, &val);
-                if (ret == 0) row_builder_->AppendDouble(val);
-                break;
+        }
+    } else {
+        for (int32_t i = 0; i < plist_.size(); i++) {
+            uint32_t idx = plist_.Get(i);
+            if (cur_rv_->IsNULL(idx)) {
+                row_builder_->AppendNULL();
+                continue;
             }
-            case ::openmldb::type::kString:
-            case ::openmldb::type::kVarchar: {
-                char* val = NULL;
-                uint32_t size = 0;
-                ret = cur_rv_->GetString(idx, &val, &size);
-                if (ret == 0) row_builder_->AppendString(val, size);
-                break;
+            if (!AppendColumn(idx)) {
+                delete[] ptr;
+                PDLOG(WARNING, "fail to project column %s with idx %u", cur_schema_->Get(idx).name().c_str(), idx);
+                return false;
             }
-            default: { PDLOG(WARNING, "not supported type"); }
-        }
-        if (ret != 0) {
-            delete[] ptr;
-            PDLOG(WARNING, "fail to project column %s with idx %u", column.name().c_str(), idx);
-            return false;
         }
     }
     *output_ptr = reinterpret_cast<int8_t*>(ptr);
@@ -1153,5 +1126,70 @@ bool RowProject::Project(const int8_t* row_ptr, uint32_t size, int8_t** output_p
     return true;
 }
 
+bool RowProject::AppendColumn(uint32_t idx) {
+    const ::openmldb::common::ColumnDesc& column = cur_schema_->Get(idx);
+    int32_t ret = 0;
+    switch (column.data_type()) {
+        case ::openmldb::type::kBool: {
+            bool val = false;
+            ret = cur_rv_->GetBool(idx, &val);
+            if (ret == 0) row_builder_->AppendBool(val);
+            break;
+        }
+        case ::openmldb::type::kSmallInt: {
+            int16_t val = 0;
+            ret = cur_rv_->GetInt16(idx, &val);
+            if (ret == 0) row_builder_->AppendInt16(val);
+            break;
+        }
+        case ::openmldb::type::kInt: {
+            int32_t val = 0;
+            ret = cur_rv_->GetInt32(idx, &val);
+            if (ret == 0) row_builder_->AppendInt32(val);
+            break;
+        }
+        case ::openmldb::type::kDate: {
+            int32_t val = 0;
+            ret = cur_rv_->GetDate(idx, &val);
+            if (ret == 0) row_builder_->AppendDate(val);
+            break;
+        }
+        case ::openmldb::type::kBigInt: {
+            int64_t val = 0;
+            ret = cur_rv_->GetInt64(idx, &val);
+            if (ret == 0) row_builder_->AppendInt64(val);
+            break;
+        }
+        case ::openmldb::type::kTimestamp: {
+            int64_t val = 0;
+            ret = cur_rv_->GetTimestamp(idx, &val);
+            if (ret == 0) row_builder_->AppendTimestamp(val);
+            break;
+        }
+        case ::openmldb::type::kFloat: {
+            float val = 0;
+            ret = cur_rv_->GetFloat(idx, &val);
+            if (ret == 0) row_builder_->AppendFloat(val);
+            break;
+        }
+        case ::openmldb::type::kDouble: {
+            double val = 0;
+            ret = cur_rv_->GetDouble(idx, &val);
+            if (ret == 0) row_builder_->AppendDouble(val);
+            break;
+        }
+        case ::openmldb::type::kString:
+        case ::openmldb::type::kVarchar: {
+            char* val = NULL;
+            uint32_t size = 0;
+            ret = cur_rv_->GetString(idx, &val, &size);
+            if (ret == 0) row_builder_->AppendString(val, size);
+            break;
+        }
+        default: { PDLOG(WARNING, "not supported type"); }
+    }
+    return ret == 0;
+}
+
 }  // namespace codec
 }  // namespace openmldb
@@ -49,9 +49,15 @@ class RowProject;
 // TODO(wangtaize) share the row codec context
 struct RowContext {};
 
+// Project rows into the columns of plist.
+// With keep_layout the output row keeps the schema of the latest version and
+// the columns out of plist are set to null, so readers which decode rows by the
+// table schema still work but strings and pruned columns are not copied. Rows
+// of an older schema version output null for the columns added after it.
 class RowProject {
  public:
-    RowProject(const std::map<int32_t, std::shared_ptr<Schema>>& vers_schema, const ProjectList& plist);
+    RowProject(const std::map<int32_t, std::shared_ptr<Schema>>& vers_schema, const ProjectList& plist,
+               bool keep_layout = false);
 
     ~RowProject();
 
@@ -62,7 +68,11 @@ class RowProject {
     uint32_t GetMaxIdx() { return max_idx_; }
 
  private:
+    bool AppendColumn(uint32_t idx);
+
     const ProjectList& plist_;
+    bool keep_layout_;
+    std::vector<bool> selected_;
     Schema output_schema_;
     // TODO(wangtaize) share the init overhead
     RowBuilder* row_builder_;
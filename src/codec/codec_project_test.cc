@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -398,6 +400,105 @@ TEST_P(ProjectCodecTest, common_case) {
     CompareRow(&left, &right, args->output_schema);
 }
 
+TEST_F(ProjectCodecTest, keep_layout) {
+    Schema schema;
+    common::ColumnDesc* column1 = schema.Add();
+    column1->set_name("col1");
+    column1->set_data_type(type::kVarchar);
+    column1->set_not_null(true);
+    common::ColumnDesc* column2 = schema.Add();
+    column2->set_name("col2");
+    column2->set_data_type(type::kBigInt);
+    common::ColumnDesc* column3 = schema.Add();
+    column3->set_name("col3");
+    column3->set_data_type(type::kVarchar);
+
+    RowBuilder input_rb(schema);
+    std::string prefix = "a long string which is pruned";
+    std::string hello = "hello";
+    uint32_t input_row_size = input_rb.CalTotalLength(prefix.size() + hello.size());
+    std::string input(input_row_size, '\0');
+    int8_t* input_ptr = reinterpret_cast<int8_t*>(&input[0]);
+    input_rb.SetBuffer(input_ptr, input_row_size);
+    input_rb.AppendString(prefix.c_str(), prefix.size());
+    input_rb.AppendInt64(64);
+    input_rb.AppendString(hello.c_str(), hello.size());
+
+    std::map<int32_t, std::shared_ptr<Schema>> vers_schema;
+    vers_schema.insert(std::make_pair(1, std::make_shared<Schema>(schema)));
+    ProjectList plist;
+    plist.Add(1);
+    plist.Add(2);
+    RowProject rp(vers_schema, plist, true);
+    ASSERT_TRUE(rp.Init());
+    int8_t* output = NULL;
+    uint32_t output_size = 0;
+    ASSERT_TRUE(rp.Project(input_ptr, input_row_size, &output, &output_size));
+    ASSERT_EQ(input_row_size - prefix.size(), output_size);
+
+    // the output row is decoded by the table schema
+    RowView view(schema, output, output_size);
+    ASSERT_TRUE(view.IsNULL(0));
+    int64_t c2 = 0;
+    ASSERT_EQ(0, view.GetInt64(1, &c2));
+    ASSERT_EQ(64, c2);
+    char* c3 = NULL;
+    uint32_t c3_size = 0;
+    ASSERT_EQ(0, view.GetString(2, &c3, &c3_size));
+    ASSERT_EQ(hello, std::string(c3, c3_size));
+    delete[] reinterpret_cast<char*>(output);
+}
+
+TEST_F(ProjectCodecTest, keep_layout_added_column) {
+    Schema old_schema;
+    common::ColumnDesc* column1 = old_schema.Add();
+    column1->set_name("col1");
+    column1->set_data_type(type::kVarchar);
+    common::ColumnDesc* column2 = old_schema.Add();
+    column2->set_name("col2");
+    column2->set_data_type(type::kBigInt);
+    Schema schema(old_schema);
+    common::ColumnDesc* column3 = schema.Add();
+    column3->set_name("col3");
+    column3->set_data_type(type::kVarchar);
+
+    // a row written before col3 was added
+    RowBuilder input_rb(old_schema);
+    std::string str = "pruned";
+    uint32_t input_row_size = input_rb.CalTotalLength(str.size());
+    std::string input(input_row_size, '\0');
+    int8_t* input_ptr = reinterpret_cast<int8_t*>(&input[0]);
+    input_rb.SetBuffer(input_ptr, input_row_size);
+    input_rb.AppendString(str.c_str(), str.size());
+    input_rb.AppendInt64(64);
+
+    std::map<int32_t, std::shared_ptr<Schema>> vers_schema;
+    vers_schema.insert(std::make_pair(1, std::make_shared<Schema>(old_schema)));
+    vers_schema.insert(std::make_pair(2, std::make_shared<Schema>(schema)));
+    ProjectList plist;
+    plist.Add(1);
+    plist.Add(2);
+    RowProject rp(vers_schema, plist, true);
+    ASSERT_TRUE(rp.Init());
+    int8_t* output = NULL;
+    uint32_t output_size = 0;
+    ASSERT_TRUE(rp.Project(input_ptr, input_row_size, &output, &output_size));
+
+    // the column the row does not have yet is null
+    RowView view(schema, output, output_size);
+    ASSERT_TRUE(view.IsNULL(0));
+    int64_t c2 = 0;
+    ASSERT_EQ(0, view.GetInt64(1, &c2));
+    ASSERT_EQ(64, c2);
+    ASSERT_TRUE(view.IsNULL(2));
+    delete[] reinterpret_cast<char*>(output);
+
+    // without keep_layout such a projection still has no view for the old version
+    RowProject narrow_rp(vers_schema, plist);
+    ASSERT_TRUE(narrow_rp.Init());
+    ASSERT_FALSE(narrow_rp.Project(input_ptr, input_row_size, &output, &output_size));
+}
+
 INSTANTIATE_TEST_SUITE_P(ProjectCodecTestPrefix, ProjectCodecTest, testing::ValuesIn(GenCommonCase()));
 
 }  // namespace codec
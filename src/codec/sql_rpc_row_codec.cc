@@ -19,7 +19,22 @@
 namespace openmldb {
 namespace codec {
 
-bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, hybridse::codec::Row* row) {
+// return the address of [offset, offset + size) of buf if it lies in one backing block, else null
+static const char* GetContiguousData(const butil::IOBuf& buf, size_t offset, size_t size) {
+    size_t block_start = 0;
+    for (size_t i = 0; i < buf.backing_block_num(); ++i) {
+        auto block = buf.backing_block(i);
+        size_t block_end = block_start + block.size();
+        if (offset < block_end) {
+            return offset + size <= block_end ? block.data() + (offset - block_start) : nullptr;
+        }
+        block_start = block_end;
+    }
+    return nullptr;
+}
+
+static bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, bool in_place,
+                         hybridse::codec::Row* row) {
     if (row == nullptr) {
         return false;
     }
@@ -53,12 +68,19 @@ bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t sl
                 row->Append(hybridse::base::RefCountedSlice());
             }
         } else {
-            int8_t* slice_buf = reinterpret_cast<int8_t*>(malloc(slice_size));
-            buf.copy_to(slice_buf, slice_size, cur_offset);
+            const char* data = in_place ? GetContiguousData(buf, cur_offset, slice_size) : nullptr;
+            hybridse::base::RefCountedSlice slice;
+            if (data != nullptr) {
+                slice = hybridse::base::RefCountedSlice::Create(data, slice_size);
+            } else {
+                int8_t* slice_buf = reinterpret_cast<int8_t*>(malloc(slice_size));
+                buf.copy_to(slice_buf, slice_size, cur_offset);
+                slice = hybridse::base::RefCountedSlice::CreateManaged(slice_buf, slice_size);
+            }
             if (i == 0) {
-                *row = hybridse::codec::Row(hybridse::base::RefCountedSlice::CreateManaged(slice_buf, slice_size));
+                *row = hybridse::codec::Row(slice);
             } else {
-                row->Append(hybridse::base::RefCountedSlice::CreateManaged(slice_buf, slice_size));
+                row->Append(slice);
             }
         }
         cur_offset = next_offset;
@@ -70,6 +92,15 @@ bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t sl
     return true;
 }
 
+bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, hybridse::codec::Row* row) {
+    return DecodeRpcRow(buf, offset, size, slice_num, false, row);
+}
+
+bool DecodeRpcRowInPlace(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num,
+                         hybridse::codec::Row* row) {
+    return DecodeRpcRow(buf, offset, size, slice_num, true, row);
+}
+
 bool EncodeRpcRow(const hybridse::codec::Row& row, butil::IOBuf* buf, size_t* total_size) {
     if (buf == nullptr) {
         return false;
@@ -33,6 +33,11 @@ namespace codec {
 
 bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, hybridse::codec::Row* row);
 
+// same as DecodeRpcRow, but a slice lying in one block of `buf` is referenced in place instead of copied.
+// the row is only valid while `buf` is alive and unchanged
+bool DecodeRpcRowInPlace(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num,
+                         hybridse::codec::Row* row);
+
 bool EncodeRpcRow(const hybridse::codec::Row& row, butil::IOBuf* buf, size_t* total_size);
 
 bool EncodeRpcRow(const int8_t* buf, size_t size, butil::IOBuf* io_buf);
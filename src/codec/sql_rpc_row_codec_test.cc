@@ -123,6 +123,52 @@ TEST_F(SqlRpcRowCodecTest, TestMultiSlice) {
     ASSERT_EQ(0, decoded.size(3));
 }
 
+TEST_F(SqlRpcRowCodecTest, TestDecodeInPlace) {
+    hybridse::codec::Schema schema;
+    InitSchema(&schema);
+
+    size_t buf_size;
+    hybridse::codec::RowBuilder builder(schema);
+
+    buf_size = builder.CalTotalLength(5);
+    int8_t* buf = reinterpret_cast<int8_t*>(malloc(buf_size));
+    builder.SetBuffer(buf, buf_size);
+    builder.AppendInt32(42);
+    builder.AppendFloat(3.14);
+    builder.AppendString("hello", 5);
+    hybridse::codec::Row row(hybridse::codec::RefCountedSlice::CreateManaged(buf, buf_size));
+
+    butil::IOBuf iobuf;
+    iobuf.append("test prefix string");
+    size_t total_size;
+    ASSERT_TRUE(EncodeRpcRow(row, &iobuf, &total_size));
+
+    hybridse::codec::Row decoded;
+    ASSERT_TRUE(DecodeRpcRowInPlace(iobuf, 18, buf_size, 1, &decoded));
+    if (iobuf.backing_block_num() == 1) {
+        // referenced in place, not copied
+        ASSERT_EQ(reinterpret_cast<const int8_t*>(iobuf.backing_block(0).data()) + 18, decoded.buf(0));
+    }
+    hybridse::codec::RowView row_view(schema);
+    row_view.Reset(decoded.buf(0), decoded.size(0));
+    ASSERT_EQ(42, row_view.GetInt32Unsafe(0));
+    ASSERT_FLOAT_EQ(3.14, row_view.GetFloatUnsafe(1));
+    ASSERT_EQ("hello", row_view.GetStringUnsafe(2));
+
+    // a slice across blocks is copied
+    butil::IOBuf split_buf;
+    butil::IOBuf tail;
+    split_buf.append(buf, 4);
+    tail.append(buf + 4, buf_size - 4);
+    split_buf.append(tail);
+    hybridse::codec::Row split_decoded;
+    ASSERT_TRUE(DecodeRpcRowInPlace(split_buf, 0, buf_size, 1, &split_decoded));
+    row_view.Reset(split_decoded.buf(0), split_decoded.size(0));
+    ASSERT_EQ(42, row_view.GetInt32Unsafe(0));
+    ASSERT_FLOAT_EQ(3.14, row_view.GetFloatUnsafe(1));
+    ASSERT_EQ("hello", row_view.GetStringUnsafe(2));
+}
+
 }  // namespace codec
 }  // namespace openmldb
 
@@ -64,6 +64,8 @@ DEFINE_string(bucket_size, "1d", "the default bucket size in pre-aggr table");
 
 // scan configuration
 DEFINE_uint32(scan_max_bytes_size, 2 * 1024 * 1024, "config the max size of scan bytes size");
+DEFINE_uint32(query_cursor_timeout_ms, 60000,
+              "config the time the rest of a chunked query result is kept for the next chunk request");
 DEFINE_uint32(scan_reserve_size, 1024, "config the size of vec reserve");
 DEFINE_uint32(preview_limit_max_num, 1000, "config the max num of preview limit");
 DEFINE_uint32(preview_default_limit, 100, "config the default limit of preview");
@@ -107,6 +109,7 @@ DEFINE_int32(retry_send_file_wait_time_ms, 3000, "conf the wait time when retry
 DEFINE_int32(stream_close_wait_time_ms, 1000, "the wait time before close stream");
 DEFINE_uint32(stream_block_size, 1 * 1204 * 1024, "config the write/read block size in streaming");
 DEFINE_int32(stream_bandwidth_limit, 10 * 1204 * 1024, "the limit bandwidth. Byte/Second");
+DEFINE_uint32(send_file_concurrency, 1, "the number of files sent in parallel when sending a disk table snapshot");
 
 // if set 23, the task will execute 23:00 every day
 DEFINE_int32(make_snapshot_time, 23, "config the time to make snapshot");
@@ -142,6 +145,9 @@ DEFINE_uint32(block_cache_mb, 4096,
               "Memory allocated for caching uncompressed block (OS page cache "
               "handles the compressed ones)");
 DEFINE_uint32(write_buffer_mb, 128, "Memtable size");
+DEFINE_uint32(memtable_budget_mb, 0,
+              "Memory shared by the memtables of all disk tables in a tablet, flushes are triggered when it is "
+              "exceeded, 0 means unlimited");
 DEFINE_uint32(block_cache_shardbits, 8, "Divide block cache into 2^8 shards to avoid cache contention");
 DEFINE_bool(verify_compression, false, "For debug");
 
@@ -155,3 +161,13 @@ DEFINE_uint32(get_replica_status_interval, 10000, "config the interval to sync r
 
 DEFINE_uint32(sync_deploy_stats_timeout, 10000,
               "time interval in milliseconds to sync deploy response time stats into table");
+DEFINE_uint64(deploy_tiered_compile_threshold, 10000,
+              "recompile a deployment with aggressive llvm optimization in background after it is called "
+              "this many times, 0 to disable");
+DEFINE_uint32(deploy_profile_sample_rate, 0,
+              "profile the runners of one in this many deployment calls when deploy stats are on, the "
+              "profiles are logged as annotated plans whenever deploy stats are synced, 0 to disable");
+DEFINE_uint64(deploy_micro_batch_window_us, 0,
+              "coalesce the concurrent request mode calls of a deployment arriving within this many "
+              "microseconds into one batch request run, it also caps the latency added to a call, 0 to disable");
+DEFINE_uint32(deploy_micro_batch_max_size, 64, "run a micro batch of deployment calls once it has this many rows");
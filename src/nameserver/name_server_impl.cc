@@ -2310,6 +2310,9 @@ int NameServerImpl::CreateTableOnTablet(const std::shared_ptr<::openmldb::namese
     table_meta.set_format_version(table_info->format_version());
     table_meta.set_storage_mode(table_info->storage_mode());
     table_meta.set_base_table_tid(table_info->base_table_tid());
+    if (table_info->has_disk_option()) {
+        table_meta.mutable_disk_option()->CopyFrom(table_info->disk_option());
+    }
     if (table_info->has_key_entry_max_height()) {
         table_meta.set_key_entry_max_height(table_info->key_entry_max_height());
     }
@@ -4428,7 +4431,7 @@ int NameServerImpl::CreateAddReplicaOPTask(std::shared_ptr<OPData> op_data) {
     }
     op_data->task_list_.push_back(task);
     task = CreateLoadTableTask(request.endpoint(), op_index, ::openmldb::api::OPType::kAddReplicaOP, request.name(),
-                               tid, pid, seg_cnt, false, table_info->storage_mode());
+                               tid, pid, seg_cnt, false, table_info);
     if (!task) {
         PDLOG(WARNING, "create loadtable task failed. tid[%u] pid[%u]", tid, pid);
         return -1;
@@ -4679,7 +4682,7 @@ int NameServerImpl::CreateMigrateTask(std::shared_ptr<OPData> op_data) {
     }
     op_data->task_list_.push_back(task);
     task = CreateLoadTableTask(des_endpoint, op_index, ::openmldb::api::OPType::kMigrateOP, name, tid, pid,
-                               table_info->seg_cnt(), false, table_info->storage_mode());
+                               table_info->seg_cnt(), false, table_info);
     if (!task) {
         PDLOG(WARNING, "create loadtable task failed. tid[%u] pid[%u] endpoint[%s]", tid, pid, des_endpoint.c_str());
         return -1;
@@ -5936,7 +5939,7 @@ int NameServerImpl::CreateReAddReplicaTask(std::shared_ptr<OPData> op_data) {
     }
     op_data->task_list_.push_back(task);
     task = CreateLoadTableTask(endpoint, op_index, ::openmldb::api::OPType::kReAddReplicaOP, name, tid, pid, seg_cnt,
-                               false, table_info->storage_mode());
+                               false, table_info);
     if (!task) {
         PDLOG(WARNING, "create loadtable task failed. tid[%u] pid[%u]", tid, pid);
         return -1;
@@ -6060,7 +6063,7 @@ int NameServerImpl::CreateReAddReplicaWithDropTask(std::shared_ptr<OPData> op_da
     }
     op_data->task_list_.push_back(task);
     task = CreateLoadTableTask(endpoint, op_index, ::openmldb::api::OPType::kReAddReplicaWithDropOP, name, tid, pid,
-                               seg_cnt, false, table_info->storage_mode());
+                               seg_cnt, false, table_info);
     if (!task) {
         PDLOG(WARNING, "create loadtable task failed. tid[%u] pid[%u]", tid, pid);
         return -1;
@@ -6175,7 +6178,7 @@ int NameServerImpl::CreateReAddReplicaNoSendTask(std::shared_ptr<OPData> op_data
     }
     op_data->task_list_.push_back(task);
     task = CreateLoadTableTask(endpoint, op_index, ::openmldb::api::OPType::kReAddReplicaNoSendOP, name, tid, pid,
-                               seg_cnt, false, table_info->storage_mode());
+                               seg_cnt, false, table_info);
     if (!task) {
         PDLOG(WARNING, "create loadtable task failed. tid[%u] pid[%u]", tid, pid);
         return -1;
@@ -6542,7 +6545,7 @@ int NameServerImpl::CreateReLoadTableTask(std::shared_ptr<OPData> op_data) {
     uint32_t seg_cnt = table_info->seg_cnt();
     std::shared_ptr<Task> task =
         CreateLoadTableTask(endpoint, op_data->op_info_.op_id(), ::openmldb::api::OPType::kReLoadTableOP, name, tid,
-                            pid, seg_cnt, true, table_info->storage_mode());
+                            pid, seg_cnt, true, table_info);
     if (!task) {
         PDLOG(WARNING, "create loadtable task failed. tid[%u] pid[%u]", tid, pid);
         return -1;
@@ -6833,7 +6836,7 @@ std::shared_ptr<Task> NameServerImpl::CreateTableRemoteTask(const ::openmldb::na
 std::shared_ptr<Task> NameServerImpl::CreateLoadTableTask(const std::string& endpoint, uint64_t op_index,
                                                           ::openmldb::api::OPType op_type, const std::string& name,
                                                           uint32_t tid, uint32_t pid, uint32_t seg_cnt, bool is_leader,
-                                                          ::openmldb::common::StorageMode storage_mode) {
+                                                          const std::shared_ptr<TableInfo>& table_info) {
     std::shared_ptr<Task> task = std::make_shared<Task>(endpoint, std::make_shared<::openmldb::api::TaskInfo>());
     auto it = tablets_.find(endpoint);
     if (it == tablets_.end() || it->second->state_ != ::openmldb::type::EndpointState::kHealthy) {
@@ -6850,7 +6853,10 @@ std::shared_ptr<Task> NameServerImpl::CreateLoadTableTask(const std::string& end
     table_meta.set_tid(tid);
     table_meta.set_pid(pid);
     table_meta.set_seg_cnt(seg_cnt);
-    table_meta.set_storage_mode(storage_mode);
+    table_meta.set_storage_mode(table_info->storage_mode());
+    if (table_info->has_disk_option()) {
+        table_meta.mutable_disk_option()->CopyFrom(table_info->disk_option());
+    }
     if (is_leader) {
         table_meta.set_mode(::openmldb::api::TableMode::kTableLeader);
     } else {
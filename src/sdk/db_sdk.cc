@@ -25,6 +25,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -199,6 +200,8 @@ void ClusterSDK::CheckZk() {
     } else if (session_id_ != zk_client_->GetSessionTerm()) {
         LOG(WARNING) << "session changed, re-watch notify";
         WatchNotify();
+        ResetNodeWatches();
+        Refresh();
     }
     pool_.DelayTask(2000, [this] { CheckZk(); });
 }
@@ -297,55 +300,106 @@ bool ClusterSDK::GetTaskManagerAddress(std::string* endpoint, std::string* real_
     return true;
 }
 
+bool ClusterSDK::WatchNode(const std::string& path, std::string* value) {
+    return zk_client_->WatchItem(path, [this, path] { MarkNodeDirty(path); }, value);
+}
+
+void ClusterSDK::MarkNodeDirty(const std::string& path) {
+    std::lock_guard<std::mutex> lock(dirty_mu_);
+    dirty_nodes_.insert(path);
+}
+
+void ClusterSDK::ResetNodeWatches() {
+    std::lock_guard<std::mutex> build_lock(build_mu_);
+    for (const auto& kv : table_nodes_) {
+        zk_client_->CancelWatchItem(table_root_path_ + "/" + kv.first);
+    }
+    for (const auto& kv : sp_nodes_) {
+        zk_client_->CancelWatchItem(sp_root_path_ + "/" + kv.first);
+    }
+    table_nodes_.clear();
+    sp_nodes_.clear();
+    unresolved_tables_.clear();
+    // nodes removed while the watches were lost can not be found in the empty cache
+    rebuild_catalog_ = true;
+}
+
 // TODO(hw): refactor
 bool ClusterSDK::UpdateCatalog(const std::vector<std::string>& table_datas, const std::vector<std::string>& sp_datas) {
-    std::vector<::openmldb::nameserver::TableInfo> tables;
-    std::map<std::string, std::map<std::string, std::shared_ptr<::openmldb::nameserver::TableInfo>>> mapping;
-    auto new_catalog = std::make_shared<::openmldb::catalog::SDKCatalog>(client_manager_);
+    std::lock_guard<std::mutex> build_lock(build_mu_);
+    std::set<std::string> dirty_nodes;
+    {
+        std::lock_guard<std::mutex> lock(dirty_mu_);
+        dirty_nodes.swap(dirty_nodes_);
+    }
+    // node names of the tables which are new, modified or had an unresolved leader
+    std::set<std::string> changed_tables;
+    std::map<std::string, std::shared_ptr<::openmldb::nameserver::TableInfo>> table_nodes;
     for (const auto& table_data : table_datas) {
         if (table_data.empty()) continue;
+        std::string path = table_root_path_ + "/" + table_data;
+        auto it = table_nodes_.find(table_data);
+        if (it != table_nodes_.end() && dirty_nodes.count(path) == 0) {
+            table_nodes.emplace(table_data, it->second);
+            if (unresolved_tables_.count(table_data) > 0) {
+                changed_tables.insert(table_data);
+            }
+            continue;
+        }
         std::string value;
-        bool ok = zk_client_->GetNodeValue(table_root_path_ + "/" + table_data, value);
-        if (!ok) {
-            LOG(WARNING) << "fail to get table data " << table_root_path_ << "/" << table_data;
+        if (!WatchNode(path, &value)) {
+            LOG(WARNING) << "fail to get table data " << path;
+            // keep the last value and read the node again on the next refresh
+            MarkNodeDirty(path);
+            if (it != table_nodes_.end()) {
+                table_nodes.emplace(table_data, it->second);
+            }
             continue;
         }
-        std::shared_ptr<::openmldb::nameserver::TableInfo> table_info(new ::openmldb::nameserver::TableInfo());
-        ok = table_info->ParseFromString(value);
-        if (!ok) {
+        auto table_info = std::make_shared<::openmldb::nameserver::TableInfo>();
+        if (!table_info->ParseFromString(value)) {
             LOG(WARNING) << "fail to parse table proto with " << value;
             continue;
         }
         DLOG(INFO) << "parse table " << table_info->name() << " ok";
-        if (table_info->format_version() != 1) {
+        table_nodes.emplace(table_data, table_info);
+        changed_tables.insert(table_data);
+    }
+    // the tables of the last catalog which are removed or replaced
+    std::vector<std::pair<std::string, std::string>> removed_tables;
+    for (const auto& kv : table_nodes_) {
+        if (table_nodes.count(kv.first) == 0) {
+            zk_client_->CancelWatchItem(table_root_path_ + "/" + kv.first);
+        } else if (changed_tables.count(kv.first) == 0) {
             continue;
         }
-        tables.push_back(*(table_info));
-        auto it = mapping.find(table_info->db());
-        if (it == mapping.end()) {
-            std::map<std::string, std::shared_ptr<::openmldb::nameserver::TableInfo>> table_in_db;
-            table_in_db.insert(std::make_pair(table_info->name(), table_info));
-            mapping.insert(std::make_pair(table_info->db(), table_in_db));
-        } else {
-            it->second.insert(std::make_pair(table_info->name(), table_info));
-        }
-        DLOG(INFO) << "load table info with name " << table_info->name() << " in db " << table_info->db();
+        removed_tables.emplace_back(kv.second->db(), kv.second->name());
     }
 
-    Procedures db_sp_map;
+    bool sp_changed = false;
+    std::map<std::string, std::shared_ptr<hybridse::sdk::ProcedureInfo>> sp_nodes;
     for (const auto& node : sp_datas) {
         if (node.empty()) continue;
+        std::string path = sp_root_path_ + "/" + node;
+        auto it = sp_nodes_.find(node);
+        if (it != sp_nodes_.end() && dirty_nodes.count(path) == 0) {
+            sp_nodes.emplace(node, it->second);
+            continue;
+        }
         std::string value;
-        bool ok = zk_client_->GetNodeValue(sp_root_path_ + "/" + node, value);
-        if (!ok) {
+        if (!WatchNode(path, &value)) {
             LOG(WARNING) << "fail to get procedure data. node: " << node;
+            MarkNodeDirty(path);
+            if (it != sp_nodes_.end()) {
+                sp_nodes.emplace(node, it->second);
+            }
             continue;
         }
+        sp_changed = true;
         std::string uncompressed;
         ::snappy::Uncompress(value.c_str(), value.length(), &uncompressed);
         ::openmldb::api::ProcedureInfo sp_info_pb;
-        ok = sp_info_pb.ParseFromString(uncompressed);
-        if (!ok) {
+        if (!sp_info_pb.ParseFromString(uncompressed)) {
             LOG(WARNING) << "fail to parse procedure proto. node: " << node << " value: " << value;
             continue;
         }
@@ -356,26 +410,80 @@ bool ClusterSDK::UpdateCatalog(const std::vector<std::string>& table_datas, cons
                          << " db: " << sp_info_pb.db_name();
             continue;
         }
-        auto it = db_sp_map.find(sp_info->GetDbName());
-        if (it == db_sp_map.end()) {
-            std::map<std::string, std::shared_ptr<hybridse::sdk::ProcedureInfo>> sp_in_db = {
-                {sp_info->GetSpName(), sp_info}};
-            db_sp_map.insert(std::make_pair(sp_info->GetDbName(), sp_in_db));
-        } else {
-            it->second.insert(std::make_pair(sp_info->GetSpName(), sp_info));
+        sp_nodes.emplace(node, sp_info);
+    }
+    for (const auto& kv : sp_nodes_) {
+        if (sp_nodes.count(kv.first) == 0) {
+            zk_client_->CancelWatchItem(sp_root_path_ + "/" + kv.first);
+            sp_changed = true;
         }
+    }
+    if (changed_tables.empty() && removed_tables.empty() && !sp_changed && !rebuild_catalog_) {
+        DLOG(INFO) << "tables, procedures and tablets are not changed, keep the catalog";
+        return true;
+    }
+
+    // the tables to init, all of them if the catalog is built from scratch
+    std::vector<::openmldb::nameserver::TableInfo> tables;
+    std::map<std::string, std::map<std::string, std::shared_ptr<::openmldb::nameserver::TableInfo>>> mapping;
+    std::set<std::string> unresolved_tables;
+    for (const auto& kv : table_nodes) {
+        const auto& table_info = kv.second;
+        if (table_info->format_version() != 1) {
+            continue;
+        }
+        for (const auto& partition : table_info->table_partition()) {
+            for (const auto& meta : partition.partition_meta()) {
+                if (meta.is_leader() && meta.is_alive() && !client_manager_->GetTablet(meta.endpoint())) {
+                    unresolved_tables.insert(kv.first);
+                }
+            }
+        }
+        if (rebuild_catalog_ || changed_tables.count(kv.first) > 0) {
+            tables.push_back(*(table_info));
+        }
+        mapping[table_info->db()].insert(std::make_pair(table_info->name(), table_info));
+        DLOG(INFO) << "load table info with name " << table_info->name() << " in db " << table_info->db();
+    }
+
+    Procedures db_sp_map;
+    for (const auto& kv : sp_nodes) {
+        const auto& sp_info = kv.second;
+        db_sp_map[sp_info->GetDbName()].insert(std::make_pair(sp_info->GetSpName(), sp_info));
         DLOG(INFO) << "load procedure info with sp name " << sp_info->GetSpName() << " in db " << sp_info->GetDbName();
     }
-    if (!new_catalog->Init(tables, db_sp_map)) {
+    std::shared_ptr<::openmldb::catalog::SDKCatalog> new_catalog;
+    if (rebuild_catalog_) {
+        new_catalog = std::make_shared<::openmldb::catalog::SDKCatalog>(client_manager_);
+        if (!new_catalog->Init(tables, db_sp_map)) {
+            new_catalog.reset();
+        }
+    } else {
+        new_catalog = GetCatalog()->Apply(tables, removed_tables, db_sp_map);
+    }
+    if (!new_catalog) {
         LOG(WARNING) << "fail to init catalog";
+        // the changed nodes are not applied, read them again on the next refresh
+        std::lock_guard<std::mutex> lock(dirty_mu_);
+        dirty_nodes_.insert(dirty_nodes.begin(), dirty_nodes.end());
         return false;
     }
+    // the catalog is immutable once published, readers holding the last one are not affected
     {
         std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
         table_to_tablets_ = mapping;
         catalog_ = new_catalog;
+        cluster_version_.fetch_add(1, std::memory_order_release);
     }
     engine_->UpdateCatalog(new_catalog);
+    table_nodes_.swap(table_nodes);
+    sp_nodes_.swap(sp_nodes);
+    rebuild_catalog_ = false;
+    if (!unresolved_tables.empty()) {
+        LOG(WARNING) << unresolved_tables.size()
+                     << " tables have partition leaders without tablet client, rebuild them on the next refresh";
+    }
+    unresolved_tables_.swap(unresolved_tables);
     return true;
 }
 
@@ -397,6 +505,12 @@ bool ClusterSDK::InitTabletClient() {
     }
     // TODO(hw): update won't delete the old clients in mgr, should create a new mgr?
     client_manager_->UpdateClient(real_ep_map);
+    std::lock_guard<std::mutex> build_lock(build_mu_);
+    if (real_ep_map != tablet_endpoints_) {
+        // the partitions of the last catalog keep the accessors they were built with
+        rebuild_catalog_ = true;
+        tablet_endpoints_.swap(real_ep_map);
+    }
     return true;
 }
 
@@ -679,6 +793,7 @@ bool StandAloneSDK::BuildCatalog() {
         std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
         table_to_tablets_ = mapping;
         catalog_ = new_catalog;
+        cluster_version_.fetch_add(1, std::memory_order_release);
     }
     engine_->UpdateCatalog(new_catalog);
     return true;
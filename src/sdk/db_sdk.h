@@ -19,6 +19,8 @@
 
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -65,7 +67,8 @@ class DBSDK {
 
     bool Refresh() { return BuildCatalog(); }
 
-    inline uint64_t GetClusterVersion() { return cluster_version_.load(std::memory_order_relaxed); }
+    // bumped every time the catalog is replaced
+    inline uint64_t GetClusterVersion() { return cluster_version_.load(std::memory_order_acquire); }
 
     inline std::shared_ptr<::openmldb::catalog::SDKCatalog> GetCatalog() {
         std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
@@ -151,7 +154,14 @@ class ClusterSDK : public DBSDK {
 
  private:
     bool GetRealEndpointFromZk(const std::string& endpoint, std::string* real_endpoint);
+    // re-read the table and procedure nodes which are new or whose data watch fired, and apply them to a copy of
+    // the last catalog. the catalog is built from scratch if the tablets changed or the node watches were lost
     bool UpdateCatalog(const std::vector<std::string>& table_datas, const std::vector<std::string>& sp_datas);
+    // read the node and (re)arm the data watch on it in one zk call
+    bool WatchNode(const std::string& path, std::string* value);
+    void MarkNodeDirty(const std::string& path);
+    // the node watches are lost with the zk session, read every node again on the next build
+    void ResetNodeWatches();
     bool InitTabletClient();
     void WatchNotify();
     void CheckZk();
@@ -170,6 +180,21 @@ class ClusterSDK : public DBSDK {
 
     ::openmldb::zk::ZkClient* zk_client_;
     ::baidu::common::ThreadPool pool_;
+
+    // serializes catalog builds, guards the parsed nodes
+    std::mutex build_mu_;
+    // parsed table and procedure nodes of the last built catalog, by node name
+    std::map<std::string, std::shared_ptr<::openmldb::nameserver::TableInfo>> table_nodes_;
+    std::map<std::string, std::shared_ptr<hybridse::sdk::ProcedureInfo>> sp_nodes_;
+    // the real endpoints of the tablets the clients are created for, by endpoint
+    std::map<std::string, std::string> tablet_endpoints_;
+    // the partitions of the last catalog can not be reused, build the next one from scratch
+    bool rebuild_catalog_ = true;
+    // node names of the tables which had a partition leader without tablet client in the last catalog
+    std::set<std::string> unresolved_tables_;
+    // paths of the watched nodes changed or deleted since they were read, set by the zk event thread
+    std::mutex dirty_mu_;
+    std::set<std::string> dirty_nodes_;
 };
 
 class StandAloneSDK : public DBSDK {
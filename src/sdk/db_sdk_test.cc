@@ -113,6 +113,40 @@ TEST_F(DBSDKTest, smokeTest) {
     ASSERT_TRUE(sdk.Refresh());
 }
 
+TEST_F(DBSDKTest, incrementalRefresh) {
+    ClusterOptions option;
+    option.zk_cluster = mc_->GetZkCluster();
+    option.zk_path = mc_->GetZkPath();
+    ClusterSDK sdk(option);
+    ASSERT_TRUE(sdk.Init());
+
+    CreateTable();
+    ASSERT_TRUE(sdk.Refresh());
+    auto catalog = sdk.GetCatalog();
+    auto table_ptr = sdk.GetTableInfo(db_name_, table_name_);
+    ASSERT_TRUE(table_ptr);
+
+    // nothing changed, the catalog is kept
+    ASSERT_TRUE(sdk.Refresh());
+    ASSERT_EQ(catalog, sdk.GetCatalog());
+
+    // a new table rebuilds the catalog, the unchanged table info is reused
+    auto first_table = table_name_;
+    CreateTable();
+    ASSERT_TRUE(sdk.Refresh());
+    ASSERT_NE(catalog, sdk.GetCatalog());
+    ASSERT_TRUE(sdk.GetTableInfo(db_name_, table_name_));
+    ASSERT_EQ(table_ptr.get(), sdk.GetTableInfo(table_ptr->db(), first_table).get());
+
+    // a dropped table rebuilds the catalog too
+    catalog = sdk.GetCatalog();
+    std::string msg;
+    ASSERT_TRUE(mc_->GetNsClient()->DropTable(table_ptr->db(), first_table, msg)) << msg;
+    ASSERT_TRUE(sdk.Refresh());
+    ASSERT_NE(catalog, sdk.GetCatalog());
+    ASSERT_FALSE(sdk.GetTableInfo(table_ptr->db(), first_table));
+}
+
 // TODO(hw): StandAlone sdk can access cluster, but it's not a good test. Better to access StandAlone server.
 TEST_F(DBSDKTest, standAloneMode) {
     // mini cluster endpoints' ports are random, so we get the ns address first
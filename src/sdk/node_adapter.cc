@@ -71,6 +71,18 @@ bool NodeAdapter::TransformToTableDef(::hybridse::node::CreatePlanNode* create_n
                     storage_mode = dynamic_cast<hybridse::node::StorageModeNode *>(table_option)->GetStorageMode();
                     break;
                 }
+                case hybridse::node::kDiskOption: {
+                    auto disk_option = dynamic_cast<hybridse::node::DiskOptionNode*>(table_option);
+                    auto value = static_cast<uint32_t>(disk_option->GetValue());
+                    if (disk_option->GetName() == "block_size_kb") {
+                        table->mutable_disk_option()->set_block_size_kb(value);
+                    } else if (disk_option->GetName() == "write_buffer_mb") {
+                        table->mutable_disk_option()->set_write_buffer_mb(value);
+                    } else {
+                        table->mutable_disk_option()->set_block_cache_mb(value);
+                    }
+                    break;
+                }
                 case hybridse::node::kDistributions: {
                     auto d_list = dynamic_cast<hybridse::node::DistributionsNode*>(table_option)->GetDistributionList();
                     if (d_list != nullptr) {
@@ -105,6 +117,11 @@ bool NodeAdapter::TransformToTableDef(::hybridse::node::CreatePlanNode* create_n
 
     table->set_format_version(1);
     table->set_storage_mode(static_cast<common::StorageMode>(storage_mode));
+    if (table->has_disk_option() && storage_mode == hybridse::node::kMemory) {
+        status->msg = "disk options are only supported by SSD or HDD tables";
+        status->code = hybridse::common::kUnsupportSql;
+        return false;
+    }
     bool has_generate_index = false;
     for (auto column_desc : column_desc_list) {
         switch (column_desc->GetType()) {
@@ -155,5 +155,58 @@ std::shared_ptr<::hybridse::sdk::ResultSet> ResultSetSQL::MakeResultSet(
     return {};
 }
 
+bool ChunkedResultSetSQL::Reset() {
+    for (auto& chunk : chunks_) {
+        if (!chunk->Reset()) {
+            return false;
+        }
+    }
+    chunk_idx_ = 0;
+    return true;
+}
+
+bool ChunkedResultSetSQL::Next() {
+    while (!chunks_[chunk_idx_]->Next()) {
+        if (chunk_idx_ + 1 == chunks_.size() && !FetchChunk()) {
+            return false;
+        }
+        chunk_idx_++;
+    }
+    return true;
+}
+
+int32_t ChunkedResultSetSQL::Size() {
+    while (FetchChunk()) {
+    }
+    int32_t size = 0;
+    for (auto& chunk : chunks_) {
+        size += chunk->Size();
+    }
+    return size;
+}
+
+bool ChunkedResultSetSQL::FetchChunk() {
+    if (!has_more_) {
+        return false;
+    }
+    has_more_ = false;
+    std::shared_ptr<::openmldb::api::QueryResponse> response;
+    std::shared_ptr<brpc::Controller> cntl;
+    if (!fetcher_(cursor_id_, &response, &cntl)) {
+        LOG(WARNING) << "fail to fetch the next chunk of cursor " << cursor_id_ << ", the result is incomplete";
+        return false;
+    }
+    ::hybridse::sdk::Status status;
+    auto chunk = std::dynamic_pointer_cast<ResultSetSQL>(ResultSetSQL::MakeResultSet(response, cntl, &status));
+    if (!chunk) {
+        LOG(WARNING) << "fail to make the result set of cursor " << cursor_id_ << ": " << status.msg;
+        return false;
+    }
+    chunks_.push_back(chunk);
+    has_more_ = response->has_more();
+    cursor_id_ = response->cursor_id();
+    return true;
+}
+
 }  // namespace sdk
 }  // namespace openmldb
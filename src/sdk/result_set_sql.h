@@ -17,6 +17,7 @@
 #ifndef SRC_SDK_RESULT_SET_SQL_H_
 #define SRC_SDK_RESULT_SET_SQL_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -100,6 +101,64 @@ class ResultSetSQL : public ::hybridse::sdk::ResultSet {
     std::shared_ptr<butil::IOBuf> io_buf_;
 };
 
+// a batch query result returned by the tablet in chunks. the next chunk is only requested when the rows of the
+// fetched ones are consumed, so the tablet produces the result as fast as the client reads it. fetched chunks are
+// kept so that the result set can be reset
+class ChunkedResultSetSQL : public ::hybridse::sdk::ResultSet {
+ public:
+    // request the chunk following `cursor_id`, false on failure
+    using ChunkFetcher = std::function<bool(uint64_t cursor_id, std::shared_ptr<::openmldb::api::QueryResponse>*,
+                                            std::shared_ptr<brpc::Controller>*)>;
+
+    ChunkedResultSetSQL(const std::shared_ptr<ResultSetSQL>& first_chunk, uint64_t cursor_id, ChunkFetcher fetcher)
+        : chunks_({first_chunk}), chunk_idx_(0), has_more_(true), cursor_id_(cursor_id), fetcher_(std::move(fetcher)) {}
+    ~ChunkedResultSetSQL() {}
+
+    bool Reset() override;
+
+    bool Next() override;
+
+    bool IsNULL(int index) override { return chunks_[chunk_idx_]->IsNULL(index); }
+
+    bool GetString(uint32_t index, std::string* str) override { return chunks_[chunk_idx_]->GetString(index, str); }
+
+    bool GetBool(uint32_t index, bool* result) override { return chunks_[chunk_idx_]->GetBool(index, result); }
+
+    bool GetChar(uint32_t index, char* result) override { return chunks_[chunk_idx_]->GetChar(index, result); }
+
+    bool GetInt16(uint32_t index, int16_t* result) override { return chunks_[chunk_idx_]->GetInt16(index, result); }
+
+    bool GetInt32(uint32_t index, int32_t* result) override { return chunks_[chunk_idx_]->GetInt32(index, result); }
+
+    bool GetInt64(uint32_t index, int64_t* result) override { return chunks_[chunk_idx_]->GetInt64(index, result); }
+
+    bool GetFloat(uint32_t index, float* result) override { return chunks_[chunk_idx_]->GetFloat(index, result); }
+
+    bool GetDouble(uint32_t index, double* result) override { return chunks_[chunk_idx_]->GetDouble(index, result); }
+
+    bool GetDate(uint32_t index, int32_t* date) override { return chunks_[chunk_idx_]->GetDate(index, date); }
+
+    bool GetDate(uint32_t index, int32_t* year, int32_t* month, int32_t* day) override {
+        return chunks_[chunk_idx_]->GetDate(index, year, month, day);
+    }
+
+    bool GetTime(uint32_t index, int64_t* mills) override { return chunks_[chunk_idx_]->GetTime(index, mills); }
+
+    const ::hybridse::sdk::Schema* GetSchema() override { return chunks_[0]->GetSchema(); }
+
+    // fetches all the chunks left
+    int32_t Size() override;
+
+ private:
+    bool FetchChunk();
+
+    std::vector<std::shared_ptr<ResultSetSQL>> chunks_;
+    size_t chunk_idx_;
+    bool has_more_;
+    uint64_t cursor_id_;
+    ChunkFetcher fetcher_;
+};
+
 class MultipleResultSetSQL : public ::hybridse::sdk::ResultSet {
  public:
     explicit MultipleResultSetSQL(const std::vector<std::shared_ptr<ResultSetSQL>>& result_set_list,
@@ -24,6 +24,7 @@
 #include <utility>
 
 #include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/strip.h"
 #include "base/ddl_parser.h"
@@ -1136,12 +1137,74 @@ std::shared_ptr<::hybridse::sdk::ResultSet> SQLClusterRouter::ExecuteSQLParamete
     DLOG(INFO) << " send query to tablet " << client->GetEndpoint();
     auto response = std::make_shared<::openmldb::api::QueryResponse>();
     if (!client->Query(db, sql, parameter_types, parameter ? parameter->GetRow() : "", cntl.get(), response.get(),
-                       options_.enable_debug)) {
+                       options_.enable_debug, false, true)) {
         status->msg = response->msg();
         status->code = -1;
         return {};
     }
-    return ResultSetSQL::MakeResultSet(response, cntl, status);
+    auto rs = ResultSetSQL::MakeResultSet(response, cntl, status);
+    if (!rs || !response->has_more()) {
+        return rs;
+    }
+    // the rest of the result is fetched from the same tablet as it is read
+    auto timeout = options_.request_timeout;
+    auto fetcher = [client, timeout](uint64_t cursor_id, std::shared_ptr<::openmldb::api::QueryResponse>* chunk,
+                                     std::shared_ptr<::brpc::Controller>* chunk_cntl) {
+        *chunk_cntl = std::make_shared<::brpc::Controller>();
+        (*chunk_cntl)->set_timeout_ms(timeout);
+        *chunk = std::make_shared<::openmldb::api::QueryResponse>();
+        return client->QueryChunk(cursor_id, chunk_cntl->get(), chunk->get());
+    };
+    return std::make_shared<ChunkedResultSetSQL>(std::dynamic_pointer_cast<ResultSetSQL>(rs), response->cursor_id(),
+                                                 fetcher);
+}
+
+// EXPLAIN ANALYZE is not in the sql grammar, get the query following it, false if sql is not one
+static bool ConsumeExplainAnalyze(absl::string_view sql, std::string* query) {
+    constexpr absl::string_view kExplain = "explain";
+    constexpr absl::string_view kAnalyze = "analyze";
+    sql = absl::StripLeadingAsciiWhitespace(sql);
+    if (!absl::StartsWithIgnoreCase(sql, kExplain)) {
+        return false;
+    }
+    sql.remove_prefix(kExplain.size());
+    auto analyze = absl::StripLeadingAsciiWhitespace(sql);
+    if (analyze.size() == sql.size() || !absl::StartsWithIgnoreCase(analyze, kAnalyze)) {
+        return false;
+    }
+    analyze.remove_prefix(kAnalyze.size());
+    auto query_sql = absl::StripLeadingAsciiWhitespace(analyze);
+    if (query_sql.size() == analyze.size()) {
+        return false;
+    }
+    query->assign(query_sql.data(), query_sql.size());
+    return true;
+}
+
+std::shared_ptr<hybridse::sdk::ResultSet> SQLClusterRouter::ExplainAnalyze(const std::string& db,
+                                                                           const std::string& sql,
+                                                                           ::hybridse::sdk::Status* status) {
+    if (status == nullptr) {
+        return {};
+    }
+    auto client = GetTabletClientForBatchQuery(db, sql, std::shared_ptr<openmldb::sdk::SQLRequestRow>(), status);
+    if (!status->IsOK() || !client) {
+        status->msg = absl::StrCat("no tablet available for sql", status->msg);
+        status->code = -1;
+        return {};
+    }
+    auto cntl = std::make_shared<::brpc::Controller>();
+    cntl->set_timeout_ms(options_.request_timeout);
+    ::openmldb::api::QueryResponse response;
+    if (!client->Query(db, sql, std::vector<openmldb::type::DataType>(), "", cntl.get(), &response,
+                       options_.enable_debug, true)) {
+        status->msg = response.msg();
+        status->code = -1;
+        return {};
+    }
+    *status = {};
+    std::vector<std::string> value = {absl::StrCat(response.profile(), "\nOUTPUT ROWS ", response.count(), "\n")};
+    return ResultSetSQL::MakeResultSet({FORMAT_STRING_KEY}, {value}, status);
 }
 
 std::shared_ptr<hybridse::sdk::ResultSet> SQLClusterRouter::ExecuteSQLBatchRequest(
@@ -2292,6 +2355,14 @@ std::shared_ptr<hybridse::sdk::ResultSet> SQLClusterRouter::ExecuteSQL(const std
     if (status == nullptr) {
         return {};
     }
+    std::string analyze_sql;
+    if (ConsumeExplainAnalyze(sql, &analyze_sql)) {
+        if (cluster_sdk_->IsClusterMode() && !IsOnlineMode()) {
+            *status = {::hybridse::common::StatusCode::kCmdError, "EXPLAIN ANALYZE is only supported in online mode"};
+            return {};
+        }
+        return ExplainAnalyze(db, analyze_sql, status);
+    }
     hybridse::node::NodeManager node_manager;
     hybridse::node::PlanNodeList plan_trees;
     hybridse::base::Status sql_status;
@@ -171,6 +171,11 @@ class SQLClusterRouter : public SQLRouter {
                                                                      std::shared_ptr<SQLRequestRowBatch> row_batch,
                                                                      ::hybridse::sdk::Status* status) override;
 
+    /// Run the query online with runtime profiling, the result is the plan annotated with the time and output rows
+    /// of each runner. `EXPLAIN ANALYZE <query>` executed in online mode calls it
+    std::shared_ptr<hybridse::sdk::ResultSet> ExplainAnalyze(const std::string& db, const std::string& sql,
+                                                             ::hybridse::sdk::Status* status);
+
     /// utility functions to query registered components in the current DBMS
     //
     /// \param status result status, will set status.code to error if error happens
@@ -22,9 +22,11 @@
 #include <vector>
 
 #include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
 #include "base/file_util.h"
 #include "base/glog_wapper.h"
 #include "codec/fe_row_codec.h"
+#include "codec/schema_codec.h"
 #include "common/timer.h"
 #include "gflags/gflags.h"
 #include "gtest/gtest.h"
@@ -34,6 +36,11 @@
 #include "sdk/sql_sdk_test.h"
 #include "vm/catalog.h"
 
+DECLARE_bool(enable_proxy_prefetch);
+DECLARE_bool(enable_column_pushdown);
+DECLARE_uint64(deploy_tiered_compile_threshold);
+DECLARE_uint32(scan_max_bytes_size);
+
 namespace openmldb {
 namespace sdk {
 
@@ -600,6 +607,307 @@ TEST_F(SQLClusterTest, Aggregator) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(SQLClusterTest, AggregatorDistinctCount) {
+    SQLRouterOptions sql_opt;
+    sql_opt.zk_cluster = mc_->GetZkCluster();
+    sql_opt.zk_path = mc_->GetZkPath();
+    auto router = NewClusterSQLRouter(sql_opt);
+    SetOnlineMode(router);
+    ASSERT_TRUE(router != nullptr);
+    std::string base_table = "t" + GenRand();
+    std::string base_db = "d" + GenRand();
+    ::hybridse::sdk::Status status;
+    bool ok = router->CreateDB(base_db, &status);
+    ASSERT_TRUE(ok);
+    std::string ddl = "create table " + base_table +
+                      "(col1 string, col2 string, col3 timestamp, col4 bigint) "
+                      "options(partitionnum=8);";
+    ok = router->ExecuteDDL(base_db, ddl, &status);
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(router->RefreshCatalog());
+
+    std::string deploy_sql = "deploy test_aggr options(long_windows='w1:2') select col1, col2,"
+                             " distinct_count(col4) over w1 as w1_distinct_col4 from " + base_table +
+                             " WINDOW w1 AS (PARTITION BY col1,col2 ORDER BY col3"
+                             " ROWS BETWEEN 100 PRECEDING AND CURRENT ROW);";
+    router->ExecuteSQL(base_db, "use " + base_db + ";", &status);
+    router->ExecuteSQL(base_db, deploy_sql, &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+
+    std::string pre_aggr_db = openmldb::nameserver::PRE_AGG_DB;
+    for (int i = 1; i <= 11; i++) {
+        std::string insert = "insert into " + base_table + " values('str1', 'str2', " +
+                             std::to_string(i) + ", " + std::to_string(i % 5) + ");";
+        ok = router->ExecuteInsert(base_db, insert, &status);
+        ASSERT_TRUE(ok);
+    }
+    std::string aggr_table = "pre_" + base_db + "_test_aggr_w1_distinct_count_col4";
+    auto rs = router->ExecuteSQL(pre_aggr_db, "select * from " + aggr_table + ";", &status);
+    ASSERT_EQ(5, rs->Size());
+
+    // the buckets and the raw rows are merged into one sketch, which is exact for so few values
+    auto request_row = router->GetRequestRowByProcedure(base_db, "test_aggr", &status);
+    ASSERT_TRUE(request_row != nullptr);
+    request_row->Init(8);
+    request_row->AppendString("str1");
+    request_row->AppendString("str2");
+    request_row->AppendTimestamp(12);
+    request_row->AppendInt64(7);
+    ASSERT_TRUE(request_row->Build());
+    rs = router->CallProcedure(base_db, "test_aggr", request_row, &status);
+    ASSERT_TRUE(rs != nullptr) << status.msg;
+    ASSERT_EQ(1, rs->Size());
+    ASSERT_TRUE(rs->Next());
+    ASSERT_EQ(6, rs->GetInt64Unsafe(2));
+
+    std::string msg;
+    ASSERT_TRUE(mc_->GetNsClient()->DropProcedure(base_db, "test_aggr", msg));
+    ok = router->ExecuteDDL(pre_aggr_db, "drop table " + aggr_table + ";", &status);
+    ASSERT_TRUE(ok);
+    ok = router->ExecuteDDL(base_db, "drop table " + base_table + ";", &status);
+    ASSERT_TRUE(ok);
+    ok = router->DropDB(base_db, &status);
+    ASSERT_TRUE(ok);
+}
+
+// the two last joins are remote tasks fed by the request row only, so they are prefetched at once.
+// identical request rows of a batch share the sub queries of a task
+TEST_F(SQLClusterTest, ClusterRequestIndependentRemoteTasks) {
+    SQLRouterOptions sql_opt;
+    sql_opt.zk_cluster = mc_->GetZkCluster();
+    sql_opt.zk_path = mc_->GetZkPath();
+    auto router = NewClusterSQLRouter(sql_opt);
+    ASSERT_TRUE(router != nullptr);
+    SetOnlineMode(router);
+    std::string db = "d" + GenRand();
+    ::hybridse::sdk::Status status;
+    ASSERT_TRUE(router->CreateDB(db, &status));
+    std::vector<std::string> tables = {"t1", "t2", "t3"};
+    for (auto& table : tables) {
+        std::string ddl = "create table " + table +
+                          "(col1 string, col2 string, col3 timestamp, col4 bigint, index(key=col1, ts=col3)) "
+                          "options(partitionnum=8);";
+        ASSERT_TRUE(router->ExecuteDDL(db, ddl, &status)) << status.msg;
+    }
+    ASSERT_TRUE(router->RefreshCatalog());
+    std::vector<std::string> inserts = {
+        "insert into t2 values('k1', 'x', 1, 10);",  "insert into t2 values('k1', 'x', 2, 20);",
+        "insert into t2 values('k2', 'x', 1, 30);",  "insert into t3 values('k1', 'x', 1, 100);",
+        "insert into t3 values('k2', 'x', 2, 200);", "insert into t3 values('k2', 'x', 1, 300);",
+    };
+    for (auto& insert : inserts) {
+        ASSERT_TRUE(router->ExecuteInsert(db, insert, &status)) << status.msg;
+    }
+
+    std::string sql =
+        "select t1.col1, t2.col4 as v2, t3.col4 as v3 from t1 "
+        "last join t2 order by t2.col3 on t1.col2 = t2.col1 "
+        "last join t3 order by t3.col3 on t1.col2 = t3.col1;";
+    auto build_request_row = [&](const std::string& col1, const std::string& col2) {
+        auto request_row = router->GetRequestRow(db, sql, &status);
+        EXPECT_TRUE(request_row != nullptr) << status.msg;
+        request_row->Init(col1.size() + col2.size());
+        request_row->AppendString(col1);
+        request_row->AppendString(col2);
+        request_row->AppendTimestamp(100);
+        request_row->AppendInt64(1);
+        EXPECT_TRUE(request_row->Build());
+        return request_row;
+    };
+    bool prefetch = FLAGS_enable_proxy_prefetch;
+    for (bool enable_prefetch : {true, false}) {
+        FLAGS_enable_proxy_prefetch = enable_prefetch;
+        auto rs = router->ExecuteSQLRequest(db, sql, build_request_row("r1", "k1"), &status);
+        ASSERT_TRUE(rs != nullptr) << status.msg;
+        ASSERT_EQ(1, rs->Size());
+        ASSERT_TRUE(rs->Next());
+        ASSERT_EQ(20, rs->GetInt64Unsafe(1));
+        ASSERT_EQ(100, rs->GetInt64Unsafe(2));
+
+        auto request_row = build_request_row("r1", "k1");
+        auto row_batch = std::make_shared<SQLRequestRowBatch>(
+            request_row->GetSchema(), std::make_shared<ColumnIndicesSet>(request_row->GetSchema()));
+        ASSERT_TRUE(row_batch->AddRow(request_row));
+        ASSERT_TRUE(row_batch->AddRow(build_request_row("r1", "k1")));
+        ASSERT_TRUE(row_batch->AddRow(build_request_row("r2", "k2")));
+        ASSERT_TRUE(row_batch->AddRow(build_request_row("r3", "k3")));
+        rs = router->ExecuteSQLBatchRequest(db, sql, row_batch, &status);
+        ASSERT_TRUE(rs != nullptr) << status.msg;
+        ASSERT_EQ(4, rs->Size());
+        std::vector<std::pair<int64_t, int64_t>> expected = {{20, 100}, {20, 100}, {30, 200}};
+        for (auto& values : expected) {
+            ASSERT_TRUE(rs->Next());
+            ASSERT_EQ(values.first, rs->GetInt64Unsafe(1));
+            ASSERT_EQ(values.second, rs->GetInt64Unsafe(2));
+        }
+        // no right row of the key
+        ASSERT_TRUE(rs->Next());
+        ASSERT_TRUE(rs->IsNULL(1));
+        ASSERT_TRUE(rs->IsNULL(2));
+    }
+    FLAGS_enable_proxy_prefetch = prefetch;
+
+    for (auto& table : tables) {
+        ASSERT_TRUE(router->ExecuteDDL(db, "drop table " + table + ";", &status)) << status.msg;
+    }
+    ASSERT_TRUE(router->DropDB(db, &status));
+}
+
+TEST_F(SQLClusterTest, ColumnPushdownOnCompressedTable) {
+    SQLRouterOptions sql_opt;
+    sql_opt.zk_cluster = mc_->GetZkCluster();
+    sql_opt.zk_path = mc_->GetZkPath();
+    auto router = NewClusterSQLRouter(sql_opt);
+    ASSERT_TRUE(router != nullptr);
+    SetOnlineMode(router);
+    std::string db = "d" + GenRand();
+    std::string name = "t" + GenRand();
+    ::hybridse::sdk::Status status;
+    ASSERT_TRUE(router->CreateDB(db, &status));
+    // there is no sql syntax for compression, create the table through the nameserver
+    ::openmldb::nameserver::TableInfo table_info;
+    table_info.set_format_version(1);
+    table_info.set_db(db);
+    table_info.set_name(name);
+    table_info.set_partition_num(8);
+    table_info.set_replica_num(1);
+    table_info.set_compress_type(::openmldb::type::kSnappy);
+    ::openmldb::codec::SchemaCodec::SetColumnDesc(table_info.add_column_desc(), "col1", ::openmldb::type::kString);
+    ::openmldb::codec::SchemaCodec::SetColumnDesc(table_info.add_column_desc(), "col2", ::openmldb::type::kString);
+    ::openmldb::codec::SchemaCodec::SetColumnDesc(table_info.add_column_desc(), "col3", ::openmldb::type::kTimestamp);
+    ::openmldb::codec::SchemaCodec::SetColumnDesc(table_info.add_column_desc(), "col4", ::openmldb::type::kBigInt);
+    ::openmldb::codec::SchemaCodec::SetIndex(table_info.add_column_key(), "index0", "col1", "col3",
+                                             ::openmldb::type::kAbsoluteTime, 0, 0);
+    std::string msg;
+    ASSERT_TRUE(mc_->GetNsClient()->CreateTable(table_info, false, msg)) << msg;
+    ASSERT_TRUE(router->RefreshCatalog());
+    for (int i = 0; i < 10; i++) {
+        std::string insert = absl::StrCat("insert into ", name, " values('k", i % 5, "', 'x', ", i, ", ", i, ");");
+        ASSERT_TRUE(router->ExecuteInsert(db, insert, &status)) << status.msg;
+    }
+
+    std::string window_sql = absl::StrCat("select col1, sum(col4) over w as w_sum from ", name,
+                                          " window w as (partition by col1 order by col3 "
+                                          "rows between 10 preceding and current row);");
+    bool pushdown = FLAGS_enable_column_pushdown;
+    FLAGS_enable_column_pushdown = true;
+    auto rs = router->ExecuteSQL(db, absl::StrCat("select col1, col4 from ", name, ";"), &status);
+    ASSERT_TRUE(rs != nullptr) << status.msg;
+    ASSERT_EQ(10, rs->Size());
+    int64_t total = 0;
+    while (rs->Next()) {
+        total += rs->GetInt64Unsafe(1);
+    }
+    ASSERT_EQ(45, total);
+
+    for (int i = 0; i < 5; i++) {
+        auto request_row = router->GetRequestRow(db, window_sql, &status);
+        ASSERT_TRUE(request_row != nullptr) << status.msg;
+        std::string key = absl::StrCat("k", i);
+        request_row->Init(key.size() + 1);
+        request_row->AppendString(key);
+        request_row->AppendString("x");
+        request_row->AppendTimestamp(100);
+        request_row->AppendInt64(100);
+        ASSERT_TRUE(request_row->Build());
+        rs = router->ExecuteSQLRequest(db, window_sql, request_row, &status);
+        ASSERT_TRUE(rs != nullptr) << status.msg;
+        ASSERT_EQ(1, rs->Size());
+        ASSERT_TRUE(rs->Next());
+        // rows i and i + 5 share the key
+        ASSERT_EQ(100 + i + i + 5, rs->GetInt64Unsafe(1));
+    }
+    FLAGS_enable_column_pushdown = pushdown;
+
+    ASSERT_TRUE(router->ExecuteDDL(db, "drop table " + name + ";", &status)) << status.msg;
+    ASSERT_TRUE(router->DropDB(db, &status));
+}
+
+// a hot procedure is recompiled in the background and its compile infos are swapped
+TEST_F(SQLClusterTest, TieredCompileHotProcedure) {
+    SQLRouterOptions sql_opt;
+    sql_opt.zk_cluster = mc_->GetZkCluster();
+    sql_opt.zk_path = mc_->GetZkPath();
+    auto router = NewClusterSQLRouter(sql_opt);
+    ASSERT_TRUE(router != nullptr);
+    SetOnlineMode(router);
+    std::string db = "d" + GenRand();
+    std::string name = "t" + GenRand();
+    ::hybridse::sdk::Status status;
+    ASSERT_TRUE(router->CreateDB(db, &status));
+    std::string ddl = "create table " + name +
+                      "(col1 string, col2 timestamp, col3 bigint, index(key=col1, ts=col2)) "
+                      "options(partitionnum=1, replicanum=1);";
+    ASSERT_TRUE(router->ExecuteDDL(db, ddl, &status)) << status.msg;
+    ASSERT_TRUE(router->RefreshCatalog());
+    for (int i = 1; i <= 5; i++) {
+        std::string insert = absl::StrCat("insert into ", name, " values('k1', ", i, ", ", i, ");");
+        ASSERT_TRUE(router->ExecuteInsert(db, insert, &status)) << status.msg;
+    }
+    std::string sp_name = "sp" + GenRand();
+    router->ExecuteSQL(db, "use " + db + ";", &status);
+    router->ExecuteSQL(db,
+                       absl::StrCat("deploy ", sp_name, " select col1, sum(col3) over w as w_sum from ", name,
+                                    " window w as (partition by col1 order by col2 "
+                                    "rows between 3 preceding and current row);"),
+                       &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+
+    auto call = [&]() -> int64_t {
+        auto request_row = router->GetRequestRowByProcedure(db, sp_name, &status);
+        EXPECT_TRUE(request_row != nullptr) << status.msg;
+        request_row->Init(2);
+        request_row->AppendString("k1");
+        request_row->AppendTimestamp(10);
+        request_row->AppendInt64(100);
+        EXPECT_TRUE(request_row->Build());
+        auto rs = router->CallProcedure(db, sp_name, request_row, &status);
+        EXPECT_TRUE(rs != nullptr) << status.msg;
+        if (rs == nullptr || !rs->Next()) {
+            return -1;
+        }
+        return rs->GetInt64Unsafe(1);
+    };
+    auto request_infos = [&]() {
+        std::vector<std::shared_ptr<::hybridse::vm::CompileInfo>> infos;
+        for (auto& endpoint : mc_->GetTbEndpoint()) {
+            ::hybridse::base::Status get_status;
+            infos.push_back(mc_->GetTablet(endpoint)->GetSpCache()->GetRequestInfo(db, sp_name, get_status));
+        }
+        return infos;
+    };
+
+    uint64_t threshold = FLAGS_deploy_tiered_compile_threshold;
+    FLAGS_deploy_tiered_compile_threshold = 3;
+    auto infos = request_infos();
+    // 100 + 5 + 4 + 3
+    ASSERT_EQ(112, call());
+    ASSERT_EQ(112, call());
+    // no recompile below the threshold
+    ASSERT_TRUE(infos == request_infos());
+    ASSERT_EQ(112, call());
+    bool swapped = false;
+    for (int i = 0; i < 100 && !swapped; i++) {
+        swapped = infos != request_infos();
+        if (!swapped) {
+            absl::SleepFor(absl::Milliseconds(50));
+        }
+    }
+    ASSERT_TRUE(swapped);
+    auto optimized_infos = request_infos();
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(112, call());
+    }
+    // recompiled once
+    ASSERT_TRUE(optimized_infos == request_infos());
+    FLAGS_deploy_tiered_compile_threshold = threshold;
+
+    std::string msg;
+    ASSERT_TRUE(mc_->GetNsClient()->DropProcedure(db, sp_name, msg)) << msg;
+    ASSERT_TRUE(router->ExecuteDDL(db, "drop table " + name + ";", &status)) << status.msg;
+    ASSERT_TRUE(router->DropDB(db, &status));
+}
+
 TEST_F(SQLClusterTest, PreAggrTableExist) {
     SQLRouterOptions sql_opt;
     sql_opt.zk_cluster = mc_->GetZkCluster();
@@ -992,6 +1300,91 @@ TEST_F(SQLClusterTest, ClusterSelect) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(SQLClusterTest, ChunkedSelect) {
+    SQLRouterOptions sql_opt;
+    sql_opt.zk_cluster = mc_->GetZkCluster();
+    sql_opt.zk_path = mc_->GetZkPath();
+    auto router = NewClusterSQLRouter(sql_opt);
+    ASSERT_TRUE(router != nullptr);
+    SetOnlineMode(router);
+    std::string table = "test" + GenRand();
+    std::string db = "db" + GenRand();
+    ::hybridse::sdk::Status status;
+    ASSERT_TRUE(router->CreateDB(db, &status));
+    std::string ddl = "create table " + table +
+                      "("
+                      "col1 string, col2 bigint,"
+                      "index(key=col1, ts=col2)) options(partitionnum=1, replicanum=1);";
+    ASSERT_TRUE(router->ExecuteDDL(db, ddl, &status));
+    ASSERT_TRUE(router->RefreshCatalog());
+    for (int i = 0; i < 5; i++) {
+        std::string insert = "insert into " + table + " values('key', " + std::to_string(1000 + i) + ");";
+        ASSERT_TRUE(router->ExecuteInsert(db, insert, &status));
+    }
+
+    gflags::FlagSaver saver;
+    // every chunk holds one row
+    FLAGS_scan_max_bytes_size = 1;
+    auto res = router->ExecuteSQL(db, "select col2 from " + table + ";", &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    ASSERT_TRUE(res);
+    std::vector<int64_t> values;
+    while (res->Next()) {
+        values.push_back(res->GetInt64Unsafe(0));
+    }
+    ASSERT_EQ(5u, values.size());
+    ASSERT_EQ(5, res->Size());
+    // the fetched chunks are kept, the result is read again without any request
+    ASSERT_TRUE(res->Reset());
+    for (auto value : values) {
+        ASSERT_TRUE(res->Next());
+        ASSERT_EQ(value, res->GetInt64Unsafe(0));
+    }
+    ASSERT_FALSE(res->Next());
+
+    ASSERT_TRUE(router->ExecuteDDL(db, "drop table " + table + ";", &status));
+    ASSERT_TRUE(router->DropDB(db, &status));
+}
+
+TEST_F(SQLClusterTest, ExplainAnalyze) {
+    SQLRouterOptions sql_opt;
+    sql_opt.zk_cluster = mc_->GetZkCluster();
+    sql_opt.zk_path = mc_->GetZkPath();
+    auto router = NewClusterSQLRouter(sql_opt);
+    ASSERT_TRUE(router != nullptr);
+    SetOnlineMode(router);
+    std::string table = "test" + GenRand();
+    std::string db = "db" + GenRand();
+    ::hybridse::sdk::Status status;
+    ASSERT_TRUE(router->CreateDB(db, &status));
+    std::string ddl = "create table " + table +
+                      "("
+                      "col1 string, col2 bigint,"
+                      "index(key=col1, ts=col2)) options(partitionnum=1, replicanum=1);";
+    ASSERT_TRUE(router->ExecuteDDL(db, ddl, &status));
+    ASSERT_TRUE(router->RefreshCatalog());
+    ASSERT_TRUE(router->ExecuteInsert(db, "insert into " + table + " values('helloworld', 1024);", &status));
+    ASSERT_TRUE(router->ExecuteInsert(db, "insert into " + table + " values('helloworld', 1025);", &status));
+
+    auto res = router->ExecuteSQL(db, "EXPLAIN  analyze\nselect col1, col2 + 1 as c2 from " + table + ";", &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    ASSERT_TRUE(res);
+    ASSERT_EQ(1, res->Size());
+    ASSERT_TRUE(res->Next());
+    std::string profile = res->GetStringUnsafe(0);
+    ASSERT_NE(std::string::npos, profile.find("PROFILED RUNS 1")) << profile;
+    ASSERT_NE(std::string::npos, profile.find("OUTPUT ROWS 2")) << profile;
+
+    // EXPLAIN without ANALYZE still only prints the plan
+    res = router->ExecuteSQL(db, "explain select col1 from " + table + ";", &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    ASSERT_TRUE(res->Next());
+    ASSERT_EQ(std::string::npos, res->GetStringUnsafe(0).find("PROFILED RUNS"));
+
+    ASSERT_TRUE(router->ExecuteDDL(db, "drop table " + table + ";", &status));
+    ASSERT_TRUE(router->DropDB(db, &status));
+}
+
 }  // namespace sdk
 }  // namespace openmldb
 
@@ -437,13 +437,14 @@ bool SQLRequestRowBatch::AddRow(std::shared_ptr<SQLRequestRow> row) {
         return false;
     }
     const std::string& row_str = row->GetRow();
-    int8_t* input_buf = reinterpret_cast<int8_t*>(const_cast<char*>(&row_str[0]));
-    size_t input_size = row_str.size();
+    return AddRow(reinterpret_cast<const int8_t*>(row_str.data()), row_str.size());
+}
 
+bool SQLRequestRowBatch::AddRow(const int8_t* input_buf, size_t input_size) {
     // non-common
     if (common_column_indices_.empty() ||
         common_column_indices_.size() == static_cast<size_t>(request_schema_.size())) {
-        non_common_slices_.emplace_back(std::string(reinterpret_cast<char*>(input_buf), input_size));
+        non_common_slices_.emplace_back(std::string(reinterpret_cast<const char*>(input_buf), input_size));
         return true;
     }
 
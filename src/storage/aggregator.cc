@@ -23,6 +23,7 @@
 #include "base/glog_wapper.h"
 #include "base/slice.h"
 #include "base/strings.h"
+#include "base/hyper_log_log.h"
 #include "common/timer.h"
 #include "storage/aggregator.h"
 #include "storage/table.h"
@@ -145,7 +146,7 @@ bool Aggregator::Update(const std::string& key, const std::string& row, const ui
 
     // init buffer timestamp range
     if (aggr_buffer.ts_begin_ == -1) {
-        aggr_buffer.data_type_ = aggr_col_type_;
+        aggr_buffer.data_type_ = GetAggrValType();
         aggr_buffer.ts_begin_ = cur_ts;
         if (window_type_ == WindowType::kRowsRange) {
             aggr_buffer.ts_end_ = cur_ts + window_size_ - 1;
@@ -363,7 +364,7 @@ bool Aggregator::GetAggrBufferFromRowView(const codec::RowView& row_view, const
     if (buffer == nullptr) {
         return false;
     }
-    buffer->data_type_ = aggr_col_type_;
+    buffer->data_type_ = GetAggrValType();
     row_view.GetValue(row_ptr, 1, DataType::kTimestamp, &buffer->ts_begin_);
     row_view.GetValue(row_ptr, 2, DataType::kTimestamp, &buffer->ts_end_);
     row_view.GetValue(row_ptr, 3, DataType::kInt, &buffer->aggr_cnt_);
@@ -390,7 +391,8 @@ bool Aggregator::FlushAggrBuffer(const std::string& key, const std::string& filt
     row_builder_.SetTimestamp(row_ptr, 1, buffer.ts_begin_);
     row_builder_.SetTimestamp(row_ptr, 2, buffer.ts_end_);
     row_builder_.SetInt32(row_ptr, 3, buffer.aggr_cnt_);
-    if ((aggr_type_ == AggrType::kMax || aggr_type_ == AggrType::kMin) && buffer.AggrValEmpty()) {
+    if ((aggr_type_ == AggrType::kMax || aggr_type_ == AggrType::kMin || aggr_type_ == AggrType::kDistinctCount) &&
+        buffer.AggrValEmpty()) {
         row_builder_.SetNULL(row_ptr, row_size, 4);
     } else {
         row_builder_.SetString(row_ptr, row_size, 4, aggr_val.c_str(), aggr_val.size());
@@ -981,6 +983,109 @@ bool AvgAggregator::DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) {
     return true;
 }
 
+DistinctCountAggregator::DistinctCountAggregator(const ::openmldb::api::TableMeta& base_meta,
+                                                 const ::openmldb::api::TableMeta& aggr_meta,
+                                                 std::shared_ptr<Table> aggr_table,
+                                                 std::shared_ptr<LogReplicator> aggr_replicator,
+                                                 const uint32_t& index_pos, const std::string& aggr_col,
+                                                 const AggrType& aggr_type, const std::string& ts_col,
+                                                 WindowType window_tpye, uint32_t window_size)
+    : Aggregator(base_meta, aggr_meta, aggr_table, aggr_replicator, index_pos, aggr_col, aggr_type, ts_col, window_tpye,
+                 window_size) {}
+
+bool DistinctCountAggregator::UpdateAggrVal(const codec::RowView& row_view, const int8_t* row_ptr,
+                                            AggrBuffer* aggr_buffer) {
+    if (row_view.IsNULL(row_ptr, aggr_col_idx_)) {
+        return true;
+    }
+    // hash over the bytes of the value in its column type, the same as the request time merge
+    uint64_t hash = 0;
+    switch (aggr_col_type_) {
+        case DataType::kSmallInt: {
+            int16_t val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            hash = ::hybridse::base::HyperLogLog::Hash(&val, sizeof(val));
+            break;
+        }
+        case DataType::kDate:
+        case DataType::kInt: {
+            int32_t val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            hash = ::hybridse::base::HyperLogLog::Hash(&val, sizeof(val));
+            break;
+        }
+        case DataType::kTimestamp:
+        case DataType::kBigInt: {
+            int64_t val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            hash = ::hybridse::base::HyperLogLog::Hash(&val, sizeof(val));
+            break;
+        }
+        case DataType::kFloat: {
+            float val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            hash = ::hybridse::base::HyperLogLog::Hash(&val, sizeof(val));
+            break;
+        }
+        case DataType::kDouble: {
+            double val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            hash = ::hybridse::base::HyperLogLog::Hash(&val, sizeof(val));
+            break;
+        }
+        case DataType::kString:
+        case DataType::kVarchar: {
+            char* ch = NULL;
+            uint32_t ch_length = 0;
+            row_view.GetValue(row_ptr, aggr_col_idx_, &ch, &ch_length);
+            hash = ::hybridse::base::HyperLogLog::Hash(ch, ch_length);
+            break;
+        }
+        default: {
+            PDLOG(ERROR, "Unsupported data type");
+            return false;
+        }
+    }
+    auto& registers = aggr_buffer->aggr_val_.vstring;
+    if (registers.data == NULL) {
+        registers.len = ::hybridse::base::HyperLogLog::kRegisterSize;
+        registers.data = new char[registers.len]();
+    }
+    ::hybridse::base::HyperLogLog::Add(hash, reinterpret_cast<uint8_t*>(registers.data));
+    aggr_buffer->non_null_cnt_++;
+    return true;
+}
+
+bool DistinctCountAggregator::EncodeAggrVal(const AggrBuffer& buffer, std::string* aggr_val) {
+    if (buffer.aggr_val_.vstring.data == NULL) {
+        aggr_val->clear();
+        return true;
+    }
+    aggr_val->assign(buffer.aggr_val_.vstring.data, buffer.aggr_val_.vstring.len);
+    return true;
+}
+
+bool DistinctCountAggregator::DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) {
+    char* aggr_val = NULL;
+    uint32_t ch_length = 0;
+    if (aggr_row_view_.GetValue(row_ptr, 4, &aggr_val, &ch_length) == 1) {  // null value
+        return true;
+    }
+    if (ch_length != ::hybridse::base::HyperLogLog::kRegisterSize) {
+        PDLOG(ERROR, "invalid distinct count sketch size %u", ch_length);
+        return false;
+    }
+    auto& registers = buffer->aggr_val_.vstring;
+    if (registers.data == NULL) {
+        registers.data = new char[ch_length];
+    }
+    registers.len = ch_length;
+    memcpy(registers.data, aggr_val, ch_length);
+    // the sketch is not empty, the exact number of values it holds is not needed
+    buffer->non_null_cnt_ = std::max<int64_t>(buffer->non_null_cnt_, 1);
+    return true;
+}
+
 std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& base_meta,
                                              const ::openmldb::api::TableMeta& aggr_meta,
                                              std::shared_ptr<Table> aggr_table,
@@ -1042,6 +1147,10 @@ std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& b
     } else if (aggr_type == "avg") {
         return std::make_shared<AvgAggregator>(base_meta, aggr_meta, aggr_table, aggr_replicator, index_pos, aggr_col,
                                                AggrType::kAvg, ts_col, window_type, window_size);
+    } else if (aggr_type == "distinct_count") {
+        return std::make_shared<DistinctCountAggregator>(base_meta, aggr_meta, aggr_table, aggr_replicator, index_pos,
+                                                         aggr_col, AggrType::kDistinctCount, ts_col, window_type,
+                                                         window_size);
     } else if (aggr_type == "count_where") {
         if (filter_col.empty()) {
             PDLOG(ERROR, "no filter column specified for count_where");
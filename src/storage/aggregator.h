@@ -44,6 +44,7 @@ enum class AggrType {
     kCount = 4,
     kAvg = 5,
     kCountWhere = 6,
+    kDistinctCount = 7,
 };
 
 enum class WindowType {
@@ -170,6 +171,8 @@ class Aggregator {
     bool CheckBufferFilled(int64_t cur_ts, int64_t buffer_end, int32_t buffer_cnt);
 
  private:
+    // type of the value kept in AggrBuffer, which decides how the buffer is copied and released
+    virtual DataType GetAggrValType() const { return aggr_col_type_; }
     virtual bool UpdateAggrVal(const codec::RowView& row_view, const int8_t* row_ptr, AggrBuffer* aggr_buffer) = 0;
     virtual bool EncodeAggrVal(const AggrBuffer& buffer, std::string* aggr_val) = 0;
     virtual bool DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) = 0;
@@ -299,6 +302,26 @@ class AvgAggregator : public Aggregator {
     bool DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) override;
 };
 
+// keeps a HyperLogLog sketch of the aggr column in the buffer, see ::hybridse::base::HyperLogLog
+class DistinctCountAggregator : public Aggregator {
+ public:
+    DistinctCountAggregator(const ::openmldb::api::TableMeta& base_meta, const ::openmldb::api::TableMeta& aggr_meta,
+                            std::shared_ptr<Table> aggr_table, std::shared_ptr<LogReplicator> aggr_replicator,
+                            const uint32_t& index_pos, const std::string& aggr_col, const AggrType& aggr_type,
+                            const std::string& ts_col, WindowType window_tpye, uint32_t window_size);
+
+    ~DistinctCountAggregator() = default;
+
+ private:
+    DataType GetAggrValType() const override { return DataType::kString; }
+
+    bool UpdateAggrVal(const codec::RowView& row_view, const int8_t* row_ptr, AggrBuffer* aggr_buffer) override;
+
+    bool EncodeAggrVal(const AggrBuffer& buffer, std::string* aggr_val) override;
+
+    bool DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) override;
+};
+
 std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& base_meta,
                                              const ::openmldb::api::TableMeta& aggr_meta,
                                              std::shared_ptr<Table> aggr_table,
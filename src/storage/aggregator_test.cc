@@ -19,6 +19,7 @@
 #include "gtest/gtest.h"
 
 #include "base/file_util.h"
+#include "base/hyper_log_log.h"
 #include "codec/schema_codec.h"
 #include "common/timer.h"
 #include "storage/aggregator.h"
@@ -677,6 +678,49 @@ TEST_F(AggregatorTest, AvgAggregatorUpdate) {
     ASSERT_EQ(last_buffer->non_null_cnt_, static_cast<int64_t>(0));
 }
 
+void CheckDistinctCountAggrResult(std::shared_ptr<Table> aggr_table, int64_t count) {
+    ASSERT_EQ(aggr_table->GetRecordCnt(), 50);
+    auto it = aggr_table->NewTraverseIterator(0);
+    it->SeekToFirst();
+    for (int i = 50 - 1; i >= 0; --i) {
+        ASSERT_TRUE(it->Valid());
+        auto tmp_val = it->GetValue();
+        std::string origin_data = tmp_val.ToString();
+        codec::RowView origin_row_view(aggr_table->GetTableMeta()->column_desc(),
+                                       reinterpret_cast<int8_t*>(const_cast<char*>(origin_data.c_str())),
+                                       origin_data.size());
+        char* ch = NULL;
+        uint32_t ch_length = 0;
+        if (count == 0) {
+            ASSERT_TRUE(origin_row_view.IsNULL(4));
+        } else {
+            origin_row_view.GetString(4, &ch, &ch_length);
+            ASSERT_EQ(ch_length, ::hybridse::base::HyperLogLog::kRegisterSize);
+            ASSERT_EQ(::hybridse::base::HyperLogLog::Estimate(reinterpret_cast<uint8_t*>(ch)), count);
+        }
+        it->Next();
+    }
+}
+
+TEST_F(AggregatorTest, DistinctCountAggregatorUpdate) {
+    std::shared_ptr<Aggregator> aggregator;
+    AggrBuffer* last_buffer;
+    std::shared_ptr<Table> aggr_table;
+    // every bucket holds two different values
+    ASSERT_TRUE(GetUpdatedResult(counter, "col3", "distinct_count", "1s", aggregator, aggr_table, &last_buffer));
+    CheckDistinctCountAggrResult(aggr_table, 2);
+    ASSERT_EQ(last_buffer->non_null_cnt_, 1);
+    ASSERT_EQ(::hybridse::base::HyperLogLog::Estimate(
+                  reinterpret_cast<uint8_t*>(last_buffer->aggr_val_.vstring.data)), 1);
+    counter += 2;
+    ASSERT_TRUE(GetUpdatedResult(counter, "col9", "distinct_count", "1m", aggregator, aggr_table, &last_buffer));
+    CheckDistinctCountAggrResult(aggr_table, 2);
+    counter += 2;
+    ASSERT_TRUE(GetUpdatedResult(counter, "col_null", "distinct_count", "1h", aggregator, aggr_table, &last_buffer));
+    CheckDistinctCountAggrResult(aggr_table, 0);
+    ASSERT_EQ(last_buffer->non_null_cnt_, 0);
+}
+
 TEST_F(AggregatorTest, CountWhereAggregatorUpdate) {
     std::shared_ptr<Aggregator> aggregator;
     AggrBuffer* last_buffer;
@@ -15,11 +15,14 @@
  */
 
 #include "storage/disk_table.h"
+#include <mutex>  // NOLINT
 #include <utility>
 #include "base/file_util.h"
 #include "base/glog_wapper.h"  // NOLINT
 #include "base/hash.h"
 #include "config.h"  // NOLINT
+#include "rocksdb/cache.h"
+#include "rocksdb/write_buffer_manager.h"
 
 DECLARE_bool(disable_wal);
 DECLARE_uint32(max_traverse_cnt);
@@ -27,6 +30,7 @@ DECLARE_uint32(max_traverse_cnt);
 DECLARE_string(file_compression);
 DECLARE_uint32(block_cache_mb);
 DECLARE_uint32(write_buffer_mb);
+DECLARE_uint32(memtable_budget_mb);
 DECLARE_uint32(block_cache_shardbits);
 DECLARE_bool(verify_compression);
 
@@ -35,7 +39,13 @@ namespace storage {
 
 static rocksdb::Options ssd_option_template;
 static rocksdb::Options hdd_option_template;
+static rocksdb::BlockBasedTableOptions table_option_template;
 static bool options_template_initialized = false;
+// the block cache shared by all disk tables, its capacity is FLAGS_block_cache_mb
+// minus the block cache reserved by tables with their own DiskTableOption::block_cache_mb
+static std::shared_ptr<rocksdb::Cache> shared_block_cache;
+static std::mutex block_cache_mu;
+static uint64_t reserved_block_cache_bytes = 0;
 
 DiskTable::DiskTable(const std::string& name, uint32_t id, uint32_t pid, const std::map<std::string, uint32_t>& mapping,
                      uint64_t ttl, ::openmldb::type::TTLType ttl_type, ::openmldb::common::StorageMode storage_mode,
@@ -76,12 +86,44 @@ DiskTable::~DiskTable() {
         db_->Close();
         delete db_;
     }
+    ReleaseBlockCache();
+}
+
+bool DiskTable::ReserveBlockCache(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(block_cache_mu);
+    uint64_t total = static_cast<uint64_t>(FLAGS_block_cache_mb) << 20;
+    if (reserved_block_cache_bytes + bytes >= total) {
+        PDLOG(WARNING, "block cache budget is not enough. reserved %lu request %lu total %lu, tid %u pid %u",
+              reserved_block_cache_bytes, bytes, total, id_, pid_);
+        return false;
+    }
+    reserved_block_cache_bytes += bytes;
+    shared_block_cache->SetCapacity(total - reserved_block_cache_bytes);
+    reserved_cache_bytes_ = bytes;
+    return true;
+}
+
+void DiskTable::ReleaseBlockCache() {
+    if (reserved_cache_bytes_ == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(block_cache_mu);
+    reserved_block_cache_bytes -= reserved_cache_bytes_;
+    shared_block_cache->SetCapacity((static_cast<uint64_t>(FLAGS_block_cache_mb) << 20) - reserved_block_cache_bytes);
+    reserved_cache_bytes_ = 0;
 }
 
 void DiskTable::initOptionTemplate() {
-    std::shared_ptr<rocksdb::Cache> cache = rocksdb::NewLRUCache(FLAGS_block_cache_mb << 20,
-                                                                 FLAGS_block_cache_shardbits);  // Can be set by flags
+    shared_block_cache = rocksdb::NewLRUCache(static_cast<uint64_t>(FLAGS_block_cache_mb) << 20,
+                                              FLAGS_block_cache_shardbits);  // Can be set by flags
+    // the memtables of all disk tables share one budget
+    std::shared_ptr<rocksdb::WriteBufferManager> write_buffer_manager;
+    if (FLAGS_memtable_budget_mb > 0) {
+        write_buffer_manager =
+            std::make_shared<rocksdb::WriteBufferManager>(static_cast<size_t>(FLAGS_memtable_budget_mb) << 20);
+    }
     // SSD options template
+    ssd_option_template.write_buffer_manager = write_buffer_manager;
     ssd_option_template.max_open_files = -1;
     ssd_option_template.env->SetBackgroundThreads(1, rocksdb::Env::Priority::HIGH);  // flush threads
     ssd_option_template.env->SetBackgroundThreads(4, rocksdb::Env::Priority::LOW);   // compaction threads
@@ -100,7 +142,7 @@ void DiskTable::initOptionTemplate() {
     rocksdb::BlockBasedTableOptions table_options;
     // table_options.cache_index_and_filter_blocks = true;
     // table_options.pin_l0_filter_and_index_blocks_in_cache = true;
-    table_options.block_cache = cache;
+    table_options.block_cache = shared_block_cache;
     // table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10,
     // false));
     table_options.whole_key_filtering = false;
@@ -124,6 +166,7 @@ void DiskTable::initOptionTemplate() {
 #endif
     ssd_option_template.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
     // HDD options template
+    hdd_option_template.write_buffer_manager = write_buffer_manager;
     hdd_option_template.max_open_files = -1;
     hdd_option_template.env->SetBackgroundThreads(1, rocksdb::Env::Priority::HIGH);  // flush threads
     hdd_option_template.env->SetBackgroundThreads(1, rocksdb::Env::Priority::LOW);   // compaction threads
@@ -142,10 +185,41 @@ void DiskTable::initOptionTemplate() {
     hdd_option_template.target_file_size_base = 256 << 20;
     hdd_option_template.max_bytes_for_level_base = 1024 << 20;
     hdd_option_template.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    table_option_template = table_options;
 
     options_template_initialized = true;
 }
 
+void DiskTable::ApplyTableOption(rocksdb::ColumnFamilyOptions* cfo) {
+    if (!table_meta_ || !table_meta_->has_disk_option()) {
+        return;
+    }
+    const auto& disk_option = table_meta_->disk_option();
+    if (disk_option.has_write_buffer_mb() && disk_option.write_buffer_mb() > 0) {
+        cfo->write_buffer_size = static_cast<size_t>(disk_option.write_buffer_mb()) << 20;
+    }
+    if (!disk_option.has_block_size_kb() && !table_block_cache_) {
+        return;
+    }
+    rocksdb::BlockBasedTableOptions table_options = table_option_template;
+    if (disk_option.has_block_size_kb() && disk_option.block_size_kb() > 0) {
+        table_options.block_size = static_cast<size_t>(disk_option.block_size_kb()) << 10;
+    }
+    if (table_block_cache_) {
+        table_options.block_cache = table_block_cache_;
+    }
+    cfo->table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+}
+
+bool DiskTable::GetBlockCacheStat(uint64_t* hit, uint64_t* miss) const {
+    if (!options_.statistics) {
+        return false;
+    }
+    *hit = options_.statistics->getTickerCount(rocksdb::BLOCK_CACHE_HIT);
+    *miss = options_.statistics->getTickerCount(rocksdb::BLOCK_CACHE_MISS);
+    return true;
+}
+
 bool DiskTable::InitColumnFamilyDescriptor() {
     cf_ds_.clear();
     cf_ds_.push_back(
@@ -160,6 +234,7 @@ bool DiskTable::InitColumnFamilyDescriptor() {
             cfo = rocksdb::ColumnFamilyOptions(hdd_option_template);
             options_ = hdd_option_template;
         }
+        ApplyTableOption(&cfo);
         cfo.comparator = &cmp_;
         cfo.prefix_extractor.reset(new KeyTsPrefixTransform());
         const auto& indexs = inner_index->GetIndex();
@@ -178,6 +253,12 @@ bool DiskTable::Init() {
     if (!InitFromMeta()) {
         return false;
     }
+    if (table_meta_->has_disk_option() && table_meta_->disk_option().block_cache_mb() > 0) {
+        uint64_t bytes = static_cast<uint64_t>(table_meta_->disk_option().block_cache_mb()) << 20;
+        if (ReserveBlockCache(bytes)) {
+            table_block_cache_ = rocksdb::NewLRUCache(bytes, FLAGS_block_cache_shardbits);
+        }
+    }
     InitColumnFamilyDescriptor();
     std::string path = table_path_ + "/data";
     if (!openmldb::base::IsExists(path)) {
@@ -191,6 +272,9 @@ bool DiskTable::Init() {
     options_.create_if_missing = true;
     options_.error_if_exists = false;
     options_.create_missing_column_families = true;
+    // per table statistics, used to report block cache hit rate in GetTableStatus
+    options_.statistics = rocksdb::CreateDBStatistics();
+    options_.statistics->set_stats_level(rocksdb::StatsLevel::kExceptHistogramOrTimers);
     rocksdb::Status s = rocksdb::DB::Open(options_, path, cf_ds_, &cf_hs_, &db_);
     if (!s.ok()) {
         PDLOG(WARNING, "rocksdb open failed. tid %u pid %u error %s", id_, pid_, s.ToString().c_str());
@@ -865,7 +949,7 @@ DiskTableKeyIterator::DiskTableKeyIterator(rocksdb::DB* db, rocksdb::Iterator* i
                                            rocksdb::ColumnFamilyHandle* column_handle)
     : db_(db),
       it_(it),
-      snapshot_(snapshot),
+      snapshot_(snapshot, [db](const rocksdb::Snapshot* s) { db->ReleaseSnapshot(s); }),
       ttl_type_(ttl_type),
       expire_time_(expire_time),
       expire_cnt_(expire_cnt),
@@ -879,7 +963,7 @@ DiskTableKeyIterator::DiskTableKeyIterator(rocksdb::DB* db, rocksdb::Iterator* i
                                            rocksdb::ColumnFamilyHandle* column_handle)
     : db_(db),
       it_(it),
-      snapshot_(snapshot),
+      snapshot_(snapshot, [db](const rocksdb::Snapshot* s) { db->ReleaseSnapshot(s); }),
       ttl_type_(ttl_type),
       expire_time_(expire_time),
       expire_cnt_(expire_cnt),
@@ -887,10 +971,7 @@ DiskTableKeyIterator::DiskTableKeyIterator(rocksdb::DB* db, rocksdb::Iterator* i
       ts_idx_(ts_idx),
       column_handle_(column_handle) {}
 
-DiskTableKeyIterator::~DiskTableKeyIterator() {
-    delete it_;
-    db_->ReleaseSnapshot(snapshot_);
-}
+DiskTableKeyIterator::~DiskTableKeyIterator() { delete it_; }
 
 void DiskTableKeyIterator::SeekToFirst() {
     it_->SeekToFirst();
@@ -955,36 +1036,33 @@ const hybridse::codec::Row DiskTableKeyIterator::GetKey() {
     return row;
 }
 
-std::unique_ptr<::hybridse::vm::RowIterator> DiskTableKeyIterator::GetValue() {
+// row iterators read the window of one pk only, so they reuse the snapshot of the key iterator
+// instead of acquiring a new one (which takes the db mutex) and seek by prefix, which lets
+// rocksdb skip memtables and files by prefix bloom filter
+rocksdb::Iterator* DiskTableKeyIterator::NewRowIterator() const {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
-    const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
-    ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.snapshot = snapshot_.get();
+    ro.prefix_same_as_start = true;
     ro.pin_data = true;
-    rocksdb::Iterator* it = db_->NewIterator(ro, column_handle_);
-    std::unique_ptr<DiskTableRowIterator> wit(new DiskTableRowIterator(db_, it, snapshot, ttl_type_, expire_time_,
-                                                                       expire_cnt_, pk_, ts_, has_ts_idx_, ts_idx_));
-    return wit;
+    return db_->NewIterator(ro, column_handle_);
+}
+
+std::unique_ptr<::hybridse::vm::RowIterator> DiskTableKeyIterator::GetValue() {
+    return std::unique_ptr<::hybridse::vm::RowIterator>(GetRawValue());
 }
 
 ::hybridse::vm::RowIterator* DiskTableKeyIterator::GetRawValue() {
-    rocksdb::ReadOptions ro = rocksdb::ReadOptions();
-    const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
-    ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
-    ro.pin_data = true;
-    rocksdb::Iterator* it = db_->NewIterator(ro, column_handle_);
-    return new DiskTableRowIterator(db_, it, snapshot, ttl_type_, expire_time_, expire_cnt_, pk_, ts_, has_ts_idx_,
-                                    ts_idx_);
+    return new DiskTableRowIterator(db_, NewRowIterator(), snapshot_, ttl_type_, expire_time_, expire_cnt_, pk_, ts_,
+                                    has_ts_idx_, ts_idx_);
 }
 
-DiskTableRowIterator::DiskTableRowIterator(rocksdb::DB* db, rocksdb::Iterator* it, const rocksdb::Snapshot* snapshot,
+DiskTableRowIterator::DiskTableRowIterator(rocksdb::DB* db, rocksdb::Iterator* it, DiskSnapshotPtr snapshot,
                                            ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
                                            uint64_t expire_cnt, std::string pk, uint64_t ts, bool has_ts_idx,
                                            uint32_t ts_idx)
     : db_(db),
       it_(it),
-      snapshot_(snapshot),
+      snapshot_(std::move(snapshot)),
       record_idx_(1),
       expire_value_(expire_time, expire_cnt, ttl_type),
       pk_(pk),
@@ -992,12 +1070,10 @@ DiskTableRowIterator::DiskTableRowIterator(rocksdb::DB* db, rocksdb::Iterator* i
       ts_(ts),
       has_ts_idx_(has_ts_idx),
       ts_idx_(ts_idx),
-      row_() {}
+      row_(),
+      pk_valid_(false) {}
 
-DiskTableRowIterator::~DiskTableRowIterator() {
-    delete it_;
-    db_->ReleaseSnapshot(snapshot_);
-}
+DiskTableRowIterator::~DiskTableRowIterator() { delete it_; }
 
 bool DiskTableRowIterator::Valid() const {
     if (!pk_valid_) return false;
@@ -34,6 +34,7 @@
 #include "rocksdb/options.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/slice_transform.h"
+#include "rocksdb/statistics.h"
 #include "rocksdb/status.h"
 #include "rocksdb/table.h"
 #include "rocksdb/utilities/checkpoint.h"
@@ -270,9 +271,13 @@ class DiskTableTraverseIterator : public TraverseIterator {
     uint64_t traverse_cnt_;
 };
 
+// the snapshot is shared by a key iterator and all the row iterators it creates,
+// and is released after the last of them is destroyed
+using DiskSnapshotPtr = std::shared_ptr<const rocksdb::Snapshot>;
+
 class DiskTableRowIterator : public ::hybridse::vm::RowIterator {
  public:
-    DiskTableRowIterator(rocksdb::DB* db, rocksdb::Iterator* it, const rocksdb::Snapshot* snapshot,
+    DiskTableRowIterator(rocksdb::DB* db, rocksdb::Iterator* it, DiskSnapshotPtr snapshot,
                          ::openmldb::storage::TTLType ttl_type, uint64_t expire_time, uint64_t expire_cnt,
                          std::string pk, uint64_t ts, bool has_ts_idx, uint32_t ts_idx);
 
@@ -293,7 +298,7 @@ class DiskTableRowIterator : public ::hybridse::vm::RowIterator {
  private:
     rocksdb::DB* db_;
     rocksdb::Iterator* it_;
-    const rocksdb::Snapshot* snapshot_;
+    DiskSnapshotPtr snapshot_;
     uint32_t record_idx_;
     TTLSt expire_value_;
     std::string pk_;
@@ -332,11 +337,12 @@ class DiskTableKeyIterator : public ::hybridse::vm::WindowIterator {
 
  private:
     void NextPK();
+    rocksdb::Iterator* NewRowIterator() const;
 
  private:
     rocksdb::DB* db_;
     rocksdb::Iterator* it_;
-    const rocksdb::Snapshot* snapshot_;
+    DiskSnapshotPtr snapshot_;
     ::openmldb::storage::TTLType ttl_type_;
     uint64_t expire_time_;
     uint64_t expire_cnt_;
@@ -425,6 +431,14 @@ class DiskTable : public Table {
 
     int GetCount(uint32_t index, const std::string& pk, uint64_t& count) override; // NOLINT
 
+    // block cache hit and miss count since the table is opened
+    bool GetBlockCacheStat(uint64_t* hit, uint64_t* miss) const;
+
+ private:
+    void ApplyTableOption(rocksdb::ColumnFamilyOptions* cfo);
+    bool ReserveBlockCache(uint64_t bytes);
+    void ReleaseBlockCache();
+
  private:
     rocksdb::DB* db_;
     rocksdb::WriteOptions write_opts_;
@@ -434,6 +448,8 @@ class DiskTable : public Table {
     KeyTSComparator cmp_;
     std::atomic<uint64_t> offset_;
     std::string table_path_;
+    std::shared_ptr<rocksdb::Cache> table_block_cache_;
+    uint64_t reserved_cache_bytes_ = 0;
 };
 
 }  // namespace storage
@@ -1198,6 +1198,46 @@ TEST_F(DiskTableTest, CheckPoint) {
     RemoveData(table_path);
 }
 
+TEST_F(DiskTableTest, DiskOption) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_tid(16);
+    table_meta.set_pid(1);
+    table_meta.set_storage_mode(::openmldb::common::kHDD);
+    table_meta.set_format_version(1);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts1", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "ts1", ::openmldb::type::kAbsoluteTime, 0, 0);
+    auto disk_option = table_meta.mutable_disk_option();
+    disk_option->set_block_size_kb(4);
+    disk_option->set_write_buffer_mb(16);
+    disk_option->set_block_cache_mb(16);
+
+    std::string table_path = FLAGS_hdd_root_path + "/16_1";
+    DiskTable* table = new DiskTable(table_meta, table_path);
+    ASSERT_TRUE(table->Init());
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        for (int k = 0; k < 10; k++) {
+            ASSERT_TRUE(table->Put(key, 9537 + k, "value", 5));
+        }
+    }
+    table->CompactDB();
+    for (int round = 0; round < 2; round++) {
+        for (int idx = 0; idx < 100; idx++) {
+            std::string value;
+            ASSERT_TRUE(table->Get("test" + std::to_string(idx), 9537, value));
+            ASSERT_EQ("value", value);
+        }
+    }
+    uint64_t hit = 0;
+    uint64_t miss = 0;
+    ASSERT_TRUE(table->GetBlockCacheStat(&hit, &miss));
+    ASSERT_GT(hit, 0u);
+    ASSERT_GT(miss, 0u);
+    delete table;
+    RemoveData(table_path);
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
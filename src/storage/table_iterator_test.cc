@@ -117,6 +117,49 @@ TEST_P(TableIteratorTest, smoketest) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_P(TableIteratorTest, row_iterator_outlive_window_iterator) {
+    ::openmldb::common::StorageMode storageMode = GetParam();
+
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::string table_path = "";
+    int id = 1;
+    if (storageMode == ::openmldb::common::kHDD) {
+        id = ++counter;
+        table_path = GetDBPath(FLAGS_hdd_root_path, id, 1);
+    }
+    Table* table = CreateTable("tx_log", id, 1, 8, mapping, 0, ::openmldb::type::kAbsoluteTime,
+        table_path, storageMode);
+    ASSERT_TRUE(table->Init());
+    std::string value = "test";
+    for (int i = 0; i < 3; i++) {
+        std::string key = "card" + std::to_string(i);
+        for (int j = 0; j < 5; j++) {
+            ASSERT_TRUE(table->Put(key, 1000 + j, value.c_str(), value.size()));
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        std::string key = "card" + std::to_string(i);
+        ::hybridse::vm::WindowIterator* it = table->NewWindowIterator(0);
+        ASSERT_TRUE(it != NULL);
+        it->Seek(key);
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(key, it->GetKey().ToString());
+        std::unique_ptr<::hybridse::vm::RowIterator> wit(it->GetRawValue());
+        delete it;
+        wit->SeekToFirst();
+        int cnt = 0;
+        while (wit->Valid()) {
+            ASSERT_EQ(1004 - cnt, static_cast<int>(wit->GetKey()));
+            ASSERT_EQ(value, wit->GetValue().ToString());
+            cnt++;
+            wit->Next();
+        }
+        ASSERT_EQ(5, cnt);
+    }
+    delete table;
+}
+
 TEST_P(TableIteratorTest, latest) {
     ::openmldb::common::StorageMode storageMode = GetParam();
 
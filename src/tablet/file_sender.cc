@@ -16,6 +16,11 @@
 
 #include "tablet/file_sender.h"
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <map>
+#include <mutex>   // NOLINT
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -24,6 +29,7 @@
 #include "boost/algorithm/string/predicate.hpp"
 #include "common/timer.h"
 #include "gflags/gflags.h"
+#include "log/crc32c.h"
 
 DECLARE_int32(send_file_max_try);
 DECLARE_uint32(stream_block_size);
@@ -34,10 +40,70 @@ DECLARE_int32(stream_close_wait_time_ms);
 DECLARE_int32(retry_send_file_wait_time_ms);
 DECLARE_int32(request_max_retry);
 DECLARE_int32(request_timeout_ms);
+DECLARE_uint32(send_file_concurrency);
 
 namespace openmldb {
 namespace tablet {
 
+namespace {
+// checksums of files already read, an entry is valid while the inode, size and mtime are unchanged
+struct ChecksumEntry {
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    uint32_t checksum;
+};
+constexpr size_t kMaxChecksumCacheSize = 100000;
+std::mutex checksum_cache_mu;
+std::map<std::string, ChecksumEntry> checksum_cache;
+}  // namespace
+
+bool GetFileChecksum(const std::string& full_path, uint32_t* checksum) {
+    struct stat st;
+    if (stat(full_path.c_str(), &st) != 0) {
+        PDLOG(WARNING, "fail to stat file %s", full_path.c_str());
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(checksum_cache_mu);
+        auto it = checksum_cache.find(full_path);
+        if (it != checksum_cache.end()) {
+            if (it->second.ino == st.st_ino && it->second.size == st.st_size && it->second.mtime == st.st_mtime) {
+                *checksum = it->second.checksum;
+                return true;
+            }
+            checksum_cache.erase(it);
+        }
+    }
+    FILE* file = fopen(full_path.c_str(), "rb");
+    if (file == NULL) {
+        PDLOG(WARNING, "fail to open file %s", full_path.c_str());
+        return false;
+    }
+    std::vector<char> buffer(FLAGS_stream_block_size);
+    uint32_t crc = 0;
+    bool ok = true;
+    while (true) {
+        size_t len = fread(buffer.data(), 1, buffer.size(), file);
+        crc = ::openmldb::log::Extend(crc, buffer.data(), len);
+        if (len < buffer.size()) {
+            ok = feof(file) != 0;
+            break;
+        }
+    }
+    fclose(file);
+    if (!ok) {
+        return false;
+    }
+    *checksum = crc;
+    std::lock_guard<std::mutex> lock(checksum_cache_mu);
+    if (checksum_cache.size() >= kMaxChecksumCacheSize) {
+        checksum_cache.clear();
+    }
+    checksum_cache[full_path] = ChecksumEntry{st.st_ino, st.st_size, st.st_mtime, crc};
+    return true;
+}
+
 FileSender::FileSender(uint32_t tid, uint32_t pid, common::StorageMode storage_mode, const std::string& endpoint)
     : tid_(tid),
       pid_(pid),
@@ -46,6 +112,7 @@ FileSender::FileSender(uint32_t tid, uint32_t pid, common::StorageMode storage_m
       cur_try_time_(0),
       max_try_time_(FLAGS_send_file_max_try),
       limit_time_(0),
+      active_streams_(1),
       channel_(NULL),
       stub_(NULL) {}
 
@@ -109,9 +176,10 @@ int FileSender::WriteData(const std::string& file_name, const std::string& dir_n
         return -1;
     }
     uint64_t time_used = ::baidu::common::timer::get_micros() - cur_time;
-    if (limit_time_ > time_used && len > FLAGS_stream_block_size / 2) {
-        uint64_t sleep_time = limit_time_ - time_used;
-        DEBUGLOG("sleep %lu us, limit_time %lu time_used %lu", sleep_time, limit_time_, time_used);
+    uint64_t limit_time = limit_time_ * active_streams_.load(std::memory_order_relaxed);
+    if (limit_time > time_used && len > FLAGS_stream_block_size / 2) {
+        uint64_t sleep_time = limit_time - time_used;
+        DEBUGLOG("sleep %lu us, limit_time %lu time_used %lu", sleep_time, limit_time, time_used);
         std::this_thread::sleep_for(std::chrono::microseconds(sleep_time));
     }
     return 0;
@@ -232,15 +300,76 @@ int FileSender::CheckFile(const std::string& file_name, const std::string& dir_n
     return 0;
 }
 
+int FileSender::ReuseFile(const std::string& file_name, const std::string& dir_name, uint64_t file_size,
+                          uint32_t checksum) {
+    ::openmldb::api::CheckFileRequest check_request;
+    ::openmldb::api::GeneralResponse response;
+    check_request.set_tid(tid_);
+    check_request.set_pid(pid_);
+    check_request.set_file(file_name);
+    check_request.set_storage_mode(storage_mode_);
+    if (!dir_name.empty()) {
+        check_request.set_dir_name(dir_name);
+    }
+    check_request.set_size(file_size);
+    check_request.set_checksum(checksum);
+    brpc::Controller cntl;
+    stub_->CheckFile(&cntl, &check_request, &response, NULL);
+    if (cntl.Failed() || response.code() != 0) {
+        return -1;
+    }
+    PDLOG(INFO, "reuse file[%s] on %s. tid[%u] pid[%u]", file_name.c_str(), endpoint_.c_str(), tid_, pid_);
+    return 0;
+}
+
+int FileSender::SendDirFile(const std::string& dir_name, const std::string& full_path) {
+    std::string file_name = full_path.substr(full_path.find_last_of("/") + 1);
+    // sst files are immutable, so the ones the receiver already has need not be sent again
+    if (boost::ends_with(file_name, ".sst")) {
+        uint64_t file_size = 0;
+        uint32_t checksum = 0;
+        if (::openmldb::base::GetFileSize(full_path, file_size) && GetFileChecksum(full_path, &checksum) &&
+            ReuseFile(file_name, dir_name, file_size, checksum) == 0) {
+            return 0;
+        }
+    }
+    return SendFile(file_name, dir_name, full_path);
+}
+
 int FileSender::SendDir(const std::string& dir_name, const std::string& full_path) {
     std::vector<std::string> file_vec;
     ::openmldb::base::GetFileName(full_path, file_vec);
-    for (const std::string& file : file_vec) {
-        if (SendFile(file.substr(file.find_last_of("/") + 1), dir_name, file) < 0) {
-            return -1;
+    size_t concurrency = std::min(static_cast<size_t>(FLAGS_send_file_concurrency), file_vec.size());
+    if (concurrency <= 1) {
+        for (const std::string& file : file_vec) {
+            if (SendDirFile(dir_name, file) < 0) {
+                return -1;
+            }
         }
+        return 0;
     }
-    return 0;
+    std::atomic<size_t> next(0);
+    std::atomic<bool> has_error(false);
+    active_streams_.store(concurrency, std::memory_order_relaxed);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < concurrency; i++) {
+        workers.emplace_back([&]() {
+            while (!has_error.load(std::memory_order_relaxed)) {
+                size_t idx = next.fetch_add(1, std::memory_order_relaxed);
+                if (idx >= file_vec.size()) {
+                    break;
+                }
+                if (SendDirFile(dir_name, file_vec[idx]) < 0) {
+                    has_error.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    active_streams_.store(1, std::memory_order_relaxed);
+    return has_error.load(std::memory_order_relaxed) ? -1 : 0;
 }
 
 }  // namespace tablet
@@ -19,6 +19,7 @@
 #include <brpc/channel.h>
 #include <brpc/controller.h>
 
+#include <atomic>
 #include <string>
 
 #include "proto/tablet.pb.h"
@@ -26,6 +27,9 @@
 namespace openmldb {
 namespace tablet {
 
+// crc32c of the whole file. the result is cached until the file is changed
+bool GetFileChecksum(const std::string& full_path, uint32_t* checksum);
+
 class FileSender {
  public:
     FileSender(uint32_t tid, uint32_t pid, common::StorageMode storage_mode, const std::string& endpoint);
@@ -39,8 +43,12 @@ class FileSender {
     int WriteData(const std::string& file_name, const std::string& dir_name, const char* buffer, size_t len,
                   uint64_t block_id);
     int CheckFile(const std::string& file_name, const std::string& dir_name, uint64_t file_size);
+    // ask the receiver to reuse its local copy of the file, return 0 if it has one
+    int ReuseFile(const std::string& file_name, const std::string& dir_name, uint64_t file_size, uint32_t checksum);
 
  private:
+    int SendDirFile(const std::string& dir_name, const std::string& full_path);
+
     uint32_t tid_;
     uint32_t pid_;
     common::StorageMode storage_mode_;
@@ -48,6 +56,8 @@ class FileSender {
     uint32_t cur_try_time_;
     uint32_t max_try_time_;
     uint64_t limit_time_;
+    // the bandwidth limit is shared by the files sent in parallel
+    std::atomic<uint32_t> active_streams_;
     brpc::Channel* channel_;
     ::openmldb::api::TabletServer_Stub* stub_;
 };
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/file_sender.h"
+
+#include <brpc/server.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "base/file_util.h"
+#include "base/glog_wapper.h"
+#include "log/crc32c.h"
+#include "tablet/tablet_impl.h"
+
+DECLARE_string(db_root_path);
+DECLARE_string(hdd_root_path);
+DECLARE_uint32(send_file_concurrency);
+
+inline std::string GenRand() { return std::to_string(rand() % 10000000 + 1); }  // NOLINT
+
+namespace openmldb {
+namespace tablet {
+
+static void WriteFile(const std::string& path, const std::string& content) {
+    ::openmldb::base::MkdirRecur(path.substr(0, path.find_last_of("/") + 1));
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs << content;
+}
+
+static std::string ReadFile(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+class FileSenderTest : public ::testing::Test {
+ public:
+    FileSenderTest() {}
+    ~FileSenderTest() {}
+
+    void SetUp() override {
+        TabletImpl* tablet = new TabletImpl();
+        ASSERT_TRUE(tablet->Init(""));
+        ASSERT_EQ(0, server_.AddService(tablet, brpc::SERVER_OWNS_SERVICE));
+        brpc::ServerOptions options;
+        ASSERT_EQ(0, server_.Start(endpoint_.c_str(), &options));
+    }
+
+    void TearDown() override {
+        server_.Stop(0);
+        server_.Join();
+    }
+
+ protected:
+    std::string endpoint_ = "127.0.0.1:18531";
+    brpc::Server server_;
+};
+
+TEST_F(FileSenderTest, GetFileChecksum) {
+    std::string path = "/tmp/" + GenRand() + "/checksum.sst";
+    std::string content(10000, 'a');
+    WriteFile(path, content);
+    uint32_t checksum = 0;
+    ASSERT_TRUE(GetFileChecksum(path, &checksum));
+    ASSERT_EQ(::openmldb::log::Value(content.data(), content.size()), checksum);
+    // the cached checksum is dropped once the file changes
+    content.append("bcd");
+    WriteFile(path, content);
+    ASSERT_TRUE(GetFileChecksum(path, &checksum));
+    ASSERT_EQ(::openmldb::log::Value(content.data(), content.size()), checksum);
+    ASSERT_FALSE(GetFileChecksum(path + ".not_exist", &checksum));
+}
+
+TEST_F(FileSenderTest, ReuseLocalFile) {
+    uint32_t tid = 101;
+    uint32_t pid = 1;
+    std::string table_path = FLAGS_hdd_root_path + "/" + std::to_string(tid) + "_" + std::to_string(pid);
+    std::string content = "sst file content";
+    WriteFile(table_path + "/data/000001.sst", content);
+    WriteFile(table_path + "/data/000002.sst", content);
+    // left by an interrupted transfer, has the right size but not the right content
+    WriteFile(table_path + "/snapshot/sst_dir/000002.sst", std::string(content.size(), 'x'));
+    uint32_t checksum = ::openmldb::log::Value(content.data(), content.size());
+
+    FileSender sender(tid, pid, ::openmldb::common::kHDD, endpoint_);
+    ASSERT_TRUE(sender.Init());
+    ASSERT_EQ(0, sender.ReuseFile("000001.sst", "sst_dir", content.size(), checksum));
+    struct stat st;
+    ASSERT_EQ(0, stat((table_path + "/snapshot/sst_dir/000001.sst").c_str(), &st));
+    ASSERT_EQ(2u, st.st_nlink);
+    // an existing target is accepted only with the same checksum
+    ASSERT_EQ(0, sender.ReuseFile("000001.sst", "sst_dir", content.size(), checksum));
+    ASSERT_EQ(-1, sender.ReuseFile("000002.sst", "sst_dir", content.size(), checksum));
+    // no local file with the same checksum
+    ASSERT_EQ(-1, sender.ReuseFile("000003.sst", "sst_dir", content.size(), checksum));
+    WriteFile(table_path + "/data/000003.sst", content);
+    ASSERT_EQ(-1, sender.ReuseFile("000003.sst", "sst_dir", content.size(), checksum + 1));
+    ASSERT_FALSE(::openmldb::base::IsExists(table_path + "/snapshot/sst_dir/000003.sst"));
+}
+
+TEST_F(FileSenderTest, SendDirParallel) {
+    uint32_t tid = 102;
+    uint32_t pid = 1;
+    std::string src_dir = "/tmp/" + GenRand() + "/snapshot_dir/";
+    for (int i = 0; i < 10; i++) {
+        WriteFile(src_dir + "file_" + std::to_string(i), std::string(1000 * (i + 1), 'a' + i));
+    }
+    uint32_t old_concurrency = FLAGS_send_file_concurrency;
+    FLAGS_send_file_concurrency = 4;
+    FileSender sender(tid, pid, ::openmldb::common::kHDD, endpoint_);
+    ASSERT_TRUE(sender.Init());
+    ASSERT_EQ(0, sender.SendDir("snapshot_dir", src_dir));
+    FLAGS_send_file_concurrency = old_concurrency;
+    std::string dst_dir = FLAGS_hdd_root_path + "/" + std::to_string(tid) + "_" + std::to_string(pid) +
+                          "/snapshot/snapshot_dir/";
+    for (int i = 0; i < 10; i++) {
+        std::string file_name = "file_" + std::to_string(i);
+        ASSERT_EQ(ReadFile(src_dir + file_name), ReadFile(dst_dir + file_name));
+    }
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    srand(time(NULL));
+    ::openmldb::base::SetLogLevel(INFO);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    FLAGS_db_root_path = "/tmp/" + GenRand();
+    FLAGS_hdd_root_path = "/tmp/hdd_" + GenRand();
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/request_batcher.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <chrono>  // NOLINT
+#include <mutex>   // NOLINT
+
+namespace openmldb::tablet {
+
+static int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+RequestBatcher::RequestBatcher(uint64_t window_us, uint32_t max_batch_size)
+    : window_us_(window_us),
+      max_batch_size_(std::max(max_batch_size, 1u)),
+      mu_(),
+      open_batches_(),
+      batch_cnt_(0),
+      row_cnt_(0),
+      max_batch_size_seen_(0),
+      total_batch_cnt_(0),
+      total_row_cnt_(0) {}
+
+void RequestBatcher::CloseBatch(const std::string& key, Batch* batch) {
+    if (batch->closed) {
+        return;
+    }
+    batch->closed = true;
+    auto it = open_batches_.find(key);
+    if (it != open_batches_.end() && it->second.get() == batch) {
+        open_batches_.erase(it);
+    }
+}
+
+int32_t RequestBatcher::Run(const std::string& key, const hybridse::codec::Row& row, const BatchRun& run,
+                            hybridse::codec::Row* output) {
+    std::shared_ptr<Batch> batch;
+    {
+        std::unique_lock<bthread::Mutex> lock(mu_);
+        auto it = open_batches_.find(key);
+        if (it != open_batches_.end()) {
+            // join the open batch and wait for its leader to run it
+            batch = it->second;
+            size_t idx = batch->rows.size();
+            batch->rows.push_back(row);
+            if (batch->rows.size() >= max_batch_size_) {
+                CloseBatch(key, batch.get());
+                batch->cv.notify_all();
+            }
+            while (!batch->done) {
+                batch->cv.wait(lock);
+            }
+            if (batch->ret == 0) {
+                *output = batch->outputs[idx];
+                return 0;
+            }
+            lock.unlock();
+            // find out if the own row fails the batch
+            return RunSingle(row, run, output);
+        }
+        batch = std::make_shared<Batch>();
+        batch->rows.push_back(row);
+        open_batches_.emplace(key, batch);
+        int64_t deadline = NowUs() + static_cast<int64_t>(window_us_);
+        while (!batch->closed && batch->rows.size() < max_batch_size_) {
+            int64_t left = deadline - NowUs();
+            if (left <= 0) {
+                break;
+            }
+            batch->cv.wait_for(lock, left);
+        }
+        CloseBatch(key, batch.get());
+    }
+    // rows of a closed batch are not modified any more
+    std::vector<hybridse::codec::Row> outputs;
+    int32_t ret = run(batch->rows, &outputs);
+    if (ret == 0 && outputs.size() != batch->rows.size()) {
+        ret = -1;
+    }
+    uint64_t size = batch->rows.size();
+    batch_cnt_.fetch_add(1, std::memory_order_relaxed);
+    row_cnt_.fetch_add(size, std::memory_order_relaxed);
+    total_batch_cnt_.fetch_add(1, std::memory_order_relaxed);
+    total_row_cnt_.fetch_add(size, std::memory_order_relaxed);
+    uint64_t max_size = max_batch_size_seen_.load(std::memory_order_relaxed);
+    while (size > max_size && !max_batch_size_seen_.compare_exchange_weak(max_size, size)) {
+    }
+    if (ret == 0) {
+        *output = outputs[0];
+    }
+    {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        batch->outputs.swap(outputs);
+        batch->ret = ret;
+        batch->done = true;
+    }
+    batch->cv.notify_all();
+    if (ret != 0 && size > 1) {
+        return RunSingle(batch->rows[0], run, output);
+    }
+    return ret;
+}
+
+int32_t RequestBatcher::RunSingle(const hybridse::codec::Row& row, const BatchRun& run,
+                                  hybridse::codec::Row* output) {
+    std::vector<hybridse::codec::Row> outputs;
+    int32_t ret = run({row}, &outputs);
+    if (ret == 0 && outputs.size() != 1) {
+        ret = -1;
+    }
+    if (ret == 0) {
+        *output = outputs[0];
+    }
+    return ret;
+}
+
+void RequestBatcher::FlushStats(uint64_t* batch_cnt, uint64_t* row_cnt, uint64_t* max_batch_size) {
+    *batch_cnt = batch_cnt_.exchange(0, std::memory_order_relaxed);
+    *row_cnt = row_cnt_.exchange(0, std::memory_order_relaxed);
+    *max_batch_size = max_batch_size_seen_.exchange(0, std::memory_order_relaxed);
+}
+
+void RequestBatcher::GetTotalStats(uint64_t* batch_cnt, uint64_t* row_cnt) const {
+    *batch_cnt = total_batch_cnt_.load(std::memory_order_relaxed);
+    *row_cnt = total_row_cnt_.load(std::memory_order_relaxed);
+}
+
+CommonColumnLayout::CommonColumnLayout(const hybridse::vm::BatchRequestInfo& info,
+                                       const hybridse::codec::Schema& request_schema,
+                                       const hybridse::codec::Schema& output_schema)
+    : request_schema_(request_schema), output_schema_(output_schema) {
+    SplitColumns(request_schema_, info.common_column_indices, &common_, &non_common_);
+    SplitColumns(output_schema_, info.output_common_column_indices, &output_common_, &output_non_common_);
+    if (output_common_.indices.empty() || output_non_common_.indices.empty()) {
+        return;
+    }
+    output_sources_.resize(output_schema_.size());
+    for (size_t i = 0; i < output_common_.indices.size(); i++) {
+        output_sources_[output_common_.indices[i]] = {0, i};
+    }
+    for (size_t i = 0; i < output_non_common_.indices.size(); i++) {
+        output_sources_[output_non_common_.indices[i]] = {1, i};
+    }
+}
+
+void CommonColumnLayout::SplitColumns(const hybridse::codec::Schema& schema, const std::set<size_t>& common_indices,
+                                      Columns* common, Columns* non_common) {
+    for (int i = 0; i < schema.size(); i++) {
+        auto columns = common_indices.count(i) > 0 ? common : non_common;
+        *columns->schema.Add() = schema.Get(i);
+        columns->indices.push_back(i);
+    }
+}
+
+bool CommonColumnLayout::Split(const hybridse::codec::Row& row, hybridse::codec::Row* split_row,
+                               std::string* common_key) const {
+    std::vector<hybridse::codec::RowView> views = {hybridse::codec::RowView(request_schema_)};
+    if (!views[0].Reset(row.buf(), row.size())) {
+        return false;
+    }
+    std::vector<std::pair<size_t, size_t>> sources;
+    for (size_t idx : common_.indices) {
+        sources.emplace_back(0, idx);
+    }
+    hybridse::codec::Row common_row;
+    if (!BuildRow(common_.schema, &views, sources, &common_row)) {
+        return false;
+    }
+    sources.clear();
+    for (size_t idx : non_common_.indices) {
+        sources.emplace_back(0, idx);
+    }
+    hybridse::codec::Row non_common_row;
+    if (!BuildRow(non_common_.schema, &views, sources, &non_common_row)) {
+        return false;
+    }
+    common_key->assign(reinterpret_cast<const char*>(common_row.buf()), common_row.size());
+    *split_row = hybridse::codec::Row(1, common_row, 1, non_common_row);
+    return true;
+}
+
+bool CommonColumnLayout::Merge(const hybridse::codec::Row& output, hybridse::codec::Row* row) const {
+    if (output_sources_.empty()) {
+        *row = output;
+        return true;
+    }
+    if (output.GetRowPtrCnt() != 2) {
+        return false;
+    }
+    std::vector<hybridse::codec::RowView> views = {hybridse::codec::RowView(output_common_.schema),
+                                                   hybridse::codec::RowView(output_non_common_.schema)};
+    if (!views[0].Reset(output.buf(0), output.size(0)) || !views[1].Reset(output.buf(1), output.size(1))) {
+        return false;
+    }
+    return BuildRow(output_schema_, &views, output_sources_, row);
+}
+
+bool CommonColumnLayout::BuildRow(const hybridse::codec::Schema& schema, std::vector<hybridse::codec::RowView>* views,
+                                  const std::vector<std::pair<size_t, size_t>>& sources, hybridse::codec::Row* row) {
+    uint32_t str_len = 0;
+    for (int i = 0; i < schema.size(); i++) {
+        auto& view = (*views)[sources[i].first];
+        uint32_t idx = sources[i].second;
+        const char* str = nullptr;
+        uint32_t len = 0;
+        if (schema.Get(i).type() == hybridse::type::kVarchar && !view.IsNULL(idx) &&
+            view.GetString(idx, &str, &len) == 0) {
+            str_len += len;
+        }
+    }
+    hybridse::codec::RowBuilder builder(schema);
+    uint32_t total_size = builder.CalTotalLength(str_len);
+    int8_t* buf = static_cast<int8_t*>(malloc(total_size));
+    builder.SetBuffer(buf, total_size);
+    bool ok = true;
+    for (int i = 0; i < schema.size() && ok; i++) {
+        auto& view = (*views)[sources[i].first];
+        uint32_t idx = sources[i].second;
+        if (view.IsNULL(idx)) {
+            ok = builder.AppendNULL();
+            continue;
+        }
+        switch (schema.Get(i).type()) {
+            case hybridse::type::kBool: {
+                bool val = false;
+                ok = view.GetBool(idx, &val) == 0 && builder.AppendBool(val);
+                break;
+            }
+            case hybridse::type::kInt16: {
+                int16_t val = 0;
+                ok = view.GetInt16(idx, &val) == 0 && builder.AppendInt16(val);
+                break;
+            }
+            case hybridse::type::kInt32: {
+                int32_t val = 0;
+                ok = view.GetInt32(idx, &val) == 0 && builder.AppendInt32(val);
+                break;
+            }
+            case hybridse::type::kInt64: {
+                int64_t val = 0;
+                ok = view.GetInt64(idx, &val) == 0 && builder.AppendInt64(val);
+                break;
+            }
+            case hybridse::type::kTimestamp: {
+                int64_t val = 0;
+                ok = view.GetTimestamp(idx, &val) == 0 && builder.AppendTimestamp(val);
+                break;
+            }
+            case hybridse::type::kDate: {
+                int32_t val = 0;
+                ok = view.GetDate(idx, &val) == 0 && builder.AppendDate(val);
+                break;
+            }
+            case hybridse::type::kFloat: {
+                float val = 0;
+                ok = view.GetFloat(idx, &val) == 0 && builder.AppendFloat(val);
+                break;
+            }
+            case hybridse::type::kDouble: {
+                double val = 0;
+                ok = view.GetDouble(idx, &val) == 0 && builder.AppendDouble(val);
+                break;
+            }
+            case hybridse::type::kVarchar: {
+                const char* str = nullptr;
+                uint32_t len = 0;
+                ok = view.GetString(idx, &str, &len) == 0 && builder.AppendString(str, len);
+                break;
+            }
+            default:
+                ok = false;
+        }
+    }
+    if (!ok) {
+        free(buf);
+        return false;
+    }
+    *row = hybridse::codec::Row(hybridse::base::RefCountedSlice::CreateManaged(buf, total_size));
+    return true;
+}
+
+}  // namespace openmldb::tablet
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_REQUEST_BATCHER_H_
+#define SRC_TABLET_REQUEST_BATCHER_H_
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "bthread/condition_variable.h"
+#include "codec/fe_row_codec.h"
+#include "codec/row.h"
+#include "vm/engine_context.h"
+
+namespace openmldb::tablet {
+
+// Coalesces concurrent single row runs with the same key into one batch run.
+//
+// The first caller of a key opens a batch and waits up to `window_us` for other
+// callers to join it, or until `max_batch_size` rows are collected. It then runs
+// the whole batch and hands every caller the output row of its own input row.
+// `window_us` is also the cap of the latency added to a single call. If the
+// batch run fails, every caller reruns its own row alone, so a bad row only
+// fails its own call.
+class RequestBatcher {
+ public:
+    using BatchRun = std::function<int32_t(const std::vector<hybridse::codec::Row>& rows,
+                                           std::vector<hybridse::codec::Row>* outputs)>;
+
+    RequestBatcher(uint64_t window_us, uint32_t max_batch_size);
+
+    // calls are coalesced only if the window is not 0
+    bool IsEnabled() const { return window_us_ > 0; }
+
+    // run `row` within a batch of `key`, return the result of the batch run
+    int32_t Run(const std::string& key, const hybridse::codec::Row& row, const BatchRun& run,
+                hybridse::codec::Row* output);
+
+    // get the batch size stats since the last flush and reset them
+    void FlushStats(uint64_t* batch_cnt, uint64_t* row_cnt, uint64_t* max_batch_size);
+
+    // get the batch and row counts since the batcher is created
+    void GetTotalStats(uint64_t* batch_cnt, uint64_t* row_cnt) const;
+
+ private:
+    struct Batch {
+        std::vector<hybridse::codec::Row> rows;
+        std::vector<hybridse::codec::Row> outputs;
+        int32_t ret = 0;
+        // no more rows can join
+        bool closed = false;
+        bool done = false;
+        bthread::ConditionVariable cv;
+    };
+
+    void CloseBatch(const std::string& key, Batch* batch);
+    static int32_t RunSingle(const hybridse::codec::Row& row, const BatchRun& run, hybridse::codec::Row* output);
+
+    const uint64_t window_us_;
+    const uint32_t max_batch_size_;
+    bthread::Mutex mu_;
+    // the batches still open for joining, by key
+    std::map<std::string, std::shared_ptr<Batch>> open_batches_;
+
+    std::atomic<uint64_t> batch_cnt_;
+    std::atomic<uint64_t> row_cnt_;
+    std::atomic<uint64_t> max_batch_size_seen_;
+    std::atomic<uint64_t> total_batch_cnt_;
+    std::atomic<uint64_t> total_row_cnt_;
+};
+
+// The row layout of a batch request session with common columns.
+//
+// The session takes request rows as a slice of the common columns and a slice of
+// the other columns, and all rows of a run share the values of the common columns.
+// Its output rows are split the same way by the common output columns.
+class CommonColumnLayout {
+ public:
+    CommonColumnLayout(const hybridse::vm::BatchRequestInfo& info, const hybridse::codec::Schema& request_schema,
+                       const hybridse::codec::Schema& output_schema);
+
+    // request rows are split only if some but not all request columns are common
+    bool IsSplit() const { return !common_.indices.empty() && !non_common_.indices.empty(); }
+
+    // split a request row into its common and non-common slices, `common_key` gets the
+    // encoded common columns, rows with the same key can run together
+    bool Split(const hybridse::codec::Row& row, hybridse::codec::Row* split_row, std::string* common_key) const;
+
+    // merge an output row of the session into one row of the output schema
+    bool Merge(const hybridse::codec::Row& output, hybridse::codec::Row* row) const;
+
+ private:
+    struct Columns {
+        hybridse::codec::Schema schema;
+        // the column indices in the full schema
+        std::vector<size_t> indices;
+    };
+    static void SplitColumns(const hybridse::codec::Schema& schema, const std::set<size_t>& common_indices,
+                             Columns* common, Columns* non_common);
+    // build a row of `schema`, column i is the column sources[i].second of views[sources[i].first]
+    static bool BuildRow(const hybridse::codec::Schema& schema, std::vector<hybridse::codec::RowView>* views,
+                         const std::vector<std::pair<size_t, size_t>>& sources, hybridse::codec::Row* row);
+
+    hybridse::codec::Schema request_schema_;
+    hybridse::codec::Schema output_schema_;
+    Columns common_;
+    Columns non_common_;
+    // the slice and the index in the slice of every output column, empty if outputs are not split
+    std::vector<std::pair<size_t, size_t>> output_sources_;
+    Columns output_common_;
+    Columns output_non_common_;
+};
+
+}  // namespace openmldb::tablet
+#endif  // SRC_TABLET_REQUEST_BATCHER_H_
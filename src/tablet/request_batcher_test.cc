@@ -0,0 +1,191 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/request_batcher.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "base/glog_wapper.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+namespace openmldb::tablet {
+
+using hybridse::codec::Row;
+
+class RequestBatcherTest : public ::testing::Test {};
+
+static int32_t EchoRun(const std::vector<Row>& rows, std::vector<Row>* outputs) {
+    for (const auto& row : rows) {
+        outputs->emplace_back("out_" + row.ToString());
+    }
+    return 0;
+}
+
+TEST_F(RequestBatcherTest, concurrent_calls) {
+    RequestBatcher batcher(100000, 4);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 10; i++) {
+        workers.push_back(std::thread([&batcher, i]() {
+            Row output;
+            std::string key = i % 2 == 0 ? "db.sp1" : "db.sp2";
+            ASSERT_EQ(0, batcher.Run(key, Row("row" + std::to_string(i)), EchoRun, &output));
+            ASSERT_EQ("out_row" + std::to_string(i), output.ToString());
+        }));
+    }
+    std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
+    uint64_t batch_cnt = 0;
+    uint64_t row_cnt = 0;
+    uint64_t max_batch_size = 0;
+    batcher.FlushStats(&batch_cnt, &row_cnt, &max_batch_size);
+    ASSERT_EQ(10u, row_cnt);
+    ASSERT_GE(batch_cnt, 4u);
+    ASSERT_LE(max_batch_size, 4u);
+    batcher.FlushStats(&batch_cnt, &row_cnt, &max_batch_size);
+    ASSERT_EQ(0u, batch_cnt);
+    ASSERT_EQ(0u, row_cnt);
+    // the total counts are not reset by flushes
+    batcher.GetTotalStats(&batch_cnt, &row_cnt);
+    ASSERT_GE(batch_cnt, 4u);
+    ASSERT_EQ(10u, row_cnt);
+}
+
+TEST_F(RequestBatcherTest, run_fail) {
+    RequestBatcher batcher(100000, 3);
+    ASSERT_TRUE(batcher.IsEnabled());
+    ASSERT_FALSE(RequestBatcher(0, 3).IsEnabled());
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 3; i++) {
+        workers.push_back(std::thread([&batcher, i]() {
+            Row output;
+            ASSERT_EQ(-1, batcher.Run("db.sp", Row("row" + std::to_string(i)),
+                                      [](const std::vector<Row>& rows, std::vector<Row>* outputs) { return -1; },
+                                      &output));
+        }));
+    }
+    std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
+    // a run with missing outputs fails too
+    Row output;
+    ASSERT_EQ(-1, batcher.Run("db.sp", Row("row"),
+                              [](const std::vector<Row>& rows, std::vector<Row>* outputs) { return 0; }, &output));
+}
+
+TEST_F(RequestBatcherTest, bad_row_fails_own_call) {
+    RequestBatcher batcher(100000, 4);
+    // a batch with the bad row fails as a whole
+    auto run = [](const std::vector<Row>& rows, std::vector<Row>* outputs) {
+        for (const auto& row : rows) {
+            if (row.ToString() == "row1") {
+                return -1;
+            }
+        }
+        return EchoRun(rows, outputs);
+    };
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; i++) {
+        workers.push_back(std::thread([&batcher, &run, i]() {
+            Row output;
+            int32_t ret = batcher.Run("db.sp", Row("row" + std::to_string(i)), run, &output);
+            if (i == 1) {
+                ASSERT_EQ(-1, ret);
+            } else {
+                ASSERT_EQ(0, ret);
+                ASSERT_EQ("out_row" + std::to_string(i), output.ToString());
+            }
+        }));
+    }
+    std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
+}
+
+static void AddColumn(hybridse::codec::Schema* schema, const std::string& name, hybridse::type::Type type) {
+    auto column = schema->Add();
+    column->set_name(name);
+    column->set_type(type);
+}
+
+static Row BuildRow(const hybridse::codec::Schema& schema, const std::string& str, int64_t val) {
+    hybridse::codec::RowBuilder builder(schema);
+    uint32_t total_size = builder.CalTotalLength(str.size());
+    int8_t* buf = static_cast<int8_t*>(malloc(total_size));
+    builder.SetBuffer(buf, total_size);
+    builder.AppendString(str.c_str(), str.size());
+    builder.AppendInt64(val);
+    return Row(hybridse::base::RefCountedSlice::CreateManaged(buf, total_size));
+}
+
+TEST_F(RequestBatcherTest, common_column_layout) {
+    hybridse::codec::Schema request_schema;
+    AddColumn(&request_schema, "c1", hybridse::type::kVarchar);
+    AddColumn(&request_schema, "c2", hybridse::type::kInt64);
+    hybridse::codec::Schema output_schema = request_schema;
+    hybridse::vm::BatchRequestInfo info;
+    info.common_column_indices = {0};
+    info.output_common_column_indices = {0};
+    CommonColumnLayout layout(info, request_schema, output_schema);
+    ASSERT_TRUE(layout.IsSplit());
+
+    Row split1;
+    Row split2;
+    Row split3;
+    std::string key1;
+    std::string key2;
+    std::string key3;
+    ASSERT_TRUE(layout.Split(BuildRow(request_schema, "k1", 1), &split1, &key1));
+    ASSERT_TRUE(layout.Split(BuildRow(request_schema, "k1", 2), &split2, &key2));
+    ASSERT_TRUE(layout.Split(BuildRow(request_schema, "k2", 1), &split3, &key3));
+    // calls with the same common columns run together
+    ASSERT_EQ(key1, key2);
+    ASSERT_NE(key1, key3);
+    ASSERT_EQ(2, split2.GetRowPtrCnt());
+    hybridse::codec::Schema common_schema;
+    AddColumn(&common_schema, "c1", hybridse::type::kVarchar);
+    hybridse::codec::Schema non_common_schema;
+    AddColumn(&non_common_schema, "c2", hybridse::type::kInt64);
+    hybridse::codec::RowView common_view(common_schema, split2.buf(0), split2.size(0));
+    ASSERT_EQ("k1", common_view.GetStringUnsafe(0));
+    hybridse::codec::RowView non_common_view(non_common_schema, split2.buf(1), split2.size(1));
+    int64_t val = 0;
+    ASSERT_EQ(0, non_common_view.GetInt64(0, &val));
+    ASSERT_EQ(2, val);
+
+    // the output slices are merged into one row of the output schema
+    Row merged;
+    ASSERT_TRUE(layout.Merge(split2, &merged));
+    ASSERT_EQ(1, merged.GetRowPtrCnt());
+    hybridse::codec::RowView merged_view(output_schema, merged.buf(), merged.size());
+    ASSERT_EQ("k1", merged_view.GetStringUnsafe(0));
+    ASSERT_EQ(0, merged_view.GetInt64(1, &val));
+    ASSERT_EQ(2, val);
+
+    // nothing is split without common columns
+    CommonColumnLayout no_common(hybridse::vm::BatchRequestInfo(), request_schema, output_schema);
+    ASSERT_FALSE(no_common.IsSplit());
+    Row row = BuildRow(request_schema, "k1", 1);
+    ASSERT_TRUE(no_common.Merge(row, &merged));
+    ASSERT_EQ(0, merged.compare(row));
+}
+
+}  // namespace openmldb::tablet
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    return RUN_ALL_TESTS();
+}
@@ -17,6 +17,7 @@
 #ifndef SRC_TABLET_SP_CACHE_H_
 #define SRC_TABLET_SP_CACHE_H_
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
@@ -30,16 +31,37 @@ namespace tablet {
 
 using ::openmldb::base::SpinMutex;
 
+// the number of calls of a procedure, counted without the cache lock until it reaches the threshold
+class ProcedureCallCounter {
+ public:
+    ProcedureCallCounter() : cnt_(0) {}
+    // count a call, return true once when the calls reach `threshold`
+    bool Count(uint64_t threshold) {
+        if (cnt_.load(std::memory_order_relaxed) >= threshold) {
+            return false;
+        }
+        return cnt_.fetch_add(1, std::memory_order_relaxed) + 1 == threshold;
+    }
+
+ private:
+    std::atomic<uint64_t> cnt_;
+};
+
 // tablet cache entry for sql procedure
 struct SQLProcedureCacheEntry {
     std::shared_ptr<hybridse::sdk::ProcedureInfo> procedure_info;
     std::shared_ptr<hybridse::vm::CompileInfo> request_info;
     std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info;
+    // kept when the procedure is recompiled, so it is recompiled once
+    std::shared_ptr<ProcedureCallCounter> call_cnt;
 
     SQLProcedureCacheEntry(const std::shared_ptr<hybridse::sdk::ProcedureInfo> pinfo,
                            std::shared_ptr<hybridse::vm::CompileInfo> rinfo,
                            std::shared_ptr<hybridse::vm::CompileInfo> brinfo)
-        : procedure_info(pinfo), request_info(rinfo), batch_request_info(brinfo) {}
+        : procedure_info(pinfo),
+          request_info(rinfo),
+          batch_request_info(brinfo),
+          call_cnt(std::make_shared<ProcedureCallCounter>()) {}
 };
 
 class SpCache : public hybridse::vm::CompileInfoCache {
@@ -73,6 +95,26 @@ class SpCache : public hybridse::vm::CompileInfoCache {
             std::make_pair(sp_name, SQLProcedureCacheEntry(procedure_info, request_info, batch_request_info)));
     }
 
+    // replace the compile infos of the procedure if it is not recreated since `procedure_info` was found.
+    // running requests keep the old compile infos until they finish
+    bool UpdateSQLProcedureCompileInfo(const std::string& db, const std::string& sp_name,
+                                       const std::shared_ptr<hybridse::sdk::ProcedureInfo>& procedure_info,
+                                       std::shared_ptr<hybridse::vm::CompileInfo> request_info,
+                                       std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info) {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        auto db_it = db_sp_map_.find(db);
+        if (db_it == db_sp_map_.end()) {
+            return false;
+        }
+        auto sp_it = db_it->second.find(sp_name);
+        if (sp_it == db_it->second.end() || sp_it->second.procedure_info != procedure_info) {
+            return false;
+        }
+        sp_it->second.request_info = request_info;
+        sp_it->second.batch_request_info = batch_request_info;
+        return true;
+    }
+
     void DropSQLProcedureCacheEntry(const std::string& db, const std::string& sp_name) {
         std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
         db_sp_map_[db].erase(sp_name);
@@ -86,51 +128,55 @@ class SpCache : public hybridse::vm::CompileInfoCache {
     }
     std::shared_ptr<hybridse::vm::CompileInfo> GetRequestInfo(const std::string& db, const std::string& sp_name,
                                                               hybridse::base::Status& status) override {  // NOLINT
+        return GetRequestInfo(db, sp_name, status, nullptr);
+    }
+    std::shared_ptr<hybridse::vm::CompileInfo> GetBatchRequestInfo(const std::string& db, const std::string& sp_name,
+                                                                   hybridse::base::Status& status) override {  // NOLINT
+        return GetBatchRequestInfo(db, sp_name, status, nullptr);
+    }
+    // get the compile info and the call counter of the procedure in one lookup
+    std::shared_ptr<hybridse::vm::CompileInfo> GetRequestInfo(
+        const std::string& db, const std::string& sp_name, hybridse::base::Status& status,  // NOLINT
+        std::shared_ptr<ProcedureCallCounter>* call_cnt) {
         std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
-        auto db_it = db_sp_map_.find(db);
-        if (db_it == db_sp_map_.end()) {
+        auto entry = FindEntry(db, sp_name);
+        if (entry == nullptr || !entry->request_info) {
             status = hybridse::base::Status(hybridse::common::kProcedureNotFound,
                                             "store procedure[" + sp_name + "] not found in db[" + db + "]");
             return std::shared_ptr<hybridse::vm::CompileInfo>();
         }
-        auto sp_it = db_it->second.find(sp_name);
-        if (sp_it == db_it->second.end()) {
-            status = hybridse::base::Status(hybridse::common::kProcedureNotFound,
-                                            "store procedure[" + sp_name + "] not found in db[" + db + "]");
-            return std::shared_ptr<hybridse::vm::CompileInfo>();
+        if (call_cnt != nullptr) {
+            *call_cnt = entry->call_cnt;
         }
-
-        if (!sp_it->second.request_info) {
+        return entry->request_info;
+    }
+    std::shared_ptr<hybridse::vm::CompileInfo> GetBatchRequestInfo(
+        const std::string& db, const std::string& sp_name, hybridse::base::Status& status,  // NOLINT
+        std::shared_ptr<ProcedureCallCounter>* call_cnt) {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        auto entry = FindEntry(db, sp_name);
+        if (entry == nullptr || !entry->batch_request_info) {
             status = hybridse::base::Status(hybridse::common::kProcedureNotFound,
                                             "store procedure[" + sp_name + "] not found in db[" + db + "]");
             return std::shared_ptr<hybridse::vm::CompileInfo>();
         }
-        return sp_it->second.request_info;
+        if (call_cnt != nullptr) {
+            *call_cnt = entry->call_cnt;
+        }
+        return entry->batch_request_info;
     }
-    std::shared_ptr<hybridse::vm::CompileInfo> GetBatchRequestInfo(const std::string& db, const std::string& sp_name,
-                                                                   hybridse::base::Status& status) override {  // NOLINT
-        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+
+ private:
+    // return null if the procedure is not cached, spin_mutex_ must be held
+    const SQLProcedureCacheEntry* FindEntry(const std::string& db, const std::string& sp_name) const {
         auto db_it = db_sp_map_.find(db);
         if (db_it == db_sp_map_.end()) {
-            status = hybridse::base::Status(hybridse::common::kProcedureNotFound,
-                                            "store procedure[" + sp_name + "] not found in db[" + db + "]");
-            return std::shared_ptr<hybridse::vm::CompileInfo>();
+            return nullptr;
         }
         auto sp_it = db_it->second.find(sp_name);
-        if (sp_it == db_it->second.end()) {
-            status = hybridse::base::Status(hybridse::common::kProcedureNotFound,
-                                            "store procedure[" + sp_name + "] not found in db[" + db + "]");
-            return std::shared_ptr<hybridse::vm::CompileInfo>();
-        }
-        if (!sp_it->second.batch_request_info) {
-            status = hybridse::base::Status(hybridse::common::kProcedureNotFound,
-                                            "store procedure[" + sp_name + "] not found in db[" + db + "]");
-            return std::shared_ptr<hybridse::vm::CompileInfo>();
-        }
-        return sp_it->second.batch_request_info;
+        return sp_it == db_it->second.end() ? nullptr : &sp_it->second;
     }
 
- private:
     std::map<std::string, std::map<std::string, SQLProcedureCacheEntry>> db_sp_map_;
     mutable SpinMutex spin_mutex_;
 };
@@ -21,6 +21,7 @@
 #include <google/protobuf/text_format.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include <memory>
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
@@ -30,6 +31,7 @@
 #include <snappy.h>
 
 #include <algorithm>
+#include <sstream>
 #include <thread>  // NOLINT
 #include <utility>
 #include <vector>
@@ -74,6 +76,7 @@ DECLARE_int32(gc_pool_size);
 DECLARE_int32(disk_gc_interval);
 DECLARE_int32(statdb_ttl);
 DECLARE_uint32(scan_max_bytes_size);
+DECLARE_uint32(query_cursor_timeout_ms);
 DECLARE_uint32(scan_reserve_size);
 DECLARE_double(mem_release_rate);
 DECLARE_string(db_root_path);
@@ -116,6 +119,10 @@ DECLARE_uint32(snapshot_ttl_check_interval);
 DECLARE_uint32(put_slow_log_threshold);
 DECLARE_uint32(query_slow_log_threshold);
 DECLARE_int32(snapshot_pool_size);
+DECLARE_uint64(deploy_tiered_compile_threshold);
+DECLARE_uint32(deploy_profile_sample_rate);
+DECLARE_uint64(deploy_micro_batch_window_us);
+DECLARE_uint32(deploy_micro_batch_max_size);
 
 namespace openmldb {
 namespace tablet {
@@ -147,7 +154,14 @@ TabletImpl::TabletImpl()
       sp_cache_(std::shared_ptr<SpCache>(new SpCache())),
       notify_path_(),
       globalvar_changed_notify_path_(),
-      startup_mode_(::openmldb::type::StartupMode::kStandalone) {}
+      startup_mode_(::openmldb::type::StartupMode::kStandalone),
+      deploy_profile_call_cnt_(0),
+      query_cursor_id_(0),
+      request_batcher_(FLAGS_deploy_micro_batch_window_us, FLAGS_deploy_micro_batch_max_size),
+      engine_cache_hit_cnt_(&TabletImpl::GetEngineCacheHitCnt, this),
+      engine_cache_miss_cnt_(&TabletImpl::GetEngineCacheMissCnt, this),
+      micro_batch_cnt_(&TabletImpl::GetMicroBatchCnt, this),
+      micro_batch_row_cnt_(&TabletImpl::GetMicroBatchRowCnt, this) {}
 
 TabletImpl::~TabletImpl() {
     task_pool_.Stop(true);
@@ -208,8 +222,14 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
         options.SetClusterOptimized(false);
     }
     engine_ = std::unique_ptr<::hybridse::vm::Engine>(new ::hybridse::vm::Engine(catalog_, options));
+    options.jit_options().SetEnableAggressiveOpt(true);
+    tiered_engine_ = std::unique_ptr<::hybridse::vm::Engine>(new ::hybridse::vm::Engine(catalog_, options));
     catalog_->SetLocalTablet(
         std::shared_ptr<::hybridse::vm::Tablet>(new ::hybridse::vm::LocalTablet(engine_.get(), sp_cache_)));
+    engine_cache_hit_cnt_.expose_as("tablet", "engine_cache_hit_count");
+    engine_cache_miss_cnt_.expose_as("tablet", "engine_cache_miss_count");
+    micro_batch_cnt_.expose_as("tablet", "deploy_micro_batch_count");
+    micro_batch_row_cnt_.expose_as("tablet", "deploy_micro_batch_row_count");
     std::set<std::string> snapshot_compression_set{"off", "zlib", "snappy"};
     if (snapshot_compression_set.find(FLAGS_snapshot_compression) == snapshot_compression_set.end()) {
         LOG(ERROR) << "wrong snapshot_compression: " << FLAGS_snapshot_compression;
@@ -908,8 +928,10 @@ int32_t TabletImpl::ScanIndex(const ::openmldb::api::ScanRequest* request, const
     }
 
     bool enable_project = false;
-    ::openmldb::codec::RowProject row_project(vers_schema, request->projection());
-    if (request->projection().size() > 0) {
+    ::openmldb::codec::RowProject row_project(vers_schema, request->projection(), request->keep_layout());
+    // rows of a keep_layout projection keep the table schema, full rows serve it as well
+    bool full_rows = request->keep_layout() && meta.compress_type() == ::openmldb::type::kSnappy;
+    if (request->projection().size() > 0 && !full_rows) {
         if (meta.compress_type() == ::openmldb::type::kSnappy) {
             LOG(WARNING) << "project on compress row data do not eing supported";
             return -1;
@@ -995,8 +1017,10 @@ int32_t TabletImpl::ScanIndex(const ::openmldb::api::ScanRequest* request, const
     }
 
     bool enable_project = false;
-    ::openmldb::codec::RowProject row_project(vers_schema, request->projection());
-    if (!request->projection().empty()) {
+    ::openmldb::codec::RowProject row_project(vers_schema, request->projection(), request->keep_layout());
+    // rows of a keep_layout projection keep the table schema, full rows serve it as well
+    bool full_rows = request->keep_layout() && meta.compress_type() == ::openmldb::type::kSnappy;
+    if (!request->projection().empty() && !full_rows) {
         if (meta.compress_type() == ::openmldb::type::kSnappy) {
             LOG(WARNING) << "project on compress row data, not supported";
             return -1;
@@ -1409,6 +1433,25 @@ void TabletImpl::Traverse(RpcController* controller, const ::openmldb::api::Trav
         return;
     }
     index = index_def->GetId();
+    const std::map<int32_t, std::shared_ptr<Schema>> vers_schema = table->GetAllVersionSchema();
+    ::openmldb::codec::RowProject row_project(vers_schema, request->projection(), request->keep_layout());
+    bool enable_project = false;
+    // rows of a keep_layout projection keep the table schema, full rows serve it as well
+    bool full_rows =
+        request->keep_layout() && table->GetTableMeta()->compress_type() == ::openmldb::type::kSnappy;
+    if (!request->projection().empty() && !full_rows) {
+        if (table->GetTableMeta()->compress_type() == ::openmldb::type::kSnappy) {
+            response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+            response->set_msg("project on compress row data, not supported");
+            return;
+        }
+        if (!row_project.Init()) {
+            response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+            response->set_msg("invalid project list");
+            return;
+        }
+        enable_project = true;
+    }
     ::openmldb::storage::TableIterator* it = table->NewTraverseIterator(index);
     if (it == NULL) {
         response->set_code(::openmldb::base::ReturnCode::kTsNameNotFound);
@@ -1458,8 +1501,20 @@ void TabletImpl::Traverse(RpcController* controller, const ::openmldb::api::Trav
             key_seq.emplace_back(last_pk);
         }
         openmldb::base::Slice value = it->GetValue();
-        value_map[last_pk].push_back(std::make_pair(it->GetKey(), value));
+        if (enable_project) {
+            int8_t* ptr = nullptr;
+            uint32_t size = 0;
+            if (!row_project.Project(reinterpret_cast<const int8_t*>(value.data()), value.size(), &ptr, &size)) {
+                PDLOG(WARNING, "fail to make a projection. tid %u, pid %u", request->tid(), request->pid());
+                delete it;
+                response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+                response->set_msg("fail to make a projection");
+                return;
+            }
+            value = openmldb::base::Slice(reinterpret_cast<char*>(ptr), size, true);
+        }
         total_block_size += last_pk.length() + value.size();
+        value_map[last_pk].emplace_back(it->GetKey(), std::move(value));
         scount++;
         if (it->GetCount() >= FLAGS_max_traverse_cnt) {
             DEBUGLOG("traverse cnt %lu max %lu, key %s ts %lu", it->GetCount(), FLAGS_max_traverse_cnt, last_pk.c_str(),
@@ -1599,6 +1654,24 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
     };
 
     ::hybridse::base::Status status;
+    if (request->has_cursor_id()) {
+        QueryCursor cursor;
+        {
+            std::lock_guard<std::mutex> lock(query_cursor_mu_);
+            auto it = query_cursors_.find(request->cursor_id());
+            if (it != query_cursors_.end()) {
+                cursor = std::move(it->second);
+                query_cursors_.erase(it);
+            }
+        }
+        if (!cursor.rows) {
+            response->set_code(::openmldb::base::kSQLRunError);
+            response->set_msg("query cursor not found, it may be expired");
+            return;
+        }
+        FillQueryChunk(std::move(cursor), true, response, buf);
+        return;
+    }
     if (request->is_batch()) {
         // convert repeated openmldb:type::DataType into hybridse::codec::Schema
         hybridse::codec::Schema parameter_schema;
@@ -1618,6 +1691,9 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
         if (request->is_debug()) {
             session.EnableDebug();
         }
+        if (request->is_profile()) {
+            session.SetProfile(std::make_shared<::hybridse::vm::RunProfile>());
+        }
         session.SetParameterSchema(parameter_schema);
         {
             bool ok = engine_->Get(request->sql(), request->db(), session, status);
@@ -1638,35 +1714,24 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
             response->set_msg("fail to decode parameter row");
             return;
         }
-        std::vector<::hybridse::codec::Row> output_rows;
-        int32_t run_ret = session.Run(parameter_row, output_rows);
-        if (run_ret != 0) {
+        QueryCursor cursor;
+        if (session.Run(parameter_row, &cursor.rows) != 0) {
             response->set_msg(status.msg);
             response->set_code(::openmldb::base::kSQLRunError);
             DLOG(WARNING) << "fail to run sql: " << request->sql();
             return;
         }
-        uint32_t byte_size = 0;
-        uint32_t count = 0;
-        for (auto& output_row : output_rows) {
-            if (byte_size > FLAGS_scan_max_bytes_size) {
-                LOG(WARNING) << "reach the max byte size truncate result";
-                response->set_schema(session.GetEncodedSchema());
-                response->set_byte_size(byte_size);
-                response->set_count(count);
-                response->set_code(::openmldb::base::kOk);
-                return;
-            }
-            byte_size += output_row.size();
-            buf->append(reinterpret_cast<void*>(output_row.buf()), output_row.size());
-            count += 1;
-        }
-        response->set_schema(session.GetEncodedSchema());
-        response->set_byte_size(byte_size);
-        response->set_count(count);
-        response->set_code(::openmldb::base::kOk);
-        DLOG(INFO) << "handle batch sql " << request->sql() << " with record cnt " << count << " byte size "
-                   << byte_size;
+        cursor.schema = session.GetEncodedSchema();
+        // rows are appended to the response as the result is iterated, the rest of the result is only produced
+        // when the client asks for the next chunk
+        FillQueryChunk(std::move(cursor), request->is_chunked(), response, buf);
+        if (request->is_profile()) {
+            std::ostringstream oss;
+            session.PrintProfile(oss, "");
+            response->set_profile(oss.str());
+        }
+        DLOG(INFO) << "handle batch sql " << request->sql() << " with record cnt " << response->count()
+                   << " byte size " << response->byte_size();
     } else {
         ::hybridse::vm::RequestRunSession session;
         if (request->is_debug()) {
@@ -1676,9 +1741,10 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
             const std::string& db_name = request->db();
             const std::string& sp_name = request->sp_name();
             std::shared_ptr<hybridse::vm::CompileInfo> request_compile_info;
+            std::shared_ptr<ProcedureCallCounter> call_cnt;
             {
                 hybridse::base::Status status;
-                request_compile_info = sp_cache_->GetRequestInfo(db_name, sp_name, status);
+                request_compile_info = sp_cache_->GetRequestInfo(db_name, sp_name, status, &call_cnt);
                 if (!status.isOK()) {
                     response->set_code(::openmldb::base::ReturnCode::kProcedureNotFound);
                     response->set_msg(status.msg);
@@ -1688,7 +1754,12 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
             }
             session.SetCompileInfo(request_compile_info);
             session.SetSpName(sp_name);
+            CountProcedureCall(db_name, sp_name, call_cnt.get());
+            bool profiled = SampleDeployProfile(&session);
             RunRequestQuery(ctrl, *request, session, *response, *buf);
+            if (profiled && response->code() == ::openmldb::base::kOk) {
+                CollectDeployProfile(db_name, sp_name, &session);
+            }
         } else {
             bool ok = engine_->Get(request->sql(), request->db(), session, status);
             if (!ok || session.GetCompileInfo() == nullptr) {
@@ -1708,6 +1779,48 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
     }
 }
 
+void TabletImpl::FillQueryChunk(QueryCursor cursor, bool is_chunked, ::openmldb::api::QueryResponse* response,
+                                butil::IOBuf* buf) {
+    uint32_t byte_size = 0;
+    uint32_t count = 0;
+    auto& rows = *cursor.rows;
+    for (; rows.Valid(); rows.Next()) {
+        if (byte_size > FLAGS_scan_max_bytes_size) {
+            break;
+        }
+        const auto& row = rows.GetValue();
+        byte_size += row.size();
+        buf->append(reinterpret_cast<void*>(row.buf()), row.size());
+        count += 1;
+    }
+    response->set_schema(cursor.schema);
+    response->set_byte_size(byte_size);
+    response->set_count(count);
+    response->set_code(::openmldb::base::kOk);
+    if (!rows.Valid()) {
+        return;
+    }
+    if (!is_chunked) {
+        LOG(WARNING) << "reach the max byte size truncate result";
+        return;
+    }
+    uint64_t now = ::baidu::common::timer::get_micros() / 1000;
+    uint64_t cursor_id = query_cursor_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+    cursor.expire_time = now + FLAGS_query_cursor_timeout_ms;
+    std::lock_guard<std::mutex> lock(query_cursor_mu_);
+    // cursors of clients that stopped reading are dropped once they expire
+    for (auto it = query_cursors_.begin(); it != query_cursors_.end();) {
+        if (it->second.expire_time < now) {
+            it = query_cursors_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    query_cursors_.emplace(cursor_id, std::move(cursor));
+    response->set_has_more(true);
+    response->set_cursor_id(cursor_id);
+}
+
 void TabletImpl::SubQuery(RpcController* ctrl, const openmldb::api::QueryRequest* request,
                           openmldb::api::QueryResponse* response, Closure* done) {
     DLOG(INFO) << "handle subquery request begin!";
@@ -1747,9 +1860,11 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
 
     if (is_procedure) {
         std::shared_ptr<hybridse::vm::CompileInfo> request_compile_info;
+        std::shared_ptr<ProcedureCallCounter> call_cnt;
         {
             hybridse::base::Status status;
-            request_compile_info = sp_cache_->GetBatchRequestInfo(request->db(), request->sp_name(), status);
+            request_compile_info =
+                sp_cache_->GetBatchRequestInfo(request->db(), request->sp_name(), status, &call_cnt);
             if (!status.isOK()) {
                 response->set_code(::openmldb::base::ReturnCode::kProcedureNotFound);
                 response->set_msg(status.msg);
@@ -1758,6 +1873,7 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
             }
             session.SetCompileInfo(request_compile_info);
             session.SetSpName(request->sp_name());
+            CountProcedureCall(request->db(), request->sp_name(), call_cnt.get());
         }
     } else {
         size_t common_column_num = request->common_column_indices().size();
@@ -2370,6 +2486,15 @@ void TabletImpl::GetTableStatus(RpcController* controller, const ::openmldb::api
                     }
                     status->set_idx_cnt(record_idx_cnt);
                 }
+            } else {
+                if (DiskTable* disk_table = dynamic_cast<DiskTable*>(table.get())) {
+                    uint64_t hit = 0;
+                    uint64_t miss = 0;
+                    if (disk_table->GetBlockCacheStat(&hit, &miss)) {
+                        status->set_block_cache_hit(hit);
+                        status->set_block_cache_miss(miss);
+                    }
+                }
             }
         }
     }
@@ -3649,6 +3774,37 @@ void TabletImpl::CheckFile(RpcController* controller, const ::openmldb::api::Che
         full_path.append("snapshot/");
     }
     full_path += file_name;
+    if (request->has_checksum()) {
+        // the checksum reads whole files, do not block the rpc worker
+        std::string table_path = GetDBPath(db_root_path, tid, pid);
+        Closure* async_done = done_guard.release();
+        io_pool_.AddTask([this, request, response, async_done, table_path, full_path]() {
+            brpc::ClosureGuard guard(async_done);
+            CheckLocalFile(*request, table_path, full_path, response);
+        });
+        return;
+    }
+    CheckLocalFile(*request, "", full_path, response);
+}
+
+void TabletImpl::CheckLocalFile(const ::openmldb::api::CheckFileRequest& request, const std::string& table_path,
+                                const std::string& full_path, ::openmldb::api::GeneralResponse* response) {
+    if (request.has_checksum()) {
+        if (::openmldb::base::IsExists(full_path)) {
+            // a file with the same size may be left by an interrupted transfer
+            uint32_t checksum = 0;
+            if (!GetFileChecksum(full_path, &checksum) || checksum != request.checksum()) {
+                response->set_code(::openmldb::base::ReturnCode::kError);
+                response->set_msg("check checksum failed");
+                PDLOG(WARNING, "check checksum failed. file[%s]", full_path.c_str());
+                return;
+            }
+        } else if (!LinkLocalFile(table_path, request.file(), request.size(), request.checksum(), full_path)) {
+            response->set_code(::openmldb::base::ReturnCode::kError);
+            response->set_msg("no local file to reuse");
+            return;
+        }
+    }
     uint64_t size = 0;
     if (!::openmldb::base::GetFileSize(full_path, size)) {
         response->set_code(-1);
@@ -3656,17 +3812,47 @@ void TabletImpl::CheckFile(RpcController* controller, const ::openmldb::api::Che
         PDLOG(WARNING, "get size failed. file[%s]", full_path.c_str());
         return;
     }
-    if (size != request->size()) {
+    if (size != request.size()) {
         response->set_code(-1);
         response->set_msg("check size failed");
         PDLOG(WARNING, "check size failed. file[%s] cur_size[%lu] expect_size[%lu]", full_path.c_str(), size,
-              request->size());
+              request.size());
         return;
     }
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
 }
 
+bool TabletImpl::LinkLocalFile(const std::string& table_path, const std::string& file_name, uint64_t size,
+                               uint32_t checksum, const std::string& target_path) {
+    std::vector<std::string> candidates = {table_path + "/data/" + file_name, table_path + "/old_data/" + file_name};
+    std::vector<std::string> snapshot_dirs;
+    ::openmldb::base::GetSubDir(table_path + "/snapshot/", snapshot_dirs);
+    for (const auto& dir : snapshot_dirs) {
+        candidates.push_back(table_path + "/snapshot/" + dir + "/" + file_name);
+    }
+    std::string target_dir = target_path.substr(0, target_path.find_last_of("/"));
+    for (const auto& path : candidates) {
+        uint64_t cur_size = 0;
+        uint32_t cur_checksum = 0;
+        if (!::openmldb::base::IsExists(path) || !::openmldb::base::GetFileSize(path, cur_size) || cur_size != size ||
+            !GetFileChecksum(path, &cur_checksum) || cur_checksum != checksum) {
+            continue;
+        }
+        if (!::openmldb::base::MkdirRecur(target_dir)) {
+            return false;
+        }
+        if (link(path.c_str(), target_path.c_str()) < 0) {
+            PDLOG(WARNING, "link %s to %s failed. err[%d: %s]", path.c_str(), target_path.c_str(), errno,
+                  strerror(errno));
+            return false;
+        }
+        PDLOG(INFO, "reuse local file %s as %s", path.c_str(), target_path.c_str());
+        return true;
+    }
+    return false;
+}
+
 void TabletImpl::GetManifest(RpcController* controller, const ::openmldb::api::GetManifestRequest* request,
                              ::openmldb::api::GetManifestResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
@@ -5308,6 +5494,7 @@ void TabletImpl::CreateProcedure(RpcController* controller, const openmldb::api:
     // build for single request
     ::hybridse::vm::RequestRunSession session;
     session.SetOptions(options);
+    session.SetSpName(sp_name);
     bool ok = engine_->Get(sql, db_name, session, status);
     if (!ok || session.GetCompileInfo() == nullptr) {
         response->set_msg(status.str());
@@ -5319,6 +5506,7 @@ void TabletImpl::CreateProcedure(RpcController* controller, const openmldb::api:
     // build for batch request
     ::hybridse::vm::BatchRequestRunSession batch_session;
     batch_session.SetOptions(options);
+    batch_session.SetSpName(sp_name);
     for (auto i = 0; i < sp_info.input_schema_size(); ++i) {
         bool is_constant = sp_info.input_schema().Get(i).is_constant();
         if (is_constant) {
@@ -5371,6 +5559,10 @@ void TabletImpl::DropProcedure(RpcController* controller, const ::openmldb::api:
     if (is_deployment_procedure) {
         auto collector_key = absl::StrCat(db_name, ".", sp_name);
         auto s = deploy_collector_->DeleteDeploy(collector_key);
+        {
+            std::lock_guard<std::mutex> lock(deploy_profile_mu_);
+            deploy_profiles_.erase(collector_key);
+        }
         if (!s.ok()) {
             LOG(ERROR) << "[ERROR] delete deploy collector: " << s;
         } else {
@@ -5391,7 +5583,8 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
     ::hybridse::codec::Row row;
     auto& request_buf = dynamic_cast<brpc::Controller*>(ctrl)->request_attachment();
     size_t input_slices = request.row_slices();
-    if (!codec::DecodeRpcRow(request_buf, 0, request.row_size(), input_slices, &row)) {
+    // the request row references the attachment, which outlives the run and the encoding of its output
+    if (!codec::DecodeRpcRowInPlace(request_buf, 0, request.row_size(), input_slices, &row)) {
         response.set_code(::openmldb::base::kSQLRunError);
         response.set_msg("fail to decode input row");
         return;
@@ -5400,7 +5593,7 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
     int32_t ret = 0;
     if (request.has_task_id()) {
         ret = session.Run(request.task_id(), row, &output);
-    } else {
+    } else if (!RunBatchedRequest(request, session, row, &output, &ret)) {
         ret = session.Run(row, &output);
     }
     if (ret != 0) {
@@ -5427,10 +5620,76 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
     response.set_code(::openmldb::base::kOk);
 }
 
+bool TabletImpl::RunBatchedRequest(const openmldb::api::QueryRequest& request,
+                                   ::hybridse::vm::RequestRunSession& session, const ::hybridse::codec::Row& row,
+                                   ::hybridse::codec::Row* output, int32_t* ret) {
+    if (!request_batcher_.IsEnabled() || !request.is_procedure() || request.is_debug() ||
+        session.GetProfile() || row.GetRowPtrCnt() != 1) {
+        return false;
+    }
+    hybridse::base::Status status;
+    auto batch_request_info = sp_cache_->GetBatchRequestInfo(request.db(), request.sp_name(), status);
+    if (!status.isOK() || !batch_request_info) {
+        return false;
+    }
+    const std::string& sp_name = request.sp_name();
+    std::string key = absl::StrCat(request.db(), ".", sp_name);
+    // calls only share a batch with calls of the same common column values
+    CommonColumnLayout layout(batch_request_info->GetBatchRequestInfo(), batch_request_info->GetRequestSchema(),
+                              batch_request_info->GetSchema());
+    ::hybridse::codec::Row batch_row = row;
+    if (layout.IsSplit()) {
+        std::string common_key;
+        if (!layout.Split(row, &batch_row, &common_key)) {
+            return false;
+        }
+        absl::StrAppend(&key, "|", common_key);
+    }
+    *ret = request_batcher_.Run(
+        key, batch_row,
+        [&batch_request_info, &sp_name, &layout](const std::vector<::hybridse::codec::Row>& rows,
+                                                 std::vector<::hybridse::codec::Row>* outputs) {
+            ::hybridse::vm::BatchRequestRunSession batch_session;
+            batch_session.SetCompileInfo(batch_request_info);
+            batch_session.SetSpName(sp_name);
+            std::vector<::hybridse::codec::Row> batch_outputs;
+            int32_t run_ret = batch_session.Run(rows, batch_outputs);
+            if (run_ret != 0) {
+                return run_ret;
+            }
+            outputs->resize(batch_outputs.size());
+            for (size_t i = 0; i < batch_outputs.size(); i++) {
+                if (!layout.Merge(batch_outputs[i], &(*outputs)[i])) {
+                    return -1;
+                }
+            }
+            return 0;
+        },
+        output);
+    return true;
+}
+
 void TabletImpl::CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info) {
     const std::string& db_name = sp_info->GetDbName();
     const std::string& sp_name = sp_info->GetSpName();
     const std::string& sql = sp_info->GetSql();
+    std::shared_ptr<hybridse::vm::CompileInfo> request_info;
+    std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info;
+    if (!CompileProcedure(engine_.get(), sp_info, &request_info, &batch_request_info)) {
+        return;
+    }
+    sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info, request_info, batch_request_info);
+
+    LOG(INFO) << "refresh procedure success! sp_name: " << sp_name << ", db: " << db_name << ", sql: " << sql;
+}
+
+bool TabletImpl::CompileProcedure(::hybridse::vm::Engine* engine,
+                                  const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info,
+                                  std::shared_ptr<hybridse::vm::CompileInfo>* request_info,
+                                  std::shared_ptr<hybridse::vm::CompileInfo>* batch_request_info) {
+    const std::string& db_name = sp_info->GetDbName();
+    const std::string& sp_name = sp_info->GetSpName();
+    const std::string& sql = sp_info->GetSql();
     auto long_windows = sp_info->GetOption(hybridse::vm::LONG_WINDOWS);
     std::shared_ptr<std::unordered_map<std::string, std::string>> options = nullptr;
     if (long_windows) {
@@ -5442,29 +5701,79 @@ void TabletImpl::CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureI
     // build for single request
     ::hybridse::vm::RequestRunSession session;
     session.SetOptions(options);
-    bool ok = engine_->Get(sql, db_name, session, status);
+    session.SetSpName(sp_name);
+    bool ok = engine->Get(sql, db_name, session, status);
     if (!ok || session.GetCompileInfo() == nullptr) {
         LOG(WARNING) << "fail to compile sql " << sql;
-        return;
+        return false;
     }
     // build for batch request
     ::hybridse::vm::BatchRequestRunSession batch_session;
     batch_session.SetOptions(options);
+    batch_session.SetSpName(sp_name);
     for (auto i = 0; i < sp_info->GetInputSchema().GetColumnCnt(); ++i) {
         bool is_constant = sp_info->GetInputSchema().IsConstant(i);
         if (is_constant) {
             batch_session.AddCommonColumnIdx(i);
         }
     }
-    ok = engine_->Get(sql, db_name, batch_session, status);
+    ok = engine->Get(sql, db_name, batch_session, status);
     if (!ok || batch_session.GetCompileInfo() == nullptr) {
         LOG(WARNING) << "fail to compile batch request for sql " << sql;
-        return;
+        return false;
     }
-    sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info, session.GetCompileInfo(),
-                                            batch_session.GetCompileInfo());
+    *request_info = session.GetCompileInfo();
+    *batch_request_info = batch_session.GetCompileInfo();
+    return true;
+}
 
-    LOG(INFO) << "refresh procedure success! sp_name: " << sp_name << ", db: " << db_name << ", sql: " << sql;
+void TabletImpl::CountProcedureCall(const std::string& db, const std::string& sp_name,
+                                    ProcedureCallCounter* call_cnt) {
+    if (FLAGS_deploy_tiered_compile_threshold > 0 && call_cnt != nullptr &&
+        call_cnt->Count(FLAGS_deploy_tiered_compile_threshold)) {
+        task_pool_.AddTask(boost::bind(&TabletImpl::OptimizeProcedure, this, db, sp_name));
+    }
+}
+
+bool TabletImpl::SampleDeployProfile(::hybridse::vm::RunSession* session) {
+    if (FLAGS_deploy_profile_sample_rate == 0 || !IsCollectDeployStatsEnabled()) {
+        return false;
+    }
+    if (deploy_profile_call_cnt_.fetch_add(1, std::memory_order_relaxed) % FLAGS_deploy_profile_sample_rate != 0) {
+        return false;
+    }
+    session->SetProfile(std::make_shared<::hybridse::vm::RunProfile>());
+    return true;
+}
+
+void TabletImpl::CollectDeployProfile(const std::string& db, const std::string& sp_name,
+                                      ::hybridse::vm::RunSession* session) {
+    std::lock_guard<std::mutex> lock(deploy_profile_mu_);
+    auto& deploy_profile = deploy_profiles_[absl::StrCat(db, ".", sp_name)];
+    if (deploy_profile.compile_info != session->GetCompileInfo()) {
+        // runner ids of a recompiled procedure do not match the old profile
+        deploy_profile.compile_info = session->GetCompileInfo();
+        deploy_profile.profile = std::make_shared<::hybridse::vm::RunProfile>();
+    }
+    deploy_profile.profile->Merge(*session->GetProfile());
+}
+
+void TabletImpl::OptimizeProcedure(const std::string& db, const std::string& sp_name) {
+    auto sp_info = sp_cache_->FindSpProcedureInfo(db, sp_name);
+    if (!sp_info.ok()) {
+        return;
+    }
+    std::shared_ptr<hybridse::vm::CompileInfo> request_info;
+    std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info;
+    if (!CompileProcedure(tiered_engine_.get(), *sp_info, &request_info, &batch_request_info)) {
+        LOG(WARNING) << "fail to recompile hot procedure " << db << "." << sp_name;
+        return;
+    }
+    // the engine cache is not needed, the sp cache holds the compile infos
+    tiered_engine_->ClearCacheLocked(db);
+    if (sp_cache_->UpdateSQLProcedureCompileInfo(db, sp_name, *sp_info, request_info, batch_request_info)) {
+        LOG(INFO) << "recompile hot procedure " << db << "." << sp_name << " with aggressive optimization";
+    }
 }
 
 void TabletImpl::GetBulkLoadInfo(RpcController* controller, const ::openmldb::api::BulkLoadInfoRequest* request,
@@ -5798,6 +6107,36 @@ bool TabletImpl::CreateAggregatorInternal(const ::openmldb::api::CreateAggregato
     return true;
 }
 
+uint64_t TabletImpl::GetEngineCacheHitCnt(void* arg) {
+    auto tablet = static_cast<TabletImpl*>(arg);
+    if (!tablet->engine_ || !tablet->tiered_engine_) {
+        return 0;
+    }
+    return tablet->engine_->GetCacheStats().hit_cnt + tablet->tiered_engine_->GetCacheStats().hit_cnt;
+}
+
+uint64_t TabletImpl::GetEngineCacheMissCnt(void* arg) {
+    auto tablet = static_cast<TabletImpl*>(arg);
+    if (!tablet->engine_ || !tablet->tiered_engine_) {
+        return 0;
+    }
+    return tablet->engine_->GetCacheStats().miss_cnt + tablet->tiered_engine_->GetCacheStats().miss_cnt;
+}
+
+uint64_t TabletImpl::GetMicroBatchCnt(void* arg) {
+    uint64_t batch_cnt = 0;
+    uint64_t row_cnt = 0;
+    static_cast<TabletImpl*>(arg)->request_batcher_.GetTotalStats(&batch_cnt, &row_cnt);
+    return batch_cnt;
+}
+
+uint64_t TabletImpl::GetMicroBatchRowCnt(void* arg) {
+    uint64_t batch_cnt = 0;
+    uint64_t row_cnt = 0;
+    static_cast<TabletImpl*>(arg)->request_batcher_.GetTotalStats(&batch_cnt, &row_cnt);
+    return row_cnt;
+}
+
 void TabletImpl::GetAndFlushDeployStats(::google::protobuf::RpcController* controller,
                                         const ::openmldb::api::GAFDeployStatsRequest* request,
                                         ::openmldb::api::DeployStatsResponse* response,
@@ -5813,6 +6152,28 @@ void TabletImpl::GetAndFlushDeployStats(::google::protobuf::RpcController* contr
         new_row->set_total(r.GetTotalAsStr(statistics::TimeUnit::MICRO_SECOND));
     }
     response->set_code(ReturnCode::kOk);
+
+    std::map<std::string, DeployProfile> profiles;
+    {
+        std::lock_guard<std::mutex> lock(deploy_profile_mu_);
+        profiles.swap(deploy_profiles_);
+    }
+    for (auto& kv : profiles) {
+        ::hybridse::vm::RequestRunSession session;
+        session.SetCompileInfo(kv.second.compile_info);
+        session.SetProfile(kv.second.profile);
+        std::ostringstream oss;
+        session.PrintProfile(oss, "");
+        LOG(INFO) << "runtime profile of deployment " << kv.first << ":\n" << oss.str();
+    }
+    uint64_t batch_cnt = 0;
+    uint64_t row_cnt = 0;
+    uint64_t max_batch_size = 0;
+    request_batcher_.FlushStats(&batch_cnt, &row_cnt, &max_batch_size);
+    if (batch_cnt > 0) {
+        LOG(INFO) << "micro batched " << row_cnt << " deployment calls in " << batch_cnt
+                  << " batches, max batch size " << max_batch_size;
+    }
 }
 
 }  // namespace tablet
@@ -18,6 +18,7 @@
 #define SRC_TABLET_TABLET_IMPL_H_
 
 #include <brpc/server.h>
+#include <bvar/bvar.h>
 
 #include <list>
 #include <map>
@@ -42,6 +43,7 @@
 #include "tablet/bulk_load_mgr.h"
 #include "tablet/combine_iterator.h"
 #include "tablet/file_receiver.h"
+#include "tablet/request_batcher.h"
 #include "tablet/sp_cache.h"
 #include "vm/engine.h"
 #include "zk/zk_client.h"
@@ -278,6 +280,8 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     std::shared_ptr<Aggrs> GetAggregators(uint32_t tid, uint32_t pid);
 
+    std::shared_ptr<SpCache> GetSpCache() { return sp_cache_; }
+
     void GetAndFlushDeployStats(::google::protobuf::RpcController* controller,
                                 const ::openmldb::api::GAFDeployStatsRequest* request,
                                 ::openmldb::api::DeployStatsResponse* response,
@@ -402,6 +406,14 @@ class TabletImpl : public ::openmldb::api::TabletServer {
                               std::string& msg,                   // NOLINT
                               uint64_t& term, uint64_t& offset);  // NOLINT
 
+    // hard link a local file with the same name, size and checksum to target_path
+    bool LinkLocalFile(const std::string& table_path, const std::string& file_name, uint64_t size,
+                       uint32_t checksum, const std::string& target_path);
+
+    // check the size of a received file, and the checksum if given. a missing file is linked from a local copy
+    void CheckLocalFile(const ::openmldb::api::CheckFileRequest& request, const std::string& table_path,
+                        const std::string& full_path, ::openmldb::api::GeneralResponse* response);
+
     void DelRecycle(const std::string& path);
 
     void SchedDelRecycle();
@@ -410,6 +422,17 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     void ProcessQuery(RpcController* controller, const openmldb::api::QueryRequest* request,
                       ::openmldb::api::QueryResponse* response, butil::IOBuf* buf);
+
+    // the rest of a chunked batch query result, kept until the client requests the next chunk
+    struct QueryCursor {
+        std::unique_ptr<::hybridse::vm::BatchRunCursor> rows;
+        std::string schema;
+        uint64_t expire_time = 0;
+    };
+    // append the rows of `cursor` to `buf` until scan_max_bytes_size is reached, the cursor is kept for the
+    // next chunk if rows are left and `is_chunked`, else the rest of the result is truncated
+    void FillQueryChunk(QueryCursor cursor, bool is_chunked, ::openmldb::api::QueryResponse* response,
+                        butil::IOBuf* buf);
     void ProcessBatchRequestQuery(RpcController* controller, const openmldb::api::SQLBatchRequestQueryRequest* request,
                                   openmldb::api::SQLBatchRequestQueryResponse* response,
                                   butil::IOBuf& buf);  // NOLINT
@@ -435,11 +458,43 @@ class TabletImpl : public ::openmldb::api::TabletServer {
                          ::hybridse::vm::RequestRunSession& session,                  // NOLINT
                          openmldb::api::QueryResponse& response, butil::IOBuf& buf);  // NOLINT
 
+    // run the request row of a deployment call within a micro batch of concurrent calls,
+    // return false if the call can not be batched
+    bool RunBatchedRequest(const openmldb::api::QueryRequest& request, ::hybridse::vm::RequestRunSession& session,
+                           const ::hybridse::codec::Row& row, ::hybridse::codec::Row* output,
+                           int32_t* ret);  // NOLINT
+
     void CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info);
 
+    // compile the procedure for request and batch request mode with `engine`
+    bool CompileProcedure(::hybridse::vm::Engine* engine, const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info,
+                          std::shared_ptr<hybridse::vm::CompileInfo>* request_info,
+                          std::shared_ptr<hybridse::vm::CompileInfo>* batch_request_info);
+
+    // recompile a hot procedure with the aggressive optimized engine and swap in the result
+    void OptimizeProcedure(const std::string& db, const std::string& sp_name);
+
+    // count a procedure call on the counter of its cache entry and schedule OptimizeProcedure once it is hot
+    void CountProcedureCall(const std::string& db, const std::string& sp_name, ProcedureCallCounter* call_cnt);
+
+    // enable the runtime profile of `session` for one in deploy_profile_sample_rate calls
+    bool SampleDeployProfile(::hybridse::vm::RunSession* session);
+
+    // merge the runtime profile of a sampled call into the profile of the deployment
+    void CollectDeployProfile(const std::string& db, const std::string& sp_name,
+                              ::hybridse::vm::RunSession* session);
+
     // refresh the pre-aggr tables info
     bool RefreshAggrCatalog();
 
+    // getters of the engine cache metrics, `arg` is the tablet
+    static uint64_t GetEngineCacheHitCnt(void* arg);
+    static uint64_t GetEngineCacheMissCnt(void* arg);
+
+    // getters of the micro batch metrics, `arg` is the tablet
+    static uint64_t GetMicroBatchCnt(void* arg);
+    static uint64_t GetMicroBatchRowCnt(void* arg);
+
  private:
     Tables tables_;
     std::mutex mu_;
@@ -467,6 +522,8 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     std::shared_ptr<::openmldb::catalog::TabletCatalog> catalog_;
     // thread safe
     std::unique_ptr<::hybridse::vm::Engine> engine_;
+    // recompiles hot procedures with aggressive optimization
+    std::unique_ptr<::hybridse::vm::Engine> tiered_engine_;
     std::shared_ptr<::hybridse::vm::LocalTablet> local_tablet_;
     std::string zk_cluster_;
     std::string zk_path_;
@@ -480,6 +537,28 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     std::shared_ptr<std::map<std::string, std::string>> global_variables_;
 
     std::unique_ptr<openmldb::statistics::DeployQueryTimeCollector> deploy_collector_;
+
+    struct DeployProfile {
+        std::shared_ptr<hybridse::vm::CompileInfo> compile_info;
+        std::shared_ptr<hybridse::vm::RunProfile> profile;
+    };
+    std::atomic<uint64_t> deploy_profile_call_cnt_;
+    std::mutex deploy_profile_mu_;
+    // sampled runtime profiles of deployments since the last deploy stats sync
+    std::map<std::string, DeployProfile> deploy_profiles_;
+
+    std::atomic<uint64_t> query_cursor_id_;
+    std::mutex query_cursor_mu_;
+    // cursors of chunked batch queries waiting for the next chunk request, by cursor id
+    std::map<uint64_t, QueryCursor> query_cursors_;
+    // coalesces concurrent request mode calls of a deployment
+    RequestBatcher request_batcher_;
+    // compiling result cache counts of both engines, exported to /brpc_metrics
+    bvar::PassiveStatus<uint64_t> engine_cache_hit_cnt_;
+    bvar::PassiveStatus<uint64_t> engine_cache_miss_cnt_;
+    // micro batches of deployment calls and the calls run in them, exported to /brpc_metrics
+    bvar::PassiveStatus<uint64_t> micro_batch_cnt_;
+    bvar::PassiveStatus<uint64_t> micro_batch_row_cnt_;
 };
 
 }  // namespace tablet
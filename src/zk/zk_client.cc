@@ -369,6 +369,12 @@ bool ZkClient::GetNodeValueAndStat(const char* node, std::string* value, Stat* s
     return false;
 }
 
+bool ZkClient::GetNodeStat(const std::string& node, Stat* stat) {
+    std::lock_guard<std::mutex> lock(mu_);
+    DCHECK(stat != nullptr);
+    return zoo_exists(zk_, node.c_str(), 0, stat) == ZOK;
+}
+
 bool ZkClient::DeleteNode(const std::string& node) {
     std::lock_guard<std::mutex> lock(mu_);
     if (zoo_delete(zk_, node.c_str(), -1) == ZOK) {
@@ -465,7 +471,8 @@ void ZkClient::HandleItemChanged(const std::string& path, int type, int state) {
         callback = it->second;
     }
     WatchItem(path, callback);
-    if (type == ZOO_CHANGED_EVENT) {
+    // a deleted node can not be watched again, still tell the owner so it can drop what it read from the node
+    if (type == ZOO_CHANGED_EVENT || type == ZOO_DELETED_EVENT) {
         callback();
     }
 }
@@ -475,7 +482,7 @@ void ZkClient::CancelWatchItem(const std::string& path) {
     item_callbacks_.erase(path);
 }
 
-bool ZkClient::WatchItem(const std::string& path, ItemChangedCallback callback) {
+bool ZkClient::WatchItem(const std::string& path, ItemChangedCallback callback, std::string* value) {
     std::lock_guard<std::mutex> lock(mu_);
     if (zk_ == NULL || !connected_) {
         return false;
@@ -488,9 +495,12 @@ bool ZkClient::WatchItem(const std::string& path, ItemChangedCallback callback)
     int buffer_len = ZK_MAX_BUFFER_SIZE;
     int ret = zoo_wget(zk_, path.data(), ItemWatcher, NULL, buffer_, &buffer_len, NULL);
     if (ret != ZOK) {
-        PDLOG(WARNING, "fail to watch item %s errno %d", nodes_root_path_.c_str(), ret);
+        PDLOG(WARNING, "fail to watch item %s errno %d", path.c_str(), ret);
         return false;
     }
+    if (value != nullptr) {
+        value->assign(buffer_, buffer_len);
+    }
     return true;
 }
 
@@ -94,6 +94,9 @@ class ZkClient {
 
     bool GetNodeValueAndStat(const char* node, std::string* value, Stat* stat);
 
+    // get the stat of node without its value
+    bool GetNodeStat(const std::string& node, Stat* stat);
+
     bool SetNodeValue(const std::string& node, const std::string& value);
 
     bool SetNodeWatcher(const std::string& node, watcher_fn watcher, void* watcherCtx);
@@ -118,7 +121,8 @@ class ZkClient {
 
     void HandleItemChanged(const std::string& path, int type, int state);
 
-    bool WatchItem(const std::string& path, ItemChangedCallback callback);
+    // watch the data of path, the value read when the watch is set is returned if value is not null
+    bool WatchItem(const std::string& path, ItemChangedCallback callback, std::string* value = nullptr);
     void CancelWatchItem(const std::string& path);
 
     int IsExistNodeUnLocked(const std::string& node);